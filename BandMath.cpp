@@ -0,0 +1,648 @@
+// BandMath.cpp
+//
+// Implementations for raster formulas
+// Documentation in BandMath.hpp
+//--------------------------------------------
+
+
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <cctype>
+#include <limits>
+#include <algorithm>
+#include <thread>
+#include <future>
+
+#include "Exceptions.hpp"
+#include "Raster.hpp"
+#include "RasterSlice.hpp"
+#include "IOThread.hpp"
+#include "BandMath.hpp"
+
+
+namespace GeoStar {
+
+  // an operand on the program's stack: pixels at p, or the single value v when p is NULL
+  struct BandMathOperand {
+    const float *p;
+    float v;
+  };
+
+  struct BandMathArray {
+    const float *p;
+    float operator[](const long int &i) const { return p[i]; }
+  };
+
+  struct BandMathScalar {
+    float v;
+    float operator[](const long int &) const { return v; }
+  };
+
+
+  // pixel operations:
+  struct BandMathNeg  { float operator()(const float a) const { return -a; } };
+  struct BandMathNot  { float operator()(const float a) const { return (a == 0) ? 1.0f : 0.0f; } };
+  struct BandMathAbs  { float operator()(const float a) const { return std::fabs(a); } };
+  struct BandMathSqrt { float operator()(const float a) const { return std::sqrt(a); } };
+  struct BandMathExp  { float operator()(const float a) const { return std::exp(a); } };
+  struct BandMathLog  { float operator()(const float a) const { return std::log(a); } };
+
+  struct BandMathAdd { float operator()(const float a, const float b) const { return a + b; } };
+  struct BandMathSub { float operator()(const float a, const float b) const { return a - b; } };
+  struct BandMathMul { float operator()(const float a, const float b) const { return a * b; } };
+  struct BandMathDiv {
+    float nodata;
+    float operator()(const float a, const float b) const { return (b != 0) ? a / b : nodata; }
+  };
+  struct BandMathPow { float operator()(const float a, const float b) const { return std::pow(a, b); } };
+  struct BandMathMin { float operator()(const float a, const float b) const { return (b < a) ? b : a; } };
+  struct BandMathMax { float operator()(const float a, const float b) const { return (a < b) ? b : a; } };
+  struct BandMathLt  { float operator()(const float a, const float b) const { return (a <  b) ? 1.0f : 0.0f; } };
+  struct BandMathLe  { float operator()(const float a, const float b) const { return (a <= b) ? 1.0f : 0.0f; } };
+  struct BandMathGt  { float operator()(const float a, const float b) const { return (a >  b) ? 1.0f : 0.0f; } };
+  struct BandMathGe  { float operator()(const float a, const float b) const { return (a >= b) ? 1.0f : 0.0f; } };
+  struct BandMathEq  { float operator()(const float a, const float b) const { return (a == b) ? 1.0f : 0.0f; } };
+  struct BandMathNe  { float operator()(const float a, const float b) const { return (a != b) ? 1.0f : 0.0f; } };
+  struct BandMathAnd { float operator()(const float a, const float b) const { return (a != 0 && b != 0) ? 1.0f : 0.0f; } };
+  struct BandMathOr  { float operator()(const float a, const float b) const { return (a != 0 || b != 0) ? 1.0f : 0.0f; } };
+
+
+
+  // op over n pixels, a.p or a.v -> dst; a then refers to dst, or holds the value if a is a single value
+  template<typename Op>
+  static void unary(const Op &op, BandMathOperand &a, float *dst, const long int &n) {
+    if(a.p == NULL) {
+      a.v = op(a.v);
+      return;
+    }// endif
+    const float *from = a.p;
+    for(long int i=0; i<n; ++i) dst[i] = op(from[i]);
+    a.p = dst;
+  }// end: unary
+
+
+
+  template<typename Op, typename A, typename B>
+  static void binary_loop(const Op &op, const A &a, const B &b, float *dst, const long int &n) {
+    for(long int i=0; i<n; ++i) dst[i] = op(a[i], b[i]);
+  }// end: binary_loop
+
+
+
+  // op(a, b) over n pixels into dst; the result replaces a
+  template<typename Op>
+  static void binary(const Op &op, BandMathOperand &a, const BandMathOperand &b, float *dst, const long int &n) {
+    if(a.p == NULL && b.p == NULL) {
+      a.v = op(a.v, b.v);
+      return;
+    }// endif
+
+    BandMathArray aa = {a.p};
+    BandMathArray ba = {b.p};
+    BandMathScalar as = {a.v};
+    BandMathScalar bs = {b.v};
+    if(a.p != NULL && b.p != NULL) {
+      binary_loop(op, aa, ba, dst, n);
+    } else if(a.p != NULL) {
+      binary_loop(op, aa, bs, dst, n);
+    } else {
+      binary_loop(op, as, ba, dst, n);
+    }// endif
+    a.p = dst;
+  }// end: binary
+
+
+
+  template<typename A, typename B>
+  static void select_loop(const float *cond, const A &a, const B &b, float *dst, const long int &n) {
+    for(long int i=0; i<n; ++i) dst[i] = (cond[i] != 0) ? a[i] : b[i];
+  }// end: select_loop
+
+
+
+  // cond ? a : b over n pixels into dst; the result replaces cond
+  static void select(BandMathOperand &cond, const BandMathOperand &a, const BandMathOperand &b,
+                     float *dst, const long int &n) {
+    if(cond.p == NULL) {
+      cond = (cond.v != 0) ? a : b;
+      // a branch's pixels may be in the buffer of a stack position that gets reused, keep them in our own:
+      if(cond.p != NULL) {
+        std::copy(cond.p, cond.p+n, dst);
+        cond.p = dst;
+      }// endif
+      return;
+    }// endif
+
+    BandMathArray aa = {a.p};
+    BandMathArray ba = {b.p};
+    BandMathScalar as = {a.v};
+    BandMathScalar bs = {b.v};
+    if(a.p != NULL && b.p != NULL) {
+      select_loop(cond.p, aa, ba, dst, n);
+    } else if(a.p != NULL) {
+      select_loop(cond.p, aa, bs, dst, n);
+    } else if(b.p != NULL) {
+      select_loop(cond.p, as, ba, dst, n);
+    } else {
+      select_loop(cond.p, as, bs, dst, n);
+    }// endif
+    cond.p = dst;
+  }// end: select
+
+
+
+  // runs one operation other than INPUT, CONST and NODATA on the top of stack, which has top operands
+  static void run_op(const BandMathOpCode &code, BandMathOperand *stack, int &top,
+                     float *const *temps, const long int &n, const float &nodata) {
+    if(code == BANDMATH_SELECT) {
+      select(stack[top-3], stack[top-2], stack[top-1], temps[top-3], n);
+      top -= 2;
+      return;
+    }// endif
+
+    if(code <= BANDMATH_LOG) {
+      BandMathOperand &a = stack[top-1];
+      float *dst = temps[top-1];
+      switch(code) {
+      case BANDMATH_NEG:  unary(BandMathNeg(),  a, dst, n); break;
+      case BANDMATH_NOT:  unary(BandMathNot(),  a, dst, n); break;
+      case BANDMATH_ABS:  unary(BandMathAbs(),  a, dst, n); break;
+      case BANDMATH_SQRT: unary(BandMathSqrt(), a, dst, n); break;
+      case BANDMATH_EXP:  unary(BandMathExp(),  a, dst, n); break;
+      default:            unary(BandMathLog(),  a, dst, n); break;
+      }// endswitch
+      return;
+    }// endif
+
+    BandMathOperand &a = stack[top-2];
+    const BandMathOperand &b = stack[top-1];
+    float *dst = temps[top-2];
+    BandMathDiv divide = {nodata};
+    switch(code) {
+    case BANDMATH_ADD: binary(BandMathAdd(), a, b, dst, n); break;
+    case BANDMATH_SUB: binary(BandMathSub(), a, b, dst, n); break;
+    case BANDMATH_MUL: binary(BandMathMul(), a, b, dst, n); break;
+    case BANDMATH_DIV: binary(divide,        a, b, dst, n); break;
+    case BANDMATH_POW: binary(BandMathPow(), a, b, dst, n); break;
+    case BANDMATH_MIN: binary(BandMathMin(), a, b, dst, n); break;
+    case BANDMATH_MAX: binary(BandMathMax(), a, b, dst, n); break;
+    case BANDMATH_LT:  binary(BandMathLt(),  a, b, dst, n); break;
+    case BANDMATH_LE:  binary(BandMathLe(),  a, b, dst, n); break;
+    case BANDMATH_GT:  binary(BandMathGt(),  a, b, dst, n); break;
+    case BANDMATH_GE:  binary(BandMathGe(),  a, b, dst, n); break;
+    case BANDMATH_EQ:  binary(BandMathEq(),  a, b, dst, n); break;
+    case BANDMATH_NE:  binary(BandMathNe(),  a, b, dst, n); break;
+    case BANDMATH_AND: binary(BandMathAnd(), a, b, dst, n); break;
+    default:           binary(BandMathOr(),  a, b, dst, n); break;
+    }// endswitch
+    --top;
+  }// end: run_op
+
+
+
+  // number of operands each operation takes
+  static int operand_count(const BandMathOpCode &code) {
+    if(code <= BANDMATH_NODATA) return 0;
+    if(code <= BANDMATH_LOG) return 1;
+    if(code == BANDMATH_SELECT) return 3;
+    return 2;
+  }// end: operand_count
+
+
+
+  // recursive descent parser of a formula into a program, folding constant parts as it goes
+  class BandMathParser {
+
+  private:
+    const std::string &text;
+    size_t pos;
+    std::vector<std::string> &names;
+
+    // a parsed sub-formula: its program, and whether that is a single constant
+    typedef std::vector<BandMathOp> Code;
+
+    void skip_space() {
+      while(pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) ++pos;
+    }// end: skip_space
+
+    // consumes token if it comes next
+    bool accept(const char *token) {
+      skip_space();
+      const std::string t(token);
+      if(text.compare(pos, t.size(), t) != 0) return false;
+      // don't read the < of <= as <, or the ! of != as !
+      if(t.size() == 1 && pos+1 < text.size() && text[pos+1] == '=' && (t == "<" || t == ">" || t == "!"))
+        return false;
+      pos += t.size();
+      return true;
+    }// end: accept
+
+    void expect(const char *token) {
+      BandMathSyntaxException BandMathSyntaxError;
+      if(!accept(token)) throw BandMathSyntaxError;
+    }// end: expect
+
+    static bool is_constant(const Code &c) {
+      return c.size() == 1 && c[0].code == BANDMATH_CONST;
+    }// end: is_constant
+
+    static Code constant(const float &value) {
+      BandMathOp op = {BANDMATH_CONST, -1, value};
+      return Code(1, op);
+    }// end: constant
+
+    // code for op(args...), computed now if every operand is a constant
+    static Code combine(const BandMathOpCode &code, const Code &a, const Code &b = Code(), const Code &c = Code()) {
+      // a conditional with a constant condition is one of its branches:
+      if(code == BANDMATH_SELECT && is_constant(a)) return (a[0].value != 0) ? b : c;
+
+      const int nargs = operand_count(code);
+      bool folds = is_constant(a) && (nargs < 2 || is_constant(b)) && (nargs < 3 || is_constant(c));
+      // x/0 gives the output nodata value, which is only known when the formula is evaluated:
+      if(code == BANDMATH_DIV && folds && b[0].value == 0) folds = false;
+
+      if(folds) {
+        BandMathOperand stack[3];
+        stack[0].p = NULL;  stack[0].v = a[0].value;
+        if(nargs > 1) { stack[1].p = NULL;  stack[1].v = b[0].value; }
+        if(nargs > 2) { stack[2].p = NULL;  stack[2].v = c[0].value; }
+        float *temps[3] = {NULL, NULL, NULL};
+        int top = nargs;
+        run_op(code, stack, top, temps, 0, 0);
+        return constant(stack[0].v);
+      }// endif
+
+      Code result(a);
+      result.insert(result.end(), b.begin(), b.end());
+      result.insert(result.end(), c.begin(), c.end());
+      BandMathOp op = {code, -1, 0};
+      result.push_back(op);
+      return result;
+    }// end: combine
+
+    // conditional := or [ '?' conditional ':' conditional ]
+    Code conditional() {
+      Code cond = logical_or();
+      if(!accept("?")) return cond;
+      Code a = conditional();
+      expect(":");
+      Code b = conditional();
+      return combine(BANDMATH_SELECT, cond, a, b);
+    }// end: conditional
+
+    Code logical_or() {
+      Code a = logical_and();
+      while(accept("||")) a = combine(BANDMATH_OR, a, logical_and());
+      return a;
+    }// end: logical_or
+
+    Code logical_and() {
+      Code a = comparison();
+      while(accept("&&")) a = combine(BANDMATH_AND, a, comparison());
+      return a;
+    }// end: logical_and
+
+    Code comparison() {
+      Code a = sum();
+      for(;;) {
+        if(accept("<="))      a = combine(BANDMATH_LE, a, sum());
+        else if(accept(">=")) a = combine(BANDMATH_GE, a, sum());
+        else if(accept("==")) a = combine(BANDMATH_EQ, a, sum());
+        else if(accept("!=")) a = combine(BANDMATH_NE, a, sum());
+        else if(accept("<"))  a = combine(BANDMATH_LT, a, sum());
+        else if(accept(">"))  a = combine(BANDMATH_GT, a, sum());
+        else return a;
+      }// endfor
+    }// end: comparison
+
+    Code sum() {
+      Code a = product();
+      for(;;) {
+        if(accept("+"))      a = combine(BANDMATH_ADD, a, product());
+        else if(accept("-")) a = combine(BANDMATH_SUB, a, product());
+        else return a;
+      }// endfor
+    }// end: sum
+
+    Code product() {
+      Code a = prefix();
+      for(;;) {
+        if(accept("*"))      a = combine(BANDMATH_MUL, a, prefix());
+        else if(accept("/")) a = combine(BANDMATH_DIV, a, prefix());
+        else return a;
+      }// endfor
+    }// end: product
+
+    Code prefix() {
+      if(accept("-")) return combine(BANDMATH_NEG, prefix());
+      if(accept("+")) return prefix();
+      if(accept("!")) return combine(BANDMATH_NOT, prefix());
+      return primary();
+    }// end: prefix
+
+    // primary := number | variable | nodata | function '(' args ')' | '(' conditional ')'
+    Code primary() {
+      BandMathSyntaxException BandMathSyntaxError;
+      skip_space();
+      if(pos >= text.size()) throw BandMathSyntaxError;
+
+      if(accept("(")) {
+        Code a = conditional();
+        expect(")");
+        return a;
+      }// endif
+
+      const char c = text[pos];
+      if(std::isdigit(static_cast<unsigned char>(c)) || c == '.') {
+        const char *start = text.c_str() + pos;
+        char *end = NULL;
+        const double value = std::strtod(start, &end);
+        if(end == start) throw BandMathSyntaxError;
+        pos += end - start;
+        return constant(static_cast<float>(value));
+      }// endif
+
+      if(!std::isalpha(static_cast<unsigned char>(c)) && c != '_') throw BandMathSyntaxError;
+      const size_t start = pos;
+      while(pos < text.size() && (std::isalnum(static_cast<unsigned char>(text[pos])) || text[pos] == '_')) ++pos;
+      const std::string word = text.substr(start, pos-start);
+
+      if(word == "nodata") {
+        BandMathOp op = {BANDMATH_NODATA, -1, 0};
+        return Code(1, op);
+      }// endif
+
+      BandMathOpCode function;
+      int nargs = 1;
+      if(word == "abs")       function = BANDMATH_ABS;
+      else if(word == "sqrt") function = BANDMATH_SQRT;
+      else if(word == "exp")  function = BANDMATH_EXP;
+      else if(word == "log")  function = BANDMATH_LOG;
+      else if(word == "pow")  { function = BANDMATH_POW;  nargs = 2; }
+      else if(word == "min")  { function = BANDMATH_MIN;  nargs = 2; }
+      else if(word == "max")  { function = BANDMATH_MAX;  nargs = 2; }
+      else {
+        // a variable:
+        size_t index = std::find(names.begin(), names.end(), word) - names.begin();
+        if(index == names.size()) names.push_back(word);
+        BandMathOp op = {BANDMATH_INPUT, static_cast<int>(index), 0};
+        return Code(1, op);
+      }// endif
+
+      expect("(");
+      Code a = conditional();
+      if(nargs == 1) {
+        expect(")");
+        return combine(function, a);
+      }// endif
+      expect(",");
+      Code b = conditional();
+      expect(")");
+      return combine(function, a, b);
+    }// end: primary
+
+  public:
+
+    BandMathParser(const std::string &formula, std::vector<std::string> &variables)
+      : text(formula), pos(0), names(variables) {}
+
+    // the program of the whole formula
+    Code parse() {
+      BandMathSyntaxException BandMathSyntaxError;
+      Code program = conditional();
+      skip_space();
+      if(pos != text.size()) throw BandMathSyntaxError;
+      return program;
+    }// end: parse
+
+  }; // end class: BandMathParser
+
+
+
+  BandMath::BandMath(const std::string &text)
+    : formula(text), output_nodata(std::numeric_limits<float>::quiet_NaN()), nthreads(0) {
+
+    BandMathParser parser(formula, names);
+    program = parser.parse();
+
+    inputs.assign(names.size(), NULL);
+    input_has_nodata.assign(names.size(), false);
+    input_nodata.assign(names.size(), 0);
+
+    stack_depth = 0;
+    int top = 0;
+    for(size_t i=0; i<program.size(); ++i) {
+      top += 1 - operand_count(program[i].code);
+      stack_depth = std::max(stack_depth, top);
+    }// endfor: i
+
+  }// end-BandMath-constructor
+
+
+
+  int BandMath::variable_index(const std::string &name) const {
+    for(size_t k=0; k<names.size(); ++k) if(names[k] == name) return k;
+    return -1;
+  }// end: variable_index
+
+
+
+  void BandMath::set_input(const std::string &name, const Raster *ras) {
+    BandMathInputException BandMathInputError;
+    const int k = variable_index(name);
+    if(k < 0) throw BandMathInputError;
+    inputs[k] = ras;
+    input_has_nodata[k] = false;
+  }// end: set_input
+
+
+
+  void BandMath::set_input(const std::string &name, const Raster *ras, const float &nodata) {
+    set_input(name, ras);
+    const int k = variable_index(name);
+    input_has_nodata[k] = true;
+    input_nodata[k] = nodata;
+  }// end: set_input
+
+
+
+  void BandMath::evaluate_strip(const float *const *in, const long int &n, float *out,
+                                std::vector<float> &temps) const {
+    // stack position 0 is computed straight into out, the others into temps:
+    if(temps.size() < (size_t)(stack_depth*n)) temps.resize(stack_depth*n);
+    std::vector<float *> dst(stack_depth+1);
+    dst[0] = out;
+    for(int k=1; k<stack_depth; ++k) dst[k] = &temps[k*n];
+
+    std::vector<BandMathOperand> stack(stack_depth+1);
+    int top = 0;
+    for(size_t i=0; i<program.size(); ++i) {
+      const BandMathOp &op = program[i];
+      if(op.code == BANDMATH_INPUT) {
+        stack[top].p = in[op.input];
+        ++top;
+      } else if(op.code == BANDMATH_CONST || op.code == BANDMATH_NODATA) {
+        stack[top].p = NULL;
+        stack[top].v = (op.code == BANDMATH_CONST) ? op.value : output_nodata;
+        ++top;
+      } else {
+        run_op(op.code, &stack[0], top, &dst[0], n, output_nodata);
+      }// endif
+    }// endfor: i
+
+    if(stack[0].p == NULL) {
+      std::fill(out, out+n, stack[0].v);
+    } else if(stack[0].p != out) {
+      std::copy(stack[0].p, stack[0].p+n, out);
+    }// endif
+
+    // pixels missing from any input:
+    for(size_t k=0; k<names.size(); ++k) {
+      if(!input_has_nodata[k]) continue;
+      const float *pixels = in[k];
+      const float missing = input_nodata[k];
+      const float nodata = output_nodata;
+      if(missing != missing) {
+        for(long int i=0; i<n; ++i) out[i] = (pixels[i] != pixels[i]) ? nodata : out[i];
+      } else {
+        for(long int i=0; i<n; ++i) out[i] = (pixels[i] == missing) ? nodata : out[i];
+      }// endif
+    }// endfor: k
+  }// end: evaluate_strip
+
+
+
+  void BandMath::evaluate(const std::vector<const float *> &in, const long int &n, float *out) const {
+    BandMathInputException BandMathInputError;
+    if(in.size() < names.size()) throw BandMathInputError;
+
+    std::vector<float> temps;
+    std::vector<const float *> strip(names.size());
+    for(long int i=0; i<n; i+=BANDMATH_STRIP_PIXELS) {
+      for(size_t k=0; k<names.size(); ++k) strip[k] = in[k] + i;
+      evaluate_strip(strip.empty() ? NULL : &strip[0], std::min(BANDMATH_STRIP_PIXELS, n-i), out+i, temps);
+    }// endfor: i
+  }// end: evaluate
+
+
+
+  // waits for an I/O job, if there is one, and rethrows its errors
+  static void finish_job(std::future<void> &job) {
+    if(job.valid()) job.get();
+  }// end: finish_job
+
+
+
+  void BandMath::evaluate(Raster *ras_out, const long int *blockShape) const {
+    BandMathInputException BandMathInputError;
+    RasterSizeErrorException RasterSizeError;
+    SliceSizeException SliceSizeError;
+
+    const long int nx = ras_out->get_nx();
+    const long int ny = ras_out->get_ny();
+    for(size_t k=0; k<inputs.size(); ++k) {
+      if(inputs[k] == NULL) throw BandMathInputError;
+      if(inputs[k]->get_nx() != nx || inputs[k]->get_ny() != ny) throw RasterSizeError;
+    }// endfor: k
+
+    long int shape[2];
+    if(blockShape == NULL) {
+      ras_out->default_block_shape(shape);
+    } else {
+      if(blockShape[0] < 1 || blockShape[1] < 1) throw SliceSizeError;
+      shape[0] = blockShape[0];
+      shape[1] = blockShape[1];
+    }// endif
+
+    std::vector<RasterSlice> slices;
+    for(long int y=0; y<ny; y+=shape[1])
+      for(long int x=0; x<nx; x+=shape[0])
+        slices.push_back(RasterSlice(x, y, std::min(shape[0], nx-x), std::min(shape[1], ny-y)));
+    if(slices.empty()) return;
+
+    int threads = nthreads;
+    if(threads == 0) threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    // two blocks of every input and of the output, so one block is computed while the next is read
+    // and the last written on the I/O thread:
+    const long int blockPixels = shape[0]*shape[1];
+    const size_t ninputs = inputs.size();
+    std::vector<float> in_data[2];
+    std::vector<float> out_data[2];
+    std::future<void> reads[2];
+    std::future<void> writes[2];
+    for(int b=0; b<2; ++b) {
+      in_data[b].resize(std::max(ninputs, (size_t)1)*blockPixels);
+      out_data[b].resize(blockPixels);
+    }// endfor: b
+
+    IOThread &io = IOThread::shared();
+    const std::vector<const Raster *> &sources = inputs;
+
+    try {
+      {
+        const RasterSlice slice = slices[0];
+        float *data = &in_data[0][0];
+        reads[0] = io.submit([&sources, slice, data]() {
+            for(size_t k=0; k<sources.size(); ++k) sources[k]->read(slice, data + k*slice.size(), slice.size());
+          });
+      }
+
+      for(size_t s=0; s<slices.size(); ++s) {
+        const int b = s % 2;
+        const RasterSlice slice = slices[s];
+        const long int npixels = slice.size();
+        finish_job(reads[b]);
+
+        if(s+1 < slices.size()) {
+          const RasterSlice next = slices[s+1];
+          float *data = &in_data[1-b][0];
+          reads[1-b] = io.submit([&sources, next, data]() {
+              for(size_t k=0; k<sources.size(); ++k) sources[k]->read(next, data + k*next.size(), next.size());
+            });
+        }// endif
+
+        // the write of two blocks ago used this output buffer:
+        finish_job(writes[b]);
+
+        // split the block between the threads, in whole strips:
+        const float *block = &in_data[b][0];
+        float *out = &out_data[b][0];
+        const long int nstrips = (npixels + BANDMATH_STRIP_PIXELS - 1) / BANDMATH_STRIP_PIXELS;
+        const long int perThread = (nstrips + threads - 1) / threads * BANDMATH_STRIP_PIXELS;
+
+        auto work = [this, block, npixels, out, ninputs](const long int begin, const long int end) {
+          std::vector<const float *> in(ninputs);
+          std::vector<float> temps;
+          for(long int i=begin; i<end; i+=BANDMATH_STRIP_PIXELS) {
+            for(size_t k=0; k<ninputs; ++k) in[k] = block + k*npixels + i;
+            evaluate_strip(in.empty() ? NULL : &in[0], std::min(BANDMATH_STRIP_PIXELS, end-i), out+i, temps);
+          }// endfor: i
+        };
+
+        std::vector<std::thread> workers;
+        for(long int begin=perThread; begin<npixels; begin+=perThread)
+          workers.push_back(std::thread(work, begin, std::min(begin+perThread, npixels)));
+        work(0, std::min(perThread, npixels));
+        for(size_t t=0; t<workers.size(); ++t) workers[t].join();
+
+        writes[b] = io.submit([ras_out, slice, out]() {
+            ras_out->write(slice, out, slice.size());
+          });
+      }// endfor: s
+
+      finish_job(writes[0]);
+      finish_job(writes[1]);
+    } catch(...) {
+      // don't leave jobs running on the buffers:
+      for(int b=0; b<2; ++b) {
+        if(reads[b].valid()) reads[b].wait();
+        if(writes[b].valid()) writes[b].wait();
+      }// endfor: b
+      throw;
+    }// endtry
+  }// end: evaluate
+
+}// end namespace GeoStar
@@ -0,0 +1,185 @@
+// BandMath.hpp
+//
+// raster formulas given as text, e.g. "(b5 - b4) / (b5 + b4)", compiled
+// once and evaluated over all their input rasters in a single tiled pass.
+//
+//----------------------------------------
+#ifndef BANDMATH_HPP_
+#define BANDMATH_HPP_
+
+#include <string>
+#include <vector>
+
+#include "Exceptions.hpp"
+#include "Raster.hpp"
+
+
+namespace GeoStar {
+
+  // operations of a compiled formula, run on a stack of pixel arrays
+  enum BandMathOpCode {
+    BANDMATH_INPUT, BANDMATH_CONST, BANDMATH_NODATA,
+    BANDMATH_NEG, BANDMATH_NOT, BANDMATH_ABS, BANDMATH_SQRT, BANDMATH_EXP, BANDMATH_LOG,
+    BANDMATH_ADD, BANDMATH_SUB, BANDMATH_MUL, BANDMATH_DIV, BANDMATH_POW, BANDMATH_MIN, BANDMATH_MAX,
+    BANDMATH_LT, BANDMATH_LE, BANDMATH_GT, BANDMATH_GE, BANDMATH_EQ, BANDMATH_NE,
+    BANDMATH_AND, BANDMATH_OR,
+    BANDMATH_SELECT
+  };
+
+  // one step of a compiled formula
+  struct BandMathOp {
+    BandMathOpCode code;
+    int input;     // BANDMATH_INPUT: index of the variable
+    float value;   // BANDMATH_CONST: the constant
+  };
+
+  // pixels each thread evaluates at a time, so the temporaries of a formula stay in cache
+  const long int BANDMATH_STRIP_PIXELS = 4096;
+
+
+  /** \brief BandMath -- a raster formula compiled from text
+
+  A BandMath is built from a formula over named variables, e.g. "(b5 - b4) / (b5 + b4)".  Each variable is
+  bound to a Raster with set_input, then evaluate() computes the formula for every pixel and writes it to an
+  output raster, reading each input once and writing the output once, however many operations the formula
+  has.  The same BandMath can be evaluated again with other inputs.
+
+ \see Raster::for_each_block, RasterExpr
+
+ \Par Formulas
+
+  numbers         1, 0.5, 1e-3
+  variables       any name of letters, digits and _ not starting with a digit, other than the names below
+  arithmetic      a + b, a - b, a * b, a / b, -a
+  comparisons     a < b, a <= b, a > b, a >= b, a == b, a != b  (1 if true, 0 if false)
+  logic           a && b, a || b, !a  (non-zero is true)
+  conditional     cond ? a : b
+  functions       abs(a), sqrt(a), exp(a), log(a), pow(a, b), min(a, b), max(a, b)
+  nodata          the output nodata value
+
+  Operators have the precedence they have in C.  Everything is computed in float.
+
+ \Par Nodata
+  A variable bound with a nodata value marks those pixels as missing: wherever any input is nodata the output
+  is the output nodata value (set_nodata, NaN unless set).  Division by zero also gives the output nodata value.
+
+ \Par Example
+  NDVI of two bands, with 0 marking missing pixels and water masked out:
+  \code
+  GeoStar::BandMath ndvi("b4 + b5 > 0 ? (b5 - b4) / (b5 + b4) : nodata");
+  ndvi.set_input("b4", red, 0);
+  ndvi.set_input("b5", nir, 0);
+  ndvi.set_nodata(-2);
+  ndvi.evaluate(out);
+  \endcode
+
+ \Par Details
+  The formula is parsed once into a short program for a stack machine; parts that are constant are computed
+  then.  evaluate() walks the output in blocks.  All the inputs of a block are read, and the block written,
+  on the shared I/O thread (IOThread::shared()), since HDF5 is not thread-safe; the next block is read while
+  the current one is computed.  A block is split between the threads, and each thread runs the program on
+  BANDMATH_STRIP_PIXELS pixels at a time, one operation over the whole strip before the next, which are
+  plain loops over float arrays the compiler can vectorise.
+  */
+  class BandMath {
+
+  private:
+    std::string formula;
+    std::vector<BandMathOp> program;
+
+    // variables in the order they first appear in the formula, and what they are bound to:
+    std::vector<std::string> names;
+    std::vector<const Raster *> inputs;
+    std::vector<bool> input_has_nodata;
+    std::vector<float> input_nodata;
+
+    float output_nodata;
+    int nthreads;
+
+    // deepest the stack of the program gets
+    int stack_depth;
+
+    // index of variable name, -1 if the formula does not use it
+    int variable_index(const std::string &name) const;
+
+    // runs the program on n pixels of every input (in[k] for variable k) into out
+    void evaluate_strip(const float *const *in, const long int &n, float *out, std::vector<float> &temps) const;
+
+  public:
+
+    /** \brief BandMath Constructor -- compiles a formula
+
+    \param[in] text
+	The formula, see above.
+
+    \Par Exceptions
+	BandMathSyntaxException if the formula can not be parsed.
+    */
+    BandMath(const std::string &text);
+
+    // get_formula: the formula as given
+    inline std::string get_formula() const { return formula; }
+
+    // get_variables: names of the variables of the formula, in the order they appear
+    inline const std::vector<std::string> &get_variables() const { return names; }
+
+    /** \brief set_input -- binds a variable of the formula to a raster
+
+    \param[in] name
+	Name of the variable.
+
+    \param[in] ras
+	The raster; it must be the size of the output.
+
+    \param[in] nodata
+	(Optional) Pixel value of ras that means no data; NaN to treat NaN pixels as missing.
+
+    \Par Exceptions
+	BandMathInputException if the formula has no variable of that name.
+    */
+    void set_input(const std::string &name, const Raster *ras);
+    void set_input(const std::string &name, const Raster *ras, const float &nodata);
+
+    // set_nodata: output value of pixels that are missing in an input, or divided by zero.  NaN by default.
+    inline void set_nodata(const float &nodata) { output_nodata = nodata; }
+    inline float get_nodata() const { return output_nodata; }
+
+    // set_threads: number of threads computing the blocks; 0 (the default) uses one per core.
+    inline void set_threads(const int &n) { nthreads = (n < 0) ? 0 : n; }
+
+    /** \brief evaluate -- computes the formula into a raster
+
+    \param[out] ras_out
+	Raster receiving the result, converted to its own type as write converts floats.
+
+    \param[in] blockShape
+	(Optional) x-size, y-size of the blocks, or NULL for ras_out->default_block_shape.
+
+    \Par Exceptions
+	BandMathInputException if a variable is not bound, RasterSizeErrorException if an input is not the size
+	of ras_out, SliceSizeException if a block size is less than 1.
+    */
+    void evaluate(Raster *ras_out, const long int *blockShape = NULL) const;
+
+    /** \brief evaluate -- computes the formula on pixels in memory
+
+    \param[in] in
+	One array of n pixels per variable, in the order of get_variables().
+
+    \param[in] n
+	Number of pixels.
+
+    \param[out] out
+	n results.
+
+    \Par Exceptions
+	BandMathInputException if in does not have an array for every variable.
+    */
+    void evaluate(const std::vector<const float *> &in, const long int &n, float *out) const;
+
+  }; // end class: BandMath
+
+}// end namespace GeoStar
+
+
+#endif // BANDMATH_HPP_
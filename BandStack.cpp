@@ -0,0 +1,202 @@
+// BandStack.cpp
+//
+// Implementations for multi-band raster functions
+// Documentation in BandStack.hpp
+//--------------------------------------------
+
+
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "H5Cpp.h"
+#include "Exceptions.hpp"
+#include "Image.hpp"
+#include "BandStack.hpp"
+#include "compression.hpp"
+#include "attributes.hpp"
+
+
+namespace GeoStar {
+
+  BandStack::BandStack(Image *image, const std::string &name) {
+    RasterOpenErrorException RasterOpenError;
+    RasterDoesNotExistException RasterDoesNotExist;
+
+    if(!image->datasetExists(name)) throw RasterDoesNotExist;
+
+    // check if its a valid band stack:
+    stackobj = new H5::DataSet(image->openDataset(name));
+    if(read_object_type() != "geostar::bandstack" || !raster_type_of(*stackobj, stack_datatype)) {
+      delete stackobj;
+      throw RasterOpenError;
+    }//endif
+
+    file_space = stackobj->getSpace();
+    if(file_space.getSimpleExtentNdims() != 3) {
+      delete stackobj;
+      throw RasterOpenError;
+    }//endif
+    hsize_t dims[3];
+    file_space.getSimpleExtentDims(dims);
+    stack_nbands = dims[0];
+    stack_ny = dims[1];
+    stack_nx = dims[2];
+
+    stackname = name;
+    stacktype = "geostar::bandstack";
+    stack_h5type = Raster::getHdf5FileType(stack_datatype);
+
+  }// end-BandStack-constructor
+
+
+
+  BandStack::BandStack(Image *image, const std::string &name, const RasterType &type,
+                       const int &nbands, const int &nx, const int &ny, const RasterLayout &layout) {
+
+    RasterCreationErrorException RasterCreationError;
+    RasterExistsException RasterExistsError;
+    FileReadOnlyException FileReadOnlyError;
+
+    if(image->is_readonly()) throw FileReadOnlyError;
+    if(image->datasetExists(name)) throw RasterExistsError;
+    if(nbands < 1 || layout.size < 0) throw RasterCreationError;
+    // filters only work on chunked datasets:
+    if(layout.type == CONTIGUOUS && layout.compression != COMPRESS_NONE) throw RasterCreationError;
+
+    H5::DataType h5Type = Raster::getHdf5FileType(type);
+
+    // create a 3D dataset, bands first
+    hsize_t dims[3];
+    dims[0] = nbands;
+    dims[1] = ny;
+    dims[2] = nx;
+    H5::DataSpace dataspace(3, dims);
+
+    // chunked layouts: as for Raster, but a chunk holds every band of its pixels
+    H5::DSetCreatPropList plist;
+    if(layout.type != CONTIGUOUS && nx > 0 && ny > 0) {
+      const hsize_t chunkPixels = chunk_cache_bytes(image) / RASTER_CHUNKS_PER_CACHE / (h5Type.getSize()*nbands);
+      hsize_t chunk[3];
+      chunk[0] = nbands;
+
+      if(layout.type == ROW_CHUNKED) {
+        chunk[1] = layout.size;
+        if(chunk[1] == 0) chunk[1] = chunkPixels / nx;
+        chunk[2] = nx;
+      } else if(layout.type == TILED) {
+        hsize_t tile = layout.size;
+        if(tile == 0) {
+          // largest power of 2 that fits:
+          tile = 16;
+          while(4*tile*tile <= chunkPixels) tile *= 2;
+        }// endif
+        chunk[1] = tile;
+        chunk[2] = tile;
+      } else {
+        throw RasterCreationError;
+      }// endif
+
+      // chunks can't be bigger than the stack:
+      chunk[1] = std::max(std::min(chunk[1], dims[1]), (hsize_t)1);
+      chunk[2] = std::max(std::min(chunk[2], dims[2]), (hsize_t)1);
+      plist.setChunk(3, chunk);
+
+      if(layout.compression == COMPRESS_AUTO) {
+        set_compression(plist, COMPRESS_DEFLATE, layout.level);
+      } else {
+        set_compression(plist, layout.compression, layout.level);
+      }// endif
+    }// endif
+
+    stackobj = new H5::DataSet(image->createDataset(name, h5Type, dataspace, plist));
+
+    stackname = name;
+    stacktype = "geostar::bandstack";
+    stack_datatype = type;
+    stack_h5type = h5Type;
+    stack_nbands = nbands;
+    stack_nx = nx;
+    stack_ny = ny;
+    file_space = stackobj->getSpace();
+
+    // set objtype attribute.
+    write_object_type(stacktype);
+
+  }// end-BandStack-constructor
+
+
+
+  void BandStack::default_block_shape(long int *blockShape) const {
+    blockShape[0] = std::max(stack_nx, 1L);
+    blockShape[1] = RASTER_BLOCK_PIXELS / stack_nbands / blockShape[0];
+
+    H5::DSetCreatPropList plist = stackobj->getCreatePlist();
+    if(plist.getLayout() == H5D_CHUNKED) {
+      hsize_t chunk[3];
+      plist.getChunk(3, chunk);
+      const long int chunkRows = chunk[1];
+      blockShape[1] = std::max(blockShape[1] / chunkRows, 1L) * chunkRows;
+    }// endif
+
+    if(blockShape[1] > stack_ny) blockShape[1] = stack_ny;
+    if(blockShape[1] < 1)        blockShape[1] = 1;
+  }// end: default_block_shape
+
+
+
+  void BandStack::check_block(const long int &band0, const long int &nb, const RasterSlice &slice,
+                              const size_t &length) const {
+    SliceSizeException SliceSizeError;
+
+    if(band0 < 0 || nb < 0 || band0+nb > stack_nbands) throw SliceSizeError;
+    if(slice.x0 < 0 || slice.y0 < 0 || slice.dx < 0 || slice.dy < 0) throw SliceSizeError;
+    if(slice.x0+slice.dx > stack_nx || slice.y0+slice.dy > stack_ny) throw SliceSizeError;
+    if(length < (size_t)(nb*slice.size())) throw SliceSizeError;
+  }// end: check_block
+
+
+
+  void BandStack::read_block(const long int &band0, const long int &nb, const RasterSlice &slice,
+                             void *buffer, const H5::DataType &memType) const {
+    if(nb*slice.size() == 0) return;
+
+    hsize_t start[3];
+    hsize_t count[3];
+    start[0] = band0;
+    start[1] = slice.y0;
+    start[2] = slice.x0;
+    count[0] = nb;
+    count[1] = slice.dy;
+    count[2] = slice.dx;
+    file_space.selectHyperslab(H5S_SELECT_SET, count, start);
+    H5::DataSpace memspace(3, count);
+    stackobj->read(buffer, memType, memspace, file_space);
+
+    Raster::io_counters().read_calls++;
+    Raster::io_counters().bytes_read += nb * slice.size() * memType.getSize();
+  }// end: read_block
+
+
+
+  void BandStack::write_block(const long int &band0, const long int &nb, const RasterSlice &slice,
+                              const void *buffer, const H5::DataType &memType) const {
+    if(nb*slice.size() == 0) return;
+
+    hsize_t start[3];
+    hsize_t count[3];
+    start[0] = band0;
+    start[1] = slice.y0;
+    start[2] = slice.x0;
+    count[0] = nb;
+    count[1] = slice.dy;
+    count[2] = slice.dx;
+    file_space.selectHyperslab(H5S_SELECT_SET, count, start);
+    H5::DataSpace memspace(3, count);
+    stackobj->write(buffer, memType, memspace, file_space);
+
+    Raster::io_counters().write_calls++;
+    Raster::io_counters().bytes_written += nb * slice.size() * memType.getSize();
+  }// end: write_block
+
+}// end namespace GeoStar
@@ -0,0 +1,338 @@
+// BandStack.hpp
+//
+// several bands of an image, all the same size and type, stored in
+// one 3D dataset (bands x ny x nx) so a block of every band comes
+// back from a single HDF5 read.
+//
+//----------------------------------------
+#ifndef BANDSTACK_HPP_
+#define BANDSTACK_HPP_
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <limits>
+
+#include "H5Cpp.h"
+#include "Exceptions.hpp"
+#include "RasterType.hpp"
+#include "RasterLayout.hpp"
+#include "RasterSlice.hpp"
+#include "Raster.hpp"
+#include "attributes.hpp"
+
+
+namespace GeoStar {
+  class Image;
+
+  // nbands planes of npixels values of type F (BSQ) to pixel-interleaved T (BIP),
+  // run on the stack's own type through dispatch_raster_type
+  template<typename T>
+  struct InterleaveKernel {
+    const void *planes;
+    long int npixels;
+    long int nbands;
+    T *pixels;
+
+    InterleaveKernel(const long int &n, const long int &bands, T *out)
+      : planes(NULL), npixels(n), nbands(bands), pixels(out) {}
+
+    template<typename F>
+    void operator()(const F &) {
+      const F *from = static_cast<const F *>(planes);
+      for(long int pixel=0; pixel<npixels; ++pixel) {
+        T *to = &pixels[pixel*nbands];
+        for(long int band=0; band<nbands; ++band) to[band] = static_cast<T>(from[band*npixels+pixel]);
+      }// endfor: pixel
+    }// end: operator()
+  }; // end: InterleaveKernel
+
+
+  /** \brief BandStack -- Class for multi-band images stored as one 3D HDF5 dataset
+
+  A BandStack holds nbands bands of nx by ny pixels in a dataset of shape (nbands, ny, nx).  Chunked layouts
+  put every band of a tile in the same chunk, so reading a block of all the bands is one HDF5 read of whole
+  chunks, where separate Rasters need one read per band.
+
+ \see Raster, Image::create_bandstack, Image::open_bandstack, Image::read_file_bands
+
+ \Par Usage Overview
+
+  Blocks can be read and written in two orders:
+
+  BSQ (band sequential) - all of band 0 of the block, then all of band 1, ...: read_bsq, write_bsq.
+
+  BIP (band interleaved by pixel) - all the bands of pixel 0, then all the bands of pixel 1, ...: read_bip, write_bip.
+  This is the order per-pixel computations (indices, classification) want.
+
+  Both read the block with one HDF5 call; BIP is then interleaved in memory, since HDF5 itself can not
+  reorder the elements of a selection.
+
+  To close, delete the BandStack and then delete the Image, then the File.
+
+ \Par Example
+  NDVI from bands 2 (red) and 3 (near infrared) of a stack:
+  \code
+  GeoStar::BandStack *stack = img->open_bandstack("landsat");
+  GeoStar::Raster *ndvi = img->create_raster("ndvi", GeoStar::REAL32, stack->get_nx(), stack->get_ny());
+  const long int nbands = stack->get_nbands();
+
+  stack->for_each_block<float>(NULL, ndvi,
+    [nbands](const std::vector<long int> &slice, const std::vector<float> &pixels, std::vector<float> &out) {
+      for(long int i=0; i<slice[2]*slice[3]; ++i) {
+        const float red = pixels[i*nbands+2];
+        const float nir = pixels[i*nbands+3];
+        out[i] = (nir+red != 0) ? (nir-red)/(nir+red) : 0;
+      }
+    });
+  \endcode
+  */
+  class BandStack {
+
+  private:
+    std::string stackname;
+    std::string stacktype;
+    RasterType  stack_datatype;
+
+    // HDF5 type of the pixels in the file:
+    H5::DataType stack_h5type;
+
+    // extent of the dataset:
+    long int stack_nbands;
+    long int stack_nx;
+    long int stack_ny;
+
+    // dataspace of the dataset, re-selected for every block:
+    mutable H5::DataSpace file_space;
+
+    // bands [band0, band0+nb) of slice, in BSQ order, one HDF5 call each:
+    void read_block(const long int &band0, const long int &nb, const RasterSlice &slice,
+                    void *buffer, const H5::DataType &memType) const;
+    void write_block(const long int &band0, const long int &nb, const RasterSlice &slice,
+                     const void *buffer, const H5::DataType &memType) const;
+
+    // throws unless the slice and bands are inside the stack and length holds them
+    void check_block(const long int &band0, const long int &nb, const RasterSlice &slice,
+                     const size_t &length) const;
+
+    BandStack(const BandStack &);
+    BandStack &operator=(const BandStack &);
+
+  public:
+    H5::DataSet *stackobj;
+
+    /** \brief BandStack Constructor -- opens an existing band stack
+
+    \param[in] image
+	The image that holds the stack.
+
+    \param[in] name
+	Name of the stack.
+
+    \Par Exceptions
+	RasterDoesNotExist, RasterOpenError (not a 3D GeoStar band stack)
+    */
+    BandStack(Image *image, const std::string &name);
+
+    /** \brief BandStack Constructor -- creates a new band stack
+
+    \param[in] image
+	The image that holds the stack.
+
+    \param[in] name
+	Name of the new stack.
+
+    \param[in] type
+	Pixel type of every band; any RasterType.
+
+    \param[in] nbands, nx, ny
+	Number of bands and size of each band.
+
+    \param[in] layout
+	As for Raster: CONTIGUOUS, ROW_CHUNKED or TILED, with optional compression.  Chunks always span all
+	the bands; a layout.size of 0 sizes them to the file's chunk cache, counting the bytes of every band.
+
+    \Par Exceptions
+	RasterExistsError, RasterCreationError, FileReadOnlyException
+    */
+    BandStack(Image *image, const std::string &name, const RasterType &type,
+              const int &nbands, const int &nx, const int &ny,
+              const RasterLayout &layout = RasterLayout());
+
+    inline ~BandStack() {
+      delete stackobj;
+    }
+
+    inline void write_object_type(const std::string &value) {
+      GeoStar::write_object_type((H5::H5Location *)stackobj,value);
+    }
+
+    inline std::string read_object_type() const {
+      return GeoStar::read_object_type((H5::H5Location *)stackobj);
+    }
+
+    inline long int get_nbands() const { return stack_nbands; }
+    inline long int get_nx() const { return stack_nx; }
+    inline long int get_ny() const { return stack_ny; }
+    inline RasterType get_datatype() const { return stack_datatype; }
+
+    /** \brief default_block_shape -- block shape used by for_each_block
+
+	Bands of whole rows holding about RASTER_BLOCK_PIXELS values over all the bands, rounded to
+	whole chunks when the stack is chunked.
+    */
+    void default_block_shape(long int *blockShape) const;
+
+    /** \brief read_bsq -- reads slice of every band, band after band
+
+    \param[in] slice
+	x0, y0, dx, dy of the block.
+
+    \param[out] buffer
+	At least nbands*dx*dy values: buffer[(band*dy + y)*dx + x].
+
+    \param[in] length
+	Number of values buffer holds.
+
+    \Par Exceptions
+	SliceSizeException if the slice is outside the stack or does not fit in buffer.
+    */
+    template<typename T>
+    void read_bsq(const RasterSlice &slice, T *buffer, const size_t &length) const {
+      check_block(0, stack_nbands, slice, length);
+      read_block(0, stack_nbands, slice, (void *)buffer, Raster::getHdf5Type<T>());
+    }// end: read_bsq
+
+    // write_bsq: writes slice of every band from buffer, laid out as for read_bsq
+    template<typename T>
+    void write_bsq(const RasterSlice &slice, const T *buffer, const size_t &length) {
+      check_block(0, stack_nbands, slice, length);
+      write_block(0, stack_nbands, slice, (const void *)buffer, Raster::getHdf5Type<T>());
+    }// end: write_bsq
+
+    // read_band: slice of a single band, laid out like a Raster slice
+    template<typename T>
+    void read_band(const long int &band, const RasterSlice &slice, T *buffer, const size_t &length) const {
+      check_block(band, 1, slice, length);
+      read_block(band, 1, slice, (void *)buffer, Raster::getHdf5Type<T>());
+    }// end: read_band
+
+    // write_band: writes slice of a single band
+    template<typename T>
+    void write_band(const long int &band, const RasterSlice &slice, const T *buffer, const size_t &length) {
+      check_block(band, 1, slice, length);
+      write_block(band, 1, slice, (const void *)buffer, Raster::getHdf5Type<T>());
+    }// end: write_band
+
+    /** \brief read_bip -- reads slice of every band, pixel after pixel
+
+    \param[in] slice
+	x0, y0, dx, dy of the block.
+
+    \param[out] buffer
+	Resized if needed to nbands*dx*dy values: buffer[(y*dx + x)*nbands + band].
+
+    \param[in,out] scratch
+	Work space for the BSQ read, resized as needed.  Passing the same vector for every block saves
+	an allocation per block.
+
+    \Par Exceptions
+	SliceSizeException if the slice is outside the stack.
+
+    \Par Details
+	Into a float or double buffer the block is read in the stack's own type and converted while it is
+	interleaved, which is the same conversion HDF5 would do, in one pass instead of two.  Integer
+	buffers are converted by HDF5, which clamps out-of-range values.
+    */
+    template<typename T>
+    void read_bip(const RasterSlice &slice, std::vector<T> &buffer, std::vector<char> &scratch) const {
+      const size_t nvalues = stack_nbands*slice.size();
+      check_block(0, stack_nbands, slice, nvalues);
+      if(nvalues == 0) return;
+      if(buffer.size() < nvalues) buffer.resize(nvalues);
+
+      InterleaveKernel<T> kernel(slice.size(), stack_nbands, &buffer[0]);
+      if(!std::numeric_limits<T>::is_integer && !is_complex(stack_datatype)) {
+        if(scratch.size() < nvalues*stack_h5type.getSize()) scratch.resize(nvalues*stack_h5type.getSize());
+        read_block(0, stack_nbands, slice, (void *)&scratch[0], stack_h5type);
+        kernel.planes = &scratch[0];
+        dispatch_raster_type(stack_datatype, kernel);
+      } else {
+        if(scratch.size() < nvalues*sizeof(T)) scratch.resize(nvalues*sizeof(T));
+        read_block(0, stack_nbands, slice, (void *)&scratch[0], Raster::getHdf5Type<T>());
+        kernel.planes = &scratch[0];
+        kernel(T());
+      }// endif
+    }// end: read_bip
+
+    // write_bip: writes slice of every band from buffer, laid out as for read_bip.
+    //            Throws SliceSizeException if buffer holds fewer than nbands*dx*dy values.
+    template<typename T>
+    void write_bip(const RasterSlice &slice, const std::vector<T> &buffer, std::vector<char> &scratch) {
+      SliceSizeException SliceSizeError;
+      const size_t nvalues = stack_nbands*slice.size();
+      if(buffer.size() < nvalues) throw SliceSizeError;
+      if(nvalues == 0) return;
+      if(scratch.size() < nvalues*sizeof(T)) scratch.resize(nvalues*sizeof(T));
+
+      const long int npixels = slice.size();
+      T *planes = reinterpret_cast<T *>(&scratch[0]);
+      for(long int pixel=0; pixel<npixels; ++pixel) {
+        const T *from = &buffer[pixel*stack_nbands];
+        for(long int band=0; band<stack_nbands; ++band) planes[band*npixels+pixel] = from[band];
+      }// endfor: pixel
+      write_bsq(slice, planes, nvalues);
+    }// end: write_bip
+
+    /** \brief for_each_block -- walks the stack in blocks of every band, writing one output raster
+
+    Reads each block in BIP order with one HDF5 call and calls fn(slice, pixels, out), where pixels holds
+	nbands values per pixel and out has one value per pixel of the block; out is then written to the same
+	slice of ras_out.
+
+    \param[in] blockShape
+	x-size, y-size of the blocks, or NULL for default_block_shape.
+
+    \param[out] ras_out
+	Raster the size of one band, receiving the output of fn.
+
+    \Par Exceptions
+	RasterSizeErrorException if ras_out is not the size of a band.
+    */
+    template<typename T, typename Function>
+    void for_each_block(const long int *blockShape, Raster *ras_out, Function fn) const {
+      RasterSizeErrorException RasterSizeError;
+      SliceSizeException SliceSizeError;
+      if(ras_out->get_nx() != stack_nx || ras_out->get_ny() != stack_ny) throw RasterSizeError;
+
+      long int shape[2];
+      if(blockShape == NULL) {
+        default_block_shape(shape);
+      } else {
+        if(blockShape[0] < 1 || blockShape[1] < 1) throw SliceSizeError;
+        shape[0] = blockShape[0];
+        shape[1] = blockShape[1];
+      }// endif
+
+      std::vector<T> pixels, out(shape[0]*shape[1]);
+      std::vector<char> scratch;
+      std::vector<long int> slice(4);
+      for(long int y=0; y<stack_ny; y+=shape[1]) {
+        for(long int x=0; x<stack_nx; x+=shape[0]) {
+          slice[0] = x;
+          slice[1] = y;
+          slice[2] = std::min(shape[0], stack_nx-x);
+          slice[3] = std::min(shape[1], stack_ny-y);
+          read_bip(RasterSlice(slice), pixels, scratch);
+          fn(slice, pixels, out);
+          ras_out->write(RasterSlice(slice), &out[0], out.size());
+        }// endfor: x
+      }// endfor: y
+    }// end: for_each_block
+
+  }; // end class: BandStack
+
+}// end namespace GeoStar
+
+
+#endif // BANDSTACK_HPP_
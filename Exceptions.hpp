@@ -66,6 +66,13 @@ namespace GeoStar {
                 return "FileDestroyError";
             }
     };
+    class FileReadOnlyException: public exception
+    {
+        virtual const char* what() const throw()
+            {
+                return "FileReadOnly";
+            }
+    };
 
 
     class ImageExistsException: public exception
@@ -373,6 +380,22 @@ namespace GeoStar {
           }
     };
 
+    // BandMath formulas
+    class BandMathSyntaxException: public exception
+    {
+      virtual const char* what() const throw()
+          {
+              return "BandMathSyntaxError";
+          }
+    };
+    class BandMathInputException: public exception
+    {
+      virtual const char* what() const throw()
+          {
+              return "BandMathInputError";
+          }
+    };
+
 	class RadiusSizeException: public exception
     {
       virtual const char* what() const throw()
@@ -381,6 +404,15 @@ namespace GeoStar {
           }
     };
 
+    // frequency-domain filters
+    class FrequencyParameterException: public exception
+    {
+      virtual const char* what() const throw()
+          {
+              return "FrequencyParameterError";
+          }
+    };
+
 
 
 
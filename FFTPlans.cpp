@@ -0,0 +1,302 @@
+// FFTPlans.cpp
+//
+// a cache of FFTW plans, keyed by the size, direction, type and precision
+// of the transform, with FFTW wisdom kept in files next to the HDF5 files.
+//
+//----------------------------------------
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <thread>
+#include <algorithm>
+
+#include <fftw3.h>
+
+#include "FFTPlans.hpp"
+
+#include "boost/filesystem.hpp"
+
+
+namespace GeoStar {
+
+  // kinds of plans:
+  enum FFTPlanKind { PLAN_DFT_1D, PLAN_R2C_2D, PLAN_C2R_2D, PLAN_MANY_DFT, PLAN_MANY_R2C, PLAN_MANY_C2R };
+
+
+
+  // the FFTW planner in each precision, picked by the types of the arrays:
+
+  static fftw_plan plan_dft_1d(int n, fftw_complex *in, fftw_complex *out, int sign, unsigned flags) {
+    return fftw_plan_dft_1d(n, in, out, sign, flags);
+  }
+  static fftwf_plan plan_dft_1d(int n, fftwf_complex *in, fftwf_complex *out, int sign, unsigned flags) {
+    return fftwf_plan_dft_1d(n, in, out, sign, flags);
+  }
+
+  static fftw_plan plan_r2c_2d(int ny, int nx, double *in, fftw_complex *out, unsigned flags) {
+    return fftw_plan_dft_r2c_2d(ny, nx, in, out, flags);
+  }
+  static fftwf_plan plan_r2c_2d(int ny, int nx, float *in, fftwf_complex *out, unsigned flags) {
+    return fftwf_plan_dft_r2c_2d(ny, nx, in, out, flags);
+  }
+
+  static fftw_plan plan_c2r_2d(int ny, int nx, fftw_complex *in, double *out, unsigned flags) {
+    return fftw_plan_dft_c2r_2d(ny, nx, in, out, flags);
+  }
+  static fftwf_plan plan_c2r_2d(int ny, int nx, fftwf_complex *in, float *out, unsigned flags) {
+    return fftwf_plan_dft_c2r_2d(ny, nx, in, out, flags);
+  }
+
+  // howmany rows of n, contiguous, dist n apart (nh for the half spectra):
+  static fftw_plan plan_many_dft(int n, int howmany, fftw_complex *in, fftw_complex *out, int sign, unsigned flags) {
+    return fftw_plan_many_dft(1, &n, howmany, in, NULL, 1, n, out, NULL, 1, n, sign, flags);
+  }
+  static fftwf_plan plan_many_dft(int n, int howmany, fftwf_complex *in, fftwf_complex *out, int sign, unsigned flags) {
+    return fftwf_plan_many_dft(1, &n, howmany, in, NULL, 1, n, out, NULL, 1, n, sign, flags);
+  }
+
+  static fftw_plan plan_many_r2c(int n, int howmany, double *in, fftw_complex *out, unsigned flags) {
+    return fftw_plan_many_dft_r2c(1, &n, howmany, in, NULL, 1, n, out, NULL, 1, n/2 + 1, flags);
+  }
+  static fftwf_plan plan_many_r2c(int n, int howmany, float *in, fftwf_complex *out, unsigned flags) {
+    return fftwf_plan_many_dft_r2c(1, &n, howmany, in, NULL, 1, n, out, NULL, 1, n/2 + 1, flags);
+  }
+
+  static fftw_plan plan_many_c2r(int n, int howmany, fftw_complex *in, double *out, unsigned flags) {
+    return fftw_plan_many_dft_c2r(1, &n, howmany, in, NULL, 1, n/2 + 1, out, NULL, 1, n, flags);
+  }
+  static fftwf_plan plan_many_c2r(int n, int howmany, fftwf_complex *in, float *out, unsigned flags) {
+    return fftwf_plan_many_dft_c2r(1, &n, howmany, in, NULL, 1, n/2 + 1, out, NULL, 1, n, flags);
+  }
+
+  static void destroy_plan(fftw_plan plan) { fftw_destroy_plan(plan); }
+  static void destroy_plan(fftwf_plan plan) { fftwf_destroy_plan(plan); }
+
+  static void plan_with_nthreads(const int &threads, double) { fftw_plan_with_nthreads(threads); }
+  static void plan_with_nthreads(const int &threads, float) { fftwf_plan_with_nthreads(threads); }
+
+  static void import_wisdom(const std::string &file, double) { fftw_import_wisdom_from_filename(file.c_str()); }
+  static void import_wisdom(const std::string &file, float) { fftwf_import_wisdom_from_filename(file.c_str()); }
+
+  static void export_wisdom(const std::string &file, double) { fftw_export_wisdom_to_filename(file.c_str()); }
+  static void export_wisdom(const std::string &file, float) { fftwf_export_wisdom_to_filename(file.c_str()); }
+
+  static const std::string &wisdom_name(double) { return FFT_WISDOM_FILE; }
+  static const std::string &wisdom_name(float) { return FFT_WISDOM_FILE_SINGLE; }
+
+
+
+  // a plan of precision R for key, made on arrays of its own: planning (but for FFTW_ESTIMATE) overwrites its
+  // arrays.  fftw_malloc aligns them as the callers' arrays are, which the new-array execute functions need.
+  template<typename R>
+  static typename FFTW<R>::plan make_plan(const int &kind, const std::vector<int> &n, const int &howmany,
+                                          const int &sign, const bool &inPlace, const unsigned &flags) {
+    typedef typename FFTW<R>::complex Complex;
+    const bool twoD = (n.size() == 2);
+    const int nx = n.back();
+    const long int rows = twoD ? n[0] : howmany;
+    const long int count = rows * nx;
+    const long int half = rows * (nx/2 + 1);
+
+    typename FFTW<R>::plan plan = NULL;
+    if(kind == PLAN_DFT_1D || kind == PLAN_MANY_DFT) {
+      Complex *in = static_cast<Complex*>(fftw_malloc(sizeof(Complex) * count));
+      Complex *out = inPlace ? in : static_cast<Complex*>(fftw_malloc(sizeof(Complex) * count));
+      if(kind == PLAN_DFT_1D) plan = plan_dft_1d(nx, in, out, sign, flags);
+      else plan = plan_many_dft(nx, howmany, in, out, sign, flags);
+      if(out != in) fftw_free(out);
+      fftw_free(in);
+    } else {
+      R *real = static_cast<R*>(fftw_malloc(sizeof(R) * count));
+      Complex *spectrum = static_cast<Complex*>(fftw_malloc(sizeof(Complex) * half));
+      switch(kind) {
+      case PLAN_R2C_2D:
+        plan = plan_r2c_2d(n[0], nx, real, spectrum, flags);
+        break;
+      case PLAN_C2R_2D:
+        plan = plan_c2r_2d(n[0], nx, spectrum, real, flags);
+        break;
+      case PLAN_MANY_R2C:
+        plan = plan_many_r2c(nx, howmany, real, spectrum, flags);
+        break;
+      default:
+        plan = plan_many_c2r(nx, howmany, spectrum, real, flags);
+        break;
+      }// endswitch
+      fftw_free(spectrum);
+      fftw_free(real);
+    }// endif
+    return plan;
+  }// end: make_plan
+
+
+
+  bool FFTPlans::Key::operator<(const Key &other) const {
+    if(kind != other.kind) return kind < other.kind;
+    if(n != other.n) return n < other.n;
+    if(howmany != other.howmany) return howmany < other.howmany;
+    if(sign != other.sign) return sign < other.sign;
+    if(in_place != other.in_place) return in_place < other.in_place;
+    if(flags != other.flags) return flags < other.flags;
+    return threads < other.threads;
+  }// end: operator<
+
+
+
+  FFTPlans::FFTPlans() : effort(FFT_ESTIMATE), threads(1), hits(0), misses(0) {
+    fftw_init_threads();
+    fftwf_init_threads();
+  }// end: FFTPlans
+
+
+
+  FFTPlans::~FFTPlans() {
+    clear();
+  }// end: ~FFTPlans
+
+
+
+  template<> std::map<FFTPlans::Key, fftw_plan> &FFTPlans::cache<double>() { return plans; }
+  template<> std::map<FFTPlans::Key, fftwf_plan> &FFTPlans::cache<float>() { return plans_single; }
+
+
+
+  template<typename R>
+  typename FFTW<R>::plan FFTPlans::find(Key key) {
+    const unsigned efforts[3] = {FFTW_ESTIMATE, FFTW_MEASURE, FFTW_PATIENT};
+    key.flags = efforts[effort];
+    long int size = key.howmany;
+    for(size_t i=0; i<key.n.size(); ++i) size *= key.n[i];
+    key.threads = (size < FFT_THREADS_MIN_SIZE) ? 1 : threads;
+
+    std::map<Key, typename FFTW<R>::plan> &entries = cache<R>();
+    typename std::map<Key, typename FFTW<R>::plan>::iterator entry = entries.find(key);
+    if(entry != entries.end()) {
+      ++hits;
+      return entry->second;
+    }// endif
+
+    plan_with_nthreads(key.threads, R());
+    const typename FFTW<R>::plan plan = make_plan<R>(key.kind, key.n, key.howmany, key.sign, key.in_place, key.flags);
+    entries[key] = plan;
+    ++misses;
+    // an estimate adds nothing worth keeping to the wisdom:
+    if(effort != FFT_ESTIMATE && !wisdom_directory.empty()) export_wisdom(get_wisdom_file<R>(), R());
+    return plan;
+  }// end: find
+
+
+
+  template<typename R>
+  typename FFTW<R>::plan FFTPlans::dft_1d(const int &n, const int &sign, const bool &inPlace) {
+    Key key = {PLAN_DFT_1D, std::vector<int>(1, n), 1, sign, inPlace, 0, 1};
+    return find<R>(key);
+  }// end: dft_1d
+
+
+  template<typename R>
+  typename FFTW<R>::plan FFTPlans::r2c_2d(const int &ny, const int &nx) {
+    Key key = {PLAN_R2C_2D, std::vector<int>(1, ny), 1, FFTW_FORWARD, false, 0, 1};
+    key.n.push_back(nx);
+    return find<R>(key);
+  }// end: r2c_2d
+
+
+  template<typename R>
+  typename FFTW<R>::plan FFTPlans::c2r_2d(const int &ny, const int &nx) {
+    Key key = {PLAN_C2R_2D, std::vector<int>(1, ny), 1, FFTW_BACKWARD, false, 0, 1};
+    key.n.push_back(nx);
+    return find<R>(key);
+  }// end: c2r_2d
+
+
+  template<typename R>
+  typename FFTW<R>::plan FFTPlans::many_dft(const int &n, const int &howmany, const int &sign, const bool &inPlace) {
+    Key key = {PLAN_MANY_DFT, std::vector<int>(1, n), howmany, sign, inPlace, 0, 1};
+    return find<R>(key);
+  }// end: many_dft
+
+
+  template<typename R>
+  typename FFTW<R>::plan FFTPlans::many_r2c(const int &n, const int &howmany) {
+    Key key = {PLAN_MANY_R2C, std::vector<int>(1, n), howmany, FFTW_FORWARD, false, 0, 1};
+    return find<R>(key);
+  }// end: many_r2c
+
+
+  template<typename R>
+  typename FFTW<R>::plan FFTPlans::many_c2r(const int &n, const int &howmany) {
+    Key key = {PLAN_MANY_C2R, std::vector<int>(1, n), howmany, FFTW_BACKWARD, false, 0, 1};
+    return find<R>(key);
+  }// end: many_c2r
+
+
+  // the two precisions:
+  template fftw_plan FFTPlans::dft_1d<double>(const int &, const int &, const bool &);
+  template fftwf_plan FFTPlans::dft_1d<float>(const int &, const int &, const bool &);
+  template fftw_plan FFTPlans::r2c_2d<double>(const int &, const int &);
+  template fftwf_plan FFTPlans::r2c_2d<float>(const int &, const int &);
+  template fftw_plan FFTPlans::c2r_2d<double>(const int &, const int &);
+  template fftwf_plan FFTPlans::c2r_2d<float>(const int &, const int &);
+  template fftw_plan FFTPlans::many_dft<double>(const int &, const int &, const int &, const bool &);
+  template fftwf_plan FFTPlans::many_dft<float>(const int &, const int &, const int &, const bool &);
+  template fftw_plan FFTPlans::many_r2c<double>(const int &, const int &);
+  template fftwf_plan FFTPlans::many_r2c<float>(const int &, const int &);
+  template fftw_plan FFTPlans::many_c2r<double>(const int &, const int &);
+  template fftwf_plan FFTPlans::many_c2r<float>(const int &, const int &);
+
+
+
+  void FFTPlans::set_threads(const int &value) {
+    threads = (value > 0) ? value : std::max((int)std::thread::hardware_concurrency(), 1);
+  }// end: set_threads
+
+
+
+  void FFTPlans::use_wisdom(const std::string &directory) {
+    if(directory.empty()) {
+      wisdom_directory.clear();
+      return;
+    }// endif
+
+    wisdom_directory = directory;
+    if(wisdom_read.insert(wisdom_directory).second) {
+      // a missing file is no wisdom yet:
+      import_wisdom(get_wisdom_file<double>(), double());
+      import_wisdom(get_wisdom_file<float>(), float());
+    }// endif
+  }// end: use_wisdom
+
+
+
+  template<typename R>
+  std::string FFTPlans::get_wisdom_file() const {
+    if(wisdom_directory.empty()) return std::string();
+    return (boost::filesystem::path(wisdom_directory) / wisdom_name(R())).string();
+  }// end: get_wisdom_file
+
+  template std::string FFTPlans::get_wisdom_file<double>() const;
+  template std::string FFTPlans::get_wisdom_file<float>() const;
+
+
+
+  void FFTPlans::clear() {
+    for(std::map<Key, fftw_plan>::iterator entry = plans.begin(); entry != plans.end(); ++entry)
+      destroy_plan(entry->second);
+    for(std::map<Key, fftwf_plan>::iterator entry = plans_single.begin(); entry != plans_single.end(); ++entry)
+      destroy_plan(entry->second);
+    plans.clear();
+    plans_single.clear();
+  }// end: clear
+
+
+
+  FFTPlans &FFTPlans::shared() {
+    // never deleted, as Scratch::shared(): plans outlive every Raster
+    static FFTPlans *cache = new FFTPlans();
+    return *cache;
+  }// end: shared
+
+}// end namespace GeoStar
@@ -0,0 +1,202 @@
+// FFTPlans.hpp
+//
+// a cache of FFTW plans, keyed by the size, direction, type and precision
+// of the transform, with a planner effort and a number of threads to
+// choose and FFTW wisdom kept in files next to the HDF5 files transformed.
+//
+//----------------------------------------
+#ifndef FFTPLANS_HPP_
+#define FFTPLANS_HPP_
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+
+#include <fftw3.h>
+
+
+namespace GeoStar {
+
+  // how hard FFTW looks for a fast plan, see FFTPlans::set_effort
+  enum FFTEffort {
+
+    FFT_ESTIMATE,  // FFTW_ESTIMATE: a guess, made at once
+    FFT_MEASURE,   // FFTW_MEASURE: times a few algorithms; seconds for a large 2D transform
+    FFT_PATIENT    // FFTW_PATIENT: times many more; can take minutes
+
+  }; // end: FFTEffort
+
+  // names of the FFTW wisdom files kept in each directory of HDF5 files transformed, double and single precision
+  const std::string FFT_WISDOM_FILE = "geostar.fftw-wisdom";
+  const std::string FFT_WISDOM_FILE_SINGLE = "geostar.fftwf-wisdom";
+
+  // transforms of fewer values than this are planned for one thread whatever FFTPlans::set_threads says:
+  // the threads would cost more than they save
+  const long int FFT_THREADS_MIN_SIZE = 65536;
+
+
+  // FFTW<R>: the types and execute functions of FFTW in the precision of R, double (fftw_) or float (fftwf_)
+  template<typename R> struct FFTW;
+
+  template<> struct FFTW<double> {
+    typedef fftw_complex complex;
+    typedef fftw_plan plan;
+    static void execute_dft(const plan p, complex *in, complex *out) { fftw_execute_dft(p, in, out); }
+    static void execute_r2c(const plan p, double *in, complex *out) { fftw_execute_dft_r2c(p, in, out); }
+    static void execute_c2r(const plan p, complex *in, double *out) { fftw_execute_dft_c2r(p, in, out); }
+  }; // end: FFTW<double>
+
+  template<> struct FFTW<float> {
+    typedef fftwf_complex complex;
+    typedef fftwf_plan plan;
+    static void execute_dft(const plan p, complex *in, complex *out) { fftwf_execute_dft(p, in, out); }
+    static void execute_r2c(const plan p, float *in, complex *out) { fftwf_execute_dft_r2c(p, in, out); }
+    static void execute_c2r(const plan p, complex *in, float *out) { fftwf_execute_dft_c2r(p, in, out); }
+  }; // end: FFTW<float>
+
+
+  /** \brief FFTPlans -- the FFTW plans of the Raster FFTs, made once per size
+
+  Making an FFTW plan can take far longer than running it, all the more with a planner effort above FFT_ESTIMATE.
+  FFTPlans makes each plan the first time a transform of its size, direction, type and precision is asked for, and
+  hands the same plan back afterwards, so a batch of same-sized scenes pays for planning once.  The wisdom FFTW
+  gathers while planning is saved to files (FFT_WISDOM_FILE, and FFT_WISDOM_FILE_SINGLE for single precision) in
+  the directory of the HDF5 files transformed, and read back the next time a raster from that directory is
+  transformed: later runs get their plans at once, even with FFT_PATIENT.
+
+ \see Raster::FFT_2D, Raster::FFT_2D_Inv, FFTEffort
+
+ \Par Example
+  Plans timed once, then reused for every scene, and remembered for the next run:
+  \code
+  GeoStar::FFTPlans::shared().set_effort(GeoStar::FFT_MEASURE);
+  for(size_t i=0; i<scenes.size(); ++i) scenes[i]->FFT_2D(img, spectra[i]);
+  \endcode
+  Large transforms on every core:
+  \code
+  GeoStar::FFTPlans::shared().set_threads(0);
+  ras->FFT_2D(img, spectrum);
+  \endcode
+
+ \Par Details
+  Plans are made on arrays of their own, so planning never touches the caller's data, and run with the new-array
+  execute functions (FFTW<R>::execute_dft, execute_r2c, execute_c2r) on arrays from fftw_malloc.  The plan functions
+  take the precision as a template argument: dft_1d(n, sign) plans in double precision, dft_1d<float>(n, sign) in
+  single precision, with fftwf.  Plans belong to the cache: callers must not destroy them.  They last until clear
+  or the end of the program.  The many-transform plans are of howmany contiguous rows of n values each, dist n
+  apart (nx/2+1 for the half spectra of r2c and c2r).
+
+  The threads of set_threads are FFTW's own, used inside each plan of FFT_THREADS_MIN_SIZE values or more.  An
+  FFTPlans, like FFTW's planner, is used from one thread at a time.
+  */
+  class FFTPlans {
+
+  private:
+    // the kind of transform, its sizes and options: what a plan is made for
+    struct Key {
+      int kind;
+      std::vector<int> n;
+      int howmany;
+      int sign;
+      bool in_place;
+      unsigned flags;
+      int threads;
+
+      bool operator<(const Key &other) const;
+    };
+
+    std::map<Key, fftw_plan> plans;          // double precision
+    std::map<Key, fftwf_plan> plans_single;  // single precision
+    FFTEffort effort;
+    int threads;
+    std::set<std::string> wisdom_read;  // wisdom directories already read
+    std::string wisdom_directory;       // where new wisdom goes; empty for nowhere
+    unsigned long hits;
+    unsigned long misses;
+
+    // the plans of precision R
+    template<typename R> std::map<Key, typename FFTW<R>::plan> &cache();
+
+    // the plan of key in precision R, made (and the wisdom saved) if it is not in the cache yet
+    template<typename R> typename FFTW<R>::plan find(Key key);
+
+    FFTPlans(const FFTPlans &);
+    FFTPlans &operator=(const FFTPlans &);
+
+  public:
+
+    // readies FFTW's threads
+    FFTPlans();
+
+    // destroys every plan
+    ~FFTPlans();
+
+    // dft_1d: n complex values to n, sign FFTW_FORWARD or FFTW_BACKWARD
+    template<typename R = double>
+    typename FFTW<R>::plan dft_1d(const int &n, const int &sign, const bool &inPlace = false);
+
+    // r2c_2d, c2r_2d: ny rows of nx real values to the ny rows of nx/2+1 of their half spectrum, and back
+    template<typename R = double> typename FFTW<R>::plan r2c_2d(const int &ny, const int &nx);
+    template<typename R = double> typename FFTW<R>::plan c2r_2d(const int &ny, const int &nx);
+
+    // many_dft, many_r2c, many_c2r: the 1D transforms of howmany rows of n values
+    template<typename R = double>
+    typename FFTW<R>::plan many_dft(const int &n, const int &howmany, const int &sign, const bool &inPlace = false);
+    template<typename R = double> typename FFTW<R>::plan many_r2c(const int &n, const int &howmany);
+    template<typename R = double> typename FFTW<R>::plan many_c2r(const int &n, const int &howmany);
+
+    /** \brief set_effort -- planner effort of the plans made from now on
+
+    Plans already made for another effort stay in the cache but are not used: a transform asked for again is
+    planned again at the new effort.
+
+    \param[in] value
+	FFT_ESTIMATE (the default), FFT_MEASURE or FFT_PATIENT.
+    */
+    void set_effort(const FFTEffort &value) { effort = value; }
+    FFTEffort get_effort() const { return effort; }
+
+    /** \brief set_threads -- number of threads of the plans made from now on
+
+    Transforms of FFT_THREADS_MIN_SIZE values or more are planned for this many threads, and FFTW splits each of
+    them over that many threads when it runs.  As with set_effort, plans made for another number stay in the cache
+    unused.
+
+    \param[in] value
+	number of threads; 1 (the default) runs every transform on the calling thread.  0 uses one thread per core.
+    */
+    void set_threads(const int &value);
+    int get_threads() const { return threads; }
+
+    /** \brief use_wisdom -- reads the wisdom file of a directory, and saves new wisdom there
+
+    The Raster FFTs call this with the directory of the file of the raster transformed.  The files, one per
+    precision, are read the first time only; wisdom FFTW already has is kept.  From then on, each plan made with an
+    effort above FFT_ESTIMATE saves all the wisdom FFTW has in its precision to the file of that precision.  A
+    missing or unreadable file is ignored, as is a directory that can not be written to.
+
+    \param[in] directory
+	Directory of FFT_WISDOM_FILE and FFT_WISDOM_FILE_SINGLE; empty to stop saving wisdom.
+    */
+    void use_wisdom(const std::string &directory);
+
+    // get_wisdom_file: where new wisdom of precision R (double, or float) is saved, empty for nowhere
+    template<typename R = double> std::string get_wisdom_file() const;
+
+    // clear: destroys every plan.  The wisdom FFTW has is kept, so plans made again are made at once.
+    void clear();
+
+    // get_hits, get_misses: plans handed back from the cache, and made, since the cache was made
+    unsigned long get_hits() const { return hits; }
+    unsigned long get_misses() const { return misses; }
+
+    // shared: the cache the Raster FFTs use.  Made the first time it is asked for.
+    static FFTPlans &shared();
+
+  }; // end class: FFTPlans
+
+}// end namespace GeoStar
+
+
+#endif // FFTPLANS_HPP_
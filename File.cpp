@@ -10,23 +10,39 @@
 #include "H5Cpp.h"
 
 #include "File.hpp"
+#include "FileHandle.hpp"
 #include "Image.hpp"
 #include "Exceptions.hpp"
 #include "attributes.hpp"
+#include "RasterLayout.hpp"
 
 #include "boost/filesystem.hpp"
 
 namespace GeoStar {
 
+  // bytes by which a "memory" file grows
+  static const size_t MEMORY_FILE_INCREMENT = 16*1024*1024;
+
   // create a new hdf5 file, or open an exising one.
   // name is the pathname of the file.
   // access can be:
   //          "new", create a new file, existence is an error
   //      or "existing", opens an existing file, non-existence is an error.
+  //      or "readonly", opens an existing file for reading only.
+  //      or "memory", a new file held in memory only, discarded when closed.
   File::File(const std::string &name, const std::string &access) {
     FileAccessException FileAccessError;
     FileExistsException FileExistsError;
     FileDoesNotExistException FileDoesNotExistError;
+    NotGeoSciFileException NotGeoSciFile;
+
+    // a chunk cache big enough to hold a row of chunks of a large raster:
+    H5::FileAccPropList fapl;
+    int mdc_nelmts;
+    size_t rdcc_nelmts, rdcc_nbytes;
+    double rdcc_w0;
+    fapl.getCache(mdc_nelmts, rdcc_nelmts, rdcc_nbytes, rdcc_w0);
+    fapl.setCache(mdc_nelmts, RASTER_CHUNK_CACHE_SLOTS, RASTER_CHUNK_CACHE_BYTES, rdcc_w0);
 
     if(access=="new") {
       // existence is an error:
@@ -34,7 +50,7 @@ namespace GeoStar {
       if(boost::filesystem::exists( p )){
         throw FileExistsError;
       }//endif
-      fileobj = new H5::H5File( name, H5F_ACC_EXCL );
+      handle.reset(new FileHandle(H5::H5File( name, H5F_ACC_EXCL, H5::FileCreatPropList::DEFAULT, fapl ), name));
 
     } else if(access=="existing") {
       // non-existence is an error:
@@ -42,17 +58,36 @@ namespace GeoStar {
       if(!boost::filesystem::exists( p )){
         throw FileDoesNotExistError;
       }//endif
-      fileobj = new H5::H5File( name, H5F_ACC_RDWR );
+      handle.reset(new FileHandle(H5::H5File( name, H5F_ACC_RDWR, H5::FileCreatPropList::DEFAULT, fapl ), name));
+
+    } else if(access=="readonly") {
+      // non-existence is an error:
+      boost::filesystem::path p(name);
+      if(!boost::filesystem::exists( p )){
+        throw FileDoesNotExistError;
+      }//endif
+      handle.reset(new FileHandle(H5::H5File( name, H5F_ACC_RDONLY, H5::FileCreatPropList::DEFAULT, fapl ), name, true));
+
+    } else if(access=="memory") {
+      // the HDF5 core driver: nothing is written to disk, name only identifies the file in this process
+      fapl.setCore(MEMORY_FILE_INCREMENT, false);
+      handle.reset(new FileHandle(H5::H5File( name, H5F_ACC_EXCL, H5::FileCreatPropList::DEFAULT, fapl ), name));
 
     } else {
       throw FileAccessError;
     }// endif
 
+    fileobj = &handle->h5file;
     filename = name;
     filetype="geostar::hdf5";
 
-    // set objtype attribute.
-    write_object_type(filetype);
+    if(handle->read_only) {
+      // nothing is written: the object type is only checked
+      if(read_object_type() != filetype) throw NotGeoSciFile;
+    } else {
+      // set objtype attribute.
+      write_object_type(filetype);
+    }// endif
 
   }// end-File-constructor
 
@@ -8,9 +8,11 @@
 
 
 #include <string>
+#include <memory>
 
 #include "H5Cpp.h"
 
+#include "FileHandle.hpp"
 #include "Image.hpp"
 #include "attributes.hpp"
 
@@ -63,7 +65,11 @@ There are 3 functions to deal with HDF5 groups in the file: checking on existenc
     std::string filename;
     std::string filetype;
 
+    // the open file, shared with the images and rasters opened from it:
+    std::shared_ptr<FileHandle> handle;
+
   public:
+    // the HDF5 file, owned by handle:
     H5::H5File *fileobj;
 
   /** \brief File constructor allows one to create a new GeoStar file or open an existing one.
@@ -78,9 +84,11 @@ There are 3 functions to deal with HDF5 groups in the file: checking on existenc
        This is a string, set by the user, that holds the desired name of the new file.
 
    \param[in] acess
-       This is a string, set by the user, that should be set to one of 2 strings:
+       This is a string, set by the user, that should be set to one of 4 strings:
             "new": create a new file, existence is an error
             "existing": open an existing file, non-existence is an error
+            "readonly": open an existing file for reading only, non-existence is an error
+            "memory": create a new file that is held in memory only
 
    \returns
        A valid File object on success.
@@ -90,6 +98,7 @@ There are 3 functions to deal with HDF5 groups in the file: checking on existenc
        FileAccessException 
        FileExistsException 
        FileDoesNotExistException 
+       NotGeoSciFileException ("readonly" only: the file is not a GeoStar file)
 
    \par Example
        Let's say a user wants to create a file named "sirc_raco":
@@ -115,10 +124,24 @@ There are 3 functions to deal with HDF5 groups in the file: checking on existenc
        with value "geostar::hdf5".
        For existing files, this attribute must exist and have this value, or it is not 
        a GeoStar file, and an exception is thrown.
+
+       A "readonly" file is opened with H5F_ACC_RDONLY and nothing is ever written to it: the
+       attribute is only checked.  Many processes can have the same file open "readonly" at once
+       (while none has it open for writing), which suits jobs that fan out over one input file.
+       Creating an image or raster in it, or writing a raster, throws FileReadOnlyException.
+
+       A "memory" file uses the HDF5 core driver: nothing reaches the disk, and its contents are
+       gone when it is closed.  It is meant for temporaries (see Scratch); its name need only be
+       unique among the files open in the process.
   
   */
     File(const std::string &name, const std::string &access);
 
+    // is_readonly: true if the file was opened "readonly"
+    inline bool is_readonly() const {
+      return handle->read_only;
+    }
+
 
   /** \brief File::write_object_type allows one to change the value of the attribute string 
       named "object_type" that is attached to this file.
@@ -226,7 +249,8 @@ There are 3 functions to deal with HDF5 groups in the file: checking on existenc
   /** \brief File destructor allows one to delete a File object from memory.
 
    The File destructor is automatically called to clean up memory used by the File object.
-   There is a single pointer to the HDF5 file object that must be deleted.
+   The HDF5 file is shared with the Images and Rasters opened from this File (see FileHandle), and is
+   closed when the last of them is deleted.
 
    \see open, close
 
@@ -261,7 +285,11 @@ There are 3 functions to deal with HDF5 groups in the file: checking on existenc
 
   */
     inline ~File() {
-      delete fileobj;
+    }
+
+    // get_handle: the open file and its registry of open objects, shared with the images and rasters
+    inline std::shared_ptr<FileHandle> get_handle() const {
+      return handle;
     }
 
 
@@ -372,6 +400,9 @@ There are 3 functions to deal with HDF5 groups in the file: checking on existenc
        The HDF5 image attribute named "object_type" must exist for the existing image and 
        must have the value "geostar::image".
        Otherwise, it is not a GeoStar image, and an exception is thrown.
+
+       If the image is already open (another Image object of this file has it), its HDF5 group
+       is reused: nothing is read from the file.
   
   */
     inline Image *open_image(const std::string &name) {
@@ -0,0 +1,90 @@
+// FileHandle.hpp
+//
+// an open GeoStar file, shared by reference count between the File and
+// every Image and Raster opened from it, with a registry of the groups
+// and datasets already open in it.
+//
+//-------------------------------------
+#ifndef FILEHANDLE_HPP_
+#define FILEHANDLE_HPP_
+
+#include <string>
+#include <map>
+#include <memory>
+
+#include "H5Cpp.h"
+
+
+namespace GeoStar {
+
+  /** \brief FileHandle -- the HDF5 file behind a File, and the objects open in it
+
+  A File, its Images and their Rasters each hold a std::shared_ptr to the same FileHandle, and each Image and
+  Raster also holds a shared_ptr to its own HDF5 group or dataset.  The file stays open until the last of them
+  is deleted, whatever the order they are deleted in, and a Raster can hand back its Image (Raster::getParent)
+  without opening anything.
+
+  The registry remembers, by path in the file, the groups and datasets that are open.  Opening an image or
+  raster that is already open reuses its HDF5 object, and skips the checks that were made when it was
+  first opened.  Entries are weak: they do not keep anything open.
+
+  \see File, Image, Raster
+  */
+  class FileHandle {
+
+  private:
+    std::map<std::string, std::weak_ptr<H5::Group> > groups;
+    std::map<std::string, std::weak_ptr<H5::DataSet> > datasets;
+
+    // the object open under path, or an empty pointer
+    template<typename T>
+    static std::shared_ptr<T> find(std::map<std::string, std::weak_ptr<T> > &registry, const std::string &path) {
+      typename std::map<std::string, std::weak_ptr<T> >::iterator entry = registry.find(path);
+      if(entry == registry.end()) return std::shared_ptr<T>();
+      std::shared_ptr<T> object = entry->second.lock();
+      if(!object) registry.erase(entry);
+      return object;
+    }// end: find
+
+    // remembers object under path, dropping the entries of objects closed since
+    template<typename T>
+    static void add(std::map<std::string, std::weak_ptr<T> > &registry, const std::string &path,
+                    const std::shared_ptr<T> &object) {
+      typename std::map<std::string, std::weak_ptr<T> >::iterator entry = registry.begin();
+      while(entry != registry.end()) {
+        if(entry->second.expired()) registry.erase(entry++);
+        else ++entry;
+      }// endwhile
+      registry[path] = object;
+    }// end: add
+
+    FileHandle(const FileHandle &);
+    FileHandle &operator=(const FileHandle &);
+
+  public:
+    H5::H5File h5file;
+    std::string filename;
+
+    // opened with File(name, "readonly"): nothing may be created or written
+    bool read_only;
+
+    FileHandle(const H5::H5File &file, const std::string &name, const bool &readOnly = false)
+      : h5file(file), filename(name), read_only(readOnly) {}
+
+    // find_group, find_dataset: the object open under path in the file, or an empty pointer
+    inline std::shared_ptr<H5::Group> find_group(const std::string &path) { return find(groups, path); }
+    inline std::shared_ptr<H5::DataSet> find_dataset(const std::string &path) { return find(datasets, path); }
+
+    // add_group, add_dataset: registers an object just opened or created under path
+    inline void add_group(const std::string &path, const std::shared_ptr<H5::Group> &group) {
+      add(groups, path, group);
+    }
+    inline void add_dataset(const std::string &path, const std::shared_ptr<H5::DataSet> &dataset) {
+      add(datasets, path, dataset);
+    }
+
+  }; // end class: FileHandle
+
+}// end namespace GeoStar
+
+#endif // FILEHANDLE_HPP_
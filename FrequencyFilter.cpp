@@ -0,0 +1,90 @@
+// FrequencyFilter.cpp
+//
+// transfer functions of the frequency-domain filters.
+//
+//----------------------------------------
+
+#include <cmath>
+#include <functional>
+
+#include "FrequencyFilter.hpp"
+
+
+namespace GeoStar {
+
+  // gain of a low pass of cutoff at distance d
+  static double low_pass_gain(const double &d, const double &cutoff, const FilterShape &shape, const int &order) {
+    switch(shape) {
+    case FILTER_BUTTERWORTH:
+      return 1 / (1 + std::pow(d / cutoff, 2*order));
+    case FILTER_GAUSSIAN:
+      return std::exp(-d*d / (2*cutoff*cutoff));
+    default:
+      return (d <= cutoff) ? 1 : 0;
+    }// endswitch
+  }// end: low_pass_gain
+
+
+  static void check_order(const int &order) {
+    IntegerParameterException IntegerParameterError;
+    if(order < 1) throw IntegerParameterError;
+  }// end: check_order
+
+
+
+  FrequencyFilter FrequencyFilter::lowPass(const double &cutoff, const FilterShape &shape, const int &order) {
+    FrequencyParameterException FrequencyParameterError;
+    if(!(cutoff > 0)) throw FrequencyParameterError;
+    check_order(order);
+
+    return FrequencyFilter([cutoff, shape, order](const double &u, const double &v) {
+      return low_pass_gain(std::sqrt(u*u + v*v), cutoff, shape, order);
+    });
+  }// end: lowPass
+
+
+
+  FrequencyFilter FrequencyFilter::highPass(const double &cutoff, const FilterShape &shape, const int &order) {
+    const FrequencyFilter low = lowPass(cutoff, shape, order);
+    return FrequencyFilter([low](const double &u, const double &v) { return 1 - low(u, v); });
+  }// end: highPass
+
+
+
+  FrequencyFilter FrequencyFilter::bandPass(const double &low, const double &high, const FilterShape &shape,
+                                            const int &order) {
+    FrequencyParameterException FrequencyParameterError;
+    if(!(low >= 0 && low < high)) throw FrequencyParameterError;
+    check_order(order);
+
+    const double center = (low + high) / 2;
+    const double width = high - low;
+    return FrequencyFilter([low, high, center, width, shape, order](const double &u, const double &v) {
+      const double d = std::sqrt(u*u + v*v);
+      if(shape == FILTER_IDEAL) return (d >= low && d <= high) ? 1.0 : 0.0;
+      // the smooth shapes reject the mean, and pass all of the center:
+      if(d == 0) return 0.0;
+      const double offset = d*d - center*center;
+      if(offset == 0) return 1.0;
+      const double ratio = d * width / offset;
+      if(shape == FILTER_BUTTERWORTH) return 1 - 1 / (1 + std::pow(ratio, 2*order));
+      return std::exp(-1 / (ratio*ratio));
+    });
+  }// end: bandPass
+
+
+
+  FrequencyFilter FrequencyFilter::notch(const double &u0, const double &v0, const double &radius,
+                                         const FilterShape &shape, const int &order) {
+    FrequencyParameterException FrequencyParameterError;
+    if(!(radius > 0)) throw FrequencyParameterError;
+    check_order(order);
+
+    return FrequencyFilter([u0, v0, radius, shape, order](const double &u, const double &v) {
+      const double d1 = std::sqrt((u-u0)*(u-u0) + (v-v0)*(v-v0));
+      const double d2 = std::sqrt((u+u0)*(u+u0) + (v+v0)*(v+v0));
+      return (1 - low_pass_gain(d1, radius, shape, order)) * (1 - low_pass_gain(d2, radius, shape, order));
+    });
+  }// end: notch
+
+}// end namespace GeoStar
@@ -0,0 +1,120 @@
+// FrequencyFilter.hpp
+//
+// transfer functions of frequency-domain filters: ideal, Butterworth and
+// Gaussian low-pass, high-pass, band-pass and notch filters, or any
+// function of the frequency, applied by Raster::frequencyFilter.
+//
+//----------------------------------------
+#ifndef FREQUENCYFILTER_HPP_
+#define FREQUENCYFILTER_HPP_
+
+#include <functional>
+
+#include "Exceptions.hpp"
+
+
+namespace GeoStar {
+
+  // the profile of a FrequencyFilter across its cutoff
+  enum FilterShape {
+
+    FILTER_IDEAL,        // 1 inside, 0 outside: a sharp edge, which rings
+    FILTER_BUTTERWORTH,  // 1/(1 + (D/cutoff)^(2*order)): a smooth edge, steeper with the order
+    FILTER_GAUSSIAN      // exp(-D^2/(2*cutoff^2)): the smoothest edge, with no ringing
+
+  }; // end: FilterShape
+
+
+  /** \brief FrequencyFilter -- transfer function of a frequency-domain filter
+
+  A FrequencyFilter gives the gain H(u, v) of each frequency of a raster: u across the columns, v down the rows, both
+  in cycles per pixel from -0.5 to 0.5, so (0, 0) is the mean of the raster and 0.5 the highest frequency a raster
+  holds.  Raster::frequencyFilter multiplies the spectrum of a raster by it and transforms back.
+
+ \see Raster::frequencyFilter, FilterShape
+
+ \Par Example
+  A smooth low pass that keeps the features of more than 10 pixels, and a callback that keeps the horizontal
+  frequencies only:
+  \code
+  ras->frequencyFilter(rasOut, GeoStar::FrequencyFilter::lowPass(0.1, GeoStar::FILTER_BUTTERWORTH));
+  ras->frequencyFilter(rasOut, GeoStar::FrequencyFilter([](const double &u, const double &v) {
+    return (v == 0) ? 1.0 : 0.0;
+  }));
+  \endcode
+
+ \Par Details
+  The filters made by lowPass, highPass, bandPass and notch depend on the distance D of (u, v) from the origin (or,
+  for notch, from the notch), so H(-u, -v) = H(u, v) and the filtered raster is real.  A transfer function given
+  directly should be even too: Raster::frequencyFilter uses it on the half of the spectrum with u >= 0 only, and
+  mirrors that half onto the other.  The highest column of a raster of even width is passed as u = 0.5, never -0.5.
+  Gains may be any real value, so a filter can also amplify.
+  */
+  class FrequencyFilter {
+
+  public:
+    // H(u, v): the gain of frequency (u, v)
+    typedef std::function<double(const double &, const double &)> Transfer;
+
+  private:
+    Transfer transfer;
+
+  public:
+
+    // a filter of gain h(u, v)
+    explicit FrequencyFilter(const Transfer &h) : transfer(h) {}
+
+    // the gain of frequency (u, v), in cycles per pixel
+    double operator()(const double &u, const double &v) const { return transfer(u, v); }
+
+    /** \brief lowPass -- keeps the frequencies below cutoff
+
+    \param[in] cutoff
+	Radius of the pass band, in cycles per pixel: from 0 to 0.5 (and beyond, for the corners of the spectrum).
+	For FILTER_BUTTERWORTH the gain there is 1/2, for FILTER_GAUSSIAN exp(-1/2).
+
+    \param[in] shape
+	FILTER_IDEAL (the default), FILTER_BUTTERWORTH or FILTER_GAUSSIAN.
+
+    \param[in] order
+	Order of a FILTER_BUTTERWORTH filter, 1 or more; the higher, the sharper.  Not used for the other shapes.
+
+    \Par Exceptions
+	FrequencyParameterException if cutoff is not positive, IntegerParameterException if order is less than 1.
+    */
+    static FrequencyFilter lowPass(const double &cutoff, const FilterShape &shape = FILTER_IDEAL,
+                                   const int &order = 2);
+
+    // highPass: keeps the frequencies above cutoff, 1 - lowPass(cutoff, shape, order)
+    static FrequencyFilter highPass(const double &cutoff, const FilterShape &shape = FILTER_IDEAL,
+                                    const int &order = 2);
+
+    /** \brief bandPass -- keeps the frequencies from low to high
+
+    For FILTER_IDEAL the gain is 1 for low <= D <= high.  The smooth shapes are centered on D0 = (low+high)/2, of
+    width W = high-low: for FILTER_BUTTERWORTH the gain is 1 - 1/(1 + (D*W/(D^2-D0^2))^(2*order)), for
+    FILTER_GAUSSIAN exp(-((D^2-D0^2)/(D*W))^2).  Both are 0 at D = 0.
+
+    \Par Exceptions
+	FrequencyParameterException unless 0 <= low < high, IntegerParameterException if order is less than 1.
+    */
+    static FrequencyFilter bandPass(const double &low, const double &high, const FilterShape &shape = FILTER_IDEAL,
+                                    const int &order = 2);
+
+    /** \brief notch -- removes the frequencies within radius of (u0, v0) and of (-u0, -v0)
+
+    Periodic noise, such as the stripes of a scanner, shows as a pair of peaks in the spectrum: a notch removes
+    both.  The gain is the product of highPass(radius, shape, order) around each of the two points.
+
+    \Par Exceptions
+	FrequencyParameterException if radius is not positive, IntegerParameterException if order is less than 1.
+    */
+    static FrequencyFilter notch(const double &u0, const double &v0, const double &radius,
+                                 const FilterShape &shape = FILTER_IDEAL, const int &order = 2);
+
+  }; // end class: FrequencyFilter
+
+}// end namespace GeoStar
+
+
+#endif // FREQUENCYFILTER_HPP_
@@ -0,0 +1,83 @@
+// IOThread.cpp
+//
+// a background thread that runs file I/O jobs one at a time, in order.
+//
+//-------------------------------------
+
+#include <deque>
+#include <future>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+#include "IOThread.hpp"
+
+
+namespace GeoStar {
+
+  IOThread::IOThread() : stopping(false) {
+    worker = std::thread(&IOThread::run, this);
+  }// end: IOThread
+
+
+
+  IOThread::~IOThread() {
+    {
+      std::lock_guard<std::mutex> guard(jobs_lock);
+      stopping = true;
+    }
+    jobs_ready.notify_one();
+    worker.join();
+  }// end: ~IOThread
+
+
+
+  void IOThread::run() {
+    for(;;) {
+      std::packaged_task<void()> job;
+      {
+        std::unique_lock<std::mutex> guard(jobs_lock);
+        while(jobs.empty() && !stopping) jobs_ready.wait(guard);
+        if(jobs.empty()) return;
+        job = std::move(jobs.front());
+        jobs.pop_front();
+      }
+      // exceptions end up in the job's future:
+      job();
+    }// endfor
+  }// end: run
+
+
+
+  std::future<void> IOThread::submit(const std::function<void()> &job) {
+    std::packaged_task<void()> task(job);
+    std::future<void> done = task.get_future();
+
+    if(in_worker()) {
+      task();
+      return done;
+    }// endif
+
+    {
+      std::lock_guard<std::mutex> guard(jobs_lock);
+      jobs.push_back(std::move(task));
+    }
+    jobs_ready.notify_one();
+    return done;
+  }// end: submit
+
+
+
+  bool IOThread::in_worker() const {
+    return std::this_thread::get_id() == worker.get_id();
+  }// end: in_worker
+
+
+
+  IOThread &IOThread::shared() {
+    static IOThread io;
+    return io;
+  }// end: shared
+
+}// end namespace GeoStar
@@ -0,0 +1,64 @@
+// IOThread.hpp
+//
+// a background thread that runs file I/O jobs one at a time, in order.
+//
+// The HDF5 library GeoStar links against is not thread-safe, so all the
+// reads and writes that overlap with computation are funnelled through
+// one IOThread (IOThread::shared()), never through several threads at once.
+//
+//-------------------------------------
+#ifndef IOTHREAD_HPP_
+#define IOTHREAD_HPP_
+
+#include <deque>
+#include <future>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+
+namespace GeoStar {
+
+  class IOThread {
+
+  private:
+    std::thread worker;
+    std::mutex jobs_lock;
+    std::condition_variable jobs_ready;
+    std::deque<std::packaged_task<void()> > jobs;
+    bool stopping;
+
+    // worker loop: runs jobs until the destructor asks it to stop
+    void run();
+
+    IOThread(const IOThread &);
+    IOThread &operator=(const IOThread &);
+
+  public:
+
+    // starts the worker thread
+    IOThread();
+
+    // runs the jobs already submitted, then stops the worker thread
+    ~IOThread();
+
+    // submit: queues job to run on the worker thread after every job submitted
+    //         before it.  The future becomes ready when the job has run, and
+    //         get() rethrows any exception the job threw.
+    //         A job submitted from the worker thread itself is run right away,
+    //         so jobs can not deadlock waiting for each other.
+    std::future<void> submit(const std::function<void()> &job);
+
+    // in_worker: true when called from the worker thread
+    bool in_worker() const;
+
+    // shared: the I/O thread used by the Raster streaming reader and writer.
+    //         Started the first time it is asked for.
+    static IOThread &shared();
+
+  }; // end class: IOThread
+
+}// end namespace GeoStar
+
+#endif // IOTHREAD_HPP_
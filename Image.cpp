@@ -16,6 +16,7 @@
 #include "Raster.hpp"
 #include "Exceptions.hpp"
 #include "attributes.hpp"
+#include "compression.hpp"
 
 extern "C" {
 #include "tiff.h"
@@ -23,6 +24,8 @@ extern "C" {
 #include "string.h"
 }
 #include <cstdlib>
+#include <vector>
+#include <algorithm>
 
 
 #include "gdal_priv.h"
@@ -33,30 +36,49 @@ namespace GeoStar {
 
   Image::Image(File *file, const std::string &name){
     ImageOpenErrorException ImageOpenError;
+    FileReadOnlyException FileReadOnlyError;
+
+    image_file = file->get_handle();
+    imagename = name;
+    imagetype = "geostar::image";
+
+    // already open, and checked then:
+    image_group = image_file->find_group(name);
+    if(image_group) {
+      imageobj = image_group.get();
+      return;
+    }// endif
 
     // opens Image if it exists, creates if doesn't
 
     if(file->groupExists(name)){
       // check validity of exisiting object:
-      imageobj = new H5::Group( file->openGroup( name ));
+      image_group.reset(new H5::Group( file->openGroup( name )));
+      imageobj = image_group.get();
       // check for valid objtype attribute.
       if(read_object_type() != "geostar::image") {
-        delete imageobj;
         throw ImageOpenError;
       }// endif
-      // finish setting object-specific data:
-      imagename = name;
-      imagetype = "geostar::image";
 
     } else {
+      if(image_file->read_only) throw FileReadOnlyError;
       // create a new Image group:
-      imageobj = new H5::Group( file->createGroup( name ));
-      imagename = name;
-      imagetype = "geostar::image";
+      image_group.reset(new H5::Group( file->createGroup( name )));
+      imageobj = image_group.get();
       // set objtype attribute.
       write_object_type(imagetype);
     }// endif
 
+    image_file->add_group(name, image_group);
+
+  }// end-Image-constructor
+
+
+
+  Image::Image(const std::shared_ptr<FileHandle> &file, const std::shared_ptr<H5::Group> &group,
+               const std::string &name)
+    : imagename(name), imagetype("geostar::image"), image_file(file), image_group(group) {
+    imageobj = image_group.get();
   }// end-Image-constructor
 
 
@@ -76,7 +98,7 @@ namespace GeoStar {
 
 
   Raster *Image::read_file(const std::string &infile, const std::string &name,
-				const int &nChannels){
+				const int &nChannels, const RasterLayout &layout){
     // 1. open the data file
     // 2. figure out data characteristics
     // 3. create empty raster
@@ -98,29 +120,37 @@ namespace GeoStar {
     int ny = poBand->GetYSize();
 
     // 3. create empty raster
-    Raster *ras = create_raster(name,GeoStar::REAL32,nx,ny);
+    // (for automatic compression, first try the codecs on the top of the channel)
+    RasterLayout rasterLayout = layout;
+    if(rasterLayout.compression == COMPRESS_AUTO && nx > 0 && ny > 0) {
+      int nSample = std::min(ny, 256);
+      std::vector<float> sample((size_t)nx*nSample);
+      poBand->RasterIO( GF_Read, 0, 0, nx, nSample,
+                        &sample[0], nx, nSample, GDT_Float32, 0, 0 );
+      std::vector<CompressionReport> reports =
+        measure_compression(&sample[0], H5::PredType::NATIVE_FLOAT, nx, nSample);
+      rasterLayout.compression = select_compression(reports);
+    }// endif
+
+    Raster *ras = create_raster(name,GeoStar::REAL32,nx,ny,rasterLayout);
 
-    // 4. fill raster:
-    std::vector<long int> slice(4);
-    slice[0]=0;  slice[1]=0;
-    slice[2]=nx; slice[3]=1;
+    // 4. fill raster, a band of whole rows at a time, straight from the GDAL buffer:
+    long int blockShape[2];
+    ras->default_block_shape(blockShape);
+    const long int nlines = blockShape[1];
 
     float *buf;
-    buf = (float *) CPLMalloc(sizeof(float)*nx);
-	
+    buf = (float *) CPLMalloc(sizeof(float)*nx*nlines);
 
-    for(int iy=0;iy<ny;++iy){
+    for(long int iy=0;iy<ny;iy+=nlines){
+      const long int dy = std::min(nlines, ny-iy);
       CPLErr err = poBand->RasterIO( GF_Read, 
-                    0, iy, nx, 1,
-                    buf, nx, 1, GDT_Float32,
+                    0, iy, nx, dy,
+                    buf, nx, dy, GDT_Float32,
                     0, 0 );
-      slice[1]=iy;
-	vector<float> writeBuf(buf, buf + nx);
-      ras->write(slice, writeBuf);
+      ras->write(RasterSlice(0, iy, nx, dy), buf, (size_t)nx*dy);
     } // endfor
 
-	
-
     CPLFree(buf);
     GDALClose(poDataset);
 
@@ -131,6 +161,76 @@ namespace GeoStar {
 
 
 
+  BandStack *Image::read_file_bands(const std::string &infile, const std::string &name,
+                                    const RasterLayout &layout){
+    FileOpenErrorException FileOpenError;
+
+    // 1. open the data file
+    GDALDataset *poDataset;
+    GDALAllRegister();
+    char cname[infile.length()+10]; // need a copy because it's declared const
+    strcpy(cname, infile.c_str());
+    poDataset = (GDALDataset *) GDALOpen(cname, GA_ReadOnly );
+    if( poDataset == NULL ) throw FileOpenError;
+
+    // 2. figure out data characteristics
+    int nbands = poDataset->GetRasterCount();
+    int nx = poDataset->GetRasterXSize();
+    int ny = poDataset->GetRasterYSize();
+    if( nbands < 1 ) {
+      GDALClose(poDataset);
+      throw FileOpenError;
+    }// endif
+
+    // 3. create empty stack
+    RasterLayout stackLayout = layout;
+    if(stackLayout.compression == COMPRESS_AUTO && nx > 0 && ny > 0) {
+      int nSample = std::min(ny, 256);
+      std::vector<float> sample((size_t)nx*nSample);
+      poDataset->GetRasterBand(1)->RasterIO( GF_Read, 0, 0, nx, nSample,
+                                             &sample[0], nx, nSample, GDT_Float32, 0, 0 );
+      std::vector<CompressionReport> reports =
+        measure_compression(&sample[0], H5::PredType::NATIVE_FLOAT, nx, nSample);
+      stackLayout.compression = select_compression(reports);
+    }// endif
+
+    BandStack *stack = create_bandstack(name,GeoStar::REAL32,nbands,nx,ny,stackLayout);
+
+    // 4. fill the stack, a band of whole rows of every channel at a time.
+    //    GDAL returns the channels one after the other (BSQ), the order write_bsq takes.
+    long int blockShape[2];
+    stack->default_block_shape(blockShape);
+    const long int nlines = blockShape[1];
+    const size_t blockValues = (size_t)nbands*nx*nlines;
+
+    float *buf;
+    buf = (float *) CPLMalloc(sizeof(float)*blockValues);
+
+    for(long int iy=0;iy<ny;iy+=nlines){
+      const long int dy = std::min(nlines, ny-iy);
+      CPLErr err = poDataset->RasterIO( GF_Read,
+                    0, iy, nx, dy,
+                    buf, nx, dy, GDT_Float32,
+                    nbands, NULL, 0, 0, 0 );
+      if( err != CE_None ) {
+        CPLFree(buf);
+        GDALClose(poDataset);
+        delete stack;
+        throw FileOpenError;
+      }// endif
+      stack->write_bsq(RasterSlice(0, iy, nx, dy), buf, blockValues);
+    } // endfor
+
+    CPLFree(buf);
+    GDALClose(poDataset);
+
+    // 5. return the new stack
+    return stack;
+
+  }// end-function: read_file_bands
+
+
+
 
 
 }// end namespace GeoStar
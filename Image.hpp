@@ -9,9 +9,12 @@
 #define IMAGE_HPP_
 
 #include <string>
+#include <memory>
 
 #include "H5Cpp.h"
+#include "FileHandle.hpp"
 #include "Raster.hpp"
+#include "BandStack.hpp"
 #include "attributes.hpp"
 
 namespace GeoStar {
@@ -41,6 +44,9 @@ This class also enables one to create and open rasters.
 \Par Details
 The class keeps track of the image name and the image type.
 
+The HDF5 file and group are shared (see FileHandle): several Image objects for the same image, such as
+those returned by Raster::getParent, use one open group, and the file stays open while any of them exists.
+
 There are tools to check if a dataset exists before creating or opening one.
 
 */
@@ -52,7 +58,17 @@ There are tools to check if a dataset exists before creating or opening one.
     std::string imagename;
     std::string imagetype;
 
+    // the open file and this image's group, shared with the other objects of the file:
+    std::shared_ptr<FileHandle> image_file;
+    std::shared_ptr<H5::Group> image_group;
+
+    // an Image for a group that is already open, see Raster::getParent
+    Image(const std::shared_ptr<FileHandle> &file, const std::shared_ptr<H5::Group> &group,
+          const std::string &name);
+    friend class Raster;
+
   public:
+    // the HDF5 group, owned by image_group:
     H5::Group *imageobj;
 
     /** \brief Image Constructor -- allows you to open an existing image or create a new one
@@ -77,6 +93,7 @@ There are tools to check if a dataset exists before creating or opening one.
 	Exceptions that may be raised:
 
 	ImageOpenError
+	FileReadOnlyException -- the image does not exist and the file was opened "readonly"
 
     \Par Example
 	Opening an existing Image named "landsat":
@@ -106,6 +123,9 @@ There are tools to check if a dataset exists before creating or opening one.
 	Even if the image you try to open does not exist, the function will still create a 
 	valid image object with the desired name.  The procedure to create or open a image with this
 	constructor is the same.
+
+	An image that is already open in the file (see FileHandle) is not opened again: this Image
+	shares its group, and nothing is read from the file.
     */
     Image(File *file, const std::string &name);
 
@@ -203,7 +223,7 @@ There are tools to check if a dataset exists before creating or opening one.
     /** \brief Image destructor allows one to delete a Raster object from memory.
 
    The Image destructor is automatically called to clean up memory used by the Image object.
-   There is a single pointer to the HDF5 Image object that must be deleted.
+   The HDF5 group is closed when the last Image and Raster using it is deleted.
 
    \see open, close
 
@@ -234,7 +254,16 @@ There are tools to check if a dataset exists before creating or opening one.
 
   */
     inline ~Image() {
-      delete imageobj;
+    }
+
+    // get_name: name of the image in its file
+    inline std::string get_name() const {
+      return imagename;
+    }
+
+    // is_readonly: true if the file of the image was opened "readonly"
+    inline bool is_readonly() const {
+      return image_file->read_only;
     }
 
     /** \brief create_raster allows one to create a new GeoStar raster.
@@ -259,6 +288,10 @@ There are tools to check if a dataset exists before creating or opening one.
    \param[in] ny
 	this is the size of the raster in the y-direction.
 
+   \param[in] layout
+	How the raster is stored in the file: CONTIGUOUS, ROW_CHUNKED or TILED (see RasterLayout.hpp).
+	Defaults to square tiles sized to the file's chunk cache.
+
    \returns
        A valid Raster object on success.
 
@@ -295,8 +328,9 @@ There are tools to check if a dataset exists before creating or opening one.
   */
     inline Raster *create_raster(const std::string &name, 
                                  const RasterType &type,
-                                 const int &nx, const int &ny) {
-      return new Raster(this,name,type,nx,ny);
+                                 const int &nx, const int &ny,
+                                 const RasterLayout &layout = RasterLayout()) {
+      return new Raster(this,name,type,nx,ny,layout);
     }
 
 
@@ -350,6 +384,46 @@ There are tools to check if a dataset exists before creating or opening one.
     }
 
 
+    /** \brief create_bandstack creates a new multi-band raster, all bands in one dataset.
+
+   \see  open_bandstack, read_file_bands, BandStack
+
+   \param[in] name
+       Name of the new band stack.
+
+   \param[in] type
+	Pixel type of every band.
+
+   \param[in] nbands, nx, ny
+	Number of bands and size of each band.
+
+   \param[in] layout
+	How the stack is stored (see RasterLayout.hpp); chunks always span every band.
+
+   \returns
+       A valid BandStack object on success.
+
+   \par Exceptions
+       RasterExistsError, RasterCreationError, FileReadOnlyException
+
+   \par Example
+       \code
+       GeoStar::BandStack *stack = img->create_bandstack("landsat", GeoStar::INT16U, 7, 8000, 8000);
+       \endcode
+  */
+    inline BandStack *create_bandstack(const std::string &name,
+                                       const RasterType &type,
+                                       const int &nbands, const int &nx, const int &ny,
+                                       const RasterLayout &layout = RasterLayout()) {
+      return new BandStack(this,name,type,nbands,nx,ny,layout);
+    }
+
+    // open_bandstack: opens an existing band stack, see BandStack
+    BandStack *open_bandstack(const std::string &name) {
+      return new BandStack(this,name);
+    }
+
+
     /** \brief datasetExists returns true if the named dataset exists, false otherwise.
 
    datasetExists is used to check on the existence of a dataset, before trying to create
@@ -415,6 +489,9 @@ There are tools to check if a dataset exists before creating or opening one.
    \param[in] data_space
 	
 
+   \param[in] create_plist
+	Dataset creation properties (chunking, filters).  Defaults to a contiguous dataset.
+
    \returns
        The dataset on success.
 
@@ -458,8 +535,9 @@ There are tools to check if a dataset exists before creating or opening one.
   */
     inline H5::DataSet createDataset(const std::string &name, 
                                      const H5::DataType &data_type,
-                                     const H5::DataSpace &data_space) {
-      return imageobj->createDataSet(name,data_type,data_space);
+                                     const H5::DataSpace &data_space,
+                                     const H5::DSetCreatPropList &create_plist = H5::DSetCreatPropList::DEFAULT) {
+      return imageobj->createDataSet(name,data_type,data_space,create_plist);
     }
 
     /** \brief openDataset opens the named dataset and returns it.
@@ -532,6 +610,11 @@ There are tools to check if a dataset exists before creating or opening one.
    \param[in] nChannels
 	This is an integer that specifies what channel of the image you want to read from.
 
+   \param[in] layout
+	How the new raster is stored (see RasterLayout.hpp).  With layout.compression = COMPRESS_AUTO
+	the first rows of the channel are tried with every available codec and the one with the best
+	overall read/write time is used.
+
    \returns
        A new raster with the channel data inside on success.
 
@@ -565,10 +648,43 @@ There are tools to check if a dataset exists before creating or opening one.
     \par Details
 	The raster will be created to be the same size and have the same values as the channel
 	you are reading from.  The infile must exist, otherwise an exception is thrown.
+	The codec picked by COMPRESS_AUTO depends on the data and on the speed of the machine, see
+	measure_compression and select_compression in compression.hpp.
  
   */
 
-    Raster *read_file(const std::string &infile, const std::string &name, const int &nChannels);
+    Raster *read_file(const std::string &infile, const std::string &name, const int &nChannels,
+                      const RasterLayout &layout = RasterLayout());
+
+/** \brief read_file_bands reads every channel of a file into a new band stack
+
+   Like read_file, but all the channels go into one BandStack (REAL32), filled in a single pass over the file:
+   each band of rows is read from every channel with one GDAL call and written with one HDF5 call.
+
+   \see  read_file, BandStack
+
+   \param[in] infile
+	Name of the file to read (any format GDAL reads, typically a multi-band GeoTIFF).
+
+   \param[in] name
+       Name of the band stack to create.
+
+   \param[in] layout
+	How the new stack is stored; COMPRESS_AUTO measures the codecs on the top of the first channel.
+
+   \returns
+       The new BandStack on success.
+
+   \par Exceptions
+       FileOpenError
+
+   \par Example
+       \code
+       GeoStar::BandStack *stack = img->read_file_bands("landsat.tif", "landsat");
+       \endcode
+  */
+    BandStack *read_file_bands(const std::string &infile, const std::string &name,
+                               const RasterLayout &layout = RasterLayout());
 
 
   }; // end class: Image
@@ -0,0 +1,39 @@
+// InMemoryRaster.cpp
+//
+// Implementations for rasters held in memory
+// Documentation in InMemoryRaster.hpp
+//--------------------------------------------
+
+
+#include <string>
+
+#include "H5Cpp.h"
+#include "Exceptions.hpp"
+#include "Image.hpp"
+#include "Raster.hpp"
+#include "InMemoryRaster.hpp"
+
+
+namespace GeoStar {
+
+  InMemoryRaster::InMemoryRaster(const std::string &name, const RasterType &type, const long int &nx, const long int &ny)
+    : Raster(name, type, nx, ny) {
+  }// end-InMemoryRaster-constructor
+
+
+
+  Raster *InMemoryRaster::store(Image *image, const std::string &name, const RasterLayout &layout) const {
+    Raster *ras = image->create_raster(name.empty() ? get_name() : name, get_datatype(), get_nx(), get_ny(), layout);
+    try {
+      // the whole raster in one write, already in its type:
+      if(get_nx() > 0 && get_ny() > 0) {
+        ras->write_slice(RasterSlice(0, 0, get_nx(), get_ny()), memory_pixels.get(), cache_type);
+      }// endif
+    } catch(...) {
+      delete ras;
+      throw;
+    }
+    return ras;
+  }// end: store
+
+}// end namespace GeoStar
@@ -0,0 +1,110 @@
+// InMemoryRaster.hpp
+//
+// a Raster whose pixels are held in one aligned block of memory
+// instead of an HDF5 dataset; every Raster operation works on it.
+//
+//----------------------------------------
+#ifndef INMEMORYRASTER_HPP_
+#define INMEMORYRASTER_HPP_
+
+#include <string>
+
+#include "Raster.hpp"
+#include "RasterType.hpp"
+#include "RasterLayout.hpp"
+
+
+namespace GeoStar {
+  class Image;
+
+
+  /** \brief InMemoryRaster -- a Raster held in memory
+
+  An InMemoryRaster is a Raster whose pixels live in a single contiguous buffer, in the raster's own type,
+  aligned to RASTER_MEMORY_ALIGNMENT bytes.  It has the whole Raster interface: read, write, for_each_block,
+  thresh, scale, the filters, FFT_2D, the arithmetic operators, ...; and it can be passed wherever a Raster *
+  is expected, as input or output.  Reads and writes are copies to and from the buffer, with the same type
+  conversions HDF5 makes, and no HDF5 I/O at all.
+
+ \see Raster::load, store, Raster
+
+ \Par Usage Overview
+
+  Raster::load copies a raster from its file with one HDF5 read.  Run any number of operations on the copy,
+  then store writes it to an image with one HDF5 write.  An InMemoryRaster can also be made empty (all zeros)
+  with the constructor, e.g. for the output of an operation.
+
+  The contents are lost when the InMemoryRaster is deleted.
+
+ \Par Example
+  Threshold, scale and edge-detect a band in memory, then keep only the result:
+  \code
+  GeoStar::Raster *ras = img->open_raster("B07");
+  GeoStar::InMemoryRaster *mem = ras->load();
+  GeoStar::InMemoryRaster edges("B07_edges", GeoStar::REAL32, mem->get_nx(), mem->get_ny());
+
+  mem->thresh(30);
+  mem->scale(mem, 0, 2);
+  mem->gradientMask(&edges, 1);
+
+  delete edges.store(img);
+  delete mem;
+  delete ras;
+  \endcode
+
+ \Par Details
+  An InMemoryRaster has no dataset (rasterobj is NULL) and no parent Image: getParent returns NULL, and
+  create_sibling makes another InMemoryRaster.  The write cache and prefetch settings are accepted but have
+  nothing to do.  The raster must fit in memory: nx*ny pixels of its type.
+  */
+  class InMemoryRaster : public Raster {
+
+  public:
+
+    /** \brief InMemoryRaster Constructor -- a new raster in memory, all pixels zero
+
+    \param[in] name
+	Name of the raster; also the default name given to it by store.
+
+    \param[in] type, nx, ny
+	As for Image::create_raster.
+
+    \Par Exceptions
+	RasterCreationError -- negative size, unsupported type, or not enough memory
+    */
+    InMemoryRaster(const std::string &name, const RasterType &type, const long int &nx, const long int &ny);
+
+    // data: the pixels, nx*ny values of the raster's type row by row.  Writing to them changes the raster.
+    inline void *data() { return memory_pixels.get(); }
+    inline const void *data() const { return memory_pixels.get(); }
+
+    /** \brief store -- write the raster to an image with one write
+
+    Creates a raster in image of this raster's type and size, and writes all the pixels to it in a single
+	HDF5 write.
+
+    \see Raster::load
+
+    \param[in] image
+	The image to create the raster in.
+
+    \param[in] name
+	Name of the new raster.  Empty (the default) uses this raster's name.
+
+    \param[in] layout
+	Layout of the new raster, as for Image::create_raster.
+
+    \returns
+	The new raster, deleted by the caller.
+
+    \Par Exceptions
+	The exceptions of Image::create_raster (RasterExistsError, FileReadOnlyException, ...) and of write.
+    */
+    Raster *store(Image *image, const std::string &name = "", const RasterLayout &layout = RasterLayout()) const;
+
+  }; // end class: InMemoryRaster
+
+}// end namespace GeoStar
+
+
+#endif // INMEMORYRASTER_HPP_
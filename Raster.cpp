@@ -11,12 +11,24 @@
 #include <cmath>
 #include <string.h>
 #include <cstdlib>
+#include <thread>
+#include <functional>
+#include <new>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
 
 #include "H5Cpp.h"
+#include "boost/filesystem.hpp"
 #include "Exceptions.hpp"
 #include "Image.hpp"
 #include "Raster.hpp"
+#include "InMemoryRaster.hpp"
 #include "File.hpp"
+#include "Scratch.hpp"
+#include "FFTPlans.hpp"
+#include "FrequencyFilter.hpp"
+#include "compression.hpp"
 
 #include "attributes.hpp"
 //#include <opencv2/opencv.hpp>
@@ -25,35 +37,158 @@
 
 namespace GeoStar {
 
+  // complex type: a compound of two members "re" and "im" of the given type
+  static H5::CompType complex_type(const H5::PredType &part) {
+    H5::CompType h5Type(2*part.getSize());
+    h5Type.insertMember("re", 0, part);
+    h5Type.insertMember("im", part.getSize(), part);
+    return h5Type;
+  }// end: complex_type
+
+
+
+  // RasterType of a {re, im} compound; false if it is not one
+  static bool complex_raster_type_of(const H5::CompType &h5Type, RasterType &type) {
+    if(h5Type.getNmembers() != 2) return false;
+    if(h5Type.getMemberName(0) != "re" || h5Type.getMemberName(1) != "im") return false;
+    const H5T_class_t partClass = h5Type.getMemberClass(0);
+    if(partClass != h5Type.getMemberClass(1)) return false;
+    const size_t size = h5Type.getMemberDataType(0).getSize();
+    if(size != h5Type.getMemberDataType(1).getSize()) return false;
+
+    if(partClass == H5T_INTEGER) {
+      if(h5Type.getMemberIntType(0).getSign() == H5T_SGN_NONE) return false;
+      switch(size) {
+      case 1: type = COMPLEX_INT16;  return true;
+      case 2: type = COMPLEX_INT32;  return true;
+      case 4: type = COMPLEX_INT64;  return true;
+      case 8: type = COMPLEX_INT128; return true;
+      default: return false;
+      }// end case
+    }// endif
+    if(partClass == H5T_FLOAT) {
+      switch(size) {
+      case 4: type = COMPLEX_REAL64;  return true;
+      case 8: type = COMPLEX_REAL128; return true;
+      default: return false;
+      }// end case
+    }// endif
+    return false;
+  }// end: complex_raster_type_of
+
+
+
+  bool raster_type_of(const H5::DataSet &dataset, RasterType &type) {
+    const size_t size = dataset.getDataType().getSize();
+    switch(dataset.getTypeClass()) {
+    case H5T_INTEGER: {
+      const bool sign = dataset.getIntType().getSign() != H5T_SGN_NONE;
+      switch(size) {
+      case 1: type = sign ? INT8S  : INT8U;  return true;
+      case 2: type = sign ? INT16S : INT16U; return true;
+      case 4: type = sign ? INT32S : INT32U; return true;
+      case 8: type = sign ? INT64S : INT64U; return true;
+      default: return false;
+      }// end case
+    }
+    case H5T_FLOAT:
+      switch(size) {
+      case 4: type = REAL32; return true;
+      case 8: type = REAL64; return true;
+      default: return false;
+      }// end case
+    case H5T_COMPOUND:
+      return complex_raster_type_of(dataset.getCompType(), type);
+    default:
+      return false;
+    }// end case
+  }// end: raster_type_of
+
+
+
   Raster::Raster(Image *image, const std::string &name){
     RasterOpenErrorException RasterOpenError;
     RasterDoesNotExistException RasterDoesNotExist;
 
-    if(!image->datasetExists(name)) throw RasterDoesNotExist;
+    // already open, and checked then:
+    std::shared_ptr<H5::DataSet> dataset = image->image_file->find_dataset(image->get_name() + "/" + name);
+    if(dataset) {
+      set_handles(image, dataset);
+    } else {
+      if(!image->datasetExists(name)) throw RasterDoesNotExist;
 
-    // check if its a valid Raster:
-    rasterobj = new H5::DataSet(image->openDataset(name));
-    if(read_object_type() != "geostar::raster") {
-      delete rasterobj;
-      throw RasterOpenError;
-    }//endif
+      // check if its a valid Raster:
+      set_handles(image, std::shared_ptr<H5::DataSet>(new H5::DataSet(image->openDataset(name))));
+      if(read_object_type() != "geostar::raster") throw RasterOpenError;
+    }// endif
+
+    // the pixel type is not stored separately, work it out from the dataset:
+    if(!raster_type_of(*rasterobj, raster_datatype)) throw RasterOpenError;
+    raster_file->add_dataset(raster_image_name + "/" + name, raster_dataset);
 
     // finish setting object-specific data:
     rastername = name;
     rastertype = "geostar::raster";
+    prefetch = false;
+    threads = 1;
+    write_cache = false;
+    cache_bytes = 0;
+    refresh_extent();
 
   }// end-Raster-constructor
 
 
 
 
+  void Raster::set_handles(Image *image, const std::shared_ptr<H5::DataSet> &dataset) {
+    raster_file = image->image_file;
+    raster_image = image->image_group;
+    raster_image_name = image->get_name();
+    raster_dataset = dataset;
+    rasterobj = raster_dataset.get();
+  }// end: set_handles
+
+
+
+  void Raster::use_fft_wisdom() const {
+    // an InMemoryRaster has no file, and a File may be in memory only
+    if(!raster_file) return;
+    const boost::filesystem::path path(raster_file->filename);
+    if(!boost::filesystem::exists(path)) return;
+    FFTPlans::shared().use_wisdom(boost::filesystem::absolute(path).parent_path().string());
+  }// end: use_fft_wisdom
+
+
+
+  size_t chunk_cache_bytes(Image *image) {
+    hid_t fileId = H5Iget_file_id(image->imageobj->getId());
+    hid_t fapl = H5Fget_access_plist(fileId);
+    int mdc_nelmts;
+    size_t rdcc_nslots, rdcc_nbytes;
+    double rdcc_w0;
+    herr_t status = H5Pget_cache(fapl, &mdc_nelmts, &rdcc_nslots, &rdcc_nbytes, &rdcc_w0);
+    H5Pclose(fapl);
+    H5Fclose(fileId);
+    if(status < 0) return RASTER_CHUNK_CACHE_BYTES;
+    return rdcc_nbytes;
+  }// end: chunk_cache_bytes
+
+
+
   Raster::Raster(Image *image, const std::string &name, const RasterType &type,
-           const int &nx, const int &ny){
+           const int &nx, const int &ny, const RasterLayout &layout){
 
     RasterCreationErrorException RasterCreationError;
     RasterExistsException RasterExistsError;
+    FileReadOnlyException FileReadOnlyError;
 
+    if(image->is_readonly()) throw FileReadOnlyError;
     if(image->datasetExists(name)) throw RasterExistsError;
+    if(layout.size < 0) throw RasterCreationError;
+    // filters only work on chunked datasets:
+    if(layout.type == CONTIGUOUS && layout.compression != COMPRESS_NONE) throw RasterCreationError;
+
+    H5::DataType h5Type = getHdf5FileType(type);
 
     // create a 2D dataset
     hsize_t dims[2];
@@ -61,23 +196,54 @@ namespace GeoStar {
     dims[1] = nx;
     H5::DataSpace dataspace(2, dims);
 
-    switch(type) {
-    case INT8U:
-      rasterobj = new H5::DataSet(image->createDataset(name, H5::PredType::NATIVE_UINT8, dataspace));
-      break;
-    case INT16U:
-      rasterobj = new H5::DataSet(image->createDataset(name, H5::PredType::NATIVE_UINT16, dataspace));
-      break;
-    case REAL32:
-      rasterobj = new H5::DataSet(image->createDataset(name, H5::PredType::NATIVE_FLOAT, dataspace));
-      break;
-    default:
-      throw RasterCreationError;
-    }// end case
+    // chunked layouts: an automatic chunk holds at most 1/RASTER_CHUNKS_PER_CACHE of the chunk cache
+    H5::DSetCreatPropList plist;
+    if(layout.type != CONTIGUOUS && nx > 0 && ny > 0) {
+      const hsize_t chunkPixels = chunk_cache_bytes(image) / RASTER_CHUNKS_PER_CACHE / h5Type.getSize();
+      hsize_t chunk[2];
+
+      if(layout.type == ROW_CHUNKED) {
+        chunk[0] = layout.size;
+        if(chunk[0] == 0) chunk[0] = chunkPixels / nx;
+        chunk[1] = nx;
+      } else if(layout.type == TILED) {
+        hsize_t tile = layout.size;
+        if(tile == 0) {
+          // largest power of 2 that fits:
+          tile = 16;
+          while(4*tile*tile <= chunkPixels) tile *= 2;
+        }// endif
+        chunk[0] = tile;
+        chunk[1] = tile;
+      } else {
+        throw RasterCreationError;
+      }// endif
+
+      // chunks can't be bigger than the raster:
+      chunk[0] = std::max(std::min(chunk[0], dims[0]), (hsize_t)1);
+      chunk[1] = std::max(std::min(chunk[1], dims[1]), (hsize_t)1);
+      plist.setChunk(2, chunk);
+
+      // COMPRESS_AUTO needs a sample of the data to measure (see Image::read_file);
+      // without one, deflate is the safe choice.
+      if(layout.compression == COMPRESS_AUTO) {
+        set_compression(plist, COMPRESS_DEFLATE, layout.level);
+      } else {
+        set_compression(plist, layout.compression, layout.level);
+      }// endif
+    }// endif
+
+    set_handles(image, std::shared_ptr<H5::DataSet>(new H5::DataSet(image->createDataset(name, h5Type, dataspace, plist))));
+    raster_file->add_dataset(raster_image_name + "/" + name, raster_dataset);
 
     rastername = name;
     raster_datatype=type;
     rastertype = "geostar::raster";
+    prefetch = false;
+    threads = 1;
+    write_cache = false;
+    cache_bytes = 0;
+    refresh_extent();
 
     // set objtype attribute.
     write_object_type(rastertype);
@@ -86,98 +252,576 @@ namespace GeoStar {
 
 
 
- template <>  H5::PredType Raster::getHdf5Type<uint8_t>() {return
-H5::PredType::NATIVE_UINT8;}
-    template <>  H5::PredType Raster::getHdf5Type<int8_t>() {return
-H5::PredType::NATIVE_INT8;}
-    template <>  H5::PredType Raster::getHdf5Type<uint16_t>() {return
-H5::PredType::NATIVE_UINT16;}
-    template <>  H5::PredType Raster::getHdf5Type<int16_t>() {return
-H5::PredType::NATIVE_INT16;}
-    template <>  H5::PredType Raster::getHdf5Type<uint32_t>() {return
-H5::PredType::NATIVE_UINT32;}
-    template <>  H5::PredType Raster::getHdf5Type<int32_t>() {return
-H5::PredType::NATIVE_INT32;}
-    template <>  H5::PredType Raster::getHdf5Type<uint64_t>() {return
-H5::PredType::NATIVE_UINT64;}
-    template <>  H5::PredType Raster::getHdf5Type<int64_t>() {return
-H5::PredType::NATIVE_INT64;}
-    template <>  H5::PredType Raster::getHdf5Type<float>() {return
-H5::PredType::NATIVE_FLOAT;}
-    template <>  H5::PredType Raster::getHdf5Type<double>() {return
-H5::PredType::NATIVE_DOUBLE;}
+  Raster::Raster(const std::string &name, const RasterType &type, const long int &nx, const long int &ny) {
+    RasterCreationErrorException RasterCreationError;
+    if(nx < 0 || ny < 0) throw RasterCreationError;
+
+    cache_type = getHdf5FileType(type);
+    const size_t bytes = (size_t)nx * ny * cache_type.getSize();
+
+    // never 0 bytes, so memory_pixels is set for every InMemoryRaster:
+    void *pixels = NULL;
+    if(posix_memalign(&pixels, RASTER_MEMORY_ALIGNMENT, std::max(bytes, RASTER_MEMORY_ALIGNMENT)) != 0) throw RasterCreationError;
+    memset(pixels, 0, bytes);
+    memory_pixels.reset(static_cast<char *>(pixels), free);
+
+    rasterobj = NULL;
+    rastername = name;
+    raster_datatype = type;
+    rastertype = "geostar::raster";
+    raster_nx = nx;
+    raster_ny = ny;
+    prefetch = false;
+    threads = 1;
+    write_cache = false;
+    cache_bytes = 0;
+    cache_tile[0] = std::max(nx, 1L);
+    cache_tile[1] = std::max(ny, 1L);
+
+  }// end-Raster-constructor
+
+
+
+  template <> H5::DataType Raster::getHdf5Type<uint8_t>()  {return H5::PredType::NATIVE_UINT8;}
+  template <> H5::DataType Raster::getHdf5Type<int8_t>()   {return H5::PredType::NATIVE_INT8;}
+  template <> H5::DataType Raster::getHdf5Type<uint16_t>() {return H5::PredType::NATIVE_UINT16;}
+  template <> H5::DataType Raster::getHdf5Type<int16_t>()  {return H5::PredType::NATIVE_INT16;}
+  template <> H5::DataType Raster::getHdf5Type<uint32_t>() {return H5::PredType::NATIVE_UINT32;}
+  template <> H5::DataType Raster::getHdf5Type<int32_t>()  {return H5::PredType::NATIVE_INT32;}
+  template <> H5::DataType Raster::getHdf5Type<uint64_t>() {return H5::PredType::NATIVE_UINT64;}
+  template <> H5::DataType Raster::getHdf5Type<int64_t>()  {return H5::PredType::NATIVE_INT64;}
+  template <> H5::DataType Raster::getHdf5Type<float>()    {return H5::PredType::NATIVE_FLOAT;}
+  template <> H5::DataType Raster::getHdf5Type<double>()   {return H5::PredType::NATIVE_DOUBLE;}
+
+  // std::complex<T> is laid out as T[2], real part first:
+  template <> H5::DataType Raster::getHdf5Type<std::complex<float> >() {
+    return complex_type(H5::PredType::NATIVE_FLOAT);
+  }
+  template <> H5::DataType Raster::getHdf5Type<std::complex<double> >() {
+    return complex_type(H5::PredType::NATIVE_DOUBLE);
+  }
+
+
+
+  H5::DataType Raster::getHdf5FileType(const RasterType &type) {
+    RasterCreationErrorException RasterCreationError;
+
+    switch(type) {
+    case INT8U:           return H5::PredType::NATIVE_UINT8;
+    case INT8S:           return H5::PredType::NATIVE_INT8;
+    case INT16U:          return H5::PredType::NATIVE_UINT16;
+    case INT16S:          return H5::PredType::NATIVE_INT16;
+    case INT32U:          return H5::PredType::NATIVE_UINT32;
+    case INT32S:          return H5::PredType::NATIVE_INT32;
+    case INT64U:          return H5::PredType::NATIVE_UINT64;
+    case INT64S:          return H5::PredType::NATIVE_INT64;
+    case REAL32:          return H5::PredType::NATIVE_FLOAT;
+    case REAL64:          return H5::PredType::NATIVE_DOUBLE;
+    case COMPLEX_INT16:   return complex_type(H5::PredType::NATIVE_INT8);
+    case COMPLEX_INT32:   return complex_type(H5::PredType::NATIVE_INT16);
+    case COMPLEX_INT64:   return complex_type(H5::PredType::NATIVE_INT32);
+    case COMPLEX_INT128:  return complex_type(H5::PredType::NATIVE_INT64);
+    case COMPLEX_REAL64:  return complex_type(H5::PredType::NATIVE_FLOAT);
+    case COMPLEX_REAL128: return complex_type(H5::PredType::NATIVE_DOUBLE);
+    default:
+      throw RasterCreationError;
+    }// end case
+  }// end: getHdf5FileType
 
 
 
 
   //returns the actual size of the raster in the x-direction
   long int Raster::get_nx() const {
-    H5::DataSpace space=rasterobj->getSpace();
-    hsize_t dims[2];
-    space.getSimpleExtentDims(dims);
-    return dims[1];
+    return raster_nx;
   }// end: get_nx
 
   //returns the actual size of the raster in the y-direction
   long int Raster::get_ny() const {
-    H5::DataSpace space=rasterobj->getSpace();
-    hsize_t dims[2];
-    space.getSimpleExtentDims(dims);
-    return dims[0];
+    return raster_ny;
   }// end: get_ny
 
 
+  void Raster::refresh_extent() {
+    // an InMemoryRaster can not change size:
+    if(memory_pixels) return;
+
+    // cached tiles are laid out for the old extent:
+    flush();
+
+    file_space = rasterobj->getSpace();
+    hsize_t dims[2];
+    file_space.getSimpleExtentDims(dims);
+    raster_nx = dims[1];
+    raster_ny = dims[0];
+    mem_spaces.clear();
+
+    cache_type = rasterobj->getDataType();
+    if(!get_chunk_shape(cache_tile)) {
+      cache_tile[0] = std::max(raster_nx, 1L);
+      cache_tile[1] = std::max(RASTER_CACHE_TILE_PIXELS / cache_tile[0], 1L);
+    }// endif
+  }// end: refresh_extent
+
+
+  RasterType Raster::get_datatype() const {
+    return raster_datatype;
+  }// end: get_datatype
+
+
+  void Raster::set_prefetch(const bool &value) {
+    prefetch = value;
+  }// end: set_prefetch
+
+
+  bool Raster::get_prefetch() const {
+    return prefetch;
+  }// end: get_prefetch
+
+
+  void Raster::set_threads(const int &value) {
+    threads = (value > 0) ? value : std::max((int)std::thread::hardware_concurrency(), 1);
+  }// end: set_threads
+
+
+  int Raster::get_threads() const {
+    return threads;
+  }// end: get_threads
+
+
+  void Raster::set_write_cache(const bool &value) {
+    if(!value) flush();
+    write_cache = value;
+  }// end: set_write_cache
+
+
+  bool Raster::get_write_cache() const {
+    return write_cache;
+  }// end: get_write_cache
+
+
+  RasterIOCounters &Raster::io_counters() {
+    static RasterIOCounters counters;
+    return counters;
+  }// end: io_counters
+
+
+  void Raster::h5_read(const RasterSlice &slice, void *buffer, const H5::DataType &memType) const {
+    // size of the slice of data is the SAME as the size of the slice in the file:
+    const H5::DataSpace &memspace = memory_space(slice);
+    const H5::DataSpace &dataspace = select_file_space(slice);
+    rasterobj->read(buffer, memType, memspace, dataspace);
+
+    io_counters().read_calls++;
+    io_counters().bytes_read += slice.size() * memType.getSize();
+  }// end: h5_read
+
+
+  void Raster::h5_write(const RasterSlice &slice, const void *buffer, const H5::DataType &memType) const {
+    const H5::DataSpace &memspace = memory_space(slice);
+    const H5::DataSpace &dataspace = select_file_space(slice);
+    rasterobj->write(buffer, memType, memspace, dataspace);
+
+    io_counters().write_calls++;
+    io_counters().bytes_written += slice.size() * memType.getSize();
+  }// end: h5_write
+
+
+  void Raster::read_slice(const RasterSlice &slice, void *buffer, const H5::DataType &memType) const {
+    if(memory_pixels) {
+      memory_read(slice, buffer, memType);
+    } else if(cache_overlaps(slice)) {
+      cache_read(slice, buffer, memType);
+    } else {
+      h5_read(slice, buffer, memType);
+    }// endif
+  }// end: read_slice
+
+
+  void Raster::write_slice(const RasterSlice &slice, const void *buffer, const H5::DataType &memType) const {
+    FileReadOnlyException FileReadOnlyError;
+    if(memory_pixels) {
+      memory_write(slice, buffer, memType);
+      return;
+    }// endif
+    if(raster_file->read_only) throw FileReadOnlyError;
+
+    if(write_cache) {
+      cache_write(slice, buffer, memType);
+    } else {
+      h5_write(slice, buffer, memType);
+    }// endif
+  }// end: write_slice
+
+
+  // true if slice lies inside an nx by ny raster:
+  static bool slice_inside(const RasterSlice &slice, const long int &nx, const long int &ny) {
+    return slice.x0 >= 0 && slice.y0 >= 0 && slice.x0 + slice.dx <= nx && slice.y0 + slice.dy <= ny;
+  }// end: slice_inside
+
+
+  // tile rows and columns touched by slice, last ones included:
+  static void tile_range(const RasterSlice &slice, const long int *tile, long int *range) {
+    range[0] = slice.x0 / tile[0];
+    range[1] = slice.y0 / tile[1];
+    range[2] = (slice.x0 + slice.dx - 1) / tile[0];
+    range[3] = (slice.y0 + slice.dy - 1) / tile[1];
+  }// end: tile_range
+
+
+  // n pixels from one type to another, converted as HDF5 converts them; row is room for the conversion
+  static void copy_pixels(const char *from, const H5::DataType &fromType, char *to, const H5::DataType &toType,
+                          const long int &n, std::vector<char> &row) {
+    const size_t fromSize = fromType.getSize();
+    const size_t toSize = toType.getSize();
+    if(fromType == toType) {
+      memcpy(to, from, n * toSize);
+    } else if(toSize >= fromSize) {
+      // convert in place at the destination:
+      memcpy(to, from, n * fromSize);
+      fromType.convert(toType, n, to, NULL);
+    } else {
+      row.resize(n * fromSize);
+      memcpy(&row[0], from, n * fromSize);
+      fromType.convert(toType, n, &row[0], NULL);
+      memcpy(to, &row[0], n * toSize);
+    }// endif
+  }// end: copy_pixels
+
+
+  void Raster::memory_read(const RasterSlice &slice, void *buffer, const H5::DataType &memType) const {
+    SliceSizeException SliceSizeError;
+    if(!slice_inside(slice, raster_nx, raster_ny)) throw SliceSizeError;
+    if(slice.dx < 1 || slice.dy < 1) return;
+
+    const size_t memSize = memType.getSize();
+    const size_t pixelSize = cache_type.getSize();
+    std::vector<char> row;
+
+    // whole rows are one run of pixels:
+    const bool wholeRows = slice.dx == raster_nx;
+    const long int n = wholeRows ? slice.size() : slice.dx;
+    const long int runs = wholeRows ? 1 : slice.dy;
+    for(long int r=0; r<runs; ++r) {
+      copy_pixels(memory_pixels.get() + ((slice.y0 + r) * raster_nx + slice.x0) * pixelSize, cache_type,
+                  (char *)buffer + r * n * memSize, memType, n, row);
+    }// endfor: r
+  }// end: memory_read
+
+
+  void Raster::memory_write(const RasterSlice &slice, const void *buffer, const H5::DataType &memType) const {
+    SliceSizeException SliceSizeError;
+    if(!slice_inside(slice, raster_nx, raster_ny)) throw SliceSizeError;
+    if(slice.dx < 1 || slice.dy < 1) return;
+
+    const size_t memSize = memType.getSize();
+    const size_t pixelSize = cache_type.getSize();
+    std::vector<char> row;
+
+    const bool wholeRows = slice.dx == raster_nx;
+    const long int n = wholeRows ? slice.size() : slice.dx;
+    const long int runs = wholeRows ? 1 : slice.dy;
+    for(long int r=0; r<runs; ++r) {
+      copy_pixels((const char *)buffer + r * n * memSize, memType,
+                  memory_pixels.get() + ((slice.y0 + r) * raster_nx + slice.x0) * pixelSize, cache_type, n, row);
+    }// endfor: r
+  }// end: memory_write
+
+
+  bool Raster::is_in_memory() const {
+    return memory_pixels.get() != NULL;
+  }// end: is_in_memory
+
+
+  InMemoryRaster *Raster::load() const {
+    InMemoryRaster *ras = new InMemoryRaster(rastername, raster_datatype, raster_nx, raster_ny);
+    try {
+      // the whole raster in one read, already in the copy's type:
+      if(raster_nx > 0 && raster_ny > 0) {
+        read_slice(RasterSlice(0, 0, raster_nx, raster_ny), ras->data(), ras->cache_type);
+      }// endif
+    } catch(...) {
+      delete ras;
+      throw;
+    }
+    return ras;
+  }// end: load
+
+
+  // unmaps a region mapped by Raster::map_file
+  struct Unmapper {
+    void *base;
+    size_t length;
+    Unmapper(void *start, const size_t &bytes) : base(start), length(bytes) {}
+    void operator()(const char *) const { munmap(base, length); }
+  }; // end: Unmapper
+
+
+  std::shared_ptr<const char> Raster::map_file(const H5::DataType &memType) const {
+    if(raster_nx < 1 || raster_ny < 1) return std::shared_ptr<const char>();
+    if(memory_pixels) {
+      if(!(memType == cache_type)) return std::shared_ptr<const char>();
+      return std::shared_ptr<const char>(memory_pixels, memory_pixels.get());
+    }// endif
+
+    // a plain array of memType, nothing in between:
+    if(!(memType == cache_type)) return std::shared_ptr<const char>();
+    if(rasterobj->getCreatePlist().getLayout() != H5D_CONTIGUOUS) return std::shared_ptr<const char>();
+
+    // only the default (sec2) driver keeps the file on disk as it is:
+    hid_t fapl = H5Fget_access_plist(raster_file->h5file.getId());
+    const hid_t driver = H5Pget_driver(fapl);
+    H5Pclose(fapl);
+    if(driver != H5FD_SEC2) return std::shared_ptr<const char>();
+
+    // everything written so far has to be in the file:
+    if(!raster_file->read_only) {
+      flush();
+      raster_file->h5file.flush(H5F_SCOPE_LOCAL);
+    }// endif
+
+    // no address until the first write:
+    const haddr_t offset = H5Dget_offset(rasterobj->getId());
+    if(offset == HADDR_UNDEF) return std::shared_ptr<const char>();
+    const size_t align = std::min(memType.getSize(), sizeof(double));
+    if(offset % align != 0) return std::shared_ptr<const char>();
+
+    // mmap wants a page-aligned offset:
+    const size_t bytes = (size_t)raster_nx * raster_ny * memType.getSize();
+    const haddr_t page = sysconf(_SC_PAGESIZE);
+    const haddr_t start = offset - offset % page;
+    const size_t length = bytes + (offset - start);
+
+    const int fd = open(raster_file->filename.c_str(), O_RDONLY);
+    if(fd < 0) return std::shared_ptr<const char>();
+    void *base = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, start);
+    close(fd);
+    if(base == MAP_FAILED) return std::shared_ptr<const char>();
+    // views are mostly scanned front to back: read ahead, and start now
+    madvise(base, length, MADV_SEQUENTIAL);
+    madvise(base, length, MADV_WILLNEED);
+
+    return std::shared_ptr<const char>(static_cast<const char *>(base) + (offset - start), Unmapper(base, length));
+  }// end: map_file
+
+
+  bool Raster::cache_overlaps(const RasterSlice &slice) const {
+    if(cache_tiles.empty() || slice.dx < 1 || slice.dy < 1) return false;
+
+    long int range[4];
+    tile_range(slice, cache_tile, range);
+    for(long int ty=range[1]; ty<=range[3]; ++ty) {
+      for(long int tx=range[0]; tx<=range[2]; ++tx) {
+        if(cache_tiles.count(std::make_pair(ty, tx))) return true;
+      }// endfor: tx
+    }// endfor: ty
+    return false;
+  }// end: cache_overlaps
+
+
+  // tile (tx,ty), read from the file the first time, unless slice covers it
+  RasterTile &Raster::cached_tile(const long int &tx, const long int &ty, const RasterSlice &slice) const {
+    std::pair<long int, long int> key(ty, tx);
+    std::map<std::pair<long int, long int>, RasterTile>::iterator found = cache_tiles.find(key);
+    if(found != cache_tiles.end()) return found->second;
+
+    RasterTile tile;
+    tile.area.x0 = tx * cache_tile[0];
+    tile.area.y0 = ty * cache_tile[1];
+    tile.area.dx = std::min(cache_tile[0], raster_nx - tile.area.x0);
+    tile.area.dy = std::min(cache_tile[1], raster_ny - tile.area.y0);
+    tile.data.resize(tile.area.size() * cache_type.getSize());
+    tile.dirty = false;
+
+    const bool covered = slice.x0 <= tile.area.x0 && slice.x0 + slice.dx >= tile.area.x0 + tile.area.dx
+                      && slice.y0 <= tile.area.y0 && slice.y0 + slice.dy >= tile.area.y0 + tile.area.dy;
+    if(!covered) h5_read(tile.area, &tile.data[0], cache_type);
+
+    cache_bytes += tile.data.size();
+    RasterTile &cached = cache_tiles[key];
+    cached.area = tile.area;
+    cached.data.swap(tile.data);
+    cached.dirty = false;
+    return cached;
+  }// end: cached_tile
+
+
+  void Raster::cache_read(const RasterSlice &slice, void *buffer, const H5::DataType &memType) const {
+    SliceSizeException SliceSizeError;
+    if(!slice_inside(slice, raster_nx, raster_ny)) throw SliceSizeError;
+
+    const size_t memSize = memType.getSize();
+    const size_t tileSize = cache_type.getSize();
+    const bool convert = !(memType == cache_type);
+    std::vector<char> row;
+
+    // the file, then the tiles in the cache over it; tiles not in the cache stay out of it:
+    h5_read(slice, buffer, memType);
+
+    long int range[4];
+    tile_range(slice, cache_tile, range);
+    for(long int ty=range[1]; ty<=range[3]; ++ty) {
+      for(long int tx=range[0]; tx<=range[2]; ++tx) {
+        std::map<std::pair<long int, long int>, RasterTile>::const_iterator found =
+          cache_tiles.find(std::make_pair(ty, tx));
+        if(found == cache_tiles.end()) continue;
+        const RasterTile &tile = found->second;
+
+        // part of the slice inside the tile:
+        const long int x0 = std::max(slice.x0, tile.area.x0);
+        const long int x1 = std::min(slice.x0 + slice.dx, tile.area.x0 + tile.area.dx);
+        const long int y0 = std::max(slice.y0, tile.area.y0);
+        const long int y1 = std::min(slice.y0 + slice.dy, tile.area.y0 + tile.area.dy);
+        const long int n = x1 - x0;
+        row.resize(n * std::max(memSize, tileSize));
+
+        for(long int y=y0; y<y1; ++y) {
+          memcpy(&row[0], &tile.data[((y - tile.area.y0) * tile.area.dx + x0 - tile.area.x0) * tileSize], n * tileSize);
+          if(convert) cache_type.convert(memType, n, &row[0], NULL);
+          memcpy((char *)buffer + ((y - slice.y0) * slice.dx + x0 - slice.x0) * memSize, &row[0], n * memSize);
+        }// endfor: y
+      }// endfor: tx
+    }// endfor: ty
+  }// end: cache_read
+
+
+  void Raster::cache_write(const RasterSlice &slice, const void *buffer, const H5::DataType &memType) const {
+    SliceSizeException SliceSizeError;
+    if(!slice_inside(slice, raster_nx, raster_ny)) throw SliceSizeError;
+
+    if(slice.dx < 1 || slice.dy < 1) return;
+    if(cache_bytes > RASTER_WRITE_CACHE_BYTES) flush();
+
+    const size_t memSize = memType.getSize();
+    const size_t tileSize = cache_type.getSize();
+    const bool convert = !(memType == cache_type);
+    std::vector<char> row;
+
+    long int range[4];
+    tile_range(slice, cache_tile, range);
+    for(long int ty=range[1]; ty<=range[3]; ++ty) {
+      for(long int tx=range[0]; tx<=range[2]; ++tx) {
+        RasterTile &tile = cached_tile(tx, ty, slice);
+
+        // part of the slice inside the tile:
+        const long int x0 = std::max(slice.x0, tile.area.x0);
+        const long int x1 = std::min(slice.x0 + slice.dx, tile.area.x0 + tile.area.dx);
+        const long int y0 = std::max(slice.y0, tile.area.y0);
+        const long int y1 = std::min(slice.y0 + slice.dy, tile.area.y0 + tile.area.dy);
+        const long int n = x1 - x0;
+        row.resize(n * std::max(memSize, tileSize));
+
+        for(long int y=y0; y<y1; ++y) {
+          memcpy(&row[0], (const char *)buffer + ((y - slice.y0) * slice.dx + x0 - slice.x0) * memSize, n * memSize);
+          if(convert) memType.convert(cache_type, n, &row[0], NULL);
+          memcpy(&tile.data[((y - tile.area.y0) * tile.area.dx + x0 - tile.area.x0) * tileSize], &row[0], n * tileSize);
+        }// endfor: y
+        tile.dirty = true;
+      }// endfor: tx
+    }// endfor: ty
+  }// end: cache_write
+
+
+  void Raster::flush() const {
+    while(!cache_tiles.empty()) {
+      std::map<std::pair<long int, long int>, RasterTile>::iterator tile = cache_tiles.begin();
+      if(tile->second.dirty) h5_write(tile->second.area, &tile->second.data[0], cache_type);
+      cache_bytes -= tile->second.data.size();
+      cache_tiles.erase(tile);
+    }// endwhile
+  }// end: flush
+
+
+  const H5::DataSpace &Raster::select_file_space(const RasterSlice &slice) const {
+    hsize_t count[2];
+    hsize_t start[2];
+    start[0]=slice.y0;
+    start[1]=slice.x0;
+    count[0]=slice.dy;
+    count[1]=slice.dx;
+    file_space.selectHyperslab(H5S_SELECT_SET, count, start);
+    return file_space;
+  }// end: select_file_space
+
+
+  const H5::DataSpace &Raster::memory_space(const RasterSlice &slice) const {
+    std::pair<long int, long int> shape(slice.dy, slice.dx);
+    std::map<std::pair<long int, long int>, H5::DataSpace>::iterator found = mem_spaces.find(shape);
+    if(found != mem_spaces.end()) return found->second;
+
+    // random slice shapes should not grow the map without bound:
+    if(mem_spaces.size() >= RASTER_MAX_MEMSPACES) mem_spaces.clear();
+
+    hsize_t memdims[2];
+    memdims[0]=slice.dy;
+    memdims[1]=slice.dx;
+    return mem_spaces.insert(std::make_pair(shape, H5::DataSpace(2,memdims))).first->second;
+  }// end: memory_space
+
+
+  bool Raster::get_chunk_shape(long int *chunkShape) const {
+    if(memory_pixels) {
+      chunkShape[0] = get_nx();
+      chunkShape[1] = get_ny();
+      return false;
+    }// endif
+
+    H5::DSetCreatPropList plist = rasterobj->getCreatePlist();
+    if(plist.getLayout() != H5D_CHUNKED) {
+      chunkShape[0] = get_nx();
+      chunkShape[1] = get_ny();
+      return false;
+    }// endif
+
+    hsize_t chunk[2];
+    plist.getChunk(2, chunk);
+    chunkShape[0] = chunk[1];
+    chunkShape[1] = chunk[0];
+    return true;
+  }// end: get_chunk_shape
+
+
+  // whole-row bands of about RASTER_BLOCK_PIXELS pixels,
+  // a whole number of chunks high for chunked rasters:
+  void Raster::default_block_shape(long int *blockShape) const {
+    long int nx = get_nx();
+    long int ny = get_ny();
+
+    blockShape[0] = std::max(nx, 1L);
+    blockShape[1] = RASTER_BLOCK_PIXELS / blockShape[0];
+
+    long int chunkShape[2];
+    const bool chunked = get_chunk_shape(chunkShape);
+    if(chunked) {
+      blockShape[1] = std::max(blockShape[1] / chunkShape[1], 1L) * chunkShape[1];
+    }// endif
+
+    // enough bands for every thread:
+    if(threads > 1) {
+      const long int bands = RASTER_BLOCKS_PER_THREAD * threads;
+      long int rows = std::max((ny + bands - 1) / bands, 1L);
+      if(chunked) rows = std::max(rows / chunkShape[1], 1L) * chunkShape[1];
+      blockShape[1] = std::min(blockShape[1], rows);
+    }// endif
+
+    if(blockShape[1] > ny) blockShape[1] = ny;
+    if(blockShape[1] < 1)  blockShape[1] = 1;
+  }// end: default_block_shape
+
+
   // in-place simple threshhold
   // < value : set to 0.
   void Raster::thresh(const double &value) {
-    long int nx = get_nx();
-    long int ny = get_ny();
 
-    vector<long int>slice(4);
-    slice[0]=0;
-    slice[1]=0;
-    slice[2]=nx;
-    slice[3]=1;
-
-    vector<float>data(nx);
-
-    for(int line=0;line<ny;++line) {
-      slice[1]=line;
-      read(slice, data);
-      for(int pixel=0; pixel<nx;++pixel) {
-        if(data[pixel] < value) data[pixel]=0;
-      }// endfor: pixel
-      write(slice, data);
-    }// endfor: line
+    map_pixels<float>(this, ThreshPixel(value));
 
   }// end: thresh
 
 
   // writes to different/existing channel
   void Raster::scale(Raster *ras_out, const double &offset, const double &mult) const {
-    long int nx = get_nx();
-    long int ny = get_ny();
-    int i;
 
-    vector<long int>slice(4);
-    slice[0]=0;
-    slice[1]=0;
-    slice[2]=nx;
-    slice[3]=1;
-
-    vector<float>indata(nx);
-    vector<float>outdata(nx);
-
-    for(int line=0;line<ny;++line) {
-      slice[1]=line;
-      read(slice,indata);
-      for(int pixel=0; pixel<nx;++pixel) {
-        i = mult*(indata[pixel]-offset);
-        if (i<0)   i=0;
-        outdata[pixel]= i;
-      }// endfor: pixel
-      ras_out->write(slice, outdata);
-    }// endfor: line
+    map_pixels<float>(ras_out, ScalePixel(offset, mult));
 
   }// end: scale
 
@@ -186,7 +830,6 @@ H5::PredType::NATIVE_DOUBLE;}
   void Raster::copy(const long int *inslice, Raster *ras_out) const {
     SliceSizeException SliceSizeError;
 
-	int i;
   //check and see if the input and output slices fit in their respective rasters
   	long int nx_in = get_nx();
 	long int ny_in = get_ny();
@@ -200,27 +843,23 @@ H5::PredType::NATIVE_DOUBLE;}
 	if (nx_out < (inslice[2])) throw SliceSizeError;
 	if (ny_out < (inslice[3])) throw SliceSizeError;
 
+    // copy in bands of whole rows of the slice:
+    long int nlines = RASTER_BLOCK_PIXELS / std::max(inslice[2], 1L);
+    if (nlines < 1) nlines = 1;
 
-    vector<long int>islice(4);
-    islice[0]=inslice[0];
-    islice[1]=0;
-    islice[2]=inslice[2]; //nx
-    islice[3]=1;
+    RasterSlice islice(inslice[0], 0, inslice[2], nlines);
+    RasterSlice oslice(0, 0, inslice[2], nlines);
 
-    vector<long int>oslice(4);
-    oslice[0]=0;
-    oslice[1]=0;
-    oslice[2]=inslice[2]; //nx
-    oslice[3]=1;
+    vector<float>data(inslice[2]*nlines);
 
-    vector<float>data(inslice[2]);
+    for(long int line=inslice[1];line<inslice[1]+inslice[3];line+=nlines) {
+      islice.y0=line;
+      islice.dy=std::min(nlines, inslice[1]+inslice[3]-line);
+      read(islice, data.data(), data.size());
 
-    for(int line=inslice[1];line<inslice[1]+inslice[3];++line) {
-      islice[1]=line;
-      read(islice,data);
-
-      oslice[1]=line-inslice[1];
-      ras_out->write(oslice, data);
+      oslice.y0=line-inslice[1];
+      oslice.dy=islice.dy;
+      ras_out->write(oslice, data.data(), data.size());
     }// endfor: line
 
 
@@ -241,11 +880,7 @@ H5::PredType::NATIVE_DOUBLE;}
 	if (nx < (slice[0] + slice[2])) throw SliceSizeError;
 	if (ny < (slice[1] + slice[3])) throw SliceSizeError;
 
-    vector<long int>islice(4);
-    islice[0]=slice[0];
-    islice[1]=slice[1];
-    islice[2]=slice[2];
-    islice[3]=slice[3];
+    RasterSlice islice(slice);
 
     long int num = slice[2]*slice[3];
     vector<float>data(num);
@@ -255,7 +890,7 @@ H5::PredType::NATIVE_DOUBLE;}
       data[i]=value;
     }// endfor
 
-    write(islice, data);
+    write(islice, data.data(), data.size());
 
   }// end: set
 
@@ -448,32 +1083,23 @@ void Raster::drawFilledRectangle(std::vector<long int>slice, const int radius, c
 	if (nx != nx_out) throw RasterSizeError;
 	if (ny != ny_out) throw RasterSizeError;
 
-	double temp = 0;
-	std::vector<long int> slice(4);
-	slice[0] = 0;
-	slice[1] = 0;
-	slice[2] = nx;
-	slice[3] = 1;
-
 	//init random seed, to limit pseudorandom results
 	srand((unsigned)time(NULL));
 
-	std::vector<double> data(nx);
-
-	//loop through image line by line, calculating random value between 0 and 1		
-	for (int i = 0; i < ny; ++i) {
-		slice[1] = i;
-		read(slice, data);
-	 for (int j = 0; j < nx; ++j) {
+	//loop through image a band of lines at a time, calculating random value between 0 and 1
+	for_each_block<double>(NULL, rasterOut,
+	  [low, high](const std::vector<long int> &slice, std::vector<double> &data) {
+		double temp = 0;
+		long int npixels = slice[2] * slice[3];
+		for (long int j = 0; j < npixels; ++j) {
 		temp = ((double)rand() / (double)(RAND_MAX));
 		//set values equal to 0 if below low thresh, or higher than high thresh
 		if (temp <= low) data[j] = 0;
 		else if (temp >= high) data[j] = 15000;
-	  }//endfor
-	rasterOut->write(slice, data);
-	}//endfor
-	
-	
+		}//endfor
+	  });
+
+
  }//end--addSaltPepper
 
  void Raster::bitShift(Raster *rasterOut, int bits, bool direction) {
@@ -489,37 +1115,17 @@ void Raster::drawFilledRectangle(std::vector<long int>slice, const int radius, c
 	if (nx != nx_out) throw RasterSizeError;
 	if (ny != ny_out) throw RasterSizeError;
 
-	std::vector<long int> slice(4);
-	slice[0] = 0;
-	slice[1] = 0;
-	slice[2] = nx;
-	slice[3] = 1;
-	
-	std::vector<float> data(nx);
-	
-	//loop through image and bitshift right or left, line by line
-	if (direction) {
-	double inverse = 1 / pow(2, bits);
-	  for (int i = 0; i < ny; ++i) {
-		slice[1] = i;
-		read(slice, data);
-	    for (int j = 0; j < nx; ++j) {
-		data[j] *= inverse;
-	    }//endfor
-	    rasterOut->write(slice, data);
-	  }//endfor
-	}//endif
-	
-	else {
-	for (int i = 0; i < ny; ++i) {
-		slice[1] = i;
-		read(slice, data);
-	 for (int j = 0; j < nx; ++j) {
-		data[j] *= pow(2, bits);
-	  }//endfor
-	rasterOut->write(slice, data);
-	}//endfor
-	}//endelse
+	//shifting right divides by 2^bits, shifting left multiplies by 2^bits
+	const double factor = direction ? 1 / pow(2, bits) : pow(2, bits);
+
+	//loop through image and bitshift right or left, block by block
+	for_each_block<float>(NULL, rasterOut,
+	  [factor](const std::vector<long int> &slice, std::vector<float> &data) {
+		long int npixels = slice[2] * slice[3];
+		for (long int j = 0; j < npixels; ++j) {
+		data[j] *= factor;
+		}//endfor
+	  });
 
 
  }//end--bitShift
@@ -539,62 +1145,592 @@ void Raster::drawFilledRectangle(std::vector<long int>slice, const int radius, c
 	if (partitions <= 0) throw PartitionError;
 	if (partitions > 150) throw PartitionError;
 
-	double partitionSizeX = nx / partitions;
-	double partitionSizeY = ny / partitions;
-	
-   vector<long int>slice(4);
-    slice[0]=0;
-    slice[1]=0;
-    slice[2]=partitionSizeX;
-    slice[3]=1;
-
-    vector<double>data;
-    double threshhold = 0;
-    double max = 0;
-    double min = 0;
-
-//first define the slice loops, x and y which go through the sectors.  reset thresh variables
-for (int y = 0; y < partitions; ++y) {
- for (int x = 0; x < partitions; ++x) {
-	slice[0] = x * partitionSizeX;
-	max = 0;
-	min = 100000; //assign large num to min to init - can't reassign variable to a data pt with every read
-	threshhold = 0;
-//then the interior loops, which go into the actual sectors and do the reading and writing
-
-//first find max and min and compute average
-   for (int i = 0; i < partitionSizeY; ++i) {
-	slice[1] = i + y * partitionSizeY;
-	read(slice, data);
-     for (int j = 0; j < partitionSizeX; ++j) {
-	if (data[j] < min) min = data[j];
-	if (data[j] > max) max = data[j];
-	}//endfor - j
-    }//endfor - i
-
-	//not sure exactly what factor this should be divided by.  Gets better as partitions grow.
-	threshhold = (max + min) / 3;
-	
+	long int partitionSizeX = nx / partitions;
+	long int partitionSizeY = ny / partitions;
+	if (partitionSizeX < 1 || partitionSizeY < 1) return;
 
-//then perform threshholding operation
-   for (int p = 0; p < partitionSizeY; ++p) {
-	slice[1] = p + y * partitionSizeY;
-	read(slice, data);
-     for (int q = 0; q < partitionSizeX; ++q) {
-	if (data[q] < threshhold) data[q] = 0;
-	}//endfor - q
-	rasterOut->write(slice, data);
-    }//endfor - p
+	//each partition is one block: read it once, find max and min, then threshhold and write it
+	long int window[4] = {0, 0, partitions * partitionSizeX, partitions * partitionSizeY};
+	long int blockShape[2] = {partitionSizeX, partitionSizeY};
+
+	for_each_block<double>(window, blockShape, rasterOut,
+	  [](const vector<long int> &slice, vector<double> &data) {
+		long int npixels = slice[2] * slice[3];
+		double max = 0;
+		double min = 100000; //assign large num to min to init
+		double threshhold = 0;
+
+		//first find max and min and compute average
+		for (long int j = 0; j < npixels; ++j) {
+		if (data[j] < min) min = data[j];
+		if (data[j] > max) max = data[j];
+		}//endfor - j
 
-  }//endfor - x
-}//endfor - y
+		//not sure exactly what factor this should be divided by.  Gets better as partitions grow.
+		threshhold = (max + min) / 3;
+
+		//then perform threshholding operation
+		for (long int q = 0; q < npixels; ++q) {
+		if (data[q] < threshhold) data[q] = 0;
+		}//endfor - q
+	  });
 
  }//end - autoLocalThresh
 
 
 
-  void Raster::FFT_2D(GeoStar::Image *img, Raster *rasOutReal, Raster *rasOutImg) {
+  // fftw_malloc'd array of n T, freed when it goes out of scope.  fftw_malloc aligns as fftwf_malloc does, so
+  // the arrays serve the single-precision plans too
+  template<typename T>
+  struct FFTWArray {
+    T *data;
+    explicit FFTWArray(const long int &n) : data(static_cast<T*>(fftw_malloc(sizeof(T) * std::max(n, 1L)))) {
+      if (data == NULL) throw std::bad_alloc();
+    }
+    ~FFTWArray() { fftw_free(data); }
+  private:
+    FFTWArray(const FFTWArray &);
+    FFTWArray &operator=(const FFTWArray &);
+  }; // end: FFTWArray
+
+
+
+  // reads or writes a slice of a spectrum as complex values of precision R: from a complex raster, or a pair of
+  // real ones
+  template<typename R>
+  struct Spectrum {
+    typedef std::function<void(const RasterSlice &, std::complex<R> *)> Reader;
+    typedef std::function<void(const RasterSlice &, const std::complex<R> *)> Writer;
+  }; // end: Spectrum
+
+  template<typename R>
+  static typename Spectrum<R>::Reader complex_reader(const Raster *in) {
+	return [in](const RasterSlice &slice, std::complex<R> *data) { in->read(slice, data, slice.size()); };
+  }// end: complex_reader
+
+  template<typename R>
+  static typename Spectrum<R>::Reader parts_reader(const Raster *re, const Raster *im) {
+	return [re, im](const RasterSlice &slice, std::complex<R> *data) {
+	  std::vector<R> dataRe(slice.size());
+	  std::vector<R> dataIm(slice.size());
+	  re->read(slice, &dataRe[0], dataRe.size());
+	  im->read(slice, &dataIm[0], dataIm.size());
+	  for (long int i = 0; i < slice.size(); ++i) data[i] = std::complex<R>(dataRe[i], dataIm[i]);
+	};
+  }// end: parts_reader
+
+  template<typename R>
+  static typename Spectrum<R>::Writer complex_writer(Raster *out) {
+	return [out](const RasterSlice &slice, const std::complex<R> *data) { out->write(slice, data, slice.size()); };
+  }// end: complex_writer
+
+  template<typename R>
+  static typename Spectrum<R>::Writer parts_writer(Raster *re, Raster *im) {
+	return [re, im](const RasterSlice &slice, const std::complex<R> *data) {
+	  std::vector<R> dataRe(slice.size());
+	  std::vector<R> dataIm(slice.size());
+	  for (long int i = 0; i < slice.size(); ++i) {
+	    dataRe[i] = data[i].real();
+	    dataIm[i] = data[i].imag();
+	  }
+	  re->write(slice, &dataRe[0], dataRe.size());
+	  im->write(slice, &dataIm[0], dataIm.size());
+	};
+  }// end: parts_writer
+
+
+
+  static size_t &fft_memory_setting() {
+	static size_t bytes = RASTER_FFT_MEMORY;
+	return bytes;
+  }// end: fft_memory_setting
+
+
+  void Raster::set_fft_memory(const size_t &bytes) {
+	fft_memory_setting() = bytes;
+  }// end: set_fft_memory
+
+
+  size_t Raster::get_fft_memory() {
+	return fft_memory_setting();
+  }// end: get_fft_memory
+
+
+  // true if the pixels and the half spectrum of an nx x ny raster, in precision R, both fit in the FFT memory budget
+  template<typename R>
+  static bool fft_fits_in_core(const long int &nx, const long int &ny) {
+	const double bytes = (double(sizeof(R)) * nx + double(sizeof(std::complex<R>)) * (nx/2 + 1)) * ny;
+	return bytes <= double(Raster::get_fft_memory());
+  }// end: fft_fits_in_core
+
+
+  // true for the single-precision types: FFTs between rasters of only these run in single precision
+  static bool fft_single(const RasterType &type) {
+	return type == REAL32 || type == COMPLEX_REAL64;
+  }// end: fft_single
+
+
+  // type of the transpose of a double-precision FFT whose spectrum is of type: COMPLEX_REAL128, or COMPLEX_REAL64
+  // for a COMPLEX_REAL64 spectrum.  Never the spectrum's own type when that is a COMPLEX_INT, which would truncate
+  // the row transforms before the column pass
+  static RasterType fft_transpose_type(const RasterType &type) {
+	return (type == COMPLEX_REAL64) ? COMPLEX_REAL64 : COMPLEX_REAL128;
+  }// end: fft_transpose_type
+
+
+
+
+  // whole-raster FFT of in, in memory and precision R: one r2c transform.  Writes the half spectrum
+  // (nx_out = nx/2+1) or the full one, the other half filled in from X[y][x] = conj(X[-y][-x])
+  template<typename R>
+  static void fft_forward_in_core(const Raster *in, const long int &nx_out, const typename Spectrum<R>::Writer &write) {
+	const long int nx = in->get_nx();
+	const long int ny = in->get_ny();
+	const long int nh = nx/2 + 1;
+
+	FFTWArray<typename FFTW<R>::complex> half(nh * ny);
+	{
+	  FFTWArray<R> pixels(nx * ny);
+	  in->read(RasterSlice(0, 0, nx, ny), pixels.data, nx*ny);
+	  FFTW<R>::execute_r2c(FFTPlans::shared().r2c_2d<R>(ny, nx), pixels.data, half.data);
+	}
+
+	// FFTW's complex types have the layout of std::complex:
+	const std::complex<R> *spectrum = reinterpret_cast<const std::complex<R>*>(half.data);
+	const long int band = std::max(1L, std::min(ny, RASTER_BLOCK_PIXELS / nx_out));
+	std::vector<std::complex<R> > rows(nx == nx_out ? band*nx : 0);
+
+	for (long int y0 = 0; y0 < ny; y0 += band) {
+	  const long int dy = std::min(band, ny-y0);
+	  if (nx_out == nh) {
+	    write(RasterSlice(0, y0, nh, dy), spectrum + y0*nh);
+	    continue;
+	  }
+	  for (long int y = y0; y < y0+dy; ++y) {
+	    const std::complex<R> *row = spectrum + y*nh;
+	    const std::complex<R> *mirror = spectrum + ((ny-y) % ny)*nh;
+	    std::complex<R> *full = &rows[(y-y0)*nx];
+	    for (long int x = 0; x < nh; ++x) full[x] = row[x];
+	    for (long int x = nh; x < nx; ++x) full[x] = std::conj(mirror[nx-x]);
+	  }//endfor - y
+	  write(RasterSlice(0, y0, nx, dy), &rows[0]);
+	}//endfor - y0
+  }// end: fft_forward_in_core
+
+
+
+  // whole-raster inverse FFT, in memory and precision R: one c2r transform of the half spectrum read from a spectrum
+  // nx_in wide.  For a full spectrum X, the transform is of its Hermitian part (X[k] + conj(X[-k]))/2, whose inverse
+  // is the real part of the inverse of X.  The result, divided by scale, goes to out
+  template<typename R>
+  static void fft_inverse_in_core(const typename Spectrum<R>::Reader &read, const long int &nx_in, Raster *out,
+                                  const double &scale) {
+	const long int nx = out->get_nx();
+	const long int ny = out->get_ny();
+	const long int nh = nx/2 + 1;
+	const R one_half = 0.5;
+
+	FFTWArray<typename FFTW<R>::complex> half(nh * ny);
+	std::complex<R> *spectrum = reinterpret_cast<std::complex<R>*>(half.data);
+	const long int band = std::max(1L, std::min(ny, RASTER_BLOCK_PIXELS / nh));
+	for (long int y0 = 0; y0 < ny; y0 += band)
+	  read(RasterSlice(0, y0, nh, std::min(band, ny-y0)), spectrum + y0*nh);
+
+	if (nx_in != nh) {
+	  // columns 0 and nx/2 are their own mirrors: pair up their rows
+	  for (long int x = 0; x < nh; ++x) {
+	    if (x != (nx-x) % nx) continue;
+	    for (long int y = 0; y <= ny/2; ++y) {
+	      const long int my = (ny-y) % ny;
+	      const std::complex<R> a = spectrum[y*nh + x];
+	      const std::complex<R> b = spectrum[my*nh + x];
+	      spectrum[y*nh + x] = one_half * (a + std::conj(b));
+	      spectrum[my*nh + x] = one_half * (b + std::conj(a));
+	    }//endfor - y
+	  }//endfor - x
+
+	  // the mirrors of the other columns are past the half, read in bands of rows
+	  const long int rest = nx - nh;
+	  if (rest > 0) {
+	    const long int restBand = std::max(1L, std::min(ny, RASTER_BLOCK_PIXELS / rest));
+	    std::vector<std::complex<R> > strip(restBand * rest);
+	    for (long int y0 = 0; y0 < ny; y0 += restBand) {
+	      const long int dy = std::min(restBand, ny-y0);
+	      read(RasterSlice(nh, y0, rest, dy), &strip[0]);
+	      for (long int y = y0; y < y0+dy; ++y) {
+	        std::complex<R> *row = spectrum + ((ny-y) % ny)*nh;
+	        for (long int i = 0; i < rest; ++i) {
+	          const long int x = nx - (nh+i);
+	          row[x] = one_half * (row[x] + std::conj(strip[(y-y0)*rest + i]));
+	        }//endfor - i
+	      }//endfor - y
+	    }//endfor - y0
+	  }//endif
+	}//endif
+
+	FFTWArray<R> pixels(nx * ny);
+	FFTW<R>::execute_c2r(FFTPlans::shared().c2r_2d<R>(ny, nx), half.data, pixels.data);
+
+	for (long int i = 0; i < nx*ny; ++i) pixels.data[i] /= scale;
+	out->write(RasterSlice(0, 0, nx, ny), pixels.data, nx*ny);
+  }// end: fft_inverse_in_core
+
+
+
+  // edge of the square tiles of the transpose raster of an out-of-core FFT: RASTER_FFT_TILE, halved until that
+  // many rows of rowBytes, and of columnBytes, fit in the FFT memory budget
+  static long int fft_tile(const size_t &rowBytes, const size_t &columnBytes) {
+	const size_t budget = Raster::get_fft_memory();
+	long int tile = RASTER_FFT_TILE;
+	while (tile > 1 && (tile*rowBytes > budget || tile*columnBytes > budget)) tile /= 2;
+	return tile;
+  }// end: fft_tile
+
+
+  // rows of rowBytes each that fit in the FFT memory budget, in whole tiles: a multiple of tile, at least tile,
+  // at most n
+  static long int fft_band(const size_t &rowBytes, const long int &tile, const long int &n) {
+	const long int rows = long(Raster::get_fft_memory() / std::max(rowBytes, size_t(1)));
+	return std::min(n, std::max(tile, rows / tile * tile));
+  }// end: fft_band
+
+
+  // cols[x*dy + y] = rows[y*width + x]: dy rows of width pixels, transposed in blocks that stay in cache
+  template<typename C>
+  static void transpose_band(const C *rows, const long int &dy, const long int &width, C *cols) {
+	const long int block = 32;
+	for (long int y0 = 0; y0 < dy; y0 += block) {
+	  for (long int x0 = 0; x0 < width; x0 += block) {
+	    for (long int y = y0; y < std::min(y0+block, dy); ++y)
+	      for (long int x = x0; x < std::min(x0+block, width); ++x) cols[x*dy + y] = rows[y*width + x];
+	  }//endfor - x0
+	}//endfor - y0
+  }// end: transpose_band
+
+
+  // rows y0 to y0+dy (width pixels each) of the raster t is the transpose of: columns y0 to y0+dy of t
+  template<typename C>
+  static void write_transposed(Raster *t, const long int &y0, const long int &dy, const long int &width,
+                               const C *rows, std::vector<C> &buffer) {
+	buffer.resize(dy*width);
+	transpose_band(rows, dy, width, &buffer[0]);
+	t->write(RasterSlice(y0, 0, dy, width), &buffer[0], dy*width);
+  }// end: write_transposed
+
+
+  template<typename C>
+  static void read_transposed(const Raster *t, const long int &y0, const long int &dy, C *rows, std::vector<C> &buffer) {
+	const long int width = t->get_ny();
+	buffer.resize(dy*width);
+	t->read(RasterSlice(y0, 0, dy, width), &buffer[0], dy*width);
+	transpose_band(&buffer[0], width, dy, rows);
+  }// end: read_transposed
+
+
+  // FFT in precision R of every row of the transpose raster t, in place, in bands of whole tiles: the columns of
+  // the raster t is the transpose of
+  template<typename R>
+  static void fft_transposed_rows(Raster *t, const long int &tile, const int &sign) {
+	typedef typename FFTW<R>::complex Complex;
+	const long int n = t->get_nx();
+	const long int rows = t->get_ny();
+	const long int band = fft_band(sizeof(Complex) * n, tile, rows);
+	const typename FFTW<R>::plan plan = FFTPlans::shared().many_dft<R>(n, band, sign, true);
+
+	FFTWArray<Complex> data(band * n);
+	for (long int r0 = 0; r0 < rows; r0 += band) {
+	  // the last band may be short: the rows past it are transformed too, and not written
+	  const RasterSlice slice(0, r0, n, std::min(band, rows-r0));
+	  t->read(slice, reinterpret_cast<std::complex<R>*>(data.data), slice.size());
+	  FFTW<R>::execute_dft(plan, data.data, data.data);
+	  t->write(slice, reinterpret_cast<const std::complex<R>*>(data.data), slice.size());
+	}//endfor - r0
+  }// end: fft_transposed_rows
+
+
+
+  // the complex raster type of precision R: of the transposes of the out-of-core FFTs
+  template<typename R>
+  static RasterType fft_complex_type() {
+	return (sizeof(R) == sizeof(float)) ? COMPLEX_REAL64 : COMPLEX_REAL128;
+  }// end: fft_complex_type
+
+
+  // frequency of index k of an n-point transform, in cycles per pixel: from -0.5 up to, not including, 0.5
+  static double fft_frequency(const long int &k, const long int &n) {
+	return double((k < (n+1)/2) ? k : k-n) / n;
+  }// end: fft_frequency
+
+
+
+  // the rows of in, in bands of band rows, transformed in precision R and written to the raster t is the transpose
+  // of, nx_out wide: the full spectrum, or the half (nx/2+1)
+  template<typename R>
+  static void fft_rows_to_transposed(const Raster *in, const long int &band, const long int &nx_out, Raster *t) {
+	const long int nx = in->get_nx();
+	const long int ny = in->get_ny();
+	const long int nh = nx/2 + 1;
+
+	const typename FFTW<R>::plan plan = FFTPlans::shared().many_r2c<R>(nx, band);
+	FFTWArray<R> pixels(band * nx);
+	FFTWArray<typename FFTW<R>::complex> half(band * nh);
+	const std::complex<R> *spectrum = reinterpret_cast<const std::complex<R>*>(half.data);
+	std::vector<std::complex<R> > rows(nx_out == nh ? 0 : band*nx);
+	std::vector<std::complex<R> > buffer;
+	for (long int y0 = 0; y0 < ny; y0 += band) {
+	  const long int dy = std::min(band, ny-y0);
+	  in->read(RasterSlice(0, y0, nx, dy), pixels.data, nx*dy);
+	  FFTW<R>::execute_r2c(plan, pixels.data, half.data);
+	  if (nx_out == nh) {
+	    write_transposed(t, y0, dy, nh, spectrum, buffer);
+	    continue;
+	  }
+	  // the rest of each row from X[x] = conj(X[nx-x])
+	  for (long int y = 0; y < dy; ++y) {
+	    for (long int x = 0; x < nh; ++x) rows[y*nx + x] = spectrum[y*nh + x];
+	    for (long int x = nh; x < nx; ++x) rows[y*nx + x] = std::conj(spectrum[y*nh + nx-x]);
+	  }//endfor - y
+	  write_transposed(t, y0, dy, nx, &rows[0], buffer);
+	}//endfor - y0
+  }// end: fft_rows_to_transposed
+
+
+
+  // the rows of a spectrum nx_in wide (full, or the half nx/2+1) from the raster t, its transpose, in bands of band
+  // rows, inverse transformed in precision R: c2r from a half spectrum, the real part of complex rows from a full
+  // one.  The result, divided by scale, goes to out
+  template<typename R>
+  static void fft_rows_from_transposed(const Raster *t, const long int &band, const long int &nx_in, Raster *out,
+                                       const double &scale) {
+	typedef typename FFTW<R>::complex Complex;
+	const long int nx = out->get_nx();
+	const long int ny = out->get_ny();
+	const bool fromHalf = (nx_in == nx/2 + 1);
+
+	const typename FFTW<R>::plan plan = fromHalf ? FFTPlans::shared().many_c2r<R>(nx, band)
+	                                             : FFTPlans::shared().many_dft<R>(nx, band, FFTW_BACKWARD);
+	FFTWArray<Complex> rowsIn(band * nx_in);
+	std::complex<R> *rows = reinterpret_cast<std::complex<R>*>(rowsIn.data);
+	FFTWArray<Complex> rowsOut(fromHalf ? 0 : band * nx);
+	FFTWArray<R> pixels(band * nx);
+	std::vector<std::complex<R> > buffer;
+	for (long int y0 = 0; y0 < ny; y0 += band) {
+	  const long int dy = std::min(band, ny-y0);
+	  read_transposed(t, y0, dy, rows, buffer);
+	  if (fromHalf) {
+	    FFTW<R>::execute_c2r(plan, rowsIn.data, pixels.data);
+	    for (long int i = 0; i < nx*dy; ++i) pixels.data[i] /= scale;
+	  } else {
+	    FFTW<R>::execute_dft(plan, rowsIn.data, rowsOut.data);
+	    for (long int i = 0; i < nx*dy; ++i) pixels.data[i] = rowsOut.data[i][0] / scale;
+	  }
+	  out->write(RasterSlice(0, y0, nx, dy), pixels.data, nx*dy);
+	}//endfor - y0
+  }// end: fft_rows_from_transposed
+
+
+
+  // FFT in precision R of a raster too big for fft_forward_in_core, through a scratch raster of type (complex)
+  // holding the transpose of the spectrum in square tiles.  Rows are transformed in bands and written to it
+  // transposed, its rows (the columns) are transformed in bands, and it is read back transposed in bands of rows
+  // of the spectrum, written nx_out wide: the full spectrum, or the half (nx/2+1).  Every access is a band of
+  // whole rows of a raster or of whole tiles of the transpose.
+  template<typename R>
+  static void fft_forward_blocked(const Raster *in, const long int &nx_out, const RasterType &type,
+                                  const typename Spectrum<R>::Writer &write) {
+	typedef typename FFTW<R>::complex Complex;
+	const long int nx = in->get_nx();
+	const long int ny = in->get_ny();
+	const long int nh = nx/2 + 1;
+	const size_t rowBytes = sizeof(R)*nx + sizeof(Complex)*(nh + 2*nx_out);
+	const long int tile = fft_tile(rowBytes, sizeof(Complex) * ny);
+	const long int band = fft_band(rowBytes, tile, ny);
+
+	GeoStar::ScratchRaster transposed(Scratch::shared(), type, ny, nx_out, RasterLayout(TILED, tile));
+
+	// rows, then columns:
+	fft_rows_to_transposed<R>(in, band, nx_out, transposed.get());
+	fft_transposed_rows<R>(transposed.get(), tile, FFTW_FORWARD);
+
+	// back, in bands of rows:
+	std::vector<std::complex<R> > rows(band*nx_out);
+	std::vector<std::complex<R> > buffer;
+	for (long int y0 = 0; y0 < ny; y0 += band) {
+	  const long int dy = std::min(band, ny-y0);
+	  read_transposed(transposed.get(), y0, dy, &rows[0], buffer);
+	  write(RasterSlice(0, y0, nx_out, dy), &rows[0]);
+	}//endfor - y0
+  }// end: fft_forward_blocked
+
+
+
+  // inverse FFT in precision R of a spectrum too big for fft_inverse_in_core, nx_in wide (full, or the half
+  // nx/2+1), through a scratch raster of type (complex) holding its transpose in square tiles, as
+  // fft_forward_blocked: bands of rows are written to it transposed, its rows (the columns) are transformed, then
+  // it is read back transposed and the rows transformed (see fft_rows_from_transposed).  The result, divided by
+  // scale, goes to out
+  template<typename R>
+  static void fft_inverse_blocked(const typename Spectrum<R>::Reader &read, const long int &nx_in, const RasterType &type,
+                                  Raster *out, const double &scale) {
+	typedef typename FFTW<R>::complex Complex;
+	const long int nx = out->get_nx();
+	const long int ny = out->get_ny();
+	const bool fromHalf = (nx_in == nx/2 + 1);
+	const size_t rowBytes = sizeof(Complex)*(2*nx_in + (fromHalf ? 0 : nx)) + sizeof(R)*nx;
+	const long int tile = fft_tile(rowBytes, sizeof(Complex) * ny);
+	const long int band = fft_band(rowBytes, tile, ny);
+
+	GeoStar::ScratchRaster transposed(Scratch::shared(), type, ny, nx_in, RasterLayout(TILED, tile));
+
+	// rows, in bands, written transposed:
+	{
+	  std::vector<std::complex<R> > rows(band * nx_in);
+	  std::vector<std::complex<R> > buffer;
+	  for (long int y0 = 0; y0 < ny; y0 += band) {
+	    const long int dy = std::min(band, ny-y0);
+	    read(RasterSlice(0, y0, nx_in, dy), &rows[0]);
+	    write_transposed(transposed.get(), y0, dy, nx_in, &rows[0], buffer);
+	  }//endfor - y0
+	}
+
+	// columns, then rows:
+	fft_transposed_rows<R>(transposed.get(), tile, FFTW_BACKWARD);
+	fft_rows_from_transposed<R>(transposed.get(), band, nx_in, out, scale);
+  }// end: fft_inverse_blocked
+
+
+
+  // filter of a raster in memory, in precision R: one r2c transform, the half spectrum multiplied by the gains
+  // of filter over nx*ny, one c2r transform back.  Column x of the half spectrum is u = x/nx, from 0 to 0.5
+  template<typename R>
+  static void fft_filter_in_core(const Raster *in, Raster *out, const FrequencyFilter &filter) {
+	const long int nx = in->get_nx();
+	const long int ny = in->get_ny();
+	const long int nh = nx/2 + 1;
+	const double scale = double(nx) * ny;
+
+	FFTWArray<R> pixels(nx * ny);
+	FFTWArray<typename FFTW<R>::complex> half(nh * ny);
+	in->read(RasterSlice(0, 0, nx, ny), pixels.data, nx*ny);
+	FFTW<R>::execute_r2c(FFTPlans::shared().r2c_2d<R>(ny, nx), pixels.data, half.data);
+
+	std::complex<R> *spectrum = reinterpret_cast<std::complex<R>*>(half.data);
+	for (long int y = 0; y < ny; ++y) {
+	  const double v = fft_frequency(y, ny);
+	  for (long int x = 0; x < nh; ++x) spectrum[y*nh + x] *= R(filter(double(x) / nx, v) / scale);
+	}//endfor - y
+
+	FFTW<R>::execute_c2r(FFTPlans::shared().c2r_2d<R>(ny, nx), half.data, pixels.data);
+	out->write(RasterSlice(0, 0, nx, ny), pixels.data, nx*ny);
+  }// end: fft_filter_in_core
+
+
+
+  // the columns of the half spectrum of an nx-wide raster, the rows of its transpose t: transformed, multiplied by
+  // the gains of filter over nx*ny, and transformed back, in place, in bands of whole tiles
+  template<typename R>
+  static void fft_filter_transposed_rows(Raster *t, const long int &tile, const long int &nx,
+                                         const FrequencyFilter &filter) {
+	typedef typename FFTW<R>::complex Complex;
+	const long int ny = t->get_nx();
+	const long int rows = t->get_ny();
+	const long int band = fft_band(sizeof(Complex) * ny, tile, rows);
+	const double scale = double(nx) * ny;
+	const typename FFTW<R>::plan forward = FFTPlans::shared().many_dft<R>(ny, band, FFTW_FORWARD, true);
+	const typename FFTW<R>::plan backward = FFTPlans::shared().many_dft<R>(ny, band, FFTW_BACKWARD, true);
+
+	FFTWArray<Complex> data(band * ny);
+	std::complex<R> *columns = reinterpret_cast<std::complex<R>*>(data.data);
+	for (long int r0 = 0; r0 < rows; r0 += band) {
+	  const RasterSlice slice(0, r0, ny, std::min(band, rows-r0));
+	  t->read(slice, columns, slice.size());
+	  FFTW<R>::execute_dft(forward, data.data, data.data);
+	  for (long int r = 0; r < slice.size() / ny; ++r) {
+	    const double u = double(r0+r) / nx;
+	    for (long int y = 0; y < ny; ++y) columns[r*ny + y] *= R(filter(u, fft_frequency(y, ny)) / scale);
+	  }//endfor - r
+	  FFTW<R>::execute_dft(backward, data.data, data.data);
+	  t->write(slice, columns, slice.size());
+	}//endfor - r0
+  }// end: fft_filter_transposed_rows
+
+
+
+  // filter of a raster too big for fft_filter_in_core, in precision R, through one scratch raster holding the
+  // transpose of the half spectrum: the rows transformed into it, its rows filtered (fft_filter_transposed_rows),
+  // and the rows transformed back from it
+  template<typename R>
+  static void fft_filter_blocked(const Raster *in, Raster *out, const FrequencyFilter &filter) {
+	typedef typename FFTW<R>::complex Complex;
+	const long int nx = in->get_nx();
+	const long int ny = in->get_ny();
+	const long int nh = nx/2 + 1;
+	const size_t rowBytes = sizeof(R)*nx + sizeof(Complex)*3*nh;
+	const long int tile = fft_tile(rowBytes, sizeof(Complex) * ny);
+	const long int band = fft_band(rowBytes, tile, ny);
+
+	GeoStar::ScratchRaster transposed(Scratch::shared(), fft_complex_type<R>(), ny, nh, RasterLayout(TILED, tile));
+	fft_rows_to_transposed<R>(in, band, nh, transposed.get());
+	fft_filter_transposed_rows<R>(transposed.get(), tile, nx, filter);
+	fft_rows_from_transposed<R>(transposed.get(), band, nh, out, 1);
+  }// end: fft_filter_blocked
+
+
+
+  // FFT of in in precision R: in memory if it fits the budget, else out of core through a transpose of type
+  template<typename R>
+  static void fft_forward(const Raster *in, const long int &nx_out, const RasterType &type,
+                          const typename Spectrum<R>::Writer &write) {
+	if (fft_fits_in_core<R>(in->get_nx(), in->get_ny())) fft_forward_in_core<R>(in, nx_out, write);
+	else fft_forward_blocked<R>(in, nx_out, type, write);
+  }// end: fft_forward
+
+
+  // inverse FFT into out in precision R, the same way
+  template<typename R>
+  static void fft_inverse(const typename Spectrum<R>::Reader &read, const long int &nx_in, const RasterType &type,
+                          Raster *out, const double &scale) {
+	if (fft_fits_in_core<R>(out->get_nx(), out->get_ny())) fft_inverse_in_core<R>(read, nx_in, out, scale);
+	else fft_inverse_blocked<R>(read, nx_in, type, out, scale);
+  }// end: fft_inverse
+
+
+  // filter of in into out in precision R, the same way
+  template<typename R>
+  static void fft_filter(const Raster *in, Raster *out, const FrequencyFilter &filter) {
+	if (fft_fits_in_core<R>(in->get_nx(), in->get_ny())) fft_filter_in_core<R>(in, out, filter);
+	else fft_filter_blocked<R>(in, out, filter);
+  }// end: fft_filter
+
+
+
+
+
+
+  void Raster::FFT_2D(GeoStar::Image * /*img*/, Raster *rasOut) {
+	RasterSizeErrorException RasterSizeError;
+	DataTypeException DataTypeError;
+	use_fft_wisdom();
+
+	//check raster bounds and type: the full spectrum, or its non-redundant half
+	const long int nx = get_nx();
+	const long int nx_out = rasOut->get_nx();
+	if (nx_out != nx && nx_out != nx/2 + 1) throw RasterSizeError;
+	if (get_ny() != rasOut->get_ny()) throw RasterSizeError;
+	if (!is_complex(rasOut->get_datatype())) throw DataTypeError;
+
+	//single precision from REAL32 to COMPLEX_REAL64
+	if (fft_single(get_datatype()) && fft_single(rasOut->get_datatype()))
+	  fft_forward<float>(this, nx_out, COMPLEX_REAL64, complex_writer<float>(rasOut));
+	else fft_forward<double>(this, nx_out, fft_transpose_type(rasOut->get_datatype()), complex_writer<double>(rasOut));
+
+   }//end - FFT_2D
+
+
+
+  void Raster::FFT_2D(GeoStar::Image * /*img*/, Raster *rasOutReal, Raster *rasOutImg) {
 	RasterSizeErrorException RasterSizeError;
+	use_fft_wisdom();
 
 	long int nx = get_nx();
 	long int ny = get_ny();
@@ -602,98 +1738,52 @@ for (int y = 0; y < partitions; ++y) {
 	long int ny_outReal = rasOutReal->get_ny();
 	long int nx_outImg = rasOutImg->get_nx();
 	long int ny_outImg = rasOutImg->get_ny();
-	//check raster bounds
-	if (nx != nx_outReal) throw RasterSizeError;
+	//check raster bounds: the full spectrum, or its non-redundant half
+	if (nx_outReal != nx && nx_outReal != nx/2 + 1) throw RasterSizeError;
 	if (ny != ny_outReal) throw RasterSizeError;
-	if (nx != nx_outImg) throw RasterSizeError;
+	if (nx_outReal != nx_outImg) throw RasterSizeError;
 	if (ny != ny_outImg) throw RasterSizeError;
 
-	fftw_complex *in, *out;
-	in = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * nx);
-	out = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * nx);
-	fftw_plan plan;
-	plan = fftw_plan_dft_1d(nx, in, out, FFTW_FORWARD, FFTW_ESTIMATE);
-
-	std::vector<long int>sliceFFTW(4);
-    		sliceFFTW[0]=0;
-    		sliceFFTW[1]=0;
-    		sliceFFTW[2]=nx;
-    		sliceFFTW[3]=1;
-	std::vector<double> dataReal(nx);
-	std::vector<double> dataImg(nx);
-	
-	GeoStar::Raster *rasBufferReal = img->create_raster("BufferReal", GeoStar::REAL32, nx, ny);
-	GeoStar::Raster *rasBufferImg = img->create_raster("BufferImg", GeoStar::REAL32, nx, ny);
-
-	//transform row by row
-	for (int y = 0; y < ny; ++y) {	
-	sliceFFTW[1] = y;
-	read(sliceFFTW, dataReal);
-	for(int i=0;i<nx;i++) { 
-	   in[i][0]=dataReal[i]; 
-	   in[i][1]=0.0;
+	//single precision when all three are REAL32
+	if (fft_single(get_datatype()) && fft_single(rasOutReal->get_datatype()) && fft_single(rasOutImg->get_datatype())) {
+	  fft_forward<float>(this, nx_outReal, COMPLEX_REAL64, parts_writer<float>(rasOutReal, rasOutImg));
+	  return;
 	}
 
-	
-	fftw_execute(plan);
-	
-	for (int i = 0; i < nx; i++) {
-		dataReal[i] = out[i][0];
-		dataImg[i] = out[i][1];
-	}
-	rasBufferReal->write(sliceFFTW, dataReal);
-	rasBufferImg->write(sliceFFTW, dataImg);
-	
-	}//endfor - row-by-row
+	//double precision transpose buffer only when both outputs can hold it
+	const bool wide = rasOutReal->get_datatype() == REAL64 && rasOutImg->get_datatype() == REAL64;
+	fft_forward<double>(this, nx_outReal, wide ? COMPLEX_REAL128 : COMPLEX_REAL64, parts_writer<double>(rasOutReal, rasOutImg));
 
-	//now delete objects and reinitialize for the ny size - cols transform
-	fftw_destroy_plan(plan);
-	fftw_free(in); fftw_free(out);
+   }//end - FFT_2D
 
-	fftw_complex *inCols, *outCols;
-	inCols = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * ny);
-	outCols = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * ny);
-	fftw_plan planCols;
-	planCols = fftw_plan_dft_1d(ny, inCols, outCols, FFTW_FORWARD, FFTW_ESTIMATE);
 
-		sliceFFTW[0] = 0;
-    		sliceFFTW[1] = 0;
-    		sliceFFTW[2] = 1;
-		sliceFFTW[3] = ny;
 
-	dataReal.reserve(ny);
-	dataImg.reserve(ny);
-	
-	//transform col-by-col	
-	for (int x = 0; x < nx; ++x) {
-	sliceFFTW[0] = x;
-	rasBufferReal->read(sliceFFTW, dataReal);
-	rasBufferImg->read(sliceFFTW, dataImg);
-	for (int i = 0; i < ny; ++i) {
-		inCols[i][0] = dataReal[i];
-		inCols[i][1] = dataImg[i];
-	}
-	
-	fftw_execute(planCols);
-	
-	for (int i = 0; i < ny; ++i) {
-		dataReal[i] = outCols[i][0];
-		dataImg[i] = outCols[i][1];
-	}
-	rasOutReal->write(sliceFFTW, dataReal);
-	rasOutImg->write(sliceFFTW, dataImg);
+  void Raster::FFT_2D_Inv(GeoStar::Image * /*img*/, Raster *rasOut) {
+	RasterSizeErrorException RasterSizeError;
+	DataTypeException DataTypeError;
+	use_fft_wisdom();
+
+	long int nx = get_nx();
+	long int ny = get_ny();
+	long int nx_out = rasOut->get_nx();
+	//check raster bounds and type: the full spectrum, or its non-redundant half
+	if (nx != nx_out && nx != nx_out/2 + 1) throw RasterSizeError;
+	if (ny != rasOut->get_ny()) throw RasterSizeError;
+	if (!is_complex(get_datatype())) throw DataTypeError;
 
-	}//endfor - col-by-col
+	//200000 is just a scaling factor, feel free to adjust as needed
+	//single precision from COMPLEX_REAL64 to REAL32
+	if (fft_single(get_datatype()) && fft_single(rasOut->get_datatype()))
+	  fft_inverse<float>(complex_reader<float>(this), nx, COMPLEX_REAL64, rasOut, 200000);
+	else fft_inverse<double>(complex_reader<double>(this), nx, fft_transpose_type(get_datatype()), rasOut, 200000);
 
-	delete rasBufferReal;
-	delete rasBufferImg;
-	fftw_destroy_plan(planCols);
-	fftw_free(inCols); fftw_free(outCols);
+	}//end - FFT_2D_Inv
 
-   }//end - FFT_2D
 
-  void Raster::FFT_2D_Inv(GeoStar::Image *img, Raster *rasOut, Raster *rasInImg) {
+
+  void Raster::FFT_2D_Inv(GeoStar::Image * /*img*/, Raster *rasOut, Raster *rasInImg) {
 	RasterSizeErrorException RasterSizeError;
+	use_fft_wisdom();
 
 	long int nx = get_nx();
 	long int ny = get_ny();
@@ -701,114 +1791,47 @@ for (int y = 0; y < partitions; ++y) {
 	long int ny_out = rasOut->get_ny();
 	long int nx_img = rasInImg->get_nx();
 	long int ny_img = rasInImg->get_ny();
-	//check raster bounds
-	if (nx != nx_out) throw RasterSizeError;
+	//check raster bounds: the full spectrum, or its non-redundant half
+	if (nx != nx_out && nx != nx_out/2 + 1) throw RasterSizeError;
 	if (ny != ny_out) throw RasterSizeError;
 	if (nx != nx_img) throw RasterSizeError;
 	if (ny != ny_img) throw RasterSizeError;
 
-	fftw_complex *in, *out;
-	in = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * ny);
-	out = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * ny);
-	fftw_plan plan;
-	plan = fftw_plan_dft_1d(ny, in, out, FFTW_BACKWARD, FFTW_ESTIMATE);
-
-	std::vector<long int>sliceFFTW(4);
-    		sliceFFTW[0]=0;
-    		sliceFFTW[1]=0;
-    		sliceFFTW[2]=1;
-    		sliceFFTW[3]=ny;
-	std::vector<double> dataReal(ny);
-	std::vector<double> dataImg(ny);
-	
-	GeoStar::Raster *rasBufferReal = img->create_raster("BufferRealInv", GeoStar::REAL32, nx, ny);
-	GeoStar::Raster *rasBufferImg = img->create_raster("BufferImgInv", GeoStar::REAL32, nx, ny);
-
-	//transform col by col
-	for (int x = 0; x < nx; ++x) {	
-	sliceFFTW[0] = x;
-	read(sliceFFTW, dataReal);
-	rasInImg->read(sliceFFTW, dataImg);
-	for(int i=0;i<ny;i++) { 
-	   in[i][0]=dataReal[i]; 
-	   in[i][1]=dataImg[i];
+	//single precision when all three are REAL32
+	if (fft_single(get_datatype()) && fft_single(rasInImg->get_datatype()) && fft_single(rasOut->get_datatype())) {
+	  fft_inverse<float>(parts_reader<float>(this, rasInImg), nx, COMPLEX_REAL64, rasOut, 200000);
+	  return;
 	}
 
-	
-	fftw_execute(plan);
-	
-	for (int i = 0; i < ny; i++) {
-		dataReal[i] = out[i][0];
-		dataImg[i] = out[i][1];
-	}
-	rasBufferReal->write(sliceFFTW, dataReal);
-	rasBufferImg->write(sliceFFTW, dataImg);
-	
-	}//endfor - col-by-col
+	//double precision transpose buffer only when both parts are double
+	const bool wide = get_datatype() == REAL64 && rasInImg->get_datatype() == REAL64;
+	fft_inverse<double>(parts_reader<double>(this, rasInImg), nx, wide ? COMPLEX_REAL128 : COMPLEX_REAL64, rasOut, 200000);
 
-	//now delete objects and reinitialize for the nx size - rows transform
-	fftw_destroy_plan(plan);
-	fftw_free(in); fftw_free(out);
+	}//end - FFT_2D_Inv
 
-	fftw_complex *inRows, *outRows;
-	inRows = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * nx);
-	outRows = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * nx);
-	fftw_plan planRows;
-	planRows = fftw_plan_dft_1d(nx, inRows, outRows, FFTW_BACKWARD, FFTW_ESTIMATE);
+  void Raster::frequencyFilter(Raster *rasOut, const FrequencyFilter &filter) {
+	RasterSizeErrorException RasterSizeError;
+	DataTypeException DataTypeError;
+	use_fft_wisdom();
 
-		sliceFFTW[0] = 0;
-    		sliceFFTW[1] = 0;
-    		sliceFFTW[2] = nx;
-		sliceFFTW[3] = 1;
+	//check raster bounds and types: real pixels in and out
+	if (get_nx() != rasOut->get_nx()) throw RasterSizeError;
+	if (get_ny() != rasOut->get_ny()) throw RasterSizeError;
+	if (is_complex(get_datatype()) || is_complex(rasOut->get_datatype())) throw DataTypeError;
 
-	dataReal.reserve(nx);
-	dataImg.reserve(nx);
-	
-	//transform row-by-row	
-	for (int y = 0; y < ny; ++y) {
-	sliceFFTW[1] = y;
-	rasBufferReal->read(sliceFFTW, dataReal);
-	rasBufferImg->read(sliceFFTW, dataImg);
-	for (int i = 0; i < nx; ++i) {
-		inRows[i][0] = dataReal[i];
-		inRows[i][1] = dataImg[i];
-	}
-	
-	fftw_execute(planRows);
-	
-	for (int i = 0; i < nx; ++i) {
-		dataReal[i] = outRows[i][0] / 200000; //just a scaling factor, feel free to adjust as needed
-	}
-	rasOut->write(sliceFFTW, dataReal);
+	if (fft_single(get_datatype()) && fft_single(rasOut->get_datatype())) fft_filter<float>(this, rasOut, filter);
+	else fft_filter<double>(this, rasOut, filter);
 
-	}//endfor - row-by-row
+  }//end - frequencyFilter
 
-	delete rasBufferReal;
-	delete rasBufferImg;
-	fftw_destroy_plan(planRows);
-	fftw_free(inRows); fftw_free(outRows);
 
-	}//end - FFT_2D_Inv
 
- void Raster::lowPassFilter(GeoStar::Image *img, Raster *rasInReal, Raster *rasInImg, Raster *rasOut) {
-	RasterSizeErrorException RasterSizeError;
-	//check the output raster only, all others are checked in the FFT_2D() function
-	long int nx = get_nx();
-	long int ny = get_ny();
-	if (nx != rasOut->get_nx()) throw RasterSizeError;
-	if (ny != rasOut->get_ny()) throw RasterSizeError;
+ void Raster::lowPassFilter(GeoStar::Image * /*img*/, Raster *rasInReal, Raster *rasInImg, Raster *rasOut) {
+	//frequencyFilter checks rasOut, FFT_2D the spectrum rasters
+	frequencyFilter(rasOut, FrequencyFilter::lowPass(0.2));
 
-	//transform
-	FFT_2D(img, rasInReal, rasInImg);
-
-	//set slice in output rasters to zero
-	const long int width = nx / 5;
-	const long int setSlice[4] = {width, width, width, width};
-	rasInReal->set(setSlice, 0);
-	rasInImg->set(setSlice, 0);
-
-	//transform back
-	rasInReal->FFT_2D_Inv(img, rasOut, rasInImg);
+	//the spectrum of the filtered raster, for the callers that read it
+	if (rasInReal != NULL && rasInImg != NULL) rasOut->FFT_2D(NULL, rasInReal, rasInImg);
 
  } //end - lowPassFilter
 
@@ -821,74 +1844,53 @@ for (int y = 0; y < partitions; ++y) {
 	if (nx / 2 != nx_out) throw RasterSizeError;
 	if (ny / 2 != ny_out) throw RasterSizeError;
 	
-	//define kernel and a double so no integer division
-	//scaling factor
-	double mKernel = 400;
-	double gaussianKernel[5][5] = {{1/mKernel, 4/mKernel, 6/mKernel, 4/mKernel, 1/mKernel}, 
-					{4/mKernel, 16/mKernel, 24/mKernel, 16/mKernel, 4/mKernel},
-					{6/mKernel, 24/mKernel, 36/mKernel, 24/mKernel, 6/mKernel}, 
-					{4/mKernel, 16/mKernel, 24/mKernel, 16/mKernel, 4/mKernel},
-					{1/mKernel, 4/mKernel, 6/mKernel, 4/mKernel, 1/mKernel}};
-
-    vector<long int> slice(4);
-    slice[0]=0;
-    slice[1]=0;
-    slice[2]=nx;
-    slice[3]=1;
+	//blur in place, block by block
+	DownsampleBlurPixel blur;
+	for_each_block<double>(NULL, this,
+	  [blur](const vector<long int> &slice, vector<double> &data) {
+		long int npixels = slice[2] * slice[3];
+		for (long int j = 0; j < npixels; ++j) data[j] = blur(data[j]);
+	  });
 
-    vector<double> data(nx);
-	
-	int mFlipped = 0, nFlipped = 0;
-	double temp;
-
-	for (int i = 0; i < ny; ++i) {
-	  slice[1] = i;
-	  read(slice, data);
-	  for (int j = 0; j < nx; ++j) {
-		temp = 0;
-	     for (int m = 0; m < 5; ++m) {
-		mFlipped = 5 - 1 - m;
-		for (int n = 0; n < 5; ++n) {
-		  nFlipped = 5 - 1 - n;
-		  
-		  //convolve: multiply and accumulate
-		  temp += (data[j] * gaussianKernel[mFlipped][nFlipped]);
-
-
-		}//endfor - n
-	      }//endfor - m
-		data[j] = temp;
-	   }//endfor - j
-	   write(slice, data);
-	}//endfor - i
-
-
-    vector<double> dataOut(nx_out);
-
-	int outIndexSlice = 0, outIndexData = 0;
+	if (nx_out < 1 || ny_out < 1) return;
 
 	//remove all even numbered rows and cols to downsize
-	//change size of slice - write won't work unless the same slice is used for read and write
-	for (int i = 1; i < ny; i += 2) {
-	  slice[1] = i;
-	  slice[2] = nx;
-	  read(slice, data);	
-	  slice[1] = outIndexSlice;
-	  slice[2] = nx_out;
-	  ++outIndexSlice;
-	  outIndexData = 0;
-
-	  for (int j = 1; j < nx; j += 2) {
-		dataOut[outIndexData] = data[j];
-		++outIndexData;
-	  }//endfor - j
-
-	  rasOut->write(slice, dataOut);
+	//a band of output rows is made from a band of twice as many input rows
+	long int blockShape[2];
+	rasOut->default_block_shape(blockShape);
+	const long int nlines = blockShape[1];
+
+    RasterSlice slice(0, 0, nx, 2 * nlines);
+    RasterSlice sliceOut(0, 0, nx_out, nlines);
+
+    vector<double> data(nx * 2 * nlines);
+    vector<double> dataOut(nx_out * nlines);
+
+	for (long int i = 0; i < ny_out; i += nlines) {
+	  sliceOut.y0 = i;
+	  sliceOut.dy = std::min(nlines, ny_out - i);
+	  slice.y0 = 2 * i;
+	  slice.dy = 2 * sliceOut.dy;
+	  read(slice, data.data(), data.size());
+
+	  for (long int k = 0; k < sliceOut.dy; ++k) {
+	    for (long int j = 0; j < nx_out; ++j) {
+		dataOut[k * nx_out + j] = data[(2 * k + 1) * nx + 2 * j + 1];
+	    }//endfor - j
+	  }//endfor - k
+
+	  rasOut->write(sliceOut, dataOut.data(), dataOut.size());
 	}//endfor - i
 
 
  } //end - downsample
 
+  // a REAL32 level of a pyramid: in img, or in memory when img is NULL
+  static Raster *pyramid_level(Image *img, const std::string &name, const long int nx, const long int ny) {
+    if(img == NULL) return new InMemoryRaster(name, REAL32, nx, ny);
+    return new Raster(img, name, REAL32, nx, ny);
+  }// end: pyramid_level
+
   vector<Raster *> Raster::gaussianPyramid(Image *img, int n) {
 	//RasterSizeErrorException if needed
 	IntegerParameterException integerParameterError;
@@ -897,14 +1899,14 @@ for (int y = 0; y < partitions; ++y) {
 	long int ny = get_ny();
 
 	//make base vector, fill with base layer and first downsample
-	vector<Raster *> output(n);
+	vector<Raster *> output(n + 1);
 	output[0] = this;
-	output[1] = new Raster(img, "GPyramid1", REAL32, nx / 2, ny / 2);
+	output[1] = pyramid_level(img, "GPyramid1", nx / 2, ny / 2);
 
 	downsample(output[1]);
 	//then repeat n - 1 times
 	for (int i = 2; i <= n; ++i) {
-	  output[i] = new Raster(img, "GPyramid" + to_string(i), REAL32, nx / pow(2, i), ny / pow(2, i));
+	  output[i] = pyramid_level(img, "GPyramid" + to_string(i), nx / pow(2, i), ny / pow(2, i));
 	  output[i - 1]->downsample(output[i]);
 	}
 
@@ -932,57 +1934,34 @@ for (int y = 0; y < partitions; ++y) {
 					{4/mKernel, 16/mKernel, 24/mKernel, 16/mKernel, 4/mKernel},
 					{1/mKernel, 4/mKernel, 6/mKernel, 4/mKernel, 1/mKernel}};
 
-    vector<long int> slice(4);
-    slice[0]=0;
-    slice[1]=0;
-    slice[2]=nx;
-    slice[3]=1;
-
-    vector<double> data(nx);
-
-    vector<double> dataOut(nx_out);
-
-	int outIndexSlice = 1, outIndexData = 1;
-
-	//first read existing data to larger raster to upsize - then convolve after
-	// only read in every other row and col in the rasOut
-
-	//change size of slice - write won't work unless the same slice is used for read and write
-	for (int i = 0; i < ny; ++i) {
-	  slice[1] = i;
-	  slice[2] = nx;
-	  read(slice, data);	
-	  slice[1] = outIndexSlice;
-	  slice[2] = nx_out;
-	  outIndexSlice += 2;
-		//just in case dimensions are even and end data is overshot by 1
-		if (outIndexSlice > ny_out) outIndexSlice = ny_out;
-	  outIndexData = 1;
-
-	  for (int j = 0; j < nx; ++j) {
-		dataOut[outIndexData] = data[j];
-		outIndexData += 2;
-		if (outIndexData > nx_out) outIndexData = nx_out;
-	  }//endfor - j
+	//every output pixel is the convolved value of input pixel ((x-1)/2, (y-1)/2), clamped to zero:
+	//the first row and column are copies of the second, and every other row and col repeats the one before it.
+	//convolve a band of input rows, then spread it over the matching band of output rows.
+	long int blockShape[2];
+	rasOut->default_block_shape(blockShape);
+	const long int nlines = blockShape[1];
 
-	  rasOut->write(slice, dataOut);
-	}//endfor - i
+    RasterSlice slice(0, 0, nx, 1);
+    RasterSlice sliceOut(0, 0, nx_out, nlines);
 
-	
-	//now convolve - approximate missing values with neighboring pixels
+    vector<double> data(nx * (nlines / 2 + 2));
+    vector<double> dataOut(nx_out * nlines);
 
 	int mFlipped = 0, nFlipped = 0;
 	double temp;
 
-	slice[0] = 0;
-	slice[1] = 0;
-	slice[2] = nx_out;
-	slice[3] = 1;
+	for (long int i = 0; i < ny_out; i += nlines) {
+	  sliceOut.y0 = i;
+	  sliceOut.dy = std::min(nlines, ny_out - i);
+
+	  //input rows feeding this band of output rows
+	  const long int firstRow = (i == 0) ? 0 : (i - 1) / 2;
+	  const long int lastRow = (i + sliceOut.dy - 2) / 2;
+	  slice.y0 = firstRow;
+	  slice.dy = std::max(lastRow, 0L) - firstRow + 1;
+	  read(slice, data.data(), data.size());
 
-	for (int i = 1; i < ny_out; i += 2) {
-	  slice[1] = i;
-	  rasOut->read(slice, dataOut);
-	  for (int j = 1; j < nx_out; j += 2) {
+	  for (long int j = 0; j < slice.dy * nx; ++j) {
 		temp = 0;
 	     for (int m = 0; m < 5; ++m) {
 		mFlipped = 5 - 1 - m;
@@ -990,24 +1969,23 @@ for (int y = 0; y < partitions; ++y) {
 		  nFlipped = 5 - 1 - n;
 		  
 		  //convolve: multiply and accumulate
-		  temp += (dataOut[j] * gaussianKernel[mFlipped][nFlipped]);
+		  temp += (data[j] * gaussianKernel[mFlipped][nFlipped]);
 
 
 		}//endfor - n
 	      }//endfor - m
-		dataOut[j] = temp;
-		if (j == 1) dataOut[0] = temp;
-		if (j + 1 < nx_out) dataOut[j + 1] = temp;
-	   }//endfor - j
-	   rasOut->write(slice, dataOut);
-	  if (i == 1) {
-	    slice[1] = 0;
-	    rasOut->write(slice, dataOut);
-	}
-	  if (i + 1 < ny_out) {
-	   slice[1] = i + 1;
-	   rasOut->write(slice, dataOut);
-	  }//endif
+		data[j] = temp;
+	  }//endfor - j
+
+	  for (long int k = 0; k < sliceOut.dy; ++k) {
+	    const long int row = i + k;
+	    const long int inRow = ((row == 0) ? 0 : (row - 1) / 2) - firstRow;
+	    for (long int j = 0; j < nx_out; ++j) {
+		dataOut[k * nx_out + j] = data[inRow * nx + ((j == 0) ? 0 : (j - 1) / 2)];
+	    }//endfor - j
+	  }//endfor - k
+
+	  rasOut->write(sliceOut, dataOut.data(), dataOut.size());
 	}//endfor - i
 
 
@@ -1022,14 +2000,14 @@ for (int y = 0; y < partitions; ++y) {
 	long int ny = get_ny();
 
 	//make base vector, fill with base layer and first upsample
-	vector<Raster *> output(n);
+	vector<Raster *> output(n + 1);
 	output[0] = this;
-	output[1] = new Raster(img, "LPyramid1", REAL32, nx * 2, ny * 2);
+	output[1] = pyramid_level(img, "LPyramid1", nx * 2, ny * 2);
 
 	upsample(output[1]);
 	//then repeat n - 1 times
 	for (int i = 2; i <= n; ++i) {
-	  output[i] = new Raster(img, "LPyramid" + to_string(i), REAL32, nx * pow(2, i), ny * pow(2, i));
+	  output[i] = pyramid_level(img, "LPyramid" + to_string(i), nx * pow(2, i), ny * pow(2, i));
 	  output[i - 1]->upsample(output[i]);
 	}
 
@@ -1038,6 +2016,154 @@ for (int y = 0; y < partitions; ++y) {
 
   }//end - gaussianPyramid
 
+  // the pixel and region functions declared in RasterKernels.hpp:
+
+  double GradientMaskPixel::operator()(const double pixel) const {
+	const double blurKernel[3][3] = {0.0625, 0.125, 0.0625, 0.125, 0.5, 0.125, 0.0625, 0.125, 0.0625};
+	int mFlipped = 0, nFlipped = 0;
+	double temp = 0;
+	     for (int m = 0; m < 3; ++m) {
+		mFlipped = 3 - 1 - m;
+		for (int n = 0; n < 3; ++n) {
+		  nFlipped = 3 - 1 - n;
+		  
+		  //convolve: multiply and accumulate
+		  temp += (pixel * blurKernel[mFlipped][nFlipped]);
+		}//endfor - n
+	      }//endfor - m
+	return temp;
+  }// end: GradientMaskPixel
+
+  double DownsampleBlurPixel::operator()(const double pixel) const {
+	//define kernel and a double so no integer division
+	//scaling factor
+	const double mKernel = 400;
+	const double gaussianKernel[5][5] = {{1/mKernel, 4/mKernel, 6/mKernel, 4/mKernel, 1/mKernel}, 
+					{4/mKernel, 16/mKernel, 24/mKernel, 16/mKernel, 4/mKernel},
+					{6/mKernel, 24/mKernel, 36/mKernel, 24/mKernel, 6/mKernel}, 
+					{4/mKernel, 16/mKernel, 24/mKernel, 16/mKernel, 4/mKernel},
+					{1/mKernel, 4/mKernel, 6/mKernel, 4/mKernel, 1/mKernel}};
+	int mFlipped = 0, nFlipped = 0;
+	double temp = 0;
+	     for (int m = 0; m < 5; ++m) {
+		mFlipped = 5 - 1 - m;
+		for (int n = 0; n < 5; ++n) {
+		  nFlipped = 5 - 1 - n;
+		  
+		  //convolve: multiply and accumulate
+		  temp += (pixel * gaussianKernel[mFlipped][nFlipped]);
+
+
+		}//endfor - n
+	      }//endfor - m
+	return temp;
+  }// end: DownsampleBlurPixel
+
+  void HarmonicMeanRegions::operator()(const vector<long int> &slice, vector<double> &data) const {
+	    const long int dx = slice[2];
+	    double temp(0);
+
+	  for (long int y = 0; y < slice[3]; y += n) {
+	   for (long int x = 0; x < dx; x += n) {
+		temp = 0;
+
+		//sum reciprocals
+	    for (int ySmall = 0; ySmall < n; ++ySmall) {
+		for (int xSmall = 0; xSmall < n; ++xSmall)
+		temp += 1.0 / data[(y + ySmall) * dx + x + xSmall];
+		
+		}//endfor - ysmall and xsmall
+
+		//calc harmonic mean
+		temp = (n * n) / temp; 
+
+		//now write to output block
+	    for (int ySmall = 0; ySmall < n; ++ySmall) {
+		for (int xSmall = 0; xSmall < n; ++xSmall)
+		data[(y + ySmall) * dx + x + xSmall] = temp;
+		}//endfor - ysmall and xsmall
+
+	    }//endfor - x
+	  }//endfor - y
+  }// end: HarmonicMeanRegions
+
+  void MidpointRegions::operator()(const vector<long int> &slice, vector<double> &data) const {
+	    const long int dx = slice[2];
+	    double min(0);
+	    double max(0);
+	    const double *row;
+
+	  for (long int y = 0; y < slice[3]; y += n) {
+	   for (long int x = 0; x < dx; x += n) {
+
+		//find local min and max
+	    for (int ySmall = 0; ySmall < n; ++ySmall) {
+		row = &data[(y + ySmall) * dx + x];
+		min = row[0];
+		max = row[0];
+		for (int xSmall = 0; xSmall < n; ++xSmall) {
+
+		  if (row[xSmall] < min) min = row[xSmall];
+		  else if (row[xSmall] > max) max = row[xSmall];
+
+		  }//endfor - xsmall
+		}//endfor - ysmall
+
+		//calc midpoint
+		max = (min + max) / 2; 
+
+		//now write to output block
+	    for (int ySmall = 0; ySmall < n; ++ySmall) {
+		for (int xSmall = 0; xSmall < n; ++xSmall)
+		data[(y + ySmall) * dx + x + xSmall] = max;
+		}//endfor - ysmall and xsmall
+
+	    }//endfor - x
+	  }//endfor - y
+  }// end: MidpointRegions
+
+  void RangeRegions::operator()(const vector<long int> &slice, vector<double> &data) const {
+	    const long int dx = slice[2];
+	    double min(0);
+	    double max(0);
+	    const double *row;
+
+	  for (long int y = 0; y < slice[3]; y += n) {
+	   for (long int x = 0; x < dx; x += n) {
+
+		//find local min and max
+	    for (int ySmall = 0; ySmall < n; ++ySmall) {
+		row = &data[(y + ySmall) * dx + x];
+		min = row[0];
+		max = row[0];
+		for (int xSmall = 0; xSmall < n; ++xSmall) {
+
+		  if (row[xSmall] < min) min = row[xSmall];
+		  else if (row[xSmall] > max) max = row[xSmall];
+
+		  }//endfor - xsmall
+		}//endfor - ysmall
+
+		//calc range
+		max = max - min; 
+
+		//now write to output block
+	    for (int ySmall = 0; ySmall < n; ++ySmall) {
+		for (int xSmall = 0; xSmall < n; ++xSmall)
+		data[(y + ySmall) * dx + x + xSmall] = max;
+		}//endfor - ysmall and xsmall
+
+	    }//endfor - x
+	  }//endfor - y
+  }// end: RangeRegions
+
+  // blocks for the n x n region filters: whole regions across and down
+  static void region_block_shape(const Raster *ras, const int n, long int *blockShape) {
+    ras->default_block_shape(blockShape);
+    blockShape[0] = std::max((blockShape[0] / n) * n, (long int)n);
+    blockShape[1] = std::max((blockShape[1] / n) * n, (long int)n);
+  }// end: region_block_shape
+
   void Raster::harmonicMean(GeoStar::Raster * rasOut, int n) {
 	RasterSizeErrorException RasterSizeError;
 	IntegerParameterException IntegerParameterError;
@@ -1056,46 +2182,12 @@ for (int y = 0; y < partitions; ++y) {
 	int numRegionsY = ny / n;
 	int numRegionsX = nx / n;
 
-	vector<long int> slice(4);
-    slice[0]=0;
-    slice[1]=0;
-    slice[2]=n;
-    slice[3]=1;
-
-    vector<double> data(n);
-	double temp(0);
-
-
-	//main outer loops that go across the whole image
-  for (int y = 0; y < numRegionsY; ++y) {
-   for (int x = 0; x < numRegionsX; ++x) {
-     slice[0] = x * n;
-	temp = 0;
+	long int window[4] = {0, 0, numRegionsX * n, numRegionsY * n};
+	long int blockShape[2];
+	region_block_shape(this, n, blockShape);
 
-	//sum reciprocals
-    for (int ySmall = 0; ySmall < n; ++ySmall) {
-	slice[1] = (y * n) + ySmall;
-	read(slice, data);
-	for (int xSmall = 0; xSmall < n; ++xSmall)
-	temp += 1.0 / data[xSmall];
-	
-	}//endfor - ysmall and xsmall
-
-	//calc harmonic mean
-	temp = (n * n) / temp; 
-
-	//now write to output raster
-    for (int ySmall = 0; ySmall < n; ++ySmall) {
-	slice[1] = (y * n) + ySmall;
-	read(slice, data);
-	for (int xSmall = 0; xSmall < n; ++xSmall)
-	data[xSmall] = temp;
-
-	rasOut->write(slice, data);
-	}//endfor - ysmall and xsmall
-
-    }//endfor - x
-  }//endfor - y
+	//main loop goes across the whole image, a block of whole regions at a time
+	for_each_native_block<double>(window, blockShape, rasOut, HarmonicMeanRegions(n));
 
  }//end - harmonicMean
 
@@ -1117,51 +2209,12 @@ for (int y = 0; y < partitions; ++y) {
 	int numRegionsY = ny / n;
 	int numRegionsX = nx / n;
 
-	vector<long int> slice(4);
-    slice[0]=0;
-    slice[1]=0;
-    slice[2]=n;
-    slice[3]=1;
-
-    vector<double> data(n);
-	double min(0);
-	double max(0);
-
-
-	//main outer loops that go across the whole image
-  for (int y = 0; y < numRegionsY; ++y) {
-   for (int x = 0; x < numRegionsX; ++x) {
-     slice[0] = x * n;
-
-	//find local min and max
-    for (int ySmall = 0; ySmall < n; ++ySmall) {
-	slice[1] = (y * n) + ySmall;
-	read(slice, data);
-	min = data[0];
-	max = data[0];
-	for (int xSmall = 0; xSmall < n; ++xSmall) {
-
-	  if (data[xSmall] < min) min = data[xSmall];
-	  else if (data[xSmall] > max) max = data[xSmall];
-
-	  }//endfor - xsmall
-	}//endfor - ysmall
-
-	//calc midpoint
-	max = (min + max) / 2; 
-
-	//now write to output raster
-    for (int ySmall = 0; ySmall < n; ++ySmall) {
-	slice[1] = (y * n) + ySmall;
-	read(slice, data);
-	for (int xSmall = 0; xSmall < n; ++xSmall)
-	data[xSmall] = max;
+	long int window[4] = {0, 0, numRegionsX * n, numRegionsY * n};
+	long int blockShape[2];
+	region_block_shape(this, n, blockShape);
 
-	rasOut->write(slice, data);
-	}//endfor - ysmall and xsmall
-
-    }//endfor - x
-  }//endfor - y
+	//main loop goes across the whole image, a block of whole regions at a time
+	for_each_native_block<double>(window, blockShape, rasOut, MidpointRegions(n));
 
  }//end - midpointFilter
 
@@ -1183,51 +2236,12 @@ for (int y = 0; y < partitions; ++y) {
 	int numRegionsY = ny / n;
 	int numRegionsX = nx / n;
 
-	vector<long int> slice(4);
-    slice[0]=0;
-    slice[1]=0;
-    slice[2]=n;
-    slice[3]=1;
-
-    vector<double> data(n);
-	double min(0);
-	double max(0);
-
-
-	//main outer loops that go across the whole image
-  for (int y = 0; y < numRegionsY; ++y) {
-   for (int x = 0; x < numRegionsX; ++x) {
-     slice[0] = x * n;
-
-	//find local min and max
-    for (int ySmall = 0; ySmall < n; ++ySmall) {
-	slice[1] = (y * n) + ySmall;
-	read(slice, data);
-	min = data[0];
-	max = data[0];
-	for (int xSmall = 0; xSmall < n; ++xSmall) {
-
-	  if (data[xSmall] < min) min = data[xSmall];
-	  else if (data[xSmall] > max) max = data[xSmall];
-
-	  }//endfor - xsmall
-	}//endfor - ysmall
-
-	//calc range
-	max = max - min; 
-
-	//now write to output raster
-    for (int ySmall = 0; ySmall < n; ++ySmall) {
-	slice[1] = (y * n) + ySmall;
-	read(slice, data);
-	for (int xSmall = 0; xSmall < n; ++xSmall)
-	data[xSmall] = max;
-
-	rasOut->write(slice, data);
-	}//endfor - ysmall and xsmall
+	long int window[4] = {0, 0, numRegionsX * n, numRegionsY * n};
+	long int blockShape[2];
+	region_block_shape(this, n, blockShape);
 
-    }//endfor - x
-  }//endfor - y
+	//main loop goes across the whole image, a block of whole regions at a time
+	for_each_native_block<double>(window, blockShape, rasOut, RangeRegions(n));
 
  }//end - rangeFilter
 
@@ -1342,148 +2356,47 @@ for (int y = 0; y < partitions; ++y) {
 	break;
 	}//end - switch
 
-	double blurKernel[3][3] = {0.0625, 0.125, 0.0625, 0.125, 0.5, 0.125, 0.0625, 0.125, 0.0625};
-
-    vector<long int> slice(4);
-    slice[0]=0;
-    slice[1]=0;
-    slice[2]=nx;
-    slice[3]=1;
-
-    vector<double> data(nx);
-	
-	int mFlipped = 0, nFlipped = 0;
-	double temp;
-
-	for (int i = 0; i < ny; ++i) {
-	  slice[1] = i;
-	  read(slice, data);
-	  for (int j = 0; j < nx; ++j) {
-		temp = 0;
-	     for (int m = 0; m < 3; ++m) {
-		mFlipped = 3 - 1 - m;
-		for (int n = 0; n < 3; ++n) {
-		  nFlipped = 3 - 1 - n;
-		  
-		  //convolve: multiply and accumulate
-		  temp += (data[j] * blurKernel[mFlipped][nFlipped]);
-		}//endfor - n
-	      }//endfor - m
-		data[j] = temp;
-	   }//endfor - j
-	   rasOut->write(slice, data);
-	}//endfor - i
+	map_pixels<double>(rasOut, GradientMaskPixel());
 
 
 }//end - gradientMask
 
 
-  GeoStar::Raster * Raster::operator+(const GeoStar::Raster & r2)
-  {
-    GeoStar::Image * img = Raster::getParent();
-    std::string str = rastername + "_PLUS_" + r2.rastername;
-    GeoStar::Raster * result = new GeoStar::Raster(img, str, raster_datatype, get_nx(), get_ny());
-    this->add(&r2, result);
-    return result;
-  }
   void Raster::add(const GeoStar::Raster * r2, GeoStar::Raster * ras_out)
   {
-    long int nx = get_nx(), ny = get_ny();
-    if(nx != r2->get_nx() || ny != r2->get_ny())throw RasterSizeErrorException();
-    std::vector<long int> slice(4);
-    slice[0] = 0; slice[1] = 0; slice[2] = nx; slice[3] = 1;
-    std::vector<float> bufferA(nx);
-    std::vector<float> bufferB(nx);
-    for(long int i = 0; i < ny; i++)
-    {
-      slice[1] = i;
-      read(slice, bufferA);
-      r2->read(slice, bufferB);
-      for(int j = 0; j < get_nx(); j++)bufferA[j] += bufferB[j];
-      ras_out->write(slice, bufferA);
-    }
+    map_pixels<float>(r2, ras_out,
+      [](const float a, const float b) -> float
+      {
+        return a + b;
+      });
   }
 
-  GeoStar::Raster * Raster::operator-(const GeoStar::Raster & r2)
-  {
-    GeoStar::Image * img = Raster::getParent();
-    std::string str = rastername + "_MINUS_" + r2.rastername;
-    GeoStar::Raster * result= new GeoStar::Raster(img, str, raster_datatype, get_nx(), get_ny());
-    this->subtract(&r2, result);
-    return result;
-  }
   void Raster::subtract(const GeoStar::Raster * r2, GeoStar::Raster * ras_out)
   {
-    long int nx = get_nx(), ny = get_ny();
-    if(nx != r2->get_nx() || ny != r2->get_ny())throw RasterSizeErrorException();
-    std::vector<long int> slice(4);
-    slice[0] = 0; slice[1] = 0; slice[2] = nx; slice[3] = 1;
-    std::vector<float> bufferA(nx);
-    std::vector<float> bufferB(nx);
-    for(long int i = 0; i < ny; i++)
-    {
-      slice[1] = i;
-      read(slice, bufferA);
-      r2->read(slice, bufferB);
-      for(int j = 0; j < get_nx(); j++)bufferA[j] -= bufferB[j];
-      ras_out->write(slice, bufferA);
-    }
+    map_pixels<float>(r2, ras_out,
+      [](const float a, const float b) -> float
+      {
+        return a - b;
+      });
   }
 
-  GeoStar::Raster * Raster::operator*(const GeoStar::Raster & r2)
-  {
-    GeoStar::Image * img = Raster::getParent();
-    std::string str = rastername + "_TIMES_" + r2.rastername;
-    GeoStar::Raster * result= new GeoStar::Raster(img, str, raster_datatype, get_nx(), get_ny());
-    this->multiply(&r2, result);
-    return result;
-  }
   void Raster::multiply(const GeoStar::Raster * r2, GeoStar::Raster * ras_out)
   {
-    long int nx = get_nx(), ny = get_ny();
-    if(nx != r2->get_nx() || ny != r2->get_ny())throw RasterSizeErrorException();
-    std::vector<long int> slice(4);
-    slice[0] = 0; slice[1] = 0; slice[2] = nx; slice[3] = 1;
-    std::vector<float> bufferA(nx);
-    std::vector<float> bufferB(nx);
-    for(long int i = 0; i < ny; i++)
-    {
-      slice[1] = i;
-      read(slice, bufferA);
-      r2->read(slice, bufferB);
-      for(int j = 0; j < get_nx(); j++)bufferA[j] *= bufferB[j];
-      ras_out->write(slice, bufferA);
-    }
+    map_pixels<float>(r2, ras_out,
+      [](const float a, const float b) -> float
+      {
+        return a * b;
+      });
   }
 
-  GeoStar::Raster * Raster::operator/(const GeoStar::Raster & r2)
-  {
-    GeoStar::Image * img = Raster::getParent();
-    std::string str = rastername + "_DIVIDEDBY_" + r2.rastername;
-    GeoStar::Raster * result= new GeoStar::Raster(img, str, raster_datatype, get_nx(), get_ny());
-    this->divide(&r2, result);
-    return result;
-  }
   void Raster::divide(const GeoStar::Raster * r2, GeoStar::Raster * ras_out)
   {
-    long int nx = get_nx(), ny = get_ny();
-    if(nx != r2->get_nx() || ny != r2->get_ny())throw RasterSizeErrorException();
-    std::vector<long int> slice(4);
-    slice[0] = 0; slice[1] = 0; slice[2] = nx; slice[3] = 1;
-    std::vector<float> bufferA(nx);
-    std::vector<float> bufferB(nx);
-    for(long int i = 0; i < ny; i++)
-    {
-      slice[1] = i;
-      read(slice, bufferA);
-      r2->read(slice, bufferB);
-      for(int j = 0; j < get_nx(); j++)
+    map_pixels<float>(r2, ras_out,
+      [](const float a, const float b) -> float
       {
-        if(bufferB[j] == 0)bufferA[j] = 255; // divide by zero goes to max value
-        else bufferA[j] /= bufferB[j];
-      }
-      ras_out->write(slice, bufferA);
-    }
+        if(b == 0) return 255; // divide by zero goes to max value
+        return a / b;
+      });
   }
 
   Raster* Raster::resize(Image *img, int resize_width, int resize_height){
@@ -1549,95 +2462,20 @@ for (int y = 0; y < partitions; ++y) {
 	*/
   }
 
-  GeoStar::Image * Raster::getParent()
+  GeoStar::Raster * Raster::create_sibling(const std::string & name) const
   {
-    size_t len = H5Iget_name(rasterobj->getId(),NULL,0);
-    char buffer[len];
-    H5Iget_name(rasterobj->getId(),buffer,len+1);
-    std::string imgName = buffer;
-    int a = imgName.find_first_of("/");
-    imgName = imgName.substr(a,imgName.find_last_of("/")-a);
-
-    std::string fileName = rasterobj->getFileName();
-    GeoStar::File * f = new GeoStar::File(fileName, "existing");
-    GeoStar::Image * img = new Image(f,imgName);
-    delete f;
-    return img;
-  }
+    if(memory_pixels) return new InMemoryRaster(name, raster_datatype, get_nx(), get_ny());
 
-  GeoStar::Raster * GeoStar::Raster::operator+(const float & val)
-  {
-    GeoStar::Image * img = getParent();
-    std::string str = rastername+"_PLUS_val";
-    GeoStar::Raster * r2 = new GeoStar::Raster(img, str, raster_datatype, get_nx(),get_ny());
-    std::vector<long int> slice(4);
-    slice[0] = 0; slice[1] = 0; slice[2] = get_nx(); slice[3] = 1;
-    std::vector<float> buffer(get_nx());
-    for(int i = 0; i < get_ny(); i++)
-    {
-      slice[1] = i;
-      read(slice, buffer);
-      for(int j = 0; j < get_nx(); j++)buffer[j]+=val;
-      r2->write(slice, buffer);
-    }
-    return r2;
-  }
-  GeoStar::Raster * GeoStar::Raster::operator-(const float & val)
-  {
-    GeoStar::Image * img = getParent();
-    std::string str = rastername+"_MINUS_val";
-    GeoStar::Raster * r2 = new GeoStar::Raster(img, str, raster_datatype, get_nx(),get_ny());
-    std::vector<long int> slice(4);
-    slice[0] = 0; slice[1] = 0; slice[2] = get_nx(); slice[3] = 1;
-    std::vector<float> buffer(get_nx());
-    for(int i = 0; i < get_ny(); i++)
-    {
-      slice[1] = i;
-      read(slice, buffer);
-      for(int j = 0; j < get_nx(); j++)buffer[j]-=val;
-      r2->write(slice, buffer);
-    }
-    return r2;
-  }
-  GeoStar::Raster * GeoStar::Raster::operator*(const float & val)
-  {
-    GeoStar::Image * img = getParent();
-    std::string str = rastername+"_TIMES_val";
-    GeoStar::Raster * r2 = new GeoStar::Raster(img, str, raster_datatype, get_nx(),get_ny());
-    std::vector<long int> slice(4);
-    slice[0] = 0; slice[1] = 0; slice[2] = get_nx(); slice[3] = 1;
-    std::vector<float> buffer(get_nx());
-    for(int i = 0; i < get_ny(); i++)
-    {
-      slice[1] = i;
-      read(slice, buffer);
-      for(int j = 0; j < get_nx(); j++)buffer[j]*=val;
-      r2->write(slice, buffer);
-    }
-    return r2;
+    GeoStar::Image * img = const_cast<Raster *>(this)->getParent();
+    GeoStar::Raster * result = new GeoStar::Raster(img, name, raster_datatype, get_nx(), get_ny());
+    delete img;
+    return result;
   }
-  GeoStar::Raster * GeoStar::Raster::operator/(const float & val)
+
+  GeoStar::Image * Raster::getParent()
   {
-    GeoStar::Image * img = getParent();
-    std::string str = rastername+"_DIVIDEDBY_val";
-    GeoStar::Raster * r2 = new GeoStar::Raster(img, str, raster_datatype, get_nx(),get_ny());
-    std::vector<long int> slice(4);
-    slice[0] = 0; slice[1] = 0; slice[2] = get_nx(); slice[3] = 1;
-    std::vector<float> buffer(get_nx());
-    if(val == 0) // can't divide by zero
-    {
-      throw GeoStar::DivideByZeroException();
-    }
-    else
-    {
-      for(int i = 0; i < get_ny(); i++)
-      {
-        slice[1] = i;
-        read(slice, buffer);
-        for(int j = 0; j < get_nx(); j++)buffer[j]/=val;
-        r2->write(slice, buffer);
-      }
-    }
-    return r2;
+    if(memory_pixels) return NULL;
+    return new GeoStar::Image(raster_file, raster_image, raster_image_name);
   }
+
 }// end namespace GeoStar
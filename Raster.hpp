@@ -9,10 +9,19 @@
 
 #include <string>
 #include <vector>
+#include <map>
+#include <utility>
+#include <algorithm>
+#include <cstdint>
+#include <complex>
+#include <memory>
 
 #include "H5Cpp.h"
 #include "Exceptions.hpp"
+#include "FileHandle.hpp"
 #include "RasterType.hpp"
+#include "RasterLayout.hpp"
+#include "RasterSlice.hpp"
 #include "attributes.hpp"
 
 //#include <opencv2/opencv.hpp>
@@ -21,8 +30,72 @@
 namespace GeoStar {
   class Image;
   class File;
+  class Raster;
+  class InMemoryRaster;
+  class FrequencyFilter;
+  template<typename T> class RasterReader;
+  template<typename T> class RasterWriter;
+  template<typename C, typename Function> struct MapPixelsKernel;
+  template<typename C, typename Function> struct MapPixels2Kernel;
+  template<typename C, typename Function> struct NativeBlocksKernel;
+  template<typename T, typename Function>
+  void parallel_for_each_block(const Raster *ras, const long int *window, const long int *blockShape,
+                               Raster *ras_out, const Function &fn, const unsigned &nthreads);
+  template<typename T, typename Function>
+  void parallel_for_each_block(const Raster *ras, const Raster *r2, const long int *blockShape,
+                               Raster *ras_out, const Function &fn, const unsigned &nthreads);
+  template<typename E> struct RasterExpr;
+
+  // number of pixels in the default block walked by Raster::for_each_block
+  const long int RASTER_BLOCK_PIXELS = 1048576;
+
+  // default blocks are made small enough to give each thread at least this many (see Raster::set_threads)
+  const long int RASTER_BLOCKS_PER_THREAD = 4;
+
+  // size of the chunk cache of the file the image is in (RASTER_CHUNK_CACHE_BYTES if it can not be read)
+  size_t chunk_cache_bytes(Image *image);
+
+  // RasterType of the pixels of an HDF5 dataset; false if there is none
+  bool raster_type_of(const H5::DataSet &dataset, RasterType &type);
+
+  // number of memory dataspaces (one per slice shape) a Raster keeps for reuse
+  const size_t RASTER_MAX_MEMSPACES = 16;
+
+  // bytes of tiles a Raster's write-back cache holds before it flushes them all
+  const size_t RASTER_WRITE_CACHE_BYTES = 64*1024*1024;
+
+  // size of a write-back cache tile of a contiguous raster (chunked rasters use their chunks)
+  const long int RASTER_CACHE_TILE_PIXELS = 65536;
+
+  // byte alignment of the pixels of an InMemoryRaster
+  const size_t RASTER_MEMORY_ALIGNMENT = 64;
+
+  // default memory budget of FFT_2D and FFT_2D_Inv: rasters whose transform fits are transformed in memory
+  const size_t RASTER_FFT_MEMORY = size_t(2)*1024*1024*1024;
+
+  // edge of the square tiles an out-of-core FFT transposes through (smaller if the budget needs it)
+  const long int RASTER_FFT_TILE = 256;
 
 
+  // a tile of a Raster's write-back cache, in the raster's own HDF5 type
+  struct RasterTile {
+    RasterSlice area;
+    std::vector<char> data;
+    bool dirty;
+  }; // end: RasterTile
+
+
+  // numbers of HDF5 dataset reads and writes made by all Rasters, see Raster::io_counters
+  struct RasterIOCounters {
+    unsigned long read_calls;
+    unsigned long write_calls;
+    unsigned long long bytes_read;
+    unsigned long long bytes_written;
+
+    RasterIOCounters() : read_calls(0), write_calls(0), bytes_read(0), bytes_written(0) {}
+    void reset() { *this = RasterIOCounters(); }
+  }; // end: RasterIOCounters
+
 
   /** \brief Raster -- Class to implement image and channel manipulation functions for HDF5-Raster Files
 
@@ -58,7 +131,81 @@ namespace GeoStar {
     std::string rastertype;
     RasterType  raster_datatype;
 
+    // extent of the dataset, cached by refresh_extent():
+    long int raster_nx;
+    long int raster_ny;
+
+    // true if for_each_block overlaps I/O with computation:
+    bool prefetch;
+
+    // number of threads for_each_block processes blocks on, see set_threads:
+    int threads;
+
+    // write-back cache, see set_write_cache.  Tiles are keyed by (tile row, tile column)
+    // and hold pixels in cache_type, the type of the dataset in the file (for an
+    // InMemoryRaster, the type of memory_pixels).
+    bool write_cache;
+    long int cache_tile[2];
+    H5::DataType cache_type;
+    mutable std::map<std::pair<long int, long int>, RasterTile> cache_tiles;
+    mutable size_t cache_bytes;
+
+    // reads or writes go through the cache when needed, then to h5_read and h5_write;
+    // an InMemoryRaster's go to memory_read and memory_write:
+    void read_slice(const RasterSlice &slice, void *buffer, const H5::DataType &memType) const;
+    void write_slice(const RasterSlice &slice, const void *buffer, const H5::DataType &memType) const;
+
+    // pixels of an InMemoryRaster, nx*ny of cache_type row by row, aligned to
+    // RASTER_MEMORY_ALIGNMENT.  NULL for a raster in a file.
+    std::shared_ptr<char> memory_pixels;
+
+    // a copy to or from memory_pixels, converted the way HDF5 converts on read and write:
+    void memory_read(const RasterSlice &slice, void *buffer, const H5::DataType &memType) const;
+    void memory_write(const RasterSlice &slice, const void *buffer, const H5::DataType &memType) const;
+
+    // a single HDF5 read or write, counted in io_counters():
+    void h5_read(const RasterSlice &slice, void *buffer, const H5::DataType &memType) const;
+    void h5_write(const RasterSlice &slice, const void *buffer, const H5::DataType &memType) const;
+
+    // write-back cache helpers:
+    bool cache_overlaps(const RasterSlice &slice) const;
+    RasterTile &cached_tile(const long int &tx, const long int &ty, const RasterSlice &slice) const;
+    void cache_read(const RasterSlice &slice, void *buffer, const H5::DataType &memType) const;
+    void cache_write(const RasterSlice &slice, const void *buffer, const H5::DataType &memType) const;
+
+    // dataspaces reused by read and write: file_space is the dataset's dataspace,
+    // re-selected for every slice, and mem_spaces has one memory dataspace per
+    // slice shape (dy, dx).  Both are dropped by refresh_extent().
+    mutable H5::DataSpace file_space;
+    mutable std::map<std::pair<long int, long int>, H5::DataSpace> mem_spaces;
+
+    // selects slice in file_space and returns it:
+    const H5::DataSpace &select_file_space(const RasterSlice &slice) const;
+
+    // memory dataspace of dy rows of dx pixels:
+    const H5::DataSpace &memory_space(const RasterSlice &slice) const;
+
+    // the open file, the group of the image holding the raster and the raster's dataset,
+    // shared with the other objects of the file (see FileHandle):
+    std::shared_ptr<FileHandle> raster_file;
+    std::shared_ptr<H5::Group> raster_image;
+    std::string raster_image_name;
+    std::shared_ptr<H5::DataSet> raster_dataset;
+
+    // sets the handles above from image, and rasterobj from dataset
+    void set_handles(Image *image, const std::shared_ptr<H5::DataSet> &dataset);
+
+    // points FFTPlans::shared() at the wisdom file next to the file of the raster, if that is on disk
+    void use_fft_wisdom() const;
+
+    friend class InMemoryRaster;
+
+  protected:
+    // an InMemoryRaster: nx by ny zeroed pixels in memory, with no file behind them
+    Raster(const std::string &name, const RasterType &type, const long int &nx, const long int &ny);
+
   public:
+    // the HDF5 dataset, owned by raster_dataset:
     H5::DataSet *rasterobj;
 
     /** \brief Raster Constructor -- allows you to open an existing raster
@@ -106,6 +253,10 @@ namespace GeoStar {
     \Par Details
 	The HDF5 Attribute named "object_type" must exist with the value "Geostar::HDF5"
 	or it is not a Geostar file and an exception is thrown
+
+	A raster that is already open in the file (see FileHandle) is not opened again: this Raster shares
+	its dataset, and the object type is not read again.  Each Raster still has its own write cache
+	(set_write_cache), so flush one before reading the same pixels through another.
     */
 
     Raster(Image *image, const std::string &name);
@@ -124,7 +275,8 @@ namespace GeoStar {
 
     \param[in] type
 	Specifies, out of the existing Raster Types, what data type you want your new raster to be.
-	Only accepts INT8U, INT16U, REAL32
+	Any RasterType.  The COMPLEX_* types are stored as an HDF5 compound {re, im} (see getHdf5FileType), and
+	are read and written through std::complex<float> or std::complex<double> buffers.
 
     \param[in] nx
 	specifies x-size (horizontal size) of new raster
@@ -132,6 +284,15 @@ namespace GeoStar {
     \param[in] ny
 	specifies y-size (vertical size) of new raster
 
+    \param[in] layout
+	how the pixels are stored in the file (see RasterLayout.hpp):
+	CONTIGUOUS  - one plain 2D array, no chunking
+	ROW_CHUNKED - chunks of layout.size whole rows
+	TILED       - square chunks of layout.size x layout.size pixels (the default)
+	A layout.size of 0 picks the chunk size from the file's chunk cache.
+	Chunked layouts can be compressed with layout.compression: COMPRESS_DEFLATE, COMPRESS_LZ4 or
+	COMPRESS_ZSTD (shuffle + codec, see compression.hpp).
+
     \returns
 	A valid raster object upon success
 
@@ -140,6 +301,7 @@ namespace GeoStar {
 
 	RasterCreationError
 	RasterExistsError
+	FileReadOnlyException -- the file was opened "readonly"
 
     \Par Example
 	creating a raster named "test":
@@ -165,9 +327,19 @@ namespace GeoStar {
     \Par Details
 	The HDF5 Attribute named "object_type" will be created with the value "Geostar::HDF5"
 	so it is considered a Geostar file, else an exception is thrown
+
+	Chunked layouts make column and tile access cheap: a tile of the default layout is sized so that a
+	whole row of tiles of a large raster fits in the chunk cache (RASTER_CHUNK_CACHE_BYTES), so both row
+	scans and column scans read every chunk from disk only once.
+	Rasters with a zero size are always contiguous.
+
+	Compression is transparent to read and write.  Asking for a codec whose HDF5 filter (or plugin)
+	is not available, or for compression of a CONTIGUOUS raster, raises RasterCreationError.
+	COMPRESS_AUTO needs a sample of the data to choose a codec (see Image::read_file and
+	select_compression); here it falls back to COMPRESS_DEFLATE.
     */
     Raster(Image *image, const std::string &name, const RasterType &type,
-           const int &nx, const int &ny);
+           const int &nx, const int &ny, const RasterLayout &layout = RasterLayout());
 
 /** \brief write_object_type -- allows you to write the type attribute of the raster
 
@@ -266,7 +438,7 @@ namespace GeoStar {
     /** \brief Raster destructor allows one to delete a Raster object from memory.
 
    The Raster destructor is automatically called to clean up memory used by the Raster object.
-   There is a single pointer to the HDF5 Raster object that must be deleted.
+   The HDF5 dataset is closed when the last Raster using it is deleted.
 
    \see open, close
 
@@ -298,18 +470,26 @@ namespace GeoStar {
 
   */
 
-    inline ~Raster() {
-      delete rasterobj;
+    virtual ~Raster() {
+      // a destructor can not report errors; call flush() first to see them
+      try {
+        flush();
+      } catch(...) {
+      }
     }
 
-     template <typename T> static H5::PredType getHdf5Type() {return H5::PredType::NATIVE_UINT8;}
+     // HDF5 memory type of a buffer of T; the supported types are specialized below the class.
+     template <typename T> static H5::DataType getHdf5Type() {return H5::PredType::NATIVE_UINT8;}
+
+     // HDF5 type a raster of the given type is stored as
+     static H5::DataType getHdf5FileType(const RasterType &type);
 
 /** \brief write -- allows you to write data to a raster
 
     write data from a vector to a slice in the raster.  The slice is defined by the first four dimensions
 	of the slice vector, namely x0, y0, dx, dy in that order.
 
-    \see read
+    \see read, write(const RasterSlice &, const T *, const size_t &)
 
     \param[in] slice
       This vector is the area you define to write data to.  The dimensions are as follows:
@@ -331,6 +511,7 @@ namespace GeoStar {
       Exceptions that could be raised:
 	RasterWriteError
 	SliceSizeError
+	FileReadOnlyException -- the file was opened "readonly"
 
     \Par Example
 	Writing to a raster:
@@ -370,41 +551,68 @@ namespace GeoStar {
     \Par Details
 	You can call 'writenew(slice, bufr);don't need to say writenew<int>(slice, bufr); for example
 	Make sure your slice vector is of size 4 or greater, otherwise an error will be thrown.
+	Neither the slice nor the buffer is copied; the data goes straight from the vector to HDF5.
     */
 
       template<typename T>
-      void write(const std::vector<long int> slice, std::vector<T> buffer) const {
+      void write(const std::vector<long int> &slice, const std::vector<T> &buffer) const {
 
-          RasterWriteErrorException RasterWriteError;
           SliceSizeException SliceSizeError;
 
           // slice needs to have: x0, y0, dx, dy
           if(slice.size() < 4) throw SliceSizeError;
 
-          // size of the slice of data is the SAME as the size of the slice in the file:
-          hsize_t memdims[2];
-          memdims[0]=slice[3];
-          memdims[1]=slice[2];
-          H5::DataSpace memspace(2,memdims);
-
-          H5::DataSpace dataspace = rasterobj->getSpace();
-
-          // set the slice within the file's dataset we want to write to:
-          hsize_t count[2];
-          hsize_t start[2];
-          start[0]=slice[1];
-          start[1]=slice[0];
-          count[0]=slice[3];
-          count[1]=slice[2];
-          dataspace.selectHyperslab(H5S_SELECT_SET, count, start);
-
-          //int totalSize = (count[0] - start[0]) * (count[1] - start[1]);
-          int totalSize = count[0] * count[1];
-          if (buffer.size() < totalSize) throw SliceSizeError;
-
-          H5::PredType h5Type = Raster::getHdf5Type<T>();
-          rasterobj->write( (void *)&buffer[0], h5Type, memspace, dataspace );
-      }
+          write(RasterSlice(slice), buffer.data(), buffer.size());
+      } // end: write
+
+
+
+/** \brief write -- write data from a caller-owned buffer to a raster
+
+    write length values starting at buffer to a slice of the raster, without copying them into a vector
+	first.  Use this to write from memory you manage yourself: a GDAL scanline buffer, a reused
+	(possibly aligned) scratch array, a slice of a larger array, ...
+
+    \see read, RasterSlice
+
+    \param[in] slice
+	the area to write: x0, y0, dx, dy.  slice should not be bigger than the raster you are writing to
+
+    \param[in] buffer
+	pointer to the first of slice.dx*slice.dy values, row by row.  HDF5 converts from T to the raster type.
+
+    \param[in] length
+	number of values available at buffer.  Must be at least slice.dx*slice.dy.
+
+    \returns
+	Nothing
+
+    \Par Exceptions
+      Exceptions that could be raised:
+	SliceSizeError -- raised when the buffer is shorter than the slice
+	FileReadOnlyException -- the file was opened "readonly"
+
+    \Par Example
+	Writing a 256x256 tile from a plain array:
+	\code
+	float *tile = new float[256*256];
+	// ... fill tile ...
+	ras->write(GeoStar::RasterSlice(512, 512, 256, 256), tile, 256*256);
+	delete[] tile;
+	\endcode
+    */
+
+      template<typename T>
+      void write(const RasterSlice &slice, const T *buffer, const size_t &length) const {
+
+          SliceSizeException SliceSizeError;
+
+          if(slice.dx < 0 || slice.dy < 0) throw SliceSizeError;
+          if(length < (size_t)slice.size()) throw SliceSizeError;
+
+          H5::DataType h5Type = Raster::getHdf5Type<T>();
+          write_slice(slice, (const void *)buffer, h5Type);
+      } // end: write
 
 
 
@@ -413,7 +621,7 @@ namespace GeoStar {
     read data from a slice in the raster to a vector.  The slice is defined by the first four dimensions
 	of the slice vector, namely x0, y0, dx, dy in that order.
 
-    \see write
+    \see write, read(const RasterSlice &, T *, const size_t &)
 
     \param[in] slice
       This vector is the area you define to read data from.  The dimensions are as follows:
@@ -474,41 +682,71 @@ namespace GeoStar {
 
     \Par Details
 	Make sure your slice vector is of size 4, otherwise an error will be thrown.
+	buffer is only resized when it is too small for the slice, so reading many slices into the
+	same vector allocates memory once.
     */
 
       template<typename T>
-      void read(const std::vector<long int> slice, std::vector<T> &buffer) const {
+      void read(const std::vector<long int> &slice, std::vector<T> &buffer) const {
 
-          RasterReadErrorException RasterReadError;
           SliceSizeException SliceSizeError;
 
           // slice needs to have: x0, y0, dx, dy
           if(slice.size() < 4) throw SliceSizeError;
 
-          // size of the slice of data is the SAME as the size of the slice in the file:
-          hsize_t memdims[2];
-          memdims[0]=slice[3];
-          memdims[1]=slice[2];
-          H5::DataSpace memspace(2,memdims);
-
-          H5::DataSpace dataspace = rasterobj->getSpace();
-
-          // set the slice within the file's dataset we want to write to:
-          // we want an offset of (50,50), and a size of 100X100
-          hsize_t count[2];
-          hsize_t start[2];
-          start[0]=slice[1];
-          start[1]=slice[0];
-          count[0]=slice[3];
-          count[1]=slice[2];
-          dataspace.selectHyperslab(H5S_SELECT_SET, count, start);
-
-          //int totalSize = (count[0] - start[0]) * (count[1] - start[1]);
-          int totalSize = count[0] * count[1];
-          if (buffer.size() < totalSize) buffer.resize(totalSize);
-
-          H5::PredType h5Type = Raster::getHdf5Type<T>();
-          rasterobj->read( (void *)&buffer[0], h5Type, memspace, dataspace);
+          RasterSlice area(slice);
+          if(area.dx < 0 || area.dy < 0) throw SliceSizeError;
+          if(buffer.size() < (size_t)area.size()) buffer.resize(area.size());
+
+          read(area, buffer.data(), buffer.size());
+      } // end: read
+
+
+
+/** \brief read -- read data from a raster into a caller-owned buffer
+
+    read a slice of the raster into length values starting at buffer, without going through a vector.
+	Use this to read straight into memory you manage yourself, such as a reused (possibly aligned)
+	scratch array or part of a larger array.
+
+    \see write, RasterSlice
+
+    \param[in] slice
+	the area to read: x0, y0, dx, dy.  slice should not be bigger than the raster you are reading from
+
+    \param[out] buffer
+	pointer to room for slice.dx*slice.dy values, filled row by row.  HDF5 converts from the raster type to T.
+
+    \param[in] length
+	number of values available at buffer.  Must be at least slice.dx*slice.dy.
+
+    \returns
+	Nothing
+
+    \Par Exceptions
+      Exceptions that could be raised:
+	SliceSizeError -- raised when the buffer is shorter than the slice
+
+    \Par Example
+	Reading a 256x256 tile into a plain array:
+	\code
+	float *tile = new float[256*256];
+	ras->read(GeoStar::RasterSlice(512, 512, 256, 256), tile, 256*256);
+	// ... use tile ...
+	delete[] tile;
+	\endcode
+    */
+
+      template<typename T>
+      void read(const RasterSlice &slice, T *buffer, const size_t &length) const {
+
+          SliceSizeException SliceSizeError;
+
+          if(slice.dx < 0 || slice.dy < 0) throw SliceSizeError;
+          if(length < (size_t)slice.size()) throw SliceSizeError;
+
+          H5::DataType h5Type = Raster::getHdf5Type<T>();
+          read_slice(slice, (void *)buffer, h5Type);
       } // end: read
 
 
@@ -548,45 +786,624 @@ namespace GeoStar {
 	\endcode
 
     */
-    long int get_nx() const;
+    long int get_nx() const;
+
+    /** \brief get_ny -- allows you to get the y-size of the raster
+
+    returns the actual size of the raster in the y-direction
+
+    \see get_nx
+
+    \returns
+	A long int containing the y-size of the raster
+
+    \Par Exceptions
+	None
+
+    \Par Example
+	Getting the y-size of a raster:
+	\code
+	#include "Geostar.hpp"
+	#include <string>
+	using namespace std;
+
+	int main() {
+	GeoStar::File *file = new GeoStar::File("a1.h5", "new");
+
+  	GeoStar::Image *img = file->create_image("landsat");
+
+  	GeoStar::Raster *ras = new GeoStar::Raster(img, "test", GeoStar::REAL32, 200, 200);
+	long int ny = ras->get_ny();
+
+	delete ras;
+	delete img;
+	delete file;
+
+	}
+
+	\endcode
+
+    */
+    long int get_ny() const;
+
+    /** \brief refresh_extent -- re-read the size of the raster from the file
+
+    get_nx, get_ny, read and write use a copy of the raster's extent and dataspaces that is made when the
+	raster is opened or created.  Call refresh_extent if the dataset has been resized since then.
+
+    \see get_nx, get_ny
+
+    \returns
+	Nothing
+
+    \Par Exceptions
+	None
+    */
+    void refresh_extent();
+
+    /** \brief set_prefetch -- overlap reading and writing with processing in for_each_block
+
+    When prefetch is on, for_each_block reads the next block and writes the previous one on a background
+	I/O thread while the current block is being processed.  All the operations built on for_each_block
+	(thresh, scale, gradientMask, add, ...) follow the setting of the raster they are called on.
+
+    \see get_prefetch, for_each_block, RasterReader, RasterWriter
+
+    \param[in] value
+	true to overlap I/O with processing, false (the default) to read, process and write in turn
+
+    \returns
+	Nothing
+
+    \Par Exceptions
+	None
+
+    \Par Details
+	HDF5 is only ever called from one thread at a time.  The function given to for_each_block runs on the
+	calling thread while HDF5 is busy on the I/O thread, so it must not make HDF5 calls itself when
+	prefetch is on.
+    */
+    void set_prefetch(const bool &value);
+
+    /** \brief get_prefetch -- true if for_each_block overlaps I/O with processing
+
+    \see set_prefetch
+    */
+    bool get_prefetch() const;
+
+    /** \brief set_threads -- process the blocks of for_each_block on several threads
+
+    With more than one thread, for_each_block hands its blocks to a pool of worker threads
+	(TileScheduler::shared()), so the processing of different blocks runs on different cores.  All the
+	operations built on for_each_block (thresh, scale, add, subtract, multiply, divide, gradientMask,
+	harmonicMean, midpointFilter, rangeFilter, ...) follow the setting of the raster they are called on.
+
+    \see get_threads, set_prefetch, for_each_block, TileScheduler
+
+    \param[in] value
+	number of threads; 1 (the default) processes the blocks in turn on the calling thread.  0 uses one
+	thread per core.
+
+    \returns
+	Nothing
+
+    \Par Exceptions
+	None
+
+    \Par Example
+	Threshholding on 4 cores:
+	\code
+	ras->set_threads(4);
+	ras->thresh(100);
+	\endcode
+
+    \Par Details
+	HDF5 is still only called from one thread at a time: every block is read and written on the shared
+	I/O thread, one after the other, while the other threads compute.  The function given to
+	for_each_block is copied for each thread and the copies run at the same time, so it must not call
+	HDF5 nor change shared state without a lock.  Blocks are processed in no particular order, and
+	without a block shape the default blocks are made small enough for RASTER_BLOCKS_PER_THREAD blocks
+	per thread.  Work only scales while processing a block takes longer than reading and writing it.
+    */
+    void set_threads(const int &value);
+
+    /** \brief get_threads -- number of threads for_each_block processes blocks on
+
+    \see set_threads
+    */
+    int get_threads() const;
+
+    /** \brief set_write_cache -- collect small writes in memory and write them out in whole tiles
+
+    With the write cache on, write() copies the data into tiles held in memory instead of writing it to
+	the file.  The tiles are written back, one HDF5 write per tile, by flush(), when the cache grows past
+	RASTER_WRITE_CACHE_BYTES, when the cache is turned off, and when the raster is deleted.
+	This turns the many small writes of the drawing functions (drawFilledCircle, drawRectangle, set, ...)
+	into a few large ones.
+
+    \see flush, get_write_cache, io_counters
+
+    \param[in] value
+	true to turn the cache on, false (the default) to write straight to the file
+
+    \returns
+	Nothing
+
+    \Par Exceptions
+	Turning the cache off flushes it, which may raise the HDF5 exceptions of write.
+
+    \Par Example
+	Drawing many small circles:
+	\code
+	ras->set_write_cache(true);
+	for(int i=0; i<1000; ++i) ras->drawFilledCircle(10 + (i*37)%900, 10 + (i*91)%900, 5, 255);
+	ras->flush();
+	\endcode
+
+    \Par Details
+	Tiles are the HDF5 chunks of a chunked raster, so flushing writes whole chunks.  A contiguous raster
+	uses bands of whole rows.  The first write to a tile reads it from the file, unless the write covers it.
+	Reads that touch cached tiles are served from the cache, so they always see the data written so far.
+	Data in the cache is kept in the raster's own type, converted the same way HDF5 converts it on write.
+    */
+    void set_write_cache(const bool &value);
+
+    /** \brief get_write_cache -- true if writes are collected in the write-back cache
+
+    \see set_write_cache
+    */
+    bool get_write_cache() const;
+
+    /** \brief flush -- write the tiles changed in the write-back cache to the file
+
+    Writes every changed tile with one HDF5 write and empties the cache.  Does nothing if the cache is empty.
+
+    \see set_write_cache
+
+    \returns
+	Nothing
+
+    \Par Exceptions
+	The HDF5 exceptions of write.  Tiles not yet written stay in the cache.
+    */
+    void flush() const;
+
+    /** \brief io_counters -- numbers of HDF5 reads and writes made by all Rasters
+
+    Every HDF5 dataset read or write done by a Raster read, write, flush or for_each_block is counted.
+	Call io_counters().reset() before the code to measure.
+
+    \see set_write_cache
+
+    \returns
+	the counters, shared by all Rasters
+
+    \Par Details
+	Bytes are counted in the type of the caller's buffer.  Reads and writes of an InMemoryRaster make no
+	HDF5 calls and are not counted.
+    */
+    static RasterIOCounters &io_counters();
+
+    /** \brief set_fft_memory -- memory budget of FFT_2D and FFT_2D_Inv
+
+    A raster whose pixels (as double) and half spectrum fit in the budget, 8*nx*ny + 16*(nx/2+1)*ny bytes, or half that
+	in single precision (REAL32, see FFT_2D(img, rasOut)), is transformed in memory with one 2D FFT: one read and one
+	write.  A bigger one is transformed out of core, in bands as large as the budget allows.  Shared by all Rasters.
+
+    \see get_fft_memory, FFT_2D, FFT_2D_Inv
+
+    \param[in] bytes
+	The budget, RASTER_FFT_MEMORY (2 GiB) to start with.
+    */
+    static void set_fft_memory(const size_t &bytes);
+
+    // get_fft_memory: memory budget of FFT_2D and FFT_2D_Inv, see set_fft_memory
+    static size_t get_fft_memory();
+
+    /** \brief default_block_shape -- the tile shape used when walking a raster block by block
+
+    Fills in the x-size and y-size of the blocks that for_each_block uses when no block shape is given.
+
+    \see for_each_block
+
+    \param[out] blockShape
+	array of (at least) 2 elements that receives the block size:
+	[0] - x-size of a block
+	[1] - y-size of a block
+
+    \returns
+	Nothing
+
+    \Par Exceptions
+	None
+
+    \Par Details
+	The default block is a band of whole rows holding roughly RASTER_BLOCK_PIXELS pixels.  A narrow raster
+	gets tall bands, a very wide raster gets bands of a single row.
+	For a chunked raster the height of the band is rounded to a whole number of chunks, so every chunk is
+	read from the file once per pass.  With set_threads(n), bands are made low enough for
+	RASTER_BLOCKS_PER_THREAD*n of them, so every thread has work; but never lower than a chunk.
+    */
+    void default_block_shape(long int *blockShape) const;
+
+    /** \brief get_chunk_shape -- the shape of the HDF5 chunks of the raster
+
+    Fills in the x-size and y-size of the chunks the raster is stored in.
+
+    \see default_block_shape, RasterLayout
+
+    \param[out] chunkShape
+	array of (at least) 2 elements that receives the chunk size:
+	[0] - x-size of a chunk
+	[1] - y-size of a chunk
+	For a contiguous raster the whole raster is returned.
+
+    \returns
+	true if the raster is chunked, false if it is contiguous
+
+    \Par Exceptions
+	None
+    */
+    bool get_chunk_shape(long int *chunkShape) const;
+
+    /** \brief load -- copy the raster into memory with one read
+
+    Returns an InMemoryRaster with the name, type, size and pixels of this raster.  The whole raster comes
+	back in a single HDF5 read, in the raster's own type.  Operations on the copy make no HDF5 calls, so a
+	chain of them (pyramids, repeated filters, FFT round trips) runs at memory speed; InMemoryRaster::store
+	writes the result back with one HDF5 write.
+
+    \see InMemoryRaster, InMemoryRaster::store, is_in_memory
+
+    \returns
+	A new InMemoryRaster, deleted by the caller.  This raster is not changed.
+
+    \Par Exceptions
+	RasterCreationError -- the memory for the copy could not be allocated
+	The HDF5 exceptions of read.
+
+    \Par Example
+	\code
+	GeoStar::InMemoryRaster *mem = ras->load();
+	mem->thresh(30);
+	mem->scale(mem, 0, 2);
+	GeoStar::Raster *out = mem->store(img, "chan1_scaled");
+	delete out;
+	delete mem;
+	\endcode
+    */
+    InMemoryRaster *load() const;
+
+    /** \brief is_in_memory -- true for an InMemoryRaster, false for a raster in a file
+
+    \see load, InMemoryRaster
+    */
+    bool is_in_memory() const;
+
+    /** \brief map_file -- the pixels of the raster, mapped read-only from the file
+
+    If the raster is stored in its file as one plain array of memType (a contiguous dataset, already written,
+	in a file on disk), the array is mmap'ed and returned without reading or copying anything.  Pages are
+	read on first touch and shared through the page cache with every process mapping the same file.
+	Otherwise an empty pointer is returned, and the raster must be read instead.  RasterView does both.
+
+    \see RasterView, RasterLayout
+
+    \param[in] memType
+	HDF5 type the caller wants the pixels in, e.g. getHdf5Type<float>().  It must be the type of the dataset
+	in the file: nothing is converted.
+
+    \returns
+	nx*ny pixels row by row, valid while the pointer (or a copy of it) exists; or an empty pointer.
+
+    \Par Exceptions
+	The HDF5 exceptions of flush.
+
+    \Par Details
+	Chunked and compressed rasters, rasters never written to, rasters in a "memory" file, and datasets not
+	aligned in the file for memType are not mapped.  An InMemoryRaster of memType returns its own buffer.
+	The write cache and HDF5's buffers are flushed first, so the mapping sees every write made so far;
+	later writes through HDF5 may not be seen until the file is flushed.
+    */
+    std::shared_ptr<const char> map_file(const H5::DataType &memType) const;
+
+/** \brief for_each_block -- walk a raster in tiles, writing each processed tile to an output raster
+
+    Reads the raster one block at a time, hands each block to a user-supplied function, and writes the
+	(modified) block to the same place in ras_out.  One buffer is allocated for the whole walk and reused
+	for every block, so a full pass over the raster costs one HDF5 read and one HDF5 write per block
+	instead of one per scanline.
+
+    \see default_block_shape, read, write
+
+    \param[in] blockShape
+	array of 2 elements with the x-size and y-size of a block.  Pass NULL to use default_block_shape.
+	Blocks on the right and bottom edges are clipped to the raster.
+
+    \param[out] ras_out
+	raster the processed blocks are written to.  Must be at least as big as this raster.
+	Pass "this" to process a raster in place.
+
+    \param[in] fn
+	function (or lambda) called as fn(slice, data) for every block.  slice holds x0, y0, dx, dy of the
+	block and data holds the dx*dy pixels of the block, row by row.  Any changes made to data are written out.
+	data may be longer than dx*dy; only the first dx*dy values belong to the block.
+
+    \returns
+	Nothing
+
+    \Par Exceptions
+      Exceptions that could be raised:
+	SliceSizeError
+
+    \Par Example
+	Clamping a raster to 255, 256x256 tiles at a time:
+	\code
+	#include "geostar.hpp"
+	#include <vector>
+
+	int main() {
+	GeoStar::File *file = new GeoStar::File("a1.h5", "existing");
+	GeoStar::Image *img = file->open_image("landsat");
+	GeoStar::Raster *ras = img->open_raster("B07");
+
+	long int blockShape[2] = {256, 256};
+	ras->for_each_block<float>(blockShape, ras,
+	  [](const std::vector<long int> &slice, std::vector<float> &data) {
+	    for(long int i=0; i<slice[2]*slice[3]; ++i) if(data[i] > 255) data[i] = 255;
+	  });
+
+	delete ras;
+	delete img;
+	delete file;
+	}
+	\endcode
+
+    \Par Details
+	T is the type of the buffer the blocks are read into; HDF5 converts from the raster type on the way in
+	and back to the output raster type on the way out.
+    */
+    template<typename T, typename Function>
+    void for_each_block(const long int *blockShape, Raster *ras_out, Function fn) const {
+      long int window[4] = {0, 0, get_nx(), get_ny()};
+      for_each_block<T>(window, blockShape, ras_out, fn);
+    }
+
+/** \brief for_each_block -- walk part of a raster in tiles
+
+    Same as for_each_block(blockShape, ras_out, fn), but only the blocks inside window are visited.
+	Useful for region operations that only touch whole regions of the raster.
+
+    \see for_each_block
+
+    \param[in] window
+	array of 4 elements: x0, y0, dx, dy of the part of the raster to walk.
+
+    \Par Exceptions
+      Exceptions that could be raised:
+	SliceSizeError
+    */
+    template<typename T, typename Function>
+    void for_each_block(const long int *window, const long int *blockShape,
+                        Raster *ras_out, Function fn) const {
+      SliceSizeException SliceSizeError;
+
+      long int shape[2];
+      if(blockShape == NULL) {
+        default_block_shape(shape);
+      } else {
+        shape[0] = blockShape[0];
+        shape[1] = blockShape[1];
+      }// endif
+      if(shape[0] < 1 || shape[1] < 1) throw SliceSizeError;
+
+      if(threads > 1) {
+        parallel_for_each_block<T>(this, window, shape, ras_out, fn, threads);
+        return;
+      }// endif
+
+      std::vector<long int> slice(4);
+      std::vector<T> data(shape[0]*shape[1]);
+
+      if(prefetch) {
+        RasterReader<T> reader(this, window, shape);
+        RasterWriter<T> writer(ras_out);
+        while(reader.next(slice, data)) {
+          fn(slice, data);
+          writer.write(slice, data);
+        }// endwhile
+        writer.finish();
+        return;
+      }// endif
+
+      for(long int y=window[1]; y<window[1]+window[3]; y+=shape[1]) {
+        slice[1] = y;
+        slice[3] = std::min(shape[1], window[1]+window[3]-y);
+        for(long int x=window[0]; x<window[0]+window[2]; x+=shape[0]) {
+          slice[0] = x;
+          slice[2] = std::min(shape[0], window[0]+window[2]-x);
+          RasterSlice area(slice);
+          read(area, data.data(), data.size());
+          fn(slice, data);
+          ras_out->write(area, data.data(), data.size());
+        }// endfor: x
+      }// endfor: y
+    }// end: for_each_block
+
+/** \brief for_each_block -- walk two rasters in tiles, writing a combination of them to an output raster
+
+    Reads the same block from this raster and from r2, calls fn(slice, dataA, dataB) and writes dataA to
+	ras_out.  Used for the pixel-by-pixel arithmetic functions.
+
+    \see for_each_block, add, subtract, multiply, divide
+
+    \param[in] r2
+	second input raster.  Must be the same size as this raster.
+
+    \Par Exceptions
+      Exceptions that could be raised:
+	RasterSizeErrorException -- raised when the two rasters have different sizes
+	SliceSizeError
+    */
+    template<typename T, typename Function>
+    void for_each_block(const long int *blockShape, const Raster *r2,
+                        Raster *ras_out, Function fn) const {
+      SliceSizeException SliceSizeError;
+      RasterSizeErrorException RasterSizeError;
+
+      long int nx = get_nx(), ny = get_ny();
+      if(nx != r2->get_nx() || ny != r2->get_ny()) throw RasterSizeError;
+
+      long int shape[2];
+      if(blockShape == NULL) {
+        default_block_shape(shape);
+      } else {
+        shape[0] = blockShape[0];
+        shape[1] = blockShape[1];
+      }// endif
+      if(shape[0] < 1 || shape[1] < 1) throw SliceSizeError;
+
+      if(threads > 1) {
+        parallel_for_each_block<T>(this, r2, shape, ras_out, fn, threads);
+        return;
+      }// endif
+
+      std::vector<long int> slice(4);
+      std::vector<T> dataA(shape[0]*shape[1]);
+      std::vector<T> dataB(shape[0]*shape[1]);
+
+      if(prefetch) {
+        long int window[4] = {0, 0, nx, ny};
+        RasterReader<T> readerA(this, window, shape);
+        RasterReader<T> readerB(r2, window, shape);
+        RasterWriter<T> writer(ras_out);
+        std::vector<long int> sliceB(4);
+        while(readerA.next(slice, dataA) && readerB.next(sliceB, dataB)) {
+          fn(slice, dataA, dataB);
+          writer.write(slice, dataA);
+        }// endwhile
+        writer.finish();
+        return;
+      }// endif
+
+      for(long int y=0; y<ny; y+=shape[1]) {
+        slice[1] = y;
+        slice[3] = std::min(shape[1], ny-y);
+        for(long int x=0; x<nx; x+=shape[0]) {
+          slice[0] = x;
+          slice[2] = std::min(shape[0], nx-x);
+          RasterSlice area(slice);
+          read(area, dataA.data(), dataA.size());
+          r2->read(area, dataB.data(), dataB.size());
+          fn(slice, dataA, dataB);
+          ras_out->write(area, dataA.data(), dataA.size());
+        }// endfor: x
+      }// endfor: y
+    }// end: for_each_block
+
+/** \brief map_pixels -- apply a function to every pixel, on the raster's own pixel type
+
+    Reads the raster block by block in its own type (uint8_t for INT8U, uint16_t for INT16U, ...), calls
+	op on every pixel converted to C, and stores the result back in the raster's type with saturate_cast.
+	Compared with reading into float, an INT8U raster moves a quarter of the bytes and HDF5 does no
+	type conversion.
+
+    \see for_each_block, for_each_native_block, dispatch_raster_type, saturate_cast
+
+    \param[out] ras_out
+	raster the result is written to.  Pass "this" to work in place.
+
+    \param[in] op
+	function (or lambda) called as op(value) with value of type C, returning the new value.
+
+    \returns
+	Nothing
+
+    \Par Exceptions
+      Exceptions that could be raised:
+	SliceSizeError
+
+    \Par Example
+	Clamping a raster to 100 on its own type:
+	\code
+	ras->map_pixels<float>(ras, [](float v) -> float { return v > 100 ? 100 : v; });
+	\endcode
+
+    \Par Details
+	When ras_out is of a different type, or the raster has no native pixel type, the blocks are read as C
+	and HDF5 converts to the output type, as for_each_block<C> does.
+    */
+    template<typename C, typename Function>
+    void map_pixels(Raster *ras_out, Function op) const {
+      MapPixelsKernel<C, Function> kernel(this, ras_out, op);
+      if(ras_out->raster_datatype != raster_datatype || !dispatch_raster_type(raster_datatype, kernel)) {
+        kernel(C());
+      }// endif
+    }
 
-    /** \brief get_ny -- allows you to get the y-size of the raster
+/** \brief map_pixels -- apply a function to every pair of pixels of two rasters, on their own pixel type
 
-    returns the actual size of the raster in the y-direction
+    Same as map_pixels(ras_out, op), but op is called as op(a, b) with the pixels of this raster and r2.
 
-    \see get_nx
+    \see map_pixels, for_each_block
 
-    \returns
-	A long int containing the y-size of the raster
+    \param[in] r2
+	second input raster.  Must be the same size as this raster.
 
     \Par Exceptions
-	None
+      Exceptions that could be raised:
+	RasterSizeErrorException -- raised when the two rasters have different sizes
+	SliceSizeError
 
-    \Par Example
-	Getting the y-size of a raster:
-	\code
-	#include "Geostar.hpp"
-	#include <string>
-	using namespace std;
+    \Par Details
+	The native type is only used when r2 and ras_out are of the same type as this raster.
+    */
+    template<typename C, typename Function>
+    void map_pixels(const Raster *r2, Raster *ras_out, Function op) const {
+      MapPixels2Kernel<C, Function> kernel(this, r2, ras_out, op);
+      if(ras_out->raster_datatype != raster_datatype || r2->raster_datatype != raster_datatype
+         || !dispatch_raster_type(raster_datatype, kernel)) {
+        kernel(C());
+      }// endif
+    }
 
-	int main() {
-	GeoStar::File *file = new GeoStar::File("a1.h5", "new");
+/** \brief for_each_native_block -- for_each_block reading and writing the raster's own pixel type
 
-  	GeoStar::Image *img = file->create_image("landsat");
+    Same as for_each_block<C>, but the blocks are read in the raster's own type and handed to fn
+	converted to C; fn's results are stored back with saturate_cast.  Used by the region filters,
+	which need whole blocks rather than single pixels.
 
-  	GeoStar::Raster *ras = new GeoStar::Raster(img, "test", GeoStar::REAL32, 200, 200);
-	long int ny = ras->get_ny();
+    \see for_each_block, map_pixels
 
-	delete ras;
-	delete img;
-	delete file;
+    \Par Details
+	When ras_out is of a different type, or the raster has no native pixel type, this is for_each_block<C>.
+    */
+    template<typename C, typename Function>
+    void for_each_native_block(const long int *window, const long int *blockShape,
+                               Raster *ras_out, Function fn) const {
+      NativeBlocksKernel<C, Function> kernel(this, window, blockShape, ras_out, fn);
+      if(ras_out->raster_datatype != raster_datatype || !dispatch_raster_type(raster_datatype, kernel)) {
+        kernel(C());
+      }// endif
+    }
 
-	}
+    template<typename C, typename Function>
+    void for_each_native_block(const long int *blockShape, Raster *ras_out, Function fn) const {
+      long int window[4] = {0, 0, get_nx(), get_ny()};
+      for_each_native_block<C>(window, blockShape, ras_out, fn);
+    }
 
-	\endcode
+    /** \brief get_datatype -- the RasterType of the raster's pixels
 
+    For a raster opened from a file, the type is worked out from the HDF5 type of the dataset.
+
+    \returns
+	the RasterType of the raster
     */
-    long int get_ny() const;
+    RasterType get_datatype() const;
+
+    // get_name: name of the raster in its image
+    std::string get_name() const { return rastername; }
 
     /** \brief thresh -- sets all values under a threshhold to zero
 
@@ -1360,8 +2177,7 @@ namespace GeoStar {
     \see read, write, FFT_2D_Inv
 
     \param[in] img
-	The image object you wish to use to create your buffer rasters in.  Typically should be the same image that your input/output
-	rasters are stored in.
+	Ignored, and kept for API compatibility: the temporaries come from Scratch::shared().
 
     \param[out] rasOutReal
 	This is the raster object to which the real part of the FFT data will be written to.  The original image will remain unchanged.
@@ -1420,13 +2236,70 @@ namespace GeoStar {
 
 	\par Details
 
-	rastersizeerror exception will be thrown if your rasOutReal and rasOutImg are not the same size as your input raster.
+	rastersizeerror exception will be thrown if your rasOutReal and rasOutImg are not the same size as your input raster, or
+	both nx/2+1 wide for the non-redundant half of the spectrum (see FFT_2D(img, rasOut)).
 
-	The FFT will perform a complex to complex transfer - the real part of the complex numbers will be data from the raster this 		function is called on, but the imaginary part will be set to all zeros.  Data is read line by line and 1D transforms are performed
-	row by row to real and imaginary buffer rasters, then column by column from the buffers to the output rasters.
+	The transform is the one of FFT_2D(img, rasOut), written in double precision straight to the two output rasters.  Out of
+	core, the transpose is a COMPLEX_REAL64 scratch raster (COMPLEX_REAL128 when both outputs are REAL64).  Scratch rasters
+	are removed on return (see Scratch), so nothing is added to img or its file.
     */
   void FFT_2D(GeoStar::Image *img, Raster *rasOutReal, Raster *rasOutImg);
 
+/** \brief FFT_2D -- Performs a two-dimensional Fast Fourier Transform into one complex raster
+
+    Same transform as FFT_2D(img, rasOutReal, rasOutImg), but the real and imaginary parts are written interleaved to one
+	complex raster.
+
+    \see FFT_2D_Inv, is_complex
+
+    \param[in] img
+	Ignored, and kept for API compatibility: the temporaries come from Scratch::shared().
+
+    \param[out] rasOut
+	Complex raster (COMPLEX_REAL64 or COMPLEX_REAL128 are the sensible choices) of the same size as this raster, or nx/2+1
+	wide for only the non-redundant half of the spectrum.
+
+    \returns
+	nothing
+
+    \par Exceptions
+	RasterSizeErrorException, DataTypeException
+
+    \par Example
+	\code
+	GeoStar::Raster *ras = img->open_raster("test");
+	GeoStar::Raster *rasFFT = img->create_raster("FFT", GeoStar::COMPLEX_REAL64, ras->get_nx(), ras->get_ny());
+	ras->FFT_2D(img, rasFFT);
+	\endcode
+
+    \par Details
+	rastersizeerror exception will be thrown if rasOut is neither the size of the input raster nor nx/2+1 by ny, and
+	DataTypeException if it is not complex.
+
+	The spectrum of a real raster is Hermitian, X[y][x] = conj(X[ny-y][nx-x]), so columns 0 to nx/2 hold all of it: an
+	nx/2+1 wide rasOut stores just those, and FFT_2D_Inv takes it back.  A full-width rasOut gets the other columns too.
+
+	When the pixels and the half spectrum fit in the memory budget (see set_fft_memory), the raster is read in one go and
+	transformed with a single real-to-complex 2D FFT, then written.
+
+	Otherwise it is transformed out of core, through a scratch raster (see Scratch) holding the transpose of the spectrum
+	in square tiles of RASTER_FFT_TILE pixels: COMPLEX_REAL128, or COMPLEX_REAL64 in single precision or for a
+	COMPLEX_REAL64 rasOut, so a COMPLEX_INT rasOut gets the same spectrum either way.  Rows are read and transformed in bands of whole
+	tiles and written to it transposed; its rows, the columns of the spectrum, are transformed in place in bands; then it
+	is read back in bands of whole tiles, transposed, and written to rasOut in bands of rows.  Every HDF5 access is a band
+	of whole rows or of whole tiles, never a column.
+
+	The FFTW plans of either way come from FFTPlans::shared(): made once per size at its planner effort (FFT_ESTIMATE by
+	default), then reused by every transform of that size, and FFTW's wisdom kept in FFT_WISDOM_FILE in the directory of
+	the file of the raster.  Large transforms run on the threads of FFTPlans::set_threads.  The inverse transforms do the
+	same.
+
+	A REAL32 raster transformed to a COMPLEX_REAL64 one is transformed in single precision (fftwf), which holds all the
+	precision of the rasters in half the memory and runs faster: a raster twice the size is still transformed in memory.
+	Any other pair of types is transformed in double precision.
+    */
+  void FFT_2D(GeoStar::Image *img, Raster *rasOut);
+
 /** \brief FFT_2D_Inv -- Performs a two-dimensional Inverse Fast Fourier Transform
 
     writes to one output raster for the real output.  Takes in real data from the raster this is called on, and imaginary data 
@@ -1435,8 +2308,7 @@ namespace GeoStar {
     \see read, write, FFT_2D
 
     \param[in] img
-	The image object you wish to use to create your buffer rasters in.  Typically should be the same image that your input/output
-	rasters are stored in.
+	Ignored, and kept for API compatibility: the temporaries come from Scratch::shared().
 
     \param[out] rasOut
 	This is the raster object to which the real part of the InvFFT data will be written to.  The original image will remain unchanged.
@@ -1501,104 +2373,133 @@ namespace GeoStar {
 
 	\par Details
 
-	rastersizeerror exception will be thrown if your rasOut and rasImg are not the same size as your input raster.
-
-	The FFT will perform a complex to complex transfer - the real part of the complex numbers will be data from the raster this 		function is called on, and imaginary from the rasImg parameter.  Data is read line by line and 1D transforms are performed
-	col by col to real and imaginary buffer rasters, then row by row from the buffers to the output raster.  The data is divided
-	by a factor of 10 after the final transformation to normalize it - otherwise the values are far larger than they should be.
+	rastersizeerror exception will be thrown if your rasOut and rasImg are not the same size as your input raster, or if the
+	input rasters are not the size of rasOut or nx/2+1 wide (the half spectrum, see FFT_2D(img, rasOut)).
+
+	The result is the real part of the complex to complex inverse transform - the real part of the complex numbers will be data
+	from the raster this function is called on, and imaginary from the rasImg parameter.  When it fits in the memory budget
+	(see set_fft_memory), the Hermitian part of the spectrum, whose inverse is that real part, is gathered in memory and
+	transformed with a single complex-to-real 2D FFT.  Otherwise the two parts are read in bands of rows into the transpose of
+	the spectrum, a COMPLEX_REAL64 scratch raster (COMPLEX_REAL128 when both are REAL64) of square tiles as in FFT_2D, whose
+	rows (the columns) are transformed, then read back transposed and transformed row by row into the output raster.  The data
+	is divided by a factor of 200000 after the final transformation to normalize it - otherwise the values are far larger than
+	they should be.
     */
   void FFT_2D_Inv(GeoStar::Image *img, Raster *rasOut, Raster *rasInImg);
 
-/** \brief LowPassFilter -- Performs a low-pass filter on an image
+/** \brief FFT_2D_Inv -- Performs a two-dimensional Inverse Fast Fourier Transform of a complex raster
 
-    writes to an output raster, performing a set of Fourier transforms by row and col on the input raster, setting a square of all zeros
-	in the FFT output rasters, and transforming back to real data.  
+    Same transform as FFT_2D_Inv(img, rasOut, rasInImg), reading the real and imaginary parts interleaved from the complex raster
+	this is called on, such as the output of FFT_2D(img, rasOut).
 
-    \see read, write, FFT_2D, set
+    \see FFT_2D, is_complex
 
     \param[in] img
-	The image object you wish to use to create your buffer rasters in.  Typically should be the same image that your input/output
-	rasters are stored in.
-
-    \param[in] rasInReal
-	This is the raster object to which the real part of the FFT data will be written to.  The original image will remain unchanged.
-
-    \param[in] rasInImg
-	This is the raster object to which the img part of the FFT data will be written to.  The original image will remain unchanged.
+	Ignored, and kept for API compatibility: the temporaries come from Scratch::shared().
 
-    \param[out] rasOutReal
-	This is the raster object the final inverse FFT transform data will be written to.  The original image will remain unchanged.
+    \param[out] rasOut
+	This is the raster object to which the real part of the InvFFT data will be written to.  The original image will remain unchanged.
 
     \returns
 	nothing
 
     \par Exceptions
-	RasterSizeErrorException
+	RasterSizeErrorException, DataTypeException
 
     \par Example
-	using a low-pass filter on ras, outputting to a single real raster:
-
 	\code
-	#include "Geostar.hpp"
-	using namespace std;
+	GeoStar::Raster *rasFFT = img->open_raster("FFT");
+	GeoStar::Raster *rasOut = img->create_raster("out", GeoStar::REAL32, rasFFT->get_nx(), rasFFT->get_ny());
+	rasFFT->FFT_2D_Inv(img, rasOut);
+	\endcode
 
-	int main() {
-	GeoStar::File *file = new GeoStar::File("a1.h5", "new");
+    \par Details
+	rastersizeerror exception will be thrown if this raster is neither the size of rasOut nor nx/2+1 by ny (the half spectrum
+	of FFT_2D), and DataTypeException if this raster is not complex.
 
-  	GeoStar::Image *img = file->create_image("landsat");
+	In memory with a single complex-to-real 2D FFT when it fits the memory budget, as in the two-raster form.  Otherwise out of
+	core through a transpose, COMPLEX_REAL128 unless this raster is COMPLEX_REAL64, as in the two-raster form.  The result is scaled as in the two-raster
+	form.
+    */
+  void FFT_2D_Inv(GeoStar::Image *img, Raster *rasOut);
 
-  	GeoStar::Raster *ras = new GeoStar::Raster(img, "test", GeoStar::REAL32, 1024, 1024);
+/** \brief frequencyFilter -- filters the raster in the frequency domain
 
-	GeoStar::Raster *rasReal = new GeoStar::Raster(img, "Real", GeoStar::REAL32, 1024, 1024);
+    writes to an output raster the raster filtered by a transfer function: its spectrum multiplied by the gain of each
+	frequency, and transformed back.  The transfer function is one of the low-pass, high-pass, band-pass or notch filters
+	of FrequencyFilter, ideal, Butterworth or Gaussian, or any function of the frequency.
 
-	GeoStar::Raster *rasImg = new GeoStar::Raster(img, "Imaginary", GeoStar::REAL32, 1024, 1024);
+    \see FrequencyFilter, FFT_2D, FFT_2D_Inv
 
-	GeoStar::Raster *rasOut = new GeoStar::Raster(img, "Output", GeoStar::REAL32, 1024, 1024);
+    \param[out] rasOut
+	Raster the filtered pixels are written to, the size of this raster.  It may be this raster.
 
-	ras->lowPassFilter(img, rasReal, rasImg, rasOut);
+    \param[in] filter
+	The transfer function: the gain of each frequency (u, v), in cycles per pixel.
 
-	delete ras;
-	delete rasReal;
-	delete rasImg;
-	delete rasOut;
-	delete img;
-	delete file;
+    \returns
+	Nothing
 
-	}
+    \par Exceptions
+	RasterSizeErrorException, DataTypeException
 
+    \par Example
+	Removing the stripes of a scanner, every 8 rows, then smoothing:
+	\code
+	ras->frequencyFilter(rasOut, GeoStar::FrequencyFilter::notch(0, 0.125, 0.01, GeoStar::FILTER_GAUSSIAN));
+	rasOut->frequencyFilter(rasOut, GeoStar::FrequencyFilter::lowPass(0.25, GeoStar::FILTER_BUTTERWORTH, 4));
 	\endcode
 
-	<table>
-        <tr>
-        <td>
-        \imageSize{beforeBeach.png,height:150px;width:150px;}
-        \image html beforeBeach.png "Before low-pass filter"
-        </td>
-        <td>
-        \imageSize{afterFFTFWDINVbeach.png,height:150px;width:150px;}
-        \image html afterFFTFWDINVbeach.png "After low-pass filter"
-        </td>
-        <td>
-        \imageSize{beforeBeachTable100.png,height:150px;width:150px;}
-        \image html beforeBeachTable100.png "before - table view"
-        </td>
-        <td>
-        \imageSize{afterlowpassbeachtable.png,height:150px;width:150px;}
-        \image html afterlowpassbeachtable.png "after low-pass filter - table view"
-        </td>
-        </tr>
-        </table>
+    \par Details
+	rastersizeerror exception will be thrown if rasOut is not the size of this raster, and DataTypeException if either is
+	complex.
+
+	The filter is applied to the half spectrum of the forward transform, in place, and the inverse is taken of it, scaled by
+	1/(nx*ny): a gain of 1 everywhere gives back the raster, and a low pass keeps its mean.  No dataset is made for the
+	spectrum.  When the pixels and the half spectrum fit the memory budget (see set_fft_memory), the raster is read in one
+	go, transformed, filtered and transformed back in memory, and written.  Otherwise the half spectrum goes through one
+	scratch raster of square tiles holding its transpose, as in FFT_2D: the rows are transformed into it, its rows (the
+	columns of the spectrum) are transformed, filtered and transformed back in the same pass, then the rows are transformed
+	back to rasOut.  REAL32 rasters are filtered in single precision, as in FFT_2D.
+    */
+  void frequencyFilter(Raster *rasOut, const FrequencyFilter &filter);
 
-	\par Details
+/** \brief LowPassFilter -- Performs a low-pass filter on an image
+
+    writes to an output raster the raster low-pass filtered: frequencyFilter with an ideal low pass of 0.2 cycles per pixel,
+	FrequencyFilter::lowPass(0.2).  Kept for the callers of the filter it replaces, which zeroed a hard set square of the
+	spectrum; new code should call frequencyFilter with the filter it needs.
+
+    \see frequencyFilter, FrequencyFilter
+
+    \param[in] img
+	Ignored, and kept for API compatibility.
 
-	rastersizeerror exception will be thrown if your rasinReal, rasinImg, and rasOut are not the same size as your input raster.
+    \param[out] rasInReal
+	(Optional) raster the real part of the spectrum of the filtered raster is written to, as by FFT_2D: the size of
+	this raster.  NULL, or with rasInImg NULL, for none.
+
+    \param[out] rasInImg
+	(Optional) raster the imaginary part of that spectrum is written to, as rasInReal.
+
+    \param[out] rasOut
+	This is the raster object the filtered data will be written to.  The original image will remain unchanged.
+
+    \returns
+	nothing
+
+    \par Exceptions
+	RasterSizeErrorException, DataTypeException
 
-	The FFT will perform a complex to complex transfer - the real part of the complex numbers will be data from the raster this 		function is called on, but the imaginary part will be set to all zeros.  Data is read line by line and 1D transforms are performed
-	row by row to real and imaginary buffer rasters, then column by column from the buffers to the output rasters.
-	A square with width hard set to 1/3 the input raster's size and data of all zero's is created in the center of the real and imaginary 		rasters using set(), and then this data is inversely transformed using the FFT once more.
+    \par Example
+	\code
+	ras->lowPassFilter(img, NULL, NULL, rasOut);
+	\endcode
 
-	The smaller the square width, the more accurate the final product is to the original image.  1/3 the input raster's size is about as 
-	big as the square can go before slice size exceptions are thrown.
+    \par Details
+	As frequencyFilter(rasOut, FrequencyFilter::lowPass(0.2)), which throws the exceptions for rasOut; FFT_2D throws them for
+	the spectrum rasters.  Writing the spectrum takes a forward transform of rasOut after the filter; pass NULL for both to
+	skip it.
     */
   void lowPassFilter(GeoStar::Image *img, Raster *rasInReal, Raster *rasInImg, Raster *rasOut);
 
@@ -1747,7 +2648,7 @@ namespace GeoStar {
     \see read, write, upsample, downsample, laplacianPyramid
 
     \param[in] img
-	The image within which you want to create your additional rasters.
+	The image within which you want to create your additional rasters.  NULL makes them InMemoryRasters.
 
     \param[in] n
 	The height of the pyramid, i.e. how many iterations and rasters you want to end up with.  Must be greater than zero.
@@ -1814,6 +2715,9 @@ namespace GeoStar {
 	This function iterates n times, each time creating a new raster 1/2 the size of the previous, calling downsample, and 
 	pushing this new raster back into the output vector.  This function will produce a pyramid of height n, where the bottom layer is the
 	original raster.  So if gaussianPyramid is called with n = 1, it will return the original raster and the raster downsampled once.
+
+	With img NULL, e.g. on a raster from load(), the whole pyramid is built in memory without any HDF5 I/O;
+	store the levels that are wanted afterwards (see InMemoryRaster::store).
     */
   std::vector<Raster *> gaussianPyramid(Image *img, int n);
 
@@ -1825,7 +2729,7 @@ namespace GeoStar {
     \see read, write, downsample, upsample, gaussianPyramid
 
     \param[in] img
-	The image within which you want to create your additional rasters.
+	The image within which you want to create your additional rasters.  NULL makes them InMemoryRasters.
 
     \param[in] n
 	The height of the pyramid, i.e. how many iterations and rasters you want to end up with.  Must be greater than zero.
@@ -1899,6 +2803,7 @@ namespace GeoStar {
 	This function iterates n times, each time creating a new raster twice the size of the previous, calling upsample, and 
 	pushing this new raster back into the output vector.  This function will produce a pyramid of height n, where the bottom layer is the
 	original raster.  So if laplacianPyramid is called with n = 1, it will return the original raster and the raster upsampled once.
+	With img NULL the levels are InMemoryRasters, as for gaussianPyramid.
 
 	Be careful of calling high values of n (> 5) in this function.  Upsampling tries to restore lost data by estimating with
 	neighboring pixel values, but the data is still lost when changing size.  Upsampling many times will create very blocky images,
@@ -2480,340 +3385,109 @@ int main() {
           \endcode
 
           \par Details
-          This function uses getFileName() to retrieve the raster's file, and gets the full file path in string form fo access the image name using substring operations. With both names, we can access an existing file and then access an existing image in that file.
+          The raster keeps shared handles to its file and image (see FileHandle), so the returned Image uses the
+          group that is already open: nothing is opened, read or written.  Delete the Image when done with it;
+          that does not close anything the raster uses.  An InMemoryRaster has no parent, and returns NULL.
           */
         GeoStar::Image * getParent();
 
-        /** \brief operator+ -- add two rasters
+        /** \brief create_sibling -- creates a raster like this one in the same image
 
-          Returns a raster pointer containing the sum of two rasters.
+          Returns a new raster with this raster's type and size, in the image this raster is in.
 
-          \see add
+          \see getParent, operator=
 
-          \param[in] r2
-            The raster to add to this raster. Must have the same dimensions as this.
+          \param[in] name
+            Name of the new raster.
 
           \returns
-            A GeoStar::Raster pointer which contains the sum of the two rasters.
+            The new raster.
 
           \par Exceptions
-            RasterSizeErrorException -- raised when the two rasters have different sizes
-
-          \par Example
-            Creates a 100x100 raster full of 1s, then makes ras2 point to the sum of that raster with itself.
-          \code
-          #include "geostar.hpp"
-          #include <vector>
-          int main() {
-          GeoStar::File *file = new GeoStar::File("arithmetic.h5","new");
-          GeoStar::Image *img = file->create_image("img");
-          GeoStar:: Raster *ras1 = img->create_raster("ras1", GeoStar::INT8U, 100, 100);
-
-          std::vector<uint8_t> data(100*100);
-          for(int j=0;j<100;++j) for(int i=0;i<100;++i) data[j*100+i]=1;
-          std::vector<long int> slice(4);
-          slice[0]=0; slice [1]=0;
-          slice[2]=100; slice[3]=100;
-          ras1->write(slice, data);
-
-          GeoStar::Raster * ras2 = *ras1 + *ras1;
-          }
-          \endcode
+            RasterExistsError -- a raster of that name already exists
 
           \par Details
-            This function uses getParent() to be able to make a new raster in "this" raster's Image. It then uses the add() function on that raster to store the summed rasters.
+            The sibling of an InMemoryRaster is a new InMemoryRaster, so expressions over rasters in memory stay
+            in memory.
           */
-        GeoStar::Raster * operator+(const GeoStar::Raster & r2);
-
-        /** \brief operator- -- subtract a raster from another
-
-          Returns a raster pointer containing the difference between this raster and r2.
-
-          \see subtract
-
-          \param[in] r2
-            The raster to subtract from this raster. Must have the same dimensions as this.
-
-          \returns
-            A GeoStar::Raster pointer which contains the difference between the two rasters.
-
-          \Par Exceptions
-            RasterSizeErrorException -- raised when the two rasters have different sizes
-
-            \Par Example
-              Creates a 100x100 raster full of 1s, then makes ras2 point to a raster of zeroes.
-            \code
-            #include "geostar.hpp"
-            #include <vector>
-            int main() {
-            GeoStar::File *file = new GeoStar::File("arithmetic.h5","new");
-            GeoStar::Image *img = file->create_image("img");
-            GeoStar:: Raster *ras1 = img->create_raster("ras1", GeoStar::INT8U, 100, 100);
-
-            std::vector<uint8_t> data(100*100);
-            for(int j=0;j<100;++j) for(int i=0;i<100;++i) data[j*100+i]=1;
-            std::vector<long int> slice(4);
-            slice[0]=0; slice [1]=0;
-            slice[2]=100; slice[3]=100;
-            ras1->write(slice, data);
-
-            GeoStar::Raster * ras2 = *ras1 - *ras1;
-            }
-            \endcode
-
-            \par Details
-              This function uses getParent() to be able to make a new raster in "this" raster's Image. It then uses the subtract() function on that raster to store the difference between the rasters.
-            */
-        GeoStar::Raster * operator-(const GeoStar::Raster & r2);
-
-        /** \brief operator* -- multiply a raster by another
-
-          Returns a raster pointer containing the product of this raster and r2.
-
-          \see multiply
-
-          \param[in] r2
-            The raster to multiply this raster with. Must have the same dimensions as this.
-
-          \returns
-            A GeoStar::Raster pointer which contains the product of the two rasters.
-
-          \Par Exceptions
-            RasterSizeErrorException -- raised when the two rasters have different sizes
-
-            \Par Example
-              Creates a 100x100 raster full of 2s, then makes ras2 point to a raster of 4s.
-            \code
-            #include "geostar.hpp"
-            #include <vector>
-            int main() {
-            GeoStar::File *file = new GeoStar::File("arithmetic.h5","new");
-            GeoStar::Image *img = file->create_image("img");
-            GeoStar:: Raster *ras1 = img->create_raster("ras1", GeoStar::INT8U, 100, 100);
-
-            std::vector<uint8_t> data(100*100);
-            for(int j=0;j<100;++j) for(int i=0;i<100;++i) data[j*100+i]=2;
-            std::vector<long int> slice(4);
-            slice[0]=0; slice [1]=0;
-            slice[2]=100; slice[3]=100;
-            ras1->write(slice, data);
-
-            GeoStar::Raster * ras2 = *ras1 * *ras1;
-            }
-            \endcode
-
-            \par Details
-              This function uses getParent() to be able to make a new raster in "this" raster's Image. It then uses the multiply() function on that raster to store the product of the rasters.
-            */
-        GeoStar::Raster * operator*(const GeoStar::Raster & r2);
-
-        /** \brief operator/ -- divide a raster by another
-
-          Returns a raster pointer containing the quotient of this raster and r2.
-
-          \see divide
-
-          \param[in] r2
-            The raster to divide this raster by. Must have the same dimensions as this.
-
-          \returns
-            A GeoStar::Raster pointer which contains the quotient of the two rasters.
-
-          \Par Exceptions
-            RasterSizeErrorException -- raised when the two rasters have different sizes
-
-            \Par Example
-              Creates a 100x100 raster full of 2s, then makes ras2 point to a raster of 1s, a raster divided by itself.
-            \code
-            #include "geostar.hpp"
-            #include <vector>
-            int main() {
-            GeoStar::File *file = new GeoStar::File("arithmetic.h5","new");
-            GeoStar::Image *img = file->create_image("img");
-            GeoStar:: Raster *ras1 = img->create_raster("ras1", GeoStar::INT8U, 100, 100);
-
-            std::vector<uint8_t> data(100*100);
-            for(int j=0;j<100;++j) for(int i=0;i<100;++i) data[j*100+i]=2;
-            std::vector<long int> slice(4);
-            slice[0]=0; slice [1]=0;
-            slice[2]=100; slice[3]=100;
-            ras1->write(slice, data);
-
-            GeoStar::Raster * ras2 = *ras1 / *ras1;
-            }
-            \endcode
+        GeoStar::Raster * create_sibling(const std::string & name) const;
 
-            \par Details
-              This function uses getParent() to be able to make a new raster in "this" raster's Image. It then uses the divide() function on that raster to store the quotient of the rasters.
-            */
-        GeoStar::Raster * operator/(const GeoStar::Raster & r2);
+        /** \brief operator= -- evaluates a raster expression into this raster
 
-        /** \brief operator+ -- add a constant to a raster
+          The arithmetic operators +, -, *, / on Rasters and numbers (see RasterExpr.hpp) do no work: they
+          return an expression, and assigning it to a Raster computes the whole expression in one pass over
+          the tiles of the raster, without writing any intermediate raster.
 
-          Returns a raster pointer containing the raster with a constant value added to each pixel
+          \see add, subtract, multiply, divide, RasterExpr
 
-          \see operator+
-
-          \param[in] val
-            The float value to add to each pixel in the raster.
-
-          \returns
-            A GeoStar::Raster pointer which contains the raster with a constant value added to each pixel
-
-          \Par Exceptions
-            None
-
-            \Par Example
-              This block of code intializes a raster where each pixel has a value of 2, then generates a new raster where each pixel of ras1 has 4 added to it.
-            \code
-            #include "geostar.hpp"
-            #include <vector>
-            int main() {
-            GeoStar::File *file = new GeoStar::File("arithmetic.h5","new");
-            GeoStar::Image *img = file->create_image("img");
-            GeoStar:: Raster *ras1 = img->create_raster("ras1", GeoStar::INT8U, 100, 100);
-
-            std::vector<uint8_t> data(100*100);
-            for(int j=0;j<100;++j) for(int i=0;i<100;++i) data[j*100+i]=2;
-            std::vector<long int> slice(4);
-            slice[0]=0; slice [1]=0;
-            slice[2]=100; slice[3]=100;
-            ras1->write(slice, data);
-
-            GeoStar::Raster * ras2 = *ras1 + 4;
-            }
-            \endcode
-
-            \par Details
-              This function uses getParent() to be able to make a new raster in "this" raster's Image. It then iterates through every pixel and adds the value to each.
-            */
-        GeoStar::Raster * operator+(const float & val);
-
-        /** \brief operator- -- subtract a constant from a raster
-
-          Returns a raster pointer containing the raster with a constant value subtracted from each pixel
-
-          \see operator-
-
-          \param[in] val
-            The float value to subtract from each pixel in the raster.
-
-          \returns
-            A GeoStar::Raster pointer which contains the raster with a constant value subtracted from each pixel.
-
-          \Par Exceptions
-            None
-
-            \Par Example
-              This block of code intializes a raster where each pixel has a value of 2, then generates a new raster where each pixel of ras1 has 1 subtracted from it.
-            \code
-            #include "geostar.hpp"
-            #include <vector>
-            int main() {
-            GeoStar::File *file = new GeoStar::File("arithmetic.h5","new");
-            GeoStar::Image *img = file->create_image("img");
-            GeoStar:: Raster *ras1 = img->create_raster("ras1", GeoStar::INT8U, 100, 100);
-
-            std::vector<uint8_t> data(100*100);
-            for(int j=0;j<100;++j) for(int i=0;i<100;++i) data[j*100+i]=2;
-            std::vector<long int> slice(4);
-            slice[0]=0; slice [1]=0;
-            slice[2]=100; slice[3]=100;
-            ras1->write(slice, data);
-
-            GeoStar::Raster * ras2 = *ras1 - 1;
-            }
-            \endcode
-
-            \par Details
-              This function uses getParent() to be able to make a new raster in "this" raster's Image. It then iterates through every pixel and subtracts the value from each.
-            */
-        GeoStar::Raster * operator-(const float & val);
-
-        /** \brief operator* -- multiply a raster by a constant
-
-          Returns a raster pointer containing the raster with a constant value multiplied by each pixel.
-
-          \see operator*
-
-          \param[in] val
-            The float value to multiply each pixel by in the raster.
+          \param[in] expr
+            An expression of rasters the size of this one, and numbers.
 
           \returns
-            A GeoStar::Raster pointer which contains the raster with a constant value multiplied by each pixel.
-
-          \Par Exceptions
-            None
-
-            \Par Example
-              This block of code intializes a raster where each pixel has a value of 2, then generates a new raster where each pixel of ras1 has 2 multiplied by it.
-            \code
-            #include "geostar.hpp"
-            #include <vector>
-            int main() {
-            GeoStar::File *file = new GeoStar::File("arithmetic.h5","new");
-            GeoStar::Image *img = file->create_image("img");
-            GeoStar:: Raster *ras1 = img->create_raster("ras1", GeoStar::INT8U, 100, 100);
-
-            std::vector<uint8_t> data(100*100);
-            for(int j=0;j<100;++j) for(int i=0;i<100;++i) data[j*100+i]=2;
-            std::vector<long int> slice(4);
-            slice[0]=0; slice [1]=0;
-            slice[2]=100; slice[3]=100;
-            ras1->write(slice, data);
+            This raster.
 
-            GeoStar::Raster * ras2 = *ras1*2;
-            }
-            \endcode
-
-            \par Details
-              This function uses getParent() to be able to make a new raster in "this" raster's Image. It then iterates through every pixel and multiplies the value by each.
-            */
-        GeoStar::Raster * operator*(const float & val);
+          \par Exceptions
+            RasterSizeErrorException -- the rasters of the expression are not the size of this raster
+            GeoStar::DivideByZeroException -- the expression divides by the constant 0
 
-        /** \brief operator/ -- divide a raster by a constant
+          \par Example
+            Averages two rasters and removes an offset:
+          \code
+          #include "geostar.hpp"
+          int main() {
+          GeoStar::File *file = new GeoStar::File("arithmetic.h5","existing");
+          GeoStar::Image *img = file->open_image("img");
+          GeoStar::Raster *ras1 = img->open_raster("ras1");
+          GeoStar::Raster *ras2 = img->open_raster("ras2");
+          GeoStar::Raster *out = img->create_raster("out", GeoStar::REAL32, ras1->get_nx(), ras1->get_ny());
 
-          Returns a raster pointer containing the raster with each pixel divided by a constant value
+          *out = (*ras1 + *ras2) * 0.5f - 10;
+          }
+          \endcode
 
-          \see operator/
+          \par Details
+            Pixels are computed in float, as add, subtract, multiply and divide do; a raster divided by a raster
+            gives 255 where the divisor is 0.  Every raster of the expression is read once per tile (a raster
+            used twice is read twice), and the result is converted to the type of this raster when written.
+            With set_threads on this raster, the tiles are computed on that many threads, each with its own copy
+            of the expression, while the rasters are read and written on the shared I/O thread.
+
+            Code written for the earlier operators, which returned a new raster, still compiles:
+            GeoStar::Raster *ras3 = *ras1 + *ras2; evaluates the expression once into a new raster named as
+            before ("ras1_PLUS_ras2"), of the type of the leftmost raster.  Unlike before, a chain such as
+            *ras1 + *ras2 + *ras3 creates only the final raster, and keeps float precision in between.
+          */
+        template<typename E>
+        Raster & operator=(const RasterExpr<E> & expr);
+  }; // end class: Raster
 
-          \param[in] val
-            The float value to divide each pixel by in the raster.
+  // HDF5 memory types of the supported buffer types, defined in Raster.cpp.
+  // Declared here so no other file instantiates the generic getHdf5Type.
+  template <> H5::DataType Raster::getHdf5Type<uint8_t>();
+  template <> H5::DataType Raster::getHdf5Type<int8_t>();
+  template <> H5::DataType Raster::getHdf5Type<uint16_t>();
+  template <> H5::DataType Raster::getHdf5Type<int16_t>();
+  template <> H5::DataType Raster::getHdf5Type<uint32_t>();
+  template <> H5::DataType Raster::getHdf5Type<int32_t>();
+  template <> H5::DataType Raster::getHdf5Type<uint64_t>();
+  template <> H5::DataType Raster::getHdf5Type<int64_t>();
+  template <> H5::DataType Raster::getHdf5Type<float>();
+  template <> H5::DataType Raster::getHdf5Type<double>();
+  template <> H5::DataType Raster::getHdf5Type<std::complex<float> >();
+  template <> H5::DataType Raster::getHdf5Type<std::complex<double> >();
 
-          \returns
-            A GeoStar::Raster pointer which contains the raster with each pixel divided by a constant value.
+}// end namespace GeoStar
 
-          \Par Exceptions
-            GeoStar::DivideByZeroException -- occurs when you divide by zero.
+// RasterReader and RasterWriter, used by for_each_block:
+#include "RasterStream.hpp"
 
-            \Par Example
-              This block of code intializes a raster where each pixel has a value of 2, then generates a new raster where each pixel of ras1 is divided by 2.
-            \code
-            #include "geostar.hpp"
-            #include <vector>
-            int main() {
-            GeoStar::File *file = new GeoStar::File("arithmetic.h5","new");
-            GeoStar::Image *img = file->create_image("img");
-            GeoStar:: Raster *ras1 = img->create_raster("ras1", GeoStar::INT8U, 100, 100);
-
-            std::vector<uint8_t> data(100*100);
-            for(int j=0;j<100;++j) for(int i=0;i<100;++i) data[j*100+i]=2;
-            std::vector<long int> slice(4);
-            slice[0]=0; slice [1]=0;
-            slice[2]=100; slice[3]=100;
-            ras1->write(slice, data);
-
-            GeoStar::Raster * ras2 = *ras1/2;
-            }
-            \endcode
-
-            \par Details
-              This function uses getParent() to be able to make a new raster in "this" raster's Image. It then iterates through every pixel and divides the value into each.
-            */
-        GeoStar::Raster * operator/(const float & val);
-  }; // end class: Raster
+// for_each_block on several threads, see set_threads:
+#include "RasterParallel.hpp"
 
-}// end namespace GeoStar
+// kernels used by map_pixels and for_each_native_block:
+#include "RasterKernels.hpp"
 
+// expression nodes returned by the arithmetic operators, evaluated by operator=:
+#include "RasterExpr.hpp"
 
 #endif //RASTER_HPP_
@@ -0,0 +1,265 @@
+// RasterExpr.hpp
+//
+// lazy raster arithmetic: the Raster operators +, -, *, / build an
+// expression tree, and nothing is read or written until the tree is
+// assigned to a Raster, which evaluates it in one pass over the tiles,
+// on the threads of that Raster (see Raster::set_threads).
+//
+//----------------------------------------
+#ifndef RASTEREXPR_HPP_
+#define RASTEREXPR_HPP_
+
+#include <string>
+#include <vector>
+#include <type_traits>
+
+#include "Raster.hpp"
+#include "RasterSlice.hpp"
+#include "RasterParallel.hpp"
+#include "Exceptions.hpp"
+
+
+namespace GeoStar {
+
+  /** \brief RasterExpr -- base of the lazy raster expression nodes
+
+    Every node type E derives from RasterExpr<E> and provides:
+
+	load(slice)   reads the pixels of slice from every raster under the node
+	at(i)         value of pixel i of the last slice loaded, computed in float
+	nx(), ny()    size of the rasters under the node, -1 for a constant
+	first()       leftmost raster under the node, or NULL
+	name()        name of the expression, as the eager operators used to name their output
+
+    Nodes hold their children by value, so an expression built from temporaries stays valid.
+
+    \see Raster::operator=, operator+, operator-, operator*, operator/
+
+    \Par Example
+	One pass over a, b and c, no intermediate datasets:
+	\code
+	*out = (*a + *b) * 0.5f - *c;
+	\endcode
+  */
+  template<typename E>
+  struct RasterExpr {
+    const E &self() const { return static_cast<const E &>(*this); }
+  }; // end: RasterExpr
+
+
+  // a raster in an expression: holds the pixels of the slice being evaluated
+  struct RasterTerm : public RasterExpr<RasterTerm> {
+    const Raster *ras;
+    mutable std::vector<float> data;
+
+    explicit RasterTerm(const Raster &raster) : ras(&raster) {}
+
+    void load(const RasterSlice &slice) const {
+      if(data.size() < (size_t)slice.size()) data.resize(slice.size());
+      if(slice.size() > 0) ras->read(slice, &data[0], data.size());
+    }// end: load
+
+    float at(const long int &i) const { return data[i]; }
+    long int nx() const { return ras->get_nx(); }
+    long int ny() const { return ras->get_ny(); }
+    const Raster *first() const { return ras; }
+    std::string name() const { return ras->get_name(); }
+  }; // end: RasterTerm
+
+
+  // a constant in an expression
+  struct RasterScalar : public RasterExpr<RasterScalar> {
+    float value;
+
+    explicit RasterScalar(const float &v) : value(v) {}
+
+    void load(const RasterSlice &) const {}
+    float at(const long int &) const { return value; }
+    long int nx() const { return -1; }
+    long int ny() const { return -1; }
+    const Raster *first() const { return NULL; }
+    std::string name() const { return "val"; }
+  }; // end: RasterScalar
+
+
+  // pixel operations, same results as add, subtract, multiply and divide:
+  struct RasterAddOp {
+    static const char *name() { return "_PLUS_"; }
+    float operator()(const float a, const float b) const { return a + b; }
+  };
+  struct RasterSubtractOp {
+    static const char *name() { return "_MINUS_"; }
+    float operator()(const float a, const float b) const { return a - b; }
+  };
+  struct RasterMultiplyOp {
+    static const char *name() { return "_TIMES_"; }
+    float operator()(const float a, const float b) const { return a * b; }
+  };
+  struct RasterDivideOp {
+    static const char *name() { return "_DIVIDEDBY_"; }
+    float operator()(const float a, const float b) const {
+      if(b == 0) return 255; // divide by zero goes to max value
+      return a / b;
+    }
+  };
+
+
+  // op(left, right), pixel by pixel
+  template<typename L, typename R, typename Op>
+  struct RasterBinary : public RasterExpr<RasterBinary<L, R, Op> > {
+    L left;
+    R right;
+    Op op;
+
+    RasterBinary(const L &l, const R &r) : left(l), right(r) {
+      RasterSizeErrorException RasterSizeError;
+      if(l.nx() >= 0 && r.nx() >= 0 && (l.nx() != r.nx() || l.ny() != r.ny())) throw RasterSizeError;
+    }// end: RasterBinary
+
+    void load(const RasterSlice &slice) const {
+      left.load(slice);
+      right.load(slice);
+    }// end: load
+
+    float at(const long int &i) const { return op(left.at(i), right.at(i)); }
+    long int nx() const { return (left.nx() >= 0) ? left.nx() : right.nx(); }
+    long int ny() const { return (left.ny() >= 0) ? left.ny() : right.ny(); }
+    const Raster *first() const { return (left.first() != NULL) ? left.first() : right.first(); }
+    std::string name() const { return left.name() + Op::name() + right.name(); }
+
+    /** \brief conversion to Raster* -- evaluates the expression into a new raster
+
+      Kept so code written for the eager operators, Raster *r = *a + *b, still works: the expression
+	is evaluated once, into a new raster in the image of its leftmost raster, named as the eager
+	operators named theirs (e.g. "a_PLUS_b") and of the same type as that raster.
+
+      \Par Exceptions
+	RasterExistsError if a raster of that name already exists.
+    */
+    operator Raster *() const {
+      Raster *result = first()->create_sibling(name());
+      *result = *this;
+      return result;
+    }// end: operator Raster*
+  }; // end: RasterBinary
+
+
+  // expression node type of an operand: Raster (or InMemoryRaster) -> RasterTerm, number -> RasterScalar,
+  // node -> itself
+  template<typename A, typename Enable = void>
+  struct RasterOperand {
+    static const bool value = false;
+    static const bool is_raster = false;
+  };
+
+  template<typename A>
+  struct RasterOperand<A, typename std::enable_if<std::is_base_of<Raster, A>::value>::type> {
+    static const bool value = true;
+    static const bool is_raster = true;
+    typedef RasterTerm type;
+    static type make(const Raster &a) { return RasterTerm(a); }
+  };
+
+  template<typename A>
+  struct RasterOperand<A, typename std::enable_if<std::is_arithmetic<A>::value>::type> {
+    static const bool value = true;
+    static const bool is_raster = false;
+    typedef RasterScalar type;
+    static type make(const A &a) { return RasterScalar(static_cast<float>(a)); }
+  };
+
+  template<typename A>
+  struct RasterOperand<A, typename std::enable_if<std::is_base_of<RasterExpr<A>, A>::value>::type> {
+    static const bool value = true;
+    static const bool is_raster = true;
+    typedef A type;
+    static const type &make(const A &a) { return a; }
+  };
+
+  // node type of a op b; only defined when at least one side is a raster or an expression,
+  // so the operators below drop out of overload resolution for anything else
+  template<typename A, typename B, typename Op,
+           bool Enable = RasterOperand<A>::value && RasterOperand<B>::value &&
+                         (RasterOperand<A>::is_raster || RasterOperand<B>::is_raster)>
+  struct RasterBinaryOf {};
+
+  template<typename A, typename B, typename Op>
+  struct RasterBinaryOf<A, B, Op, true> {
+    typedef RasterBinary<typename RasterOperand<A>::type, typename RasterOperand<B>::type, Op> type;
+  };
+
+
+  /** \brief operator+, operator-, operator*, operator/ -- lazy raster arithmetic
+
+    Each operand is a Raster, an expression or a number.  The result is an expression; assigning it to a
+	Raster evaluates it, and converting it to Raster* evaluates it into a new raster (see RasterBinary).
+
+    \par Exceptions
+	RasterSizeErrorException if two rasters of the expression differ in size,
+	DivideByZeroException when dividing by the constant 0.
+
+    \par Details
+	Pixels are computed in float, as add, subtract, multiply and divide do, and a raster divided by a
+	raster gives 255 where the divisor is 0.  A chain of operators keeps float precision between the
+	steps, and is only converted to the output type at the end.
+  */
+  template<typename A, typename B>
+  typename RasterBinaryOf<A, B, RasterAddOp>::type
+  operator+(const A &a, const B &b) {
+    return typename RasterBinaryOf<A, B, RasterAddOp>::type(RasterOperand<A>::make(a), RasterOperand<B>::make(b));
+  }// end: operator+
+
+  template<typename A, typename B>
+  typename RasterBinaryOf<A, B, RasterSubtractOp>::type
+  operator-(const A &a, const B &b) {
+    return typename RasterBinaryOf<A, B, RasterSubtractOp>::type(RasterOperand<A>::make(a), RasterOperand<B>::make(b));
+  }// end: operator-
+
+  template<typename A, typename B>
+  typename RasterBinaryOf<A, B, RasterMultiplyOp>::type
+  operator*(const A &a, const B &b) {
+    return typename RasterBinaryOf<A, B, RasterMultiplyOp>::type(RasterOperand<A>::make(a), RasterOperand<B>::make(b));
+  }// end: operator*
+
+  template<typename A, typename B>
+  typename RasterBinaryOf<A, B, RasterDivideOp>::type
+  operator/(const A &a, const B &b) {
+    DivideByZeroException DivideByZero;
+    if(!RasterOperand<B>::is_raster && RasterOperand<B>::make(b).at(0) == 0) throw DivideByZero;
+    return typename RasterBinaryOf<A, B, RasterDivideOp>::type(RasterOperand<A>::make(a), RasterOperand<B>::make(b));
+  }// end: operator/
+
+
+
+  template<typename E>
+  Raster &Raster::operator=(const RasterExpr<E> &expr) {
+    RasterSizeErrorException RasterSizeError;
+    const E &e = expr.self();
+    if(e.nx() != get_nx() || e.ny() != get_ny()) throw RasterSizeError;
+
+    long int shape[2];
+    default_block_shape(shape);
+    if(threads > 1) {
+      parallel_evaluate(e, this, shape, threads);
+      return *this;
+    }// endif
+
+    std::vector<float> out(shape[0]*shape[1]);
+
+    for(long int y=0; y<get_ny(); y+=shape[1]) {
+      for(long int x=0; x<get_nx(); x+=shape[0]) {
+        const RasterSlice slice(x, y, std::min(shape[0], get_nx()-x), std::min(shape[1], get_ny()-y));
+        e.load(slice);
+        const long int npixels = slice.size();
+        for(long int i=0; i<npixels; ++i) out[i] = e.at(i);
+        write(slice, &out[0], out.size());
+      }// endfor: x
+    }// endfor: y
+
+    return *this;
+  }// end: operator=
+
+}// end namespace GeoStar
+
+
+#endif // RASTEREXPR_HPP_
@@ -0,0 +1,157 @@
+// RasterKernels.hpp
+//
+// functors that run Raster operations on the raster's own pixel type;
+// see Raster::map_pixels and Raster::for_each_native_block.
+//
+//----------------------------------------
+#ifndef RASTERKERNELS_HPP_
+#define RASTERKERNELS_HPP_
+
+#include <vector>
+
+#include "Raster.hpp"
+#include "RasterType.hpp"
+
+
+namespace GeoStar {
+
+  // pixel by pixel: data = op(data), computed in C, stored as T
+  template<typename C, typename Function>
+  struct MapPixelsKernel {
+    const Raster *ras;
+    Raster *ras_out;
+    Function op;
+
+    MapPixelsKernel(const Raster *source, Raster *destination, const Function &pixelOp)
+      : ras(source), ras_out(destination), op(pixelOp) {}
+
+    template<typename T>
+    void operator()(const T &) {
+      Function &f = op;
+      ras->for_each_block<T>(NULL, ras_out,
+        [&f](const std::vector<long int> &slice, std::vector<T> &data) {
+          const long int npixels = slice[2]*slice[3];
+          for(long int pixel=0; pixel<npixels; ++pixel) {
+            data[pixel] = saturate_cast<T>(f(static_cast<C>(data[pixel])));
+          }// endfor: pixel
+        });
+    }// end: operator()
+  }; // end: MapPixelsKernel
+
+
+  // pixel by pixel over two rasters: a = op(a, b), computed in C, stored as T
+  template<typename C, typename Function>
+  struct MapPixels2Kernel {
+    const Raster *ras;
+    const Raster *r2;
+    Raster *ras_out;
+    Function op;
+
+    MapPixels2Kernel(const Raster *source, const Raster *source2, Raster *destination, const Function &pixelOp)
+      : ras(source), r2(source2), ras_out(destination), op(pixelOp) {}
+
+    template<typename T>
+    void operator()(const T &) {
+      Function &f = op;
+      ras->for_each_block<T>(NULL, r2, ras_out,
+        [&f](const std::vector<long int> &slice, std::vector<T> &dataA, std::vector<T> &dataB) {
+          const long int npixels = slice[2]*slice[3];
+          for(long int pixel=0; pixel<npixels; ++pixel) {
+            dataA[pixel] = saturate_cast<T>(f(static_cast<C>(dataA[pixel]), static_cast<C>(dataB[pixel])));
+          }// endfor: pixel
+        });
+    }// end: operator()
+  }; // end: MapPixels2Kernel
+
+
+  // whole blocks: read as T, handed to fn as C, stored back as T
+  template<typename C, typename Function>
+  struct NativeBlocksKernel {
+    const Raster *ras;
+    const long int *window;
+    const long int *blockShape;
+    Raster *ras_out;
+    Function fn;
+
+    NativeBlocksKernel(const Raster *source, const long int *walkWindow, const long int *shape,
+                       Raster *destination, const Function &blockFn)
+      : ras(source), window(walkWindow), blockShape(shape), ras_out(destination), fn(blockFn) {}
+
+    // the raster is already of the compute type: nothing to convert
+    void operator()(const C &) {
+      ras->for_each_block<C>(window, blockShape, ras_out, fn);
+    }// end: operator()
+
+    template<typename T>
+    void operator()(const T &) {
+      Function &f = fn;
+      // each copy of the block function (one per thread, see Raster::set_threads) has its own scratch:
+      std::vector<C> scratch;
+      ras->for_each_block<T>(window, blockShape, ras_out,
+        [&f, scratch](const std::vector<long int> &slice, std::vector<T> &data) mutable {
+          scratch.assign(data.begin(), data.end());
+          f(slice, scratch);
+          const long int npixels = slice[2]*slice[3];
+          for(long int pixel=0; pixel<npixels; ++pixel) data[pixel] = saturate_cast<T>(scratch[pixel]);
+        });
+    }// end: operator()
+  }; // end: NativeBlocksKernel
+
+
+
+  // the pixel and region functions of the Raster operations, shared with RasterPipeline so a
+  // pipeline computes exactly what the operations compute:
+
+  // thresh: pixels under value become 0
+  struct ThreshPixel {
+    double value;
+    explicit ThreshPixel(const double &v) : value(v) {}
+    float operator()(const float pixel) const { return (pixel < value) ? 0 : pixel; }
+  }; // end: ThreshPixel
+
+  // scale: mult*(pixel-offset), truncated to an integer and clipped at 0
+  struct ScalePixel {
+    double offset;
+    double mult;
+    ScalePixel(const double &o, const double &m) : offset(o), mult(m) {}
+    float operator()(const float pixel) const {
+      int i = mult*(pixel-offset);
+      if (i<0)   i=0;
+      return i;
+    }
+  }; // end: ScalePixel
+
+  // gradientMask: the 3x3 blur kernel applied to the pixel
+  struct GradientMaskPixel {
+    double operator()(const double pixel) const;
+  }; // end: GradientMaskPixel
+
+  // downsample: the 5x5 gaussian kernel applied to the pixel
+  struct DownsampleBlurPixel {
+    double operator()(const double pixel) const;
+  }; // end: DownsampleBlurPixel
+
+  // harmonicMean, midpointFilter, rangeFilter: every n x n region of a block whose sizes are multiples
+  // of n is replaced by one value computed from the region
+  struct HarmonicMeanRegions {
+    int n;
+    explicit HarmonicMeanRegions(const int &size) : n(size) {}
+    void operator()(const std::vector<long int> &slice, std::vector<double> &data) const;
+  }; // end: HarmonicMeanRegions
+
+  struct MidpointRegions {
+    int n;
+    explicit MidpointRegions(const int &size) : n(size) {}
+    void operator()(const std::vector<long int> &slice, std::vector<double> &data) const;
+  }; // end: MidpointRegions
+
+  struct RangeRegions {
+    int n;
+    explicit RangeRegions(const int &size) : n(size) {}
+    void operator()(const std::vector<long int> &slice, std::vector<double> &data) const;
+  }; // end: RangeRegions
+
+}// end namespace GeoStar
+
+
+#endif // RASTERKERNELS_HPP_
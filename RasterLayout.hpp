@@ -0,0 +1,64 @@
+// RasterLayout.hpp
+//
+// how the pixels of a raster are laid out in the HDF5 file
+//
+//----------------------------------------
+#ifndef RASTERLAYOUT_HPP_
+#define RASTERLAYOUT_HPP_
+
+#include <cstddef>
+
+namespace GeoStar {
+
+  // size of the HDF5 chunk cache GeoStar files are opened with.
+  // The automatic chunk sizes below are picked so that a whole
+  // row (or column) of chunks of a large raster fits in it.
+  const size_t RASTER_CHUNK_CACHE_BYTES = 32*1024*1024;
+
+  // number of hash slots of that chunk cache: a prime, as HDF5 advises, sized for the chunks it holds
+  const size_t RASTER_CHUNK_CACHE_SLOTS = 12421;
+
+  // number of chunks of a row of chunks the cache should hold:
+  // the automatic chunk size is RASTER_CHUNK_CACHE_BYTES / RASTER_CHUNKS_PER_CACHE or less.
+  const size_t RASTER_CHUNKS_PER_CACHE = 64;
+
+  enum RasterLayoutType {
+
+    CONTIGUOUS,   // one block of rows, as a plain 2D array
+    ROW_CHUNKED,  // chunks of "size" whole rows
+    TILED         // square chunks of "size" x "size" pixels
+
+  }; // end: RasterLayoutType
+
+
+  // compression of chunked rasters; see compression.hpp.
+  enum RasterCompression {
+
+    COMPRESS_NONE,
+    COMPRESS_DEFLATE,  // shuffle + zlib deflate, always available
+    COMPRESS_LZ4,      // shuffle + LZ4 HDF5 plugin
+    COMPRESS_ZSTD,     // shuffle + Zstandard HDF5 plugin
+    COMPRESS_AUTO      // measure the available codecs on the data, pick the fastest overall
+
+  }; // end: RasterCompression
+
+
+  // layout descriptor passed to the Raster constructor and Image::create_raster.
+  // size = 0 lets the chunk size be picked to suit the file's chunk cache.
+  // level = 0 uses the codec's default compression level.
+  struct RasterLayout {
+    RasterLayoutType type;
+    long int size;
+    RasterCompression compression;
+    int level;
+
+    RasterLayout() : type(TILED), size(0), compression(COMPRESS_NONE), level(0) {}
+    RasterLayout(const RasterLayoutType &layoutType, const long int &chunkSize=0,
+                 const RasterCompression &codec=COMPRESS_NONE, const int &codecLevel=0)
+      : type(layoutType), size(chunkSize), compression(codec), level(codecLevel) {}
+  }; // end: RasterLayout
+
+}// end namespace GeoStar
+
+
+#endif // RASTERLAYOUT_HPP_
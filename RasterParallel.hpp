@@ -0,0 +1,147 @@
+// RasterParallel.hpp
+//
+// for_each_block, and the evaluation of raster expressions, across threads:
+// the tiles of a walk are processed on TileScheduler::shared(), while every
+// read and write of a tile goes through the shared I/O thread, one HDF5
+// call at a time.
+//
+//----------------------------------------
+#ifndef RASTERPARALLEL_HPP_
+#define RASTERPARALLEL_HPP_
+
+#include <vector>
+#include <algorithm>
+
+#include "Raster.hpp"
+#include "RasterSlice.hpp"
+#include "IOThread.hpp"
+#include "TileScheduler.hpp"
+
+
+namespace GeoStar {
+
+  // the blocks of a walk over window, numbered row of blocks by row of blocks
+  struct TileGrid {
+    long int window[4];
+    long int shape[2];
+    long int across;
+    long int down;
+
+    TileGrid(const long int *walkWindow, const long int *blockShape) {
+      for(int i=0; i<4; ++i) window[i] = walkWindow[i];
+      shape[0] = blockShape[0];
+      shape[1] = blockShape[1];
+      across = (window[2] > 0) ? (window[2] + shape[0] - 1) / shape[0] : 0;
+      down = (window[3] > 0) ? (window[3] + shape[1] - 1) / shape[1] : 0;
+    }
+
+    long int size() const { return across * down; }
+
+    // slice: x0, y0, dx, dy of block t
+    void slice(const long int &t, std::vector<long int> &s) const {
+      s.resize(4);
+      s[0] = window[0] + (t % across) * shape[0];
+      s[1] = window[1] + (t / across) * shape[1];
+      s[2] = std::min(shape[0], window[0]+window[2]-s[0]);
+      s[3] = std::min(shape[1], window[1]+window[3]-s[1]);
+    }
+  }; // end: TileGrid
+
+
+  // for_each_block(window, blockShape, ras_out, fn) on nthreads threads.  Each thread has its own
+  // copy of fn and its own buffer; the blocks are read and written on IOThread::shared().
+  template<typename T, typename Function>
+  void parallel_for_each_block(const Raster *ras, const long int *window, const long int *blockShape,
+                               Raster *ras_out, const Function &fn, const unsigned &nthreads) {
+    const TileGrid grid(window, blockShape);
+    const unsigned n = std::min((long int)nthreads, std::max(grid.size(), 1L));
+    const long int npixels = blockShape[0]*blockShape[1];
+
+    std::vector<Function> fns(n, fn);
+    std::vector<std::vector<T> > buffers(n);
+    IOThread &io = IOThread::shared();
+
+    TileScheduler::shared().run(grid.size(),
+      [&](long int t, unsigned worker) {
+        std::vector<long int> slice;
+        grid.slice(t, slice);
+        const RasterSlice area(slice);
+        std::vector<T> &data = buffers[worker];
+        data.resize(npixels);
+
+        io.submit([&]() { ras->read(area, data.data(), data.size()); }).get();
+        fns[worker](slice, data);
+        io.submit([&]() { ras_out->write(area, data.data(), data.size()); }).get();
+      }, n);
+  }// end: parallel_for_each_block
+
+
+  // for_each_block(blockShape, r2, ras_out, fn) on nthreads threads, as above
+  template<typename T, typename Function>
+  void parallel_for_each_block(const Raster *ras, const Raster *r2, const long int *blockShape,
+                               Raster *ras_out, const Function &fn, const unsigned &nthreads) {
+    const long int window[4] = {0, 0, ras->get_nx(), ras->get_ny()};
+    const TileGrid grid(window, blockShape);
+    const unsigned n = std::min((long int)nthreads, std::max(grid.size(), 1L));
+    const long int npixels = blockShape[0]*blockShape[1];
+
+    std::vector<Function> fns(n, fn);
+    std::vector<std::vector<T> > buffersA(n);
+    std::vector<std::vector<T> > buffersB(n);
+    IOThread &io = IOThread::shared();
+
+    TileScheduler::shared().run(grid.size(),
+      [&](long int t, unsigned worker) {
+        std::vector<long int> slice;
+        grid.slice(t, slice);
+        const RasterSlice area(slice);
+        std::vector<T> &dataA = buffersA[worker];
+        std::vector<T> &dataB = buffersB[worker];
+        dataA.resize(npixels);
+        dataB.resize(npixels);
+
+        io.submit([&]() {
+            ras->read(area, dataA.data(), dataA.size());
+            r2->read(area, dataB.data(), dataB.size());
+          }).get();
+        fns[worker](slice, dataA, dataB);
+        io.submit([&]() { ras_out->write(area, dataA.data(), dataA.size()); }).get();
+      }, n);
+  }// end: parallel_for_each_block
+
+
+
+  // the pixels of the expression node e (see RasterExpr) written to ras_out in blocks of blockShape, on nthreads
+  // threads.  Each thread has its own copy of e, whose terms hold the pixels of its block, and its own buffer;
+  // the terms are read and the blocks written on IOThread::shared().
+  template<typename E>
+  void parallel_evaluate(const E &e, Raster *ras_out, const long int *blockShape, const unsigned &nthreads) {
+    const long int window[4] = {0, 0, ras_out->get_nx(), ras_out->get_ny()};
+    const TileGrid grid(window, blockShape);
+    const unsigned n = std::min((long int)nthreads, std::max(grid.size(), 1L));
+    const long int npixels = blockShape[0]*blockShape[1];
+
+    std::vector<E> exprs(n, e);
+    std::vector<std::vector<float> > buffers(n);
+    IOThread &io = IOThread::shared();
+
+    TileScheduler::shared().run(grid.size(),
+      [&](long int t, unsigned worker) {
+        std::vector<long int> slice;
+        grid.slice(t, slice);
+        const RasterSlice area(slice);
+        const E &expr = exprs[worker];
+        std::vector<float> &out = buffers[worker];
+        out.resize(npixels);
+
+        io.submit([&]() { expr.load(area); }).get();
+        const long int size = area.size();
+        for(long int i=0; i<size; ++i) out[i] = expr.at(i);
+        io.submit([&]() { ras_out->write(area, out.data(), out.size()); }).get();
+      }, n);
+  }// end: parallel_evaluate
+
+}// end namespace GeoStar
+
+
+#endif // RASTERPARALLEL_HPP_
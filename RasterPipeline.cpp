@@ -0,0 +1,650 @@
+// RasterPipeline.cpp
+//
+// lazy chains of Raster operations, planned and run tile by tile in one
+// pass.
+//
+//-------------------------------------
+
+#include <string>
+#include <sstream>
+#include <vector>
+#include <map>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <thread>
+
+#include "RasterPipeline.hpp"
+#include "RasterKernels.hpp"
+#include "IOThread.hpp"
+#include "TileScheduler.hpp"
+
+
+namespace GeoStar {
+
+  // pixel by pixel with one input, fused into runs:
+  static bool is_pixel_op(const PipelineOpCode &code) {
+    return code == PIPELINE_MAP || code == PIPELINE_THRESH || code == PIPELINE_SCALE
+      || code == PIPELINE_GRADIENT_MASK;
+  }// end: is_pixel_op
+
+  static bool is_binary_op(const PipelineOpCode &code) {
+    return code == PIPELINE_ADD || code == PIPELINE_SUBTRACT || code == PIPELINE_MULTIPLY
+      || code == PIPELINE_DIVIDE;
+  }// end: is_binary_op
+
+  static bool is_region_op(const PipelineOpCode &code) {
+    return code == PIPELINE_HARMONIC_MEAN || code == PIPELINE_MIDPOINT || code == PIPELINE_RANGE;
+  }// end: is_region_op
+
+  static const char *op_name(const PipelineOpCode &code) {
+    switch(code) {
+    case PIPELINE_SOURCE:        return "read";
+    case PIPELINE_MAP:           return "map";
+    case PIPELINE_THRESH:        return "thresh";
+    case PIPELINE_SCALE:         return "scale";
+    case PIPELINE_GRADIENT_MASK: return "gradientMask";
+    case PIPELINE_ADD:           return "add";
+    case PIPELINE_SUBTRACT:      return "subtract";
+    case PIPELINE_MULTIPLY:      return "multiply";
+    case PIPELINE_DIVIDE:        return "divide";
+    case PIPELINE_CONVOLVE:      return "convolve";
+    case PIPELINE_DOWNSAMPLE:    return "downsample";
+    case PIPELINE_HARMONIC_MEAN: return "harmonicMean";
+    case PIPELINE_MIDPOINT:      return "midpointFilter";
+    case PIPELINE_RANGE:         return "rangeFilter";
+    }// endswitch
+    return "?";
+  }// end: op_name
+
+  static bool is_empty(const RasterSlice &r) {
+    return r.dx < 1 || r.dy < 1;
+  }// end: is_empty
+
+  static bool same_rect(const RasterSlice &a, const RasterSlice &b) {
+    return a.x0 == b.x0 && a.y0 == b.y0 && a.dx == b.dx && a.dy == b.dy;
+  }// end: same_rect
+
+  // the smallest rectangle holding a and b
+  static RasterSlice unite(const RasterSlice &a, const RasterSlice &b) {
+    if(is_empty(a)) return b;
+    if(is_empty(b)) return a;
+    const long int x0 = std::min(a.x0, b.x0);
+    const long int y0 = std::min(a.y0, b.y0);
+    const long int x1 = std::max(a.x0 + a.dx, b.x0 + b.dx);
+    const long int y1 = std::max(a.y0 + a.dy, b.y0 + b.dy);
+    return RasterSlice(x0, y0, x1 - x0, y1 - y0);
+  }// end: unite
+
+  // the part of r inside [0, nx) x [0, ny)
+  static RasterSlice clip(const RasterSlice &r, const long int &nx, const long int &ny) {
+    const long int x0 = std::max(r.x0, 0L);
+    const long int y0 = std::max(r.y0, 0L);
+    const long int x1 = std::min(r.x0 + r.dx, nx);
+    const long int y1 = std::min(r.y0 + r.dy, ny);
+    if(x1 <= x0 || y1 <= y0) return RasterSlice();
+    return RasterSlice(x0, y0, x1 - x0, y1 - y0);
+  }// end: clip
+
+  // copies the part rect of buffer src (holding srcRect) to dst
+  static void copy_rect(const std::vector<float> &src, const RasterSlice &srcRect, const RasterSlice &rect,
+                        std::vector<float> &dst) {
+    dst.resize(rect.size());
+    for(long int y=0; y<rect.dy; ++y) {
+      const float *from = &src[(rect.y0 - srcRect.y0 + y)*srcRect.dx + rect.x0 - srcRect.x0];
+      std::copy(from, from + rect.dx, &dst[y*rect.dx]);
+    }// endfor: y
+  }// end: copy_rect
+
+  // size of the whole regions of a region filter on its input
+  static long int region_width(const PipelineNode *node) { return (node->nx / node->n) * node->n; }
+  static long int region_height(const PipelineNode *node) { return (node->ny / node->n) * node->n; }
+
+  // r widened to whole regions; the parts past the last whole regions are kept as they are
+  static RasterSlice whole_regions(const RasterSlice &r, const PipelineNode *node) {
+    const long int n = node->n;
+    const long int w = region_width(node);
+    const long int h = region_height(node);
+    long int x0 = r.x0, x1 = r.x0 + r.dx, y0 = r.y0, y1 = r.y0 + r.dy;
+    if(x0 < w) x0 = (x0 / n) * n;
+    if(x1 <= w) x1 = ((x1 + n - 1) / n) * n;
+    if(y0 < h) y0 = (y0 / n) * n;
+    if(y1 <= h) y1 = ((y1 + n - 1) / n) * n;
+    return RasterSlice(x0, y0, x1 - x0, y1 - y0);
+  }// end: whole_regions
+
+
+
+  //---------------------------------------- RasterPipeline
+
+  RasterPipeline::RasterPipeline(const Raster *ras) {
+    std::shared_ptr<PipelineNode> source(new PipelineNode());
+    source->code = PIPELINE_SOURCE;
+    source->source = ras;
+    source->nx = ras->get_nx();
+    source->ny = ras->get_ny();
+    node = source;
+  }// end: RasterPipeline
+
+
+
+  std::shared_ptr<PipelineNode> RasterPipeline::then(const PipelineOpCode &code, const RasterPipeline *other) const {
+    std::shared_ptr<PipelineNode> next(new PipelineNode());
+    next->code = code;
+    next->nx = node->nx;
+    next->ny = node->ny;
+    next->inputs.push_back(node);
+    if(other != NULL) {
+      RasterSizeErrorException RasterSizeError;
+      if(other->get_nx() != node->nx || other->get_ny() != node->ny) throw RasterSizeError;
+      next->inputs.push_back(other->node);
+    }// endif
+    return next;
+  }// end: then
+
+
+
+  RasterPipeline RasterPipeline::thresh(const double &value) const {
+    std::shared_ptr<PipelineNode> next = then(PIPELINE_THRESH);
+    next->a = value;
+    return RasterPipeline(next);
+  }// end: thresh
+
+  RasterPipeline RasterPipeline::scale(const double &offset, const double &mult) const {
+    std::shared_ptr<PipelineNode> next = then(PIPELINE_SCALE);
+    next->a = offset;
+    next->b = mult;
+    return RasterPipeline(next);
+  }// end: scale
+
+  RasterPipeline RasterPipeline::gradientMask(const int &mask) const {
+    IntegerParameterException IntegerParameterError;
+    if(mask < 1 || mask > 8) throw IntegerParameterError;
+    std::shared_ptr<PipelineNode> next = then(PIPELINE_GRADIENT_MASK);
+    next->n = mask;
+    return RasterPipeline(next);
+  }// end: gradientMask
+
+  RasterPipeline RasterPipeline::map(const std::function<float(float)> &fn) const {
+    std::shared_ptr<PipelineNode> next = then(PIPELINE_MAP);
+    next->fn = fn;
+    return RasterPipeline(next);
+  }// end: map
+
+  RasterPipeline RasterPipeline::add(const RasterPipeline &other) const {
+    return RasterPipeline(then(PIPELINE_ADD, &other));
+  }// end: add
+
+  RasterPipeline RasterPipeline::subtract(const RasterPipeline &other) const {
+    return RasterPipeline(then(PIPELINE_SUBTRACT, &other));
+  }// end: subtract
+
+  RasterPipeline RasterPipeline::multiply(const RasterPipeline &other) const {
+    return RasterPipeline(then(PIPELINE_MULTIPLY, &other));
+  }// end: multiply
+
+  RasterPipeline RasterPipeline::divide(const RasterPipeline &other) const {
+    return RasterPipeline(then(PIPELINE_DIVIDE, &other));
+  }// end: divide
+
+  RasterPipeline RasterPipeline::convolve(const std::vector<float> &kernel, const int &size) const {
+    IntegerParameterException IntegerParameterError;
+    if(size < 1 || size % 2 == 0) throw IntegerParameterError;
+    if((long int)kernel.size() != (long int)size*size) throw IntegerParameterError;
+    std::shared_ptr<PipelineNode> next = then(PIPELINE_CONVOLVE);
+    next->n = size;
+    next->kernel = kernel;
+    return RasterPipeline(next);
+  }// end: convolve
+
+  RasterPipeline RasterPipeline::downsample() const {
+    std::shared_ptr<PipelineNode> next = then(PIPELINE_DOWNSAMPLE);
+    next->nx = node->nx / 2;
+    next->ny = node->ny / 2;
+    return RasterPipeline(next);
+  }// end: downsample
+
+  // region filters: n odd, 3 to 11, as the Raster operations
+  static void check_region_size(const int &n) {
+    IntegerParameterException IntegerParameterError;
+    if(n < 3 || n > 11 || n % 2 == 0) throw IntegerParameterError;
+  }// end: check_region_size
+
+  RasterPipeline RasterPipeline::harmonicMean(const int &n) const {
+    check_region_size(n);
+    std::shared_ptr<PipelineNode> next = then(PIPELINE_HARMONIC_MEAN);
+    next->n = n;
+    return RasterPipeline(next);
+  }// end: harmonicMean
+
+  RasterPipeline RasterPipeline::midpointFilter(const int &n) const {
+    check_region_size(n);
+    std::shared_ptr<PipelineNode> next = then(PIPELINE_MIDPOINT);
+    next->n = n;
+    return RasterPipeline(next);
+  }// end: midpointFilter
+
+  RasterPipeline RasterPipeline::rangeFilter(const int &n) const {
+    check_region_size(n);
+    std::shared_ptr<PipelineNode> next = then(PIPELINE_RANGE);
+    next->n = n;
+    return RasterPipeline(next);
+  }// end: rangeFilter
+
+
+
+  void RasterPipeline::write(Raster *ras_out) const {
+    PipelinePlan plan;
+    plan.add_output(*this, ras_out);
+    plan.run();
+  }// end: write
+
+
+
+  //---------------------------------------- PipelinePlan
+
+  void PipelinePlan::add_output(const RasterPipeline &pipeline, Raster *ras_out) {
+    RasterSizeErrorException RasterSizeError;
+    if(ras_out->get_nx() != pipeline.get_nx() || ras_out->get_ny() != pipeline.get_ny()) throw RasterSizeError;
+    if(!outputs.empty()) {
+      if(outputs[0].second->get_nx() != ras_out->get_nx()) throw RasterSizeError;
+      if(outputs[0].second->get_ny() != ras_out->get_ny()) throw RasterSizeError;
+    }// endif
+    outputs.push_back(std::make_pair(pipeline, ras_out));
+    steps.clear();
+  }// end: add_output
+
+
+
+  void PipelinePlan::set_threads(const int &n) {
+    nthreads = (n > 0) ? n : std::max(1u, std::thread::hardware_concurrency());
+  }// end: set_threads
+
+
+
+  // number of operations and outputs reading each node, from node down
+  static void count_uses(const PipelineNode *node, std::map<const PipelineNode *, int> &uses) {
+    if(uses[node]++ > 0) return;
+    for(size_t i=0; i<node->inputs.size(); ++i) count_uses(node->inputs[i].get(), uses);
+  }// end: count_uses
+
+
+
+  void PipelinePlan::plan() {
+    steps.clear();
+    std::map<const PipelineNode *, int> uses;
+    for(size_t i=0; i<outputs.size(); ++i) count_uses(outputs[i].first.node.get(), uses);
+
+    std::map<const PipelineNode *, int> step_of;
+    for(size_t i=0; i<outputs.size(); ++i) {
+      const int s = plan_step(outputs[i].first.node.get(), step_of, uses);
+      steps[s].outputs.push_back(outputs[i].second);
+    }// endfor: i
+  }// end: plan
+
+
+
+  int PipelinePlan::plan_step(const PipelineNode *node, std::map<const PipelineNode *, int> &step_of,
+                              std::map<const PipelineNode *, int> &uses) {
+    std::map<const PipelineNode *, int>::const_iterator found = step_of.find(node);
+    if(found != step_of.end()) return found->second;
+
+    Step step;
+    step.code = node->code;
+    step.node = node;
+    step.consumers = uses[node];
+
+    // a run of pixel operations goes down to the first node read by anything else:
+    const PipelineNode *first = node;
+    if(is_pixel_op(node->code)) {
+      step.pixel_ops.push_back(node);
+      while(is_pixel_op(first->inputs[0]->code) && uses[first->inputs[0].get()] == 1) {
+        first = first->inputs[0].get();
+        step.pixel_ops.push_back(first);
+      }// endwhile
+      std::reverse(step.pixel_ops.begin(), step.pixel_ops.end());
+    }// endif
+
+    // inputs first, so steps are in the order they are computed:
+    for(size_t i=0; i<first->inputs.size(); ++i)
+      step.inputs.push_back(plan_step(first->inputs[i].get(), step_of, uses));
+
+    steps.push_back(step);
+    step_of[node] = steps.size() - 1;
+    return steps.size() - 1;
+  }// end: plan_step
+
+
+
+  void PipelinePlan::tile_needs(const RasterSlice &tile, std::vector<RasterSlice> &need) const {
+    need.assign(steps.size(), RasterSlice());
+    for(size_t s=0; s<steps.size(); ++s)
+      if(!steps[s].outputs.empty()) need[s] = tile;
+
+    // from the outputs down to the sources, each step asks its inputs for what it reads:
+    for(long int s=steps.size()-1; s>=0; --s) {
+      if(is_empty(need[s])) continue;
+      const Step &step = steps[s];
+      const PipelineNode *node = step.node;
+      if(is_region_op(step.code)) need[s] = whole_regions(need[s], node);
+      const RasterSlice &own = need[s];
+
+      for(size_t k=0; k<step.inputs.size(); ++k) {
+        const int in = step.inputs[k];
+        const PipelineNode *input = steps[in].node;
+        RasterSlice r = own;
+        if(step.code == PIPELINE_CONVOLVE) {
+          const long int half = node->n / 2;
+          r = clip(RasterSlice(own.x0 - half, own.y0 - half, own.dx + 2*half, own.dy + 2*half),
+                   input->nx, input->ny);
+        } else if(step.code == PIPELINE_DOWNSAMPLE) {
+          r = RasterSlice(2*own.x0 + 1, 2*own.y0 + 1, 2*own.dx - 1, 2*own.dy - 1);
+        } else if(is_region_op(step.code)) {
+          r = clip(own, region_width(node), region_height(node));
+        }// endif
+        need[in] = unite(need[in], r);
+      }// endfor: k
+    }// endfor: s
+  }// end: tile_needs
+
+
+
+  // applies a fused run of pixel operations, a strip at a time so it stays in cache
+  static void apply_pixel_ops(const std::vector<const PipelineNode *> &ops, float *data, const long int &npixels) {
+    for(long int i=0; i<npixels; i+=PIPELINE_STRIP_PIXELS) {
+      float *strip = data + i;
+      const long int m = std::min(PIPELINE_STRIP_PIXELS, npixels - i);
+      for(size_t k=0; k<ops.size(); ++k) {
+        const PipelineNode *op = ops[k];
+        switch(op->code) {
+        case PIPELINE_THRESH: {
+          const ThreshPixel f(op->a);
+          for(long int j=0; j<m; ++j) strip[j] = f(strip[j]);
+          break;
+        }
+        case PIPELINE_SCALE: {
+          const ScalePixel f(op->a, op->b);
+          for(long int j=0; j<m; ++j) strip[j] = f(strip[j]);
+          break;
+        }
+        case PIPELINE_GRADIENT_MASK: {
+          const GradientMaskPixel f;
+          for(long int j=0; j<m; ++j) strip[j] = float(f(strip[j]));
+          break;
+        }
+        default:
+          for(long int j=0; j<m; ++j) strip[j] = op->fn(strip[j]);
+        }// endswitch
+      }// endfor: k
+    }// endfor: i
+  }// end: apply_pixel_ops
+
+
+
+  template<typename Op>
+  static void apply_binary(float *a, const float *b, const long int &npixels, const Op &op) {
+    for(long int j=0; j<npixels; ++j) a[j] = op(a[j], b[j]);
+  }// end: apply_binary
+
+
+
+  // convolution of the pixels own, from in (holding inRect), edges repeated
+  static void convolve_tile(const PipelineNode *node, const std::vector<float> &in, const RasterSlice &inRect,
+                            const RasterSlice &own, std::vector<float> &out) {
+    const long int n = node->n;
+    const long int half = n / 2;
+    const long int nxIn = node->inputs[0]->nx;
+    const long int nyIn = node->inputs[0]->ny;
+
+    out.assign(own.size(), 0.0f);
+    for(long int y=0; y<own.dy; ++y) {
+      float *row = &out[y*own.dx];
+      for(long int j=0; j<n; ++j) {
+        const long int yy = std::min(std::max(own.y0 + y + j - half, 0L), nyIn - 1);
+        const float *src = &in[(yy - inRect.y0)*inRect.dx] - inRect.x0;
+        for(long int i=0; i<n; ++i) {
+          const float w = node->kernel[j*n + i];
+          if(w == 0) continue;
+          // pixel x reads x+shift: inside the raster for x in [lo, hi), clamped outside
+          const long int shift = own.x0 + i - half;
+          const long int lo = std::min(std::max(-shift, 0L), own.dx);
+          const long int hi = std::max(std::min(nxIn - shift, own.dx), lo);
+          for(long int x=0; x<lo; ++x) row[x] += w * src[0];
+          for(long int x=lo; x<hi; ++x) row[x] += w * src[x + shift];
+          for(long int x=hi; x<own.dx; ++x) row[x] += w * src[nxIn - 1];
+        }// endfor: i
+      }// endfor: j
+    }// endfor: y
+  }// end: convolve_tile
+
+
+
+  // region filter of the pixels own, from in (holding inRect); pixels past the whole regions are 0
+  static void region_tile(const PipelineNode *node, const std::vector<float> &in, const RasterSlice &inRect,
+                          const RasterSlice &own, std::vector<float> &out) {
+    out.assign(own.size(), 0.0f);
+    const RasterSlice part = clip(own, region_width(node), region_height(node));
+    if(is_empty(part)) return;
+
+    std::vector<double> data(part.size());
+    for(long int y=0; y<part.dy; ++y) {
+      const float *from = &in[(part.y0 - inRect.y0 + y)*inRect.dx + part.x0 - inRect.x0];
+      std::copy(from, from + part.dx, &data[y*part.dx]);
+    }// endfor: y
+
+    std::vector<long int> slice(4);
+    slice[0] = part.x0; slice[1] = part.y0; slice[2] = part.dx; slice[3] = part.dy;
+    switch(node->code) {
+    case PIPELINE_HARMONIC_MEAN: HarmonicMeanRegions(node->n)(slice, data); break;
+    case PIPELINE_MIDPOINT:      MidpointRegions(node->n)(slice, data); break;
+    default:                     RangeRegions(node->n)(slice, data);
+    }// endswitch
+
+    for(long int y=0; y<part.dy; ++y) {
+      float *to = &out[(part.y0 - own.y0 + y)*own.dx + part.x0 - own.x0];
+      for(long int x=0; x<part.dx; ++x) to[x] = float(data[y*part.dx + x]);
+    }// endfor: y
+  }// end: region_tile
+
+
+
+  void PipelinePlan::run_tile(const RasterSlice &tile, std::vector<RasterSlice> &need,
+                              std::vector<std::vector<float> > &buffers, const bool &serialize) const {
+    // HDF5 calls: on the shared I/O thread when tiles run on several threads
+    IOThread &io = IOThread::shared();
+    auto file_io = [&](const std::function<void()> &job) {
+      if(serialize) io.submit(job).get();
+      else job();
+    };
+
+    tile_needs(tile, need);
+    buffers.resize(steps.size());
+
+    std::vector<float> other;
+    for(size_t s=0; s<steps.size(); ++s) {
+      const RasterSlice &own = need[s];
+      if(is_empty(own)) continue;
+      const Step &step = steps[s];
+      const PipelineNode *node = step.node;
+      std::vector<float> &out = buffers[s];
+
+      // input k of the step, for pixels own: taken over when nothing else reads it, else copied
+      auto take_input = [&](const size_t &k, std::vector<float> &dst) {
+        const int in = step.inputs[k];
+        if(same_rect(need[in], own) && steps[in].consumers == 1) dst.swap(buffers[in]);
+        else copy_rect(buffers[in], need[in], own, dst);
+      };
+
+      if(step.code == PIPELINE_SOURCE) {
+        out.resize(own.size());
+        file_io([&]() { node->source->read(own, out.data(), out.size()); });
+      } else if(is_pixel_op(step.code)) {
+        take_input(0, out);
+        apply_pixel_ops(step.pixel_ops, out.data(), out.size());
+      } else if(is_binary_op(step.code)) {
+        take_input(0, out);
+        const int in = step.inputs[1];
+        const float *b = buffers[in].data();
+        if(!same_rect(need[in], own)) {
+          copy_rect(buffers[in], need[in], own, other);
+          b = other.data();
+        }// endif
+        switch(step.code) {
+        case PIPELINE_ADD:      apply_binary(out.data(), b, out.size(), RasterAddOp()); break;
+        case PIPELINE_SUBTRACT: apply_binary(out.data(), b, out.size(), RasterSubtractOp()); break;
+        case PIPELINE_MULTIPLY: apply_binary(out.data(), b, out.size(), RasterMultiplyOp()); break;
+        default:                apply_binary(out.data(), b, out.size(), RasterDivideOp());
+        }// endswitch
+      } else if(step.code == PIPELINE_CONVOLVE) {
+        const int in = step.inputs[0];
+        convolve_tile(node, buffers[in], need[in], own, out);
+      } else if(step.code == PIPELINE_DOWNSAMPLE) {
+        const int in = step.inputs[0];
+        const RasterSlice &inRect = need[in];
+        const std::vector<float> &src = buffers[in];
+        const DownsampleBlurPixel blur;
+        out.resize(own.size());
+        for(long int y=0; y<own.dy; ++y) {
+          const float *row = &src[(2*(own.y0 + y) + 1 - inRect.y0)*inRect.dx];
+          for(long int x=0; x<own.dx; ++x)
+            out[y*own.dx + x] = float(blur(row[2*(own.x0 + x) + 1 - inRect.x0]));
+        }// endfor: y
+      } else {
+        const int in = step.inputs[0];
+        region_tile(node, buffers[in], need[in], own, out);
+      }// endif
+
+      // outputs get the tile itself, out of the widened part the step computed:
+      if(step.outputs.empty()) continue;
+      const float *tileData = out.data();
+      if(!same_rect(own, tile)) {
+        copy_rect(out, own, tile, other);
+        tileData = other.data();
+      }// endif
+      for(size_t k=0; k<step.outputs.size(); ++k) {
+        Raster *ras_out = step.outputs[k];
+        file_io([&]() { ras_out->write(tile, tileData, tile.size()); });
+      }// endfor: k
+    }// endfor: s
+  }// end: run_tile
+
+
+
+  void PipelinePlan::tiles(const long int *blockShape, std::vector<RasterSlice> &all) const {
+    SliceSizeException SliceSizeError;
+    all.clear();
+    if(outputs.empty()) return;
+
+    const Raster *first = outputs[0].second;
+    const long int nx = first->get_nx();
+    const long int ny = first->get_ny();
+    long int shape[2];
+    if(blockShape != NULL) {
+      if(blockShape[0] < 1 || blockShape[1] < 1) throw SliceSizeError;
+      shape[0] = blockShape[0];
+      shape[1] = blockShape[1];
+    } else {
+      first->default_block_shape(shape);
+      // enough bands for every thread to have a few:
+      if(nthreads > 1) {
+        const long int blocks = (long int)nthreads * RASTER_BLOCKS_PER_THREAD;
+        shape[1] = std::max(1L, std::min(shape[1], (ny + blocks - 1) / blocks));
+      }// endif
+    }// endif
+
+    for(long int y=0; y<ny; y+=shape[1])
+      for(long int x=0; x<nx; x+=shape[0])
+        all.push_back(RasterSlice(x, y, std::min(shape[0], nx - x), std::min(shape[1], ny - y)));
+  }// end: tiles
+
+
+
+  PipelineReport PipelinePlan::report(const long int *blockShape) {
+    PipelineReport r;
+    if(outputs.empty()) return r;
+    if(steps.empty()) plan();
+
+    // fused: what the tiles read from the sources and write to the outputs
+    std::vector<RasterSlice> all;
+    tiles(blockShape, all);
+    std::vector<RasterSlice> need;
+    for(size_t t=0; t<all.size(); ++t) {
+      tile_needs(all[t], need);
+      for(size_t s=0; s<steps.size(); ++s) {
+        if(steps[s].code == PIPELINE_SOURCE) r.fused_bytes_read += 4ULL * need[s].size();
+        r.fused_bytes_written += 4ULL * all[t].size() * steps[s].outputs.size();
+      }// endfor: s
+    }// endfor: t
+    r.fused_passes = 1;
+
+    // eager: every operation reads its inputs and writes its REAL32 result
+    std::ostringstream text;
+    for(size_t s=0; s<steps.size(); ++s) {
+      const Step &step = steps[s];
+      std::vector<const PipelineNode *> ops = step.pixel_ops;
+      if(ops.empty()) ops.push_back(step.node);
+
+      for(size_t k=0; k<ops.size(); ++k) {
+        const PipelineNode *op = ops[k];
+        const unsigned long long npixels = 4ULL * op->nx * op->ny;
+        if(op->code == PIPELINE_SOURCE) continue;
+        ++r.eager_passes;
+        if(is_binary_op(op->code)) {
+          r.eager_bytes_read += 2*npixels;
+          r.eager_bytes_written += npixels;
+        } else if(op->code == PIPELINE_DOWNSAMPLE) {
+          // blur the input in place, then read every other row of it
+          const PipelineNode *in = op->inputs[0].get();
+          const unsigned long long ninput = 4ULL * in->nx * in->ny;
+          r.eager_bytes_read += ninput + 4ULL * 2 * op->ny * in->nx;
+          r.eager_bytes_written += ninput + npixels;
+          ++r.eager_passes;
+        } else if(is_region_op(op->code)) {
+          const unsigned long long nregions = 4ULL * region_width(op) * region_height(op);
+          r.eager_bytes_read += nregions;
+          r.eager_bytes_written += nregions;
+        } else {
+          r.eager_bytes_read += npixels;
+          r.eager_bytes_written += npixels;
+        }// endif
+      }// endfor: k
+
+      // the plan, a step per line:
+      text << s << ": ";
+      if(step.code == PIPELINE_SOURCE) text << "read " << step.node->source->get_name();
+      for(size_t k=0; k<step.pixel_ops.size(); ++k) text << (k > 0 ? ", " : "") << op_name(step.pixel_ops[k]->code);
+      if(step.pixel_ops.size() > 1) text << " (fused)";
+      if(step.pixel_ops.empty() && step.code != PIPELINE_SOURCE) text << op_name(step.code);
+      for(size_t k=0; k<step.inputs.size(); ++k) text << (k > 0 ? ", " : " <- ") << step.inputs[k];
+      for(size_t k=0; k<step.outputs.size(); ++k) text << (k > 0 ? ", " : " -> ") << step.outputs[k]->get_name();
+      text << std::endl;
+    }// endfor: s
+    r.plan = text.str();
+    return r;
+  }// end: report
+
+
+
+  void PipelinePlan::run(const long int *blockShape) {
+    if(outputs.empty()) return;
+    if(steps.empty()) plan();
+
+    std::vector<RasterSlice> all;
+    tiles(blockShape, all);
+
+    if(nthreads < 2) {
+      std::vector<RasterSlice> need;
+      std::vector<std::vector<float> > buffers;
+      for(size_t t=0; t<all.size(); ++t) run_tile(all[t], need, buffers, false);
+      return;
+    }// endif
+
+    // per-thread buffers, reused from tile to tile:
+    const unsigned n = std::min((size_t)nthreads, all.size());
+    std::vector<std::vector<RasterSlice> > needs(n);
+    std::vector<std::vector<std::vector<float> > > buffers(n);
+    TileScheduler::shared().run(all.size(),
+      [&](long int t, unsigned worker) { run_tile(all[t], needs[worker], buffers[worker], true); }, n);
+  }// end: run
+
+}// end namespace GeoStar
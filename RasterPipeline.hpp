@@ -0,0 +1,307 @@
+// RasterPipeline.hpp
+//
+// lazy chains of Raster operations: thresh, scale, gradientMask, the
+// arithmetic, convolutions, downsample and the region filters are
+// declared first, then planned and run together tile by tile, so only
+// the final outputs are ever written.
+//
+//----------------------------------------
+#ifndef RASTERPIPELINE_HPP_
+#define RASTERPIPELINE_HPP_
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <functional>
+
+#include "Raster.hpp"
+#include "RasterSlice.hpp"
+#include "Exceptions.hpp"
+
+
+namespace GeoStar {
+
+  // operations of a pipeline
+  enum PipelineOpCode {
+    PIPELINE_SOURCE,
+    // pixel by pixel:
+    PIPELINE_MAP, PIPELINE_THRESH, PIPELINE_SCALE, PIPELINE_GRADIENT_MASK,
+    PIPELINE_ADD, PIPELINE_SUBTRACT, PIPELINE_MULTIPLY, PIPELINE_DIVIDE,
+    // neighbourhoods:
+    PIPELINE_CONVOLVE, PIPELINE_DOWNSAMPLE,
+    PIPELINE_HARMONIC_MEAN, PIPELINE_MIDPOINT, PIPELINE_RANGE
+  };
+
+  // one operation of a pipeline and the operations it reads from
+  struct PipelineNode {
+    PipelineOpCode code;
+    std::vector<std::shared_ptr<const PipelineNode> > inputs;
+    const Raster *source;          // PIPELINE_SOURCE
+    long int nx;                   // size of the result
+    long int ny;
+    double a;                      // PIPELINE_THRESH: value.  PIPELINE_SCALE: offset
+    double b;                      // PIPELINE_SCALE: mult
+    int n;                         // PIPELINE_CONVOLVE: kernel size.  Region filters: region size
+    std::vector<float> kernel;     // PIPELINE_CONVOLVE: n*n weights, row by row
+    std::function<float(float)> fn;  // PIPELINE_MAP
+
+    PipelineNode() : code(PIPELINE_SOURCE), source(NULL), nx(0), ny(0), a(0), b(0), n(0) {}
+  };
+
+  // pixels of a tile each pixel-by-pixel run handles at a time, so they stay in cache
+  const long int PIPELINE_STRIP_PIXELS = 4096;
+
+
+  /** \brief PipelineReport -- I/O of a pipeline run in one pass, against running its operations one by one
+
+    Bytes are those of the pixels read from and written to rasters, 4 bytes (a float) per pixel.  The eager
+	figures are those of the same operations run one after the other, each reading its inputs and writing
+	its result to a REAL32 raster: the usual way of chaining Raster operations.
+  */
+  struct PipelineReport {
+    unsigned long long fused_bytes_read;
+    unsigned long long fused_bytes_written;
+    unsigned long long eager_bytes_read;
+    unsigned long long eager_bytes_written;
+
+    // passes over the data: 1 for the plan; eagerly, one per operation and two for downsample
+    int fused_passes;
+    int eager_passes;
+
+    // the steps of the plan, one per line
+    std::string plan;
+
+    PipelineReport() : fused_bytes_read(0), fused_bytes_written(0), eager_bytes_read(0), eager_bytes_written(0),
+                       fused_passes(0), eager_passes(0) {}
+  }; // end: PipelineReport
+
+
+
+  /** \brief RasterPipeline -- a lazy chain of Raster operations
+
+  A RasterPipeline stands for the result of some operations on one or more rasters, without computing it.
+  Each method returns a new pipeline with one more operation, named and computed as the Raster operation of the
+  same name; nothing is read until the pipeline is written (write) or run with others (PipelinePlan).  Then the
+  whole chain runs in a single pass over the tiles of the output: each tile of the inputs is read once, every
+  operation is applied in memory, and only the output is written.  No intermediate raster is made.
+
+ \see PipelinePlan, PipelineReport, Raster::thresh, Raster::scale, Raster::gradientMask, Raster::downsample,
+	Raster::midpointFilter, RasterExpr, BandMath
+
+ \Par Example
+  The usual chain, in one pass instead of four, and what it saves:
+  \code
+  GeoStar::RasterPipeline edges = GeoStar::RasterPipeline(ras).scale(0, 2).thresh(100).gradientMask(1).downsample();
+
+  GeoStar::Raster *small = img->create_raster("edges", GeoStar::REAL32, edges.get_nx(), edges.get_ny());
+  GeoStar::PipelinePlan plan;
+  plan.add_output(edges, small);
+  std::cout << plan.report().plan;
+  plan.run();
+  \endcode
+
+ \Par Details
+  Everything is computed in float, as a chain of Raster operations writing REAL32 rasters computes, and the
+  output is converted to its raster's type as write converts floats.  Some differences with the Raster
+  operations:
+	- downsample does not blur its input raster in place, as Raster::downsample does.
+	- the region filters set the pixels past the last whole region to 0, as in a new output raster.
+	- convolve has no Raster counterpart.
+  Operations run on pixels in memory, so they are cheap; the gain is in I/O, reported by PipelinePlan::report.
+  */
+  class RasterPipeline {
+
+  private:
+    std::shared_ptr<const PipelineNode> node;
+
+    explicit RasterPipeline(const std::shared_ptr<const PipelineNode> &pipelineNode) : node(pipelineNode) {}
+
+    // a new node of code taking this pipeline (and other, if not NULL) as input, of this pipeline's size
+    std::shared_ptr<PipelineNode> then(const PipelineOpCode &code, const RasterPipeline *other = NULL) const;
+
+    friend class PipelinePlan;
+
+  public:
+
+    /** \brief RasterPipeline Constructor -- a pipeline that starts from the pixels of a raster
+
+    \param[in] ras
+	The raster, read as float.  It must stay open until the pipeline has run.
+    */
+    explicit RasterPipeline(const Raster *ras);
+
+    // get_nx, get_ny: size of the result
+    long int get_nx() const { return node->nx; }
+    long int get_ny() const { return node->ny; }
+
+    // pixel by pixel, as the Raster operations of the same names:
+    RasterPipeline thresh(const double &value) const;
+    RasterPipeline scale(const double &offset, const double &mult) const;
+
+    /** \brief gradientMask -- as Raster::gradientMask
+
+    \Par Exceptions
+	IntegerParameterException if mask is not 1 to 8.
+    */
+    RasterPipeline gradientMask(const int &mask) const;
+
+    /** \brief map -- any function of one pixel
+
+    \param[in] fn
+	Called as fn(value) for every pixel.  With PipelinePlan::set_threads it is called from several threads at
+	once.
+    */
+    RasterPipeline map(const std::function<float(float)> &fn) const;
+
+    /** \brief add, subtract, multiply, divide -- pixel by pixel with another pipeline, as Raster::add, ...
+
+    \Par Exceptions
+	RasterSizeErrorException if other is not the size of this pipeline.
+    */
+    RasterPipeline add(const RasterPipeline &other) const;
+    RasterPipeline subtract(const RasterPipeline &other) const;
+    RasterPipeline multiply(const RasterPipeline &other) const;
+    RasterPipeline divide(const RasterPipeline &other) const;
+
+    /** \brief convolve -- weighted sum of the size x size pixels around each pixel
+
+    Each result pixel is the sum of kernel[j*size + i] times the pixel (i - size/2, j - size/2) away from it.
+	Pixels past the edges of the raster repeat the edge pixels.  Consecutive convolutions share one read of
+	their input: the tile is read once, wide enough for all of them.
+
+    \param[in] kernel
+	size*size weights, row by row.
+
+    \param[in] size
+	Width and height of the kernel, odd.
+
+    \Par Exceptions
+	IntegerParameterException if size is not odd or kernel does not have size*size weights.
+    */
+    RasterPipeline convolve(const std::vector<float> &kernel, const int &size) const;
+
+    // downsample: half the size, as Raster::downsample (without blurring the input raster)
+    RasterPipeline downsample() const;
+
+    /** \brief harmonicMean, midpointFilter, rangeFilter -- as the Raster operations
+
+    \Par Exceptions
+	IntegerParameterException if n is not odd and 3 to 11.
+    */
+    RasterPipeline harmonicMean(const int &n) const;
+    RasterPipeline midpointFilter(const int &n) const;
+    RasterPipeline rangeFilter(const int &n) const;
+
+    /** \brief write -- runs the pipeline into a raster, in one pass
+
+    Same as a PipelinePlan with this pipeline as its only output.
+
+    \param[out] ras_out
+	Raster of the size of the pipeline.
+
+    \Par Exceptions
+	RasterSizeErrorException if ras_out is not the size of the pipeline; read and write errors.
+    */
+    void write(Raster *ras_out) const;
+
+  }; // end class: RasterPipeline
+
+
+
+  /** \brief PipelinePlan -- runs one or more pipelines together, in one pass
+
+  Pipelines added as outputs are planned together: operations that several outputs share are computed once per
+  tile, runs of pixel-by-pixel operations are fused into one step that goes over the pixels once, and every
+  step's tile is the tile of the output widened by what the steps after it need (the neighbours of a convolve,
+  whole regions of a region filter, twice the size before a downsample).  Then each tile is read from the input
+  rasters once, computed through every step in memory, and written to the outputs.
+
+ \see RasterPipeline, PipelineReport, TileScheduler
+
+ \Par Example
+  Two outputs from one read of the input:
+  \code
+  GeoStar::RasterPipeline scaled = GeoStar::RasterPipeline(ras).scale(0, 2);
+  GeoStar::PipelinePlan plan;
+  plan.add_output(scaled.thresh(100), masked);
+  plan.add_output(scaled.midpointFilter(5), smooth);
+  plan.set_threads(0);
+  plan.run();
+  \endcode
+
+ \Par Details
+  All outputs must be the same size.  Tiles are bands of whole rows, default_block_shape of the first output.
+  With more than one thread, tiles are computed on TileScheduler::shared() and read and written on the shared
+  I/O thread, as for Raster::set_threads.
+  */
+  class PipelinePlan {
+
+  private:
+    // a step of the plan: one operation, or a fused run of pixel-by-pixel ones
+    struct Step {
+      PipelineOpCode code;
+      const PipelineNode *node;                   // the operation, the last one of a fused run
+      std::vector<const PipelineNode *> pixel_ops;  // fused run, first applied first
+      std::vector<int> inputs;                    // steps read from
+      int consumers;                              // steps and outputs reading this step
+      std::vector<Raster *> outputs;              // rasters this step is written to
+    };
+
+    std::vector<std::pair<RasterPipeline, Raster *> > outputs;
+    std::vector<Step> steps;
+    int nthreads;
+
+    // steps, from the outputs.  uses: number of operations and outputs reading each node
+    void plan();
+    int plan_step(const PipelineNode *node, std::map<const PipelineNode *, int> &step_of,
+                  std::map<const PipelineNode *, int> &uses);
+
+    // the part of every step needed for one tile of the outputs, empty for steps not needed:
+    void tile_needs(const RasterSlice &tile, std::vector<RasterSlice> &need) const;
+
+    // computes one tile through every step, and writes it to the outputs
+    void run_tile(const RasterSlice &tile, std::vector<RasterSlice> &need,
+                  std::vector<std::vector<float> > &buffers, const bool &serialize) const;
+
+    // tiles of the outputs
+    void tiles(const long int *blockShape, std::vector<RasterSlice> &all) const;
+
+  public:
+    PipelinePlan() : nthreads(1) {}
+
+    /** \brief add_output -- a pipeline to compute, and the raster its result is written to
+
+    \Par Exceptions
+	RasterSizeErrorException if ras_out is not the size of the pipeline, or not the size of the other outputs.
+    */
+    void add_output(const RasterPipeline &pipeline, Raster *ras_out);
+
+    // set_threads: number of threads computing tiles; 1 (the default) runs on the calling thread, 0 one per core
+    void set_threads(const int &n);
+
+    /** \brief report -- I/O of the plan against running the operations one by one
+
+    Works the plan out tile by tile without reading anything.
+
+    \param[in] blockShape
+	(Optional) as for run.
+    */
+    PipelineReport report(const long int *blockShape = NULL);
+
+    /** \brief run -- computes every output in one pass
+
+    \param[in] blockShape
+	(Optional) x-size, y-size of the tiles, or NULL for bands of whole rows.
+
+    \Par Exceptions
+	SliceSizeException if a tile size is less than 1; read and write errors.
+    */
+    void run(const long int *blockShape = NULL);
+
+  }; // end class: PipelinePlan
+
+}// end namespace GeoStar
+
+
+#endif // RASTERPIPELINE_HPP_
@@ -0,0 +1,43 @@
+// RasterSlice.hpp
+//
+// a rectangle of pixels in a raster
+//
+//----------------------------------------
+#ifndef RASTERSLICE_HPP_
+#define RASTERSLICE_HPP_
+
+
+#include <vector>
+
+
+namespace GeoStar {
+
+  // x0, y0: offset of the top-left pixel
+  // dx, dy: size of the rectangle
+  // same order as the std::vector<long int> slices used throughout Raster.
+  struct RasterSlice {
+    long int x0;
+    long int y0;
+    long int dx;
+    long int dy;
+
+    RasterSlice() : x0(0), y0(0), dx(0), dy(0) {}
+
+    RasterSlice(const long int &x, const long int &y, const long int &width, const long int &height)
+      : x0(x), y0(y), dx(width), dy(height) {}
+
+    // from the first 4 elements of a slice array or vector:
+    explicit RasterSlice(const long int *slice)
+      : x0(slice[0]), y0(slice[1]), dx(slice[2]), dy(slice[3]) {}
+
+    explicit RasterSlice(const std::vector<long int> &slice)
+      : x0(slice[0]), y0(slice[1]), dx(slice[2]), dy(slice[3]) {}
+
+    // number of pixels in the rectangle
+    long int size() const { return dx*dy; }
+  }; // end: RasterSlice
+
+}// end namespace GeoStar
+
+
+#endif // RASTERSLICE_HPP_
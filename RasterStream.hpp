@@ -0,0 +1,195 @@
+// RasterStream.hpp
+//
+// streaming block reader and writer for Rasters: the next block is read,
+// and the previous one written, on the shared I/O thread while the
+// current block is being processed.
+//
+//----------------------------------------
+#ifndef RASTERSTREAM_HPP_
+#define RASTERSTREAM_HPP_
+
+#include <vector>
+#include <future>
+#include <algorithm>
+
+#include "Raster.hpp"
+#include "IOThread.hpp"
+
+
+namespace GeoStar {
+
+  /** \brief RasterReader -- reads a raster block by block, one block ahead
+
+    Walks a window of a raster in blocks, row of blocks by row of blocks, the same way as
+	Raster::for_each_block.  While the caller works on one block, the next one is being read on
+	IOThread::shared().
+
+    \see RasterWriter, Raster::for_each_block, Raster::set_prefetch
+
+    \Par Example
+	Clamping a raster through a reader/writer pair:
+	\code
+	long int window[4] = {0, 0, ras->get_nx(), ras->get_ny()};
+	long int blockShape[2] = {256, 256};
+
+	GeoStar::RasterReader<float> reader(ras, window, blockShape);
+	GeoStar::RasterWriter<float> writer(ras_out);
+	std::vector<long int> slice;
+	std::vector<float> data;
+	while(reader.next(slice, data)) {
+	  for(long int i=0; i<slice[2]*slice[3]; ++i) if(data[i] > 255) data[i] = 255;
+	  writer.write(slice, data);
+	}
+	writer.finish();
+	\endcode
+
+    \Par Details
+	Buffers are handed over by swapping vectors, never copied: next() swaps the caller's vector with
+	the block just read, and RasterWriter::write swaps it with the buffer of the last write.
+	The caller must not make HDF5 calls of its own between next() and the end of the walk, since the
+	library is not thread-safe.
+  */
+  template<typename T>
+  class RasterReader {
+
+  private:
+    const Raster *ras;
+    long int window[4];
+    long int shape[2];
+
+    // next block to start reading:
+    long int x;
+    long int y;
+
+    // block being read on the I/O thread:
+    std::vector<long int> pending_slice;
+    std::vector<T> pending_data;
+    std::future<void> pending;
+
+    RasterReader(const RasterReader &);
+    RasterReader &operator=(const RasterReader &);
+
+    // starts reading the block at (x,y), if there is one left
+    void prefetch() {
+      if(window[2] < 1 || window[3] < 1 || y >= window[1]+window[3]) return;
+
+      pending_slice.resize(4);
+      pending_slice[0] = x;
+      pending_slice[1] = y;
+      pending_slice[2] = std::min(shape[0], window[0]+window[2]-x);
+      pending_slice[3] = std::min(shape[1], window[1]+window[3]-y);
+
+      x += shape[0];
+      if(x >= window[0]+window[2]) {
+        x = window[0];
+        y += shape[1];
+      }// endif
+
+      const Raster *source = ras;
+      std::vector<long int> *slice = &pending_slice;
+      std::vector<T> *data = &pending_data;
+      pending = IOThread::shared().submit([source, slice, data]() {
+          source->read(*slice, *data);
+        });
+    }// end: prefetch
+
+  public:
+
+    // window: x0, y0, dx, dy of the part of ras to walk.
+    // blockShape: x-size, y-size of the blocks, both at least 1.
+    RasterReader(const Raster *source, const long int *walkWindow, const long int *blockShape)
+      : ras(source), x(walkWindow[0]), y(walkWindow[1]) {
+      SliceSizeException SliceSizeError;
+      if(blockShape[0] < 1 || blockShape[1] < 1) throw SliceSizeError;
+
+      for(int i=0; i<4; ++i) window[i] = walkWindow[i];
+      shape[0] = blockShape[0];
+      shape[1] = blockShape[1];
+      pending_data.resize(shape[0]*shape[1]);
+      prefetch();
+    }// end: RasterReader
+
+    // waits for the read in flight, so it does not land in a deleted buffer
+    ~RasterReader() {
+      if(pending.valid()) pending.wait();
+    }// end: ~RasterReader
+
+    // next: waits for the block being read, swaps it into slice and data and starts reading
+    //       the following block.  Returns false when the whole window has been read.
+    //       Rethrows any exception from the read.
+    bool next(std::vector<long int> &slice, std::vector<T> &data) {
+      if(!pending.valid()) return false;
+      pending.get();
+
+      slice.swap(pending_slice);
+      data.swap(pending_data);
+      if(pending_data.size() < (size_t)(shape[0]*shape[1])) pending_data.resize(shape[0]*shape[1]);
+      prefetch();
+      return true;
+    }// end: next
+
+  }; // end class: RasterReader
+
+
+
+  /** \brief RasterWriter -- writes blocks to a raster behind the caller
+
+    Each write() hands the block to IOThread::shared() and returns straight away; only the next
+	write() (or finish()) waits for it.
+
+    \see RasterReader, Raster::for_each_block
+
+    \Par Details
+	write() takes the contents of data and leaves a free buffer of the same size in its place.
+	Call finish() at the end: it waits for the last block and rethrows any exception from the writes.
+	The destructor waits too, but can not report errors.
+  */
+  template<typename T>
+  class RasterWriter {
+
+  private:
+    Raster *ras;
+
+    // block being written on the I/O thread:
+    std::vector<long int> pending_slice;
+    std::vector<T> pending_data;
+    std::future<void> pending;
+
+    RasterWriter(const RasterWriter &);
+    RasterWriter &operator=(const RasterWriter &);
+
+  public:
+
+    RasterWriter(Raster *destination) : ras(destination) {}
+
+    ~RasterWriter() {
+      if(pending.valid()) pending.wait();
+    }// end: ~RasterWriter
+
+    // write: queues data for writing to slice of the raster
+    void write(const std::vector<long int> &slice, std::vector<T> &data) {
+      finish();
+
+      pending_slice = slice;
+      pending_data.swap(data);
+      if(data.size() < pending_data.size()) data.resize(pending_data.size());
+
+      Raster *destination = ras;
+      const std::vector<long int> *area = &pending_slice;
+      const std::vector<T> *values = &pending_data;
+      pending = IOThread::shared().submit([destination, area, values]() {
+          destination->write(*area, *values);
+        });
+    }// end: write
+
+    // finish: waits until everything written has reached HDF5, rethrows write errors
+    void finish() {
+      if(pending.valid()) pending.get();
+    }// end: finish
+
+  }; // end class: RasterWriter
+
+}// end namespace GeoStar
+
+
+#endif // RASTERSTREAM_HPP_
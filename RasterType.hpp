@@ -8,12 +8,18 @@
 
 
 #include <string>
+#include <cstdint>
+#include <limits>
+#include <complex>
 
 #include "H5Cpp.h"
 
 
 namespace GeoStar {
 
+  // complex types are named by their total size: COMPLEX_REAL64 is a pair of
+  // 32-bit floats, COMPLEX_INT16 a pair of 8-bit signed integers, and so on.
+  // They are stored as an HDF5 compound of two members, "re" and "im".
   enum RasterType {
     
     INT8U, INT8S, INT16U, INT16S, INT32U, INT32S, INT64U, INT64S,
@@ -23,9 +29,65 @@ namespace GeoStar {
     
   }; // end: RasterType
 
-  // yet to define complex types.....
+  // true for the COMPLEX_* types
+  inline bool is_complex(const RasterType &type) {
+    return type >= COMPLEX_INT16;
+  }// end: is_complex
+
+
+  // RasterTypeTraits<R>::type is the C++ type of a pixel of a raster of type R.
+  template<RasterType R> struct RasterTypeTraits;
+
+  template<> struct RasterTypeTraits<INT8U>  { typedef uint8_t  type; };
+  template<> struct RasterTypeTraits<INT8S>  { typedef int8_t   type; };
+  template<> struct RasterTypeTraits<INT16U> { typedef uint16_t type; };
+  template<> struct RasterTypeTraits<INT16S> { typedef int16_t  type; };
+  template<> struct RasterTypeTraits<INT32U> { typedef uint32_t type; };
+  template<> struct RasterTypeTraits<INT32S> { typedef int32_t  type; };
+  template<> struct RasterTypeTraits<INT64U> { typedef uint64_t type; };
+  template<> struct RasterTypeTraits<INT64S> { typedef int64_t  type; };
+  template<> struct RasterTypeTraits<REAL32> { typedef float    type; };
+  template<> struct RasterTypeTraits<REAL64> { typedef double   type; };
+  template<> struct RasterTypeTraits<COMPLEX_REAL64>  { typedef std::complex<float>  type; };
+  template<> struct RasterTypeTraits<COMPLEX_REAL128> { typedef std::complex<double> type; };
+  // complex integer rasters are read and written through std::complex<float> or <double> buffers.
+
+
+  // dispatch_raster_type: calls fn(T()) with T the pixel type of a raster of the given type,
+  //                       so a functor with a template operator() runs on the native type.
+  //                       Returns false, without calling fn, for the complex types, which
+  //                       the real-valued kernels do not handle.
+  template<typename Function>
+  bool dispatch_raster_type(const RasterType &type, Function &fn) {
+    switch(type) {
+    case INT8U:  fn(RasterTypeTraits<INT8U>::type());  return true;
+    case INT8S:  fn(RasterTypeTraits<INT8S>::type());  return true;
+    case INT16U: fn(RasterTypeTraits<INT16U>::type()); return true;
+    case INT16S: fn(RasterTypeTraits<INT16S>::type()); return true;
+    case INT32U: fn(RasterTypeTraits<INT32U>::type()); return true;
+    case INT32S: fn(RasterTypeTraits<INT32S>::type()); return true;
+    case INT64U: fn(RasterTypeTraits<INT64U>::type()); return true;
+    case INT64S: fn(RasterTypeTraits<INT64S>::type()); return true;
+    case REAL32: fn(RasterTypeTraits<REAL32>::type()); return true;
+    case REAL64: fn(RasterTypeTraits<REAL64>::type()); return true;
+    default:     return false;
+    }// end case
+  }// end: dispatch_raster_type
+
+
+  // saturate_cast: converts value to T the way HDF5 converts on write:
+  //                integers are truncated toward zero and clamped to the range of T,
+  //                and NaN becomes 0.
+  template<typename T>
+  inline T saturate_cast(const double &value) {
+    if(!std::numeric_limits<T>::is_integer) return static_cast<T>(value);
+    if(value != value) return 0;
+    if(value <= static_cast<double>(std::numeric_limits<T>::min())) return std::numeric_limits<T>::min();
+    if(value >= static_cast<double>(std::numeric_limits<T>::max())) return std::numeric_limits<T>::max();
+    return static_cast<T>(value);
+  }// end: saturate_cast
 
 }// end namespace GeoStar
 
 
-#endif // RASTER_HPP_
+#endif // RASTERTYPE_HPP_
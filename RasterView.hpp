@@ -0,0 +1,95 @@
+// RasterView.hpp
+//
+// read-only typed view of all the pixels of a raster: mapped straight
+// from the file when the raster is a plain array on disk, read into
+// memory otherwise.
+//
+//----------------------------------------
+#ifndef RASTERVIEW_HPP_
+#define RASTERVIEW_HPP_
+
+#include <vector>
+#include <memory>
+
+#include "Raster.hpp"
+#include "RasterSlice.hpp"
+
+
+namespace GeoStar {
+
+  /** \brief RasterView -- all the pixels of a raster as a read-only array of T
+
+    A contiguous, uncompressed raster is stored in its file as a plain array.  RasterView maps that array
+	(see Raster::map_file) and hands it out as const T*: no HDF5 read and no copy, pages are brought in
+	as they are touched, and every process viewing the same file shares them through the page cache.
+	Any other raster (chunked, compressed, of another type than T, ...) is read once, whole, into
+	memory, so code using the view works on every raster either way.
+
+    \see Raster::map_file, Raster::read, RasterLayout
+
+    \Par Example
+	Mean of a raster opened "readonly":
+	\code
+	GeoStar::File *file = new GeoStar::File("a1.h5", "readonly");
+	GeoStar::Image *img = file->open_image("landsat");
+	GeoStar::Raster *ras = img->open_raster("B07");
+
+	GeoStar::RasterView<float> view(ras);
+	double sum = 0;
+	for(long int y=0; y<view.get_ny(); ++y) {
+	  const float *row = view.row(y);
+	  for(long int x=0; x<view.get_nx(); ++x) sum += row[x];
+	}
+	std::cout << sum / (view.get_nx()*view.get_ny()) << std::endl;
+	\endcode
+
+    \Par Details
+	Make rasters meant to be viewed with RasterLayout(CONTIGUOUS), and view them as their own type
+	(float for REAL32, uint16_t for INT16U, ...).  The view keeps the mapping alive, not the Raster: the
+	Raster may be deleted first.  Writes to the raster after the view is made may not show in a mapped
+	view, and never show in a read one.
+  */
+  template<typename T>
+  class RasterView {
+
+  private:
+    long int nx;
+    long int ny;
+
+    // the mapped pixels, or copy when the raster could not be mapped:
+    std::shared_ptr<const char> mapping;
+    std::vector<T> copy;
+    const T *pixels;
+
+    RasterView(const RasterView &);
+    RasterView &operator=(const RasterView &);
+
+  public:
+    explicit RasterView(const Raster *ras) : nx(ras->get_nx()), ny(ras->get_ny()), pixels(NULL) {
+      mapping = ras->map_file(Raster::getHdf5Type<T>());
+      if(mapping) {
+        pixels = reinterpret_cast<const T *>(mapping.get());
+      } else {
+        copy.resize(nx*ny);
+        if(!copy.empty()) ras->read(RasterSlice(0, 0, nx, ny), copy.data(), copy.size());
+        pixels = copy.data();
+      }// endif
+    }
+
+    inline long int get_nx() const { return nx; }
+    inline long int get_ny() const { return ny; }
+
+    // is_mapped: true if the pixels come straight from the file, false if they were read
+    inline bool is_mapped() const { return (bool)mapping; }
+
+    // data: nx*ny pixels, row by row.  row: the nx pixels of row y.
+    inline const T *data() const { return pixels; }
+    inline const T *row(const long int &y) const { return pixels + y*nx; }
+    inline const T &operator()(const long int &x, const long int &y) const { return pixels[y*nx + x]; }
+
+  }; // end class: RasterView
+
+}// end namespace GeoStar
+
+
+#endif // RASTERVIEW_HPP_
@@ -0,0 +1,135 @@
+// Scratch.cpp
+//
+// Implementations for the temporary raster workspace
+// Documentation in Scratch.hpp
+//--------------------------------------------
+
+
+#include <string>
+#include <map>
+#include <unistd.h>
+
+#include "H5Cpp.h"
+#include "Exceptions.hpp"
+#include "File.hpp"
+#include "Image.hpp"
+#include "Raster.hpp"
+#include "RasterLayout.hpp"
+#include "Scratch.hpp"
+
+#include "boost/filesystem.hpp"
+
+
+namespace GeoStar {
+
+  // workspaces made so far, so their in-memory files get different names
+  static unsigned long scratch_count = 0;
+
+
+
+  Scratch::Scratch(const size_t &budgetBytes, const std::string &spillDirectory)
+    : budget(budgetBytes), memory_bytes(0), spill_bytes(0), count(0), memory_count(0), spill_count(0), directory(spillDirectory),
+      memory_file(NULL), memory_image(NULL), spill_file(NULL), spill_image(NULL) {
+  }// end-Scratch-constructor
+
+
+
+  Scratch::~Scratch() {
+    // a destructor can not report errors
+    try {
+      while(!temporaries.empty()) release(const_cast<Raster *>(temporaries.begin()->first));
+      close_memory();
+      close_spill();
+    } catch(...) {
+    }
+  }// end: ~Scratch
+
+
+
+  Raster *Scratch::create_raster(const RasterType &type, const int &nx, const int &ny, const RasterLayout &layout) {
+    Temporary temporary;
+    temporary.name = "scratch" + std::to_string(count++);
+    temporary.bytes = (size_t)nx * ny * Raster::getHdf5FileType(type).getSize();
+    temporary.in_memory = memory_bytes + temporary.bytes <= budget;
+
+    Raster *ras;
+    if(temporary.in_memory) {
+      if(memory_file == NULL) {
+        const std::string name = "geostar-scratch-" + std::to_string(getpid()) + "-" + std::to_string(scratch_count++);
+        memory_file = new File(name, "memory");
+        memory_image = memory_file->create_image("scratch");
+      }// endif
+      ras = memory_image->create_raster(temporary.name, type, nx, ny, RasterLayout(CONTIGUOUS));
+      memory_bytes += temporary.bytes;
+      ++memory_count;
+    } else {
+      if(spill_file == NULL) {
+        boost::filesystem::path dir = directory.empty() ? boost::filesystem::temp_directory_path()
+                                                        : boost::filesystem::path(directory);
+        spill_path = (dir / boost::filesystem::unique_path("geostar-scratch-%%%%-%%%%-%%%%.h5")).string();
+        spill_file = new File(spill_path, "new");
+        spill_image = spill_file->create_image("scratch");
+      }// endif
+      ras = spill_image->create_raster(temporary.name, type, nx, ny, layout);
+      spill_bytes += temporary.bytes;
+      ++spill_count;
+    }// endif
+
+    temporaries[ras] = temporary;
+    return ras;
+  }// end: create_raster
+
+
+
+  void Scratch::release(Raster *ras) {
+    RasterDestroyErrorException RasterDestroyError;
+    if(ras == NULL) return;
+
+    std::map<const Raster *, Temporary>::iterator entry = temporaries.find(ras);
+    if(entry == temporaries.end()) throw RasterDestroyError;
+    const Temporary temporary = entry->second;
+    temporaries.erase(entry);
+
+    // the raster drops its dataset first, so the link is the last reference to it:
+    delete ras;
+    if(temporary.in_memory) {
+      memory_bytes -= temporary.bytes;
+      memory_image->imageobj->unlink(temporary.name);
+      if(--memory_count == 0) close_memory();
+    } else {
+      spill_bytes -= temporary.bytes;
+      spill_image->imageobj->unlink(temporary.name);
+      if(--spill_count == 0) close_spill();
+    }// endif
+  }// end: release
+
+
+
+  void Scratch::close_memory() {
+    delete memory_image;
+    delete memory_file;
+    memory_image = NULL;
+    memory_file = NULL;
+  }// end: close_memory
+
+
+
+  void Scratch::close_spill() {
+    if(spill_file == NULL) return;
+    delete spill_image;
+    delete spill_file;
+    spill_image = NULL;
+    spill_file = NULL;
+    boost::filesystem::remove(boost::filesystem::path(spill_path));
+  }// end: close_spill
+
+
+
+  Scratch &Scratch::shared() {
+    // never deleted: its files are closed whenever it holds no temporaries, and deleting it at exit
+    // could run after the HDF5 library has shut down.
+    static Scratch *workspace = new Scratch();
+    return *workspace;
+  }// end: shared
+
+}// end namespace GeoStar
@@ -0,0 +1,176 @@
+// Scratch.hpp
+//
+// a workspace for temporary rasters: kept in an in-memory HDF5 file up
+// to a memory budget, in a scratch file on disk beyond it, and removed
+// when released.
+//
+//----------------------------------------
+#ifndef SCRATCH_HPP_
+#define SCRATCH_HPP_
+
+#include <string>
+#include <map>
+#include <cstddef>
+
+#include "RasterType.hpp"
+#include "RasterLayout.hpp"
+#include "Exceptions.hpp"
+
+
+namespace GeoStar {
+  class File;
+  class Image;
+  class Raster;
+
+  // bytes of temporaries a Scratch keeps in memory by default
+  const size_t SCRATCH_MEMORY_BYTES = 256*1024*1024;
+
+
+  /** \brief Scratch -- workspace for temporary rasters
+
+  Operations that need intermediate rasters (e.g. the complex buffer of Raster::FFT_2D) take them from a Scratch
+  instead of creating datasets in the caller's Image.  Each temporary gets a unique name, so the same operation
+  can run any number of times, and nothing is left in the user's file.
+
+ \see ScratchRaster, Scratch::shared, File
+
+ \Par Usage Overview
+
+  create_raster returns a new temporary; release deletes it and frees its storage.  ScratchRaster does both,
+  releasing when it goes out of scope, also when an exception is thrown.
+
+  Temporaries are kept in an in-memory HDF5 file (File access "memory") as long as they fit in the memory
+  budget.  A temporary that would exceed it goes to a scratch file in a temporary directory instead; the
+  scratch file is deleted as soon as it holds no temporaries.  Likewise the in-memory file is closed, and its
+  memory returned, when it is empty.
+
+ \Par Example
+  \code
+  GeoStar::ScratchRaster buffer(GeoStar::Scratch::shared(), GeoStar::COMPLEX_REAL64, nx, ny);
+  ras->FFT_2D(img, buffer.get());
+  // ... use buffer->read(...) ...
+  \endcode
+
+ \Par Details
+  Memory use is counted as the bytes of the pixels of the temporaries in memory.  Temporaries in memory are
+  contiguous; those in the scratch file are tiled (unless create_raster is given another layout), so both row
+  and column scans are cheap.
+  A Scratch, like the rest of GeoStar, is used from one thread at a time.
+  */
+  class Scratch {
+
+  private:
+    size_t budget;
+    size_t memory_bytes;
+    size_t spill_bytes;
+    unsigned long count;
+    // temporaries in memory, and in the scratch file: each is closed when its count drops to 0
+    unsigned long memory_count;
+    unsigned long spill_count;
+    std::string directory;
+
+    // the in-memory file and the scratch file, opened when first needed:
+    File *memory_file;
+    Image *memory_image;
+    File *spill_file;
+    Image *spill_image;
+    std::string spill_path;
+
+    struct Temporary {
+      std::string name;
+      size_t bytes;
+      bool in_memory;
+    };
+    std::map<const Raster *, Temporary> temporaries;
+
+    // close the in-memory file, or close and delete the scratch file
+    void close_memory();
+    void close_spill();
+
+    Scratch(const Scratch &);
+    Scratch &operator=(const Scratch &);
+
+  public:
+
+    /** \brief Scratch Constructor -- an empty workspace
+
+    \param[in] budgetBytes
+	Bytes of temporaries to keep in memory.  0 puts every temporary in the scratch file.
+
+    \param[in] spillDirectory
+	Directory for the scratch file; the system's temporary directory if empty.
+    */
+    Scratch(const size_t &budgetBytes = SCRATCH_MEMORY_BYTES, const std::string &spillDirectory = "");
+
+    // releases every temporary still held, and deletes the scratch file
+    ~Scratch();
+
+    /** \brief create_raster -- a new temporary raster
+
+    \param[in] type, nx, ny
+	As for Image::create_raster.
+
+    \param[in] layout
+	(Optional) layout of the temporary if it goes to the scratch file, TILED with the automatic size by default.
+	Temporaries in memory are always contiguous.
+
+    \returns
+	The raster, to be given back with release (or held by a ScratchRaster).
+
+    \Par Exceptions
+	RasterCreationError, and the File exceptions if the scratch file can not be created.
+    */
+    Raster *create_raster(const RasterType &type, const int &nx, const int &ny,
+                          const RasterLayout &layout = RasterLayout());
+
+    // release: deletes a temporary from create_raster and frees its storage.  NULL is ignored.
+    //          Throws RasterDestroyErrorException if ras is not a temporary of this workspace.
+    void release(Raster *ras);
+
+    // set_budget: bytes of new temporaries to keep in memory; those already made stay where they are
+    inline void set_budget(const size_t &budgetBytes) { budget = budgetBytes; }
+    inline size_t get_budget() const { return budget; }
+
+    // get_memory_bytes, get_spill_bytes: bytes of the temporaries now in memory, and in the scratch file
+    inline size_t get_memory_bytes() const { return memory_bytes; }
+    inline size_t get_spill_bytes() const { return spill_bytes; }
+
+    // shared: the workspace the Raster operations use.  Made the first time it is asked for.
+    static Scratch &shared();
+
+  }; // end class: Scratch
+
+
+
+  // ScratchRaster: a temporary of a Scratch, released when this goes out of scope
+  class ScratchRaster {
+
+  private:
+    Scratch &scratch;
+    Raster *ras;
+
+    ScratchRaster(const ScratchRaster &);
+    ScratchRaster &operator=(const ScratchRaster &);
+
+  public:
+    ScratchRaster(Scratch &workspace, const RasterType &type, const int &nx, const int &ny,
+                  const RasterLayout &layout = RasterLayout())
+      : scratch(workspace), ras(workspace.create_raster(type, nx, ny, layout)) {}
+
+    ~ScratchRaster() {
+      // a destructor can not report errors
+      try {
+        scratch.release(ras);
+      } catch(...) {
+      }
+    }
+
+    inline Raster *get() const { return ras; }
+    inline Raster *operator->() const { return ras; }
+
+  }; // end class: ScratchRaster
+
+}// end namespace GeoStar
+
+
+#endif // SCRATCH_HPP_
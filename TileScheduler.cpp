@@ -0,0 +1,180 @@
+// TileScheduler.cpp
+//
+// a pool of worker threads that runs a batch of independent tasks across
+// cores, with work stealing.
+//
+//-------------------------------------
+
+#include <deque>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <exception>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <algorithm>
+
+#include "TileScheduler.hpp"
+
+
+namespace GeoStar {
+
+  // the scheduler the current thread works for, NULL outside the workers:
+  static thread_local const TileScheduler *current_scheduler = NULL;
+
+
+
+  TileScheduler::TileScheduler(const unsigned nthreads)
+    : task(NULL), batch(0), active(0), running(0), failed(false), stopping(false) {
+    grow(std::max(nthreads, 1u));
+  }// end: TileScheduler
+
+
+
+  TileScheduler::~TileScheduler() {
+    {
+      std::lock_guard<std::mutex> guard(state_lock);
+      stopping = true;
+    }
+    batch_ready.notify_all();
+    for(size_t i=0; i<workers.size(); ++i) workers[i]->thread.join();
+  }// end: ~TileScheduler
+
+
+
+  void TileScheduler::grow(const unsigned n) {
+    while(workers.size() < n) {
+      workers.push_back(std::unique_ptr<Worker>(new Worker()));
+      const unsigned index = workers.size() - 1;
+      workers.back()->thread = std::thread(&TileScheduler::run_worker, this, index);
+    }// endwhile
+  }// end: grow
+
+
+
+  unsigned TileScheduler::size() const {
+    return workers.size();
+  }// end: size
+
+
+
+  void TileScheduler::run_worker(const unsigned index) {
+    current_scheduler = this;
+    unsigned long seen = 0;
+
+    std::unique_lock<std::mutex> guard(state_lock);
+    for(;;) {
+      while(!stopping && batch == seen) batch_ready.wait(guard);
+      if(stopping) return;
+      seen = batch;
+      if(index >= active) continue;
+
+      guard.unlock();
+      work(index);
+      guard.lock();
+      if(--running == 0) batch_done.notify_all();
+    }// endfor
+  }// end: run_worker
+
+
+
+  void TileScheduler::work(const unsigned index) {
+    long int t;
+    while(next_task(index, t)) {
+      {
+        std::lock_guard<std::mutex> guard(state_lock);
+        if(failed) continue;
+      }
+      try {
+        (*task)(t, index);
+      } catch(...) {
+        std::lock_guard<std::mutex> guard(state_lock);
+        if(!failed) error = std::current_exception();
+        failed = true;
+      }
+    }// endwhile
+  }// end: work
+
+
+
+  bool TileScheduler::next_task(const unsigned index, long int &t) {
+    {
+      Worker &own = *workers[index];
+      std::lock_guard<std::mutex> guard(own.tasks_lock);
+      if(!own.tasks.empty()) {
+        t = own.tasks.front();
+        own.tasks.pop_front();
+        return true;
+      }// endif
+    }
+
+    // steal, starting with the next worker so thieves spread out:
+    for(unsigned i=1; i<active; ++i) {
+      Worker &victim = *workers[(index + i) % active];
+      std::lock_guard<std::mutex> guard(victim.tasks_lock);
+      if(!victim.tasks.empty()) {
+        t = victim.tasks.back();
+        victim.tasks.pop_back();
+        return true;
+      }// endif
+    }// endfor: i
+    return false;
+  }// end: next_task
+
+
+
+  void TileScheduler::run(const long int &ntasks, const std::function<void(long int, unsigned)> &job,
+                          const unsigned &nthreads) {
+    if(ntasks < 1) return;
+
+    if(nthreads < 2 || ntasks == 1 || in_worker()) {
+      for(long int t=0; t<ntasks; ++t) job(t, 0);
+      return;
+    }// endif
+
+    std::lock_guard<std::mutex> serial(run_lock);
+    const unsigned n = std::min((long int)nthreads, ntasks);
+    grow(n);
+
+    // a run of consecutive tasks for each worker:
+    for(unsigned w=0; w<n; ++w) {
+      Worker &worker = *workers[w];
+      std::lock_guard<std::mutex> guard(worker.tasks_lock);
+      for(long int t=ntasks*w/n; t<ntasks*(w+1)/n; ++t) worker.tasks.push_back(t);
+    }// endfor: w
+
+    std::exception_ptr thrown;
+    {
+      std::unique_lock<std::mutex> guard(state_lock);
+      task = &job;
+      error = std::exception_ptr();
+      failed = false;
+      active = n;
+      running = n;
+      ++batch;
+      batch_ready.notify_all();
+      while(running > 0) batch_done.wait(guard);
+      task = NULL;
+      active = 0;
+      thrown = error;
+      error = std::exception_ptr();
+    }
+
+    if(thrown) std::rethrow_exception(thrown);
+  }// end: run
+
+
+
+  bool TileScheduler::in_worker() const {
+    return current_scheduler == this;
+  }// end: in_worker
+
+
+
+  TileScheduler &TileScheduler::shared() {
+    static TileScheduler scheduler(std::thread::hardware_concurrency());
+    return scheduler;
+  }// end: shared
+
+}// end namespace GeoStar
@@ -0,0 +1,100 @@
+// TileScheduler.hpp
+//
+// a pool of worker threads that runs a batch of independent tasks (the
+// tiles of a Raster operation) across cores, with work stealing.
+//
+// Tasks must not call HDF5 themselves: the library GeoStar links against
+// is not thread-safe, so tile reads and writes are handed to
+// IOThread::shared() (see Raster::set_threads).
+//
+//-------------------------------------
+#ifndef TILESCHEDULER_HPP_
+#define TILESCHEDULER_HPP_
+
+#include <deque>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <exception>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+
+namespace GeoStar {
+
+  class TileScheduler {
+
+  private:
+    // a worker and its own queue of task numbers; other workers steal from the back
+    struct Worker {
+      std::thread thread;
+      std::mutex tasks_lock;
+      std::deque<long int> tasks;
+    };
+    std::vector<std::unique_ptr<Worker> > workers;
+
+    // one batch at a time:
+    std::mutex run_lock;
+
+    // the batch being run, guarded by state_lock:
+    std::mutex state_lock;
+    std::condition_variable batch_ready;
+    std::condition_variable batch_done;
+    const std::function<void(long int, unsigned)> *task;
+    unsigned long batch;
+    unsigned active;
+    unsigned running;
+    std::exception_ptr error;
+    bool failed;
+    bool stopping;
+
+    // worker loop: takes part in every batch that has room for it until the destructor stops it
+    void run_worker(const unsigned index);
+
+    // runs the tasks of worker index, then steals from the others until none are left
+    void work(const unsigned index);
+
+    // next task for worker index: from the front of its own queue, else from the back of another's
+    bool next_task(const unsigned index, long int &t);
+
+    // starts workers until there are n
+    void grow(const unsigned n);
+
+    TileScheduler(const TileScheduler &);
+    TileScheduler &operator=(const TileScheduler &);
+
+  public:
+
+    // starts nthreads workers
+    explicit TileScheduler(const unsigned nthreads);
+
+    // stops and joins the workers; a batch must not be running
+    ~TileScheduler();
+
+    // size: number of worker threads
+    unsigned size() const;
+
+    // run: calls task(t, worker) once for every t in [0, ntasks) on nthreads workers, and returns when
+    //      all have run.  worker is the index (0 to nthreads-1) of the thread running the task, for
+    //      per-thread buffers.  Tasks are handed out in runs of consecutive numbers, one run per worker;
+    //      a worker that runs out steals from the end of another's.  Workers are started as needed.
+    //      The first exception thrown by a task is rethrown once every worker has stopped; the tasks
+    //      not yet started are then skipped.
+    //      With nthreads < 2, or when called from a task, the tasks are run in order on the calling
+    //      thread, so tasks can themselves call run without deadlocking.
+    void run(const long int &ntasks, const std::function<void(long int, unsigned)> &task,
+             const unsigned &nthreads);
+
+    // in_worker: true when called from one of the worker threads
+    bool in_worker() const;
+
+    // shared: the scheduler used by Raster operations.  Starts with one worker per core
+    //         (std::thread::hardware_concurrency) and grows when run asks for more.
+    static TileScheduler &shared();
+
+  }; // end class: TileScheduler
+
+}// end namespace GeoStar
+
+#endif // TILESCHEDULER_HPP_
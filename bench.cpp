@@ -0,0 +1,1590 @@
+// bench.cpp
+//
+// timings of Raster operations on synthetic data
+//
+// usage: bench [nx] [ny]             (sizes of 1 or more, 4096 by default)
+//        bench --suite [--sizes 512,2048,...,16384] [--types INT8U,INT16U,REAL32]
+//                      [--ops thresh,scale,...] [--json results.json]
+//
+// The first form runs the benchmarks of the individual optimizations.  The
+// suite times every Raster operation, Image::read_file and Map rendering
+// on square synthetic rasters of each size and type (512 and 2048, all
+// three types by default), with MPix/s, MB/s of HDF5 I/O, HDF5 read and
+// write calls and peak RSS, and writes them as JSON for comparing runs.
+//
+//---------------------------------------------------------
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <functional>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <thread>
+#include <sys/resource.h>
+
+#include "File.hpp"
+#include "Image.hpp"
+#include "Raster.hpp"
+#include "InMemoryRaster.hpp"
+#include "RasterView.hpp"
+#include "RasterPipeline.hpp"
+#include "RasterStream.hpp"
+#include "BandMath.hpp"
+#include "Scratch.hpp"
+#include "FFTPlans.hpp"
+#include "FrequencyFilter.hpp"
+#include "compression.hpp"
+#include "Map.hpp"
+
+#include "gdal_priv.h"
+#include "boost/filesystem.hpp"
+
+
+double seconds_since(const std::chrono::steady_clock::time_point &start);
+
+GeoStar::Raster *make_synthetic(GeoStar::Image *img, const std::string &name,
+                                const GeoStar::RasterType &type, const long int nx, const long int ny,
+                                const GeoStar::RasterLayout &layout = GeoStar::RasterLayout());
+
+void blockBenchmark(GeoStar::Image *img, GeoStar::Raster *ras);
+
+void sliceBenchmark(GeoStar::Raster *ras);
+
+void prefetchBenchmark(GeoStar::Image *img, const long int nx, const long int ny);
+
+void writeCacheBenchmark(GeoStar::Image *img, const long int nx, const long int ny);
+
+void nativeTypeBenchmark(GeoStar::Image *img, const long int nx, const long int ny);
+
+void complexFFTBenchmark(GeoStar::Image *img, const long int nx, const long int ny);
+
+void fftPathBenchmark(GeoStar::Image *img, const long int nx, const long int ny);
+
+void fftPlanBenchmark(GeoStar::Image *img, const long int nx, const long int ny);
+
+void fftThreadBenchmark(GeoStar::Image *img, const long int nx, const long int ny);
+
+void filterBenchmark(GeoStar::Image *img, const long int nx, const long int ny);
+
+void bandStackBenchmark(GeoStar::Image *img, const long int nx, const long int ny);
+
+void expressionBenchmark(GeoStar::Image *img, const long int nx, const long int ny);
+
+void bandMathBenchmark(GeoStar::Image *img, const long int nx, const long int ny);
+
+void inMemoryBenchmark(GeoStar::File *file, const long int nx, const long int ny);
+
+void layoutBenchmark(GeoStar::Image *img, const long int nx, const long int ny);
+
+void mappedScanBenchmark(GeoStar::Image *img, const long int nx, const long int ny);
+
+void threadBenchmark(GeoStar::Image *img, const long int nx, const long int ny);
+
+void pipelineBenchmark(GeoStar::Image *img, const long int nx, const long int ny);
+
+void compressionBenchmark(const long int nx, const long int ny);
+
+int suite(int argc, char *argv[]);
+
+
+const char * const BENCH_USAGE = "usage: bench [nx] [ny]\n"
+                          "       bench --suite [--sizes 512,2048,...] [--types INT8U,INT16U,REAL32] "
+                          "[--ops thresh,scale,...] [--json results.json]";
+
+// a raster size of 1 or more, the whole of text; false if it is not one
+bool parse_size(const std::string &text, long int &n) {
+  char *end = NULL;
+  n = std::strtol(text.c_str(), &end, 10);
+  return !text.empty() && *end == '\0' && n >= 1;
+}// end: parse_size
+
+
+int main(int argc, char *argv[]) {
+
+  if(argc > 1 && std::string(argv[1]) == "--suite") return suite(argc, argv);
+
+  long int size[2] = {4096, 4096};
+  for(int i=1; i<argc; ++i) {
+    if(i > 2 || !parse_size(argv[i], size[i-1])) {
+      std::cerr << ((i > 2 || argv[i][0] == '-') ? "unknown argument " : "bad size ") << argv[i] << std::endl
+                << BENCH_USAGE << std::endl;
+      return 1;
+    }// endif
+  }// endfor: i
+  const long int nx = size[0];
+  const long int ny = size[1];
+
+  // delete output file if already exists
+  boost::filesystem::path p("bench.h5");
+  boost::filesystem::remove(p);
+
+  GeoStar::File *file = new GeoStar::File("bench.h5", "new");
+  GeoStar::Image *img = file->create_image("bench");
+
+  GeoStar::Raster *ras = make_synthetic(img, "synthetic", GeoStar::REAL32, nx, ny);
+
+  blockBenchmark(img, ras);
+  sliceBenchmark(ras);
+  prefetchBenchmark(img, nx, ny);
+  writeCacheBenchmark(img, nx, ny);
+  nativeTypeBenchmark(img, nx, ny);
+  complexFFTBenchmark(img, nx, ny);
+  fftPathBenchmark(img, nx, ny);
+  fftPlanBenchmark(img, nx, ny);
+  fftThreadBenchmark(img, nx, ny);
+  filterBenchmark(img, nx, ny);
+  bandStackBenchmark(img, nx, ny);
+  expressionBenchmark(img, nx, ny);
+  bandMathBenchmark(img, nx, ny);
+  inMemoryBenchmark(file, nx, ny);
+  layoutBenchmark(img, nx, ny);
+  mappedScanBenchmark(img, nx, ny);
+  threadBenchmark(img, nx, ny);
+  pipelineBenchmark(img, nx, ny);
+  compressionBenchmark(nx, ny);
+
+  delete ras;
+  delete img;
+  delete file;
+
+  boost::filesystem::remove(p);
+  return 0;
+}// end-main
+
+
+
+double seconds_since(const std::chrono::steady_clock::time_point &start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}// end: seconds_since
+
+
+
+// fills a new raster with a repeating ramp, so every run sees the same data
+GeoStar::Raster *make_synthetic(GeoStar::Image *img, const std::string &name,
+                                const GeoStar::RasterType &type, const long int nx, const long int ny,
+                                const GeoStar::RasterLayout &layout) {
+  GeoStar::Raster *ras = img->create_raster(name, type, nx, ny, layout);
+
+  ras->for_each_block<float>(NULL, ras,
+    [](const std::vector<long int> &slice, std::vector<float> &data) {
+      for(long int j=0; j<slice[3]; ++j)
+        for(long int i=0; i<slice[2]; ++i)
+          data[j*slice[2]+i] = ((slice[1]+j)*7 + (slice[0]+i)*13) % 251;
+    });
+
+  return ras;
+}// end: make_synthetic
+
+
+
+// the same threshhold done one scanline per read/write and with for_each_block
+void blockBenchmark(GeoStar::Image *img, GeoStar::Raster *ras) {
+  long int nx = ras->get_nx();
+  long int ny = ras->get_ny();
+  double mpix = nx * ny / 1.0e6;
+
+  GeoStar::Raster *out = img->create_raster("blockBenchmark", GeoStar::REAL32, nx, ny);
+
+  // 1. row-wise, as the operations used to do:
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  std::vector<long int> slice(4);
+  slice[0]=0;  slice[1]=0;
+  slice[2]=nx; slice[3]=1;
+  std::vector<float> data(nx);
+  for(long int line=0; line<ny; ++line) {
+    slice[1] = line;
+    ras->read(slice, data);
+    for(long int pixel=0; pixel<nx; ++pixel) if(data[pixel] < 100) data[pixel] = 0;
+    out->write(slice, data);
+  }// endfor: line
+  double rowTime = seconds_since(start);
+
+  std::cout << "row-wise        : " << rowTime << " s, " << mpix/rowTime << " MPix/s" << std::endl;
+
+  // 2. block iterator, default bands and a few square tiles:
+  long int shapes[4][2] = {{0, 0}, {256, 256}, {512, 512}, {1024, 1024}};
+  for(int s=0; s<4; ++s) {
+    const long int *blockShape = (s == 0) ? NULL : shapes[s];
+    start = std::chrono::steady_clock::now();
+    ras->for_each_block<float>(blockShape, out,
+      [](const std::vector<long int> &slice, std::vector<float> &data) {
+        long int npixels = slice[2]*slice[3];
+        for(long int pixel=0; pixel<npixels; ++pixel) if(data[pixel] < 100) data[pixel] = 0;
+      });
+    double blockTime = seconds_since(start);
+
+    if(blockShape == NULL) std::cout << "blocks (default): ";
+    else std::cout << "blocks " << blockShape[0] << "x" << blockShape[1] << " : ";
+    std::cout << blockTime << " s, " << mpix/blockTime << " MPix/s, speedup "
+              << rowTime/blockTime << std::endl;
+  }// endfor: s
+
+  delete out;
+}// end: blockBenchmark
+
+
+
+// per-call cost of small reads: Raster::read (cached extent and dataspaces) against
+// building the dataspaces for every call, as read used to do, and of get_nx
+void sliceBenchmark(GeoStar::Raster *ras) {
+  const long int nx = ras->get_nx();
+  const long int ny = ras->get_ny();
+  const long int sizes[3] = {1, 8, 64};
+  const long int ncalls = 20000;
+
+  std::vector<float> data(64*64);
+
+  for(int s=0; s<3; ++s) {
+    const long int size = std::min(sizes[s], std::min(nx, ny));
+    if(size < 1) return;
+    const long int nxs = nx - size + 1;
+    const long int nys = ny - size + 1;
+
+    // 1. building a file and memory dataspace per call:
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(long int i=0; i<ncalls; ++i) {
+      hsize_t memdims[2] = {(hsize_t)size, (hsize_t)size};
+      H5::DataSpace memspace(2, memdims);
+      H5::DataSpace dataspace = ras->rasterobj->getSpace();
+      hsize_t offset[2] = {(hsize_t)((i*7) % nys), (hsize_t)((i*13) % nxs)};
+      dataspace.selectHyperslab(H5S_SELECT_SET, memdims, offset);
+      ras->rasterobj->read(&data[0], H5::PredType::NATIVE_FLOAT, memspace, dataspace);
+    }// endfor: i
+    double freshTime = seconds_since(start);
+
+    // 2. Raster::read:
+    start = std::chrono::steady_clock::now();
+    for(long int i=0; i<ncalls; ++i) {
+      GeoStar::RasterSlice slice((i*13) % nxs, (i*7) % nys, size, size);
+      ras->read(slice, &data[0], data.size());
+    }// endfor: i
+    double cachedTime = seconds_since(start);
+
+    std::cout << "read " << size << "x" << size << " slices: "
+              << 1.0e6*freshTime/ncalls << " us/call with new dataspaces, "
+              << 1.0e6*cachedTime/ncalls << " us/call cached" << std::endl;
+  }// endfor: s
+
+  // 3. get_nx, as called in loop conditions:
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  long int total = 0;
+  for(long int i=0; i<ncalls; ++i) total += ras->get_nx();
+  double nxTime = seconds_since(start);
+  std::cout << "get_nx: " << 1.0e9*nxTime/ncalls << " ns/call (" << total/ncalls << ")" << std::endl;
+
+}// end: sliceBenchmark
+
+
+
+// thresh, scale and gradientMask with for_each_block reading, processing and writing in turn,
+// and with reads and writes overlapped with the processing on the I/O thread
+void prefetchBenchmark(GeoStar::Image *img, const long int nx, const long int ny) {
+  const double mpix = nx * ny / 1.0e6;
+  const char *names[3] = {"thresh", "scale", "gradientMask"};
+
+  GeoStar::Raster *ras = make_synthetic(img, "prefetch_in", GeoStar::REAL32, nx, ny);
+  GeoStar::Raster *out = img->create_raster("prefetch_out", GeoStar::REAL32, nx, ny);
+
+  for(int op=0; op<3; ++op) {
+    double times[2];
+    for(int overlap=0; overlap<2; ++overlap) {
+      ras->set_prefetch(overlap == 1);
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      switch(op) {
+      case 0:
+        ras->thresh(100.0);
+        break;
+      case 1:
+        ras->scale(out, 10.0, 0.5);
+        break;
+      default:
+        ras->gradientMask(out, 1);
+        break;
+      }// end case
+      times[overlap] = seconds_since(start);
+    }// endfor: overlap
+
+    std::cout << names[op] << ": " << mpix/times[0] << " MPix/s in turn, "
+              << mpix/times[1] << " MPix/s overlapped, speedup " << times[0]/times[1] << std::endl;
+  }// endfor: op
+
+  delete out;
+  delete ras;
+}// end: prefetchBenchmark
+
+
+
+// many small circles and rectangles drawn straight to the file and through the write-back cache
+void writeCacheBenchmark(GeoStar::Image *img, const long int nx, const long int ny) {
+  const long int nshapes = 2000;
+  const double radius = 5;
+  if(nx < 4*radius || ny < 4*radius) return;
+
+  GeoStar::Raster *ras[2];
+  double times[2];
+  unsigned long writes[2];
+
+  for(int cached=0; cached<2; ++cached) {
+    ras[cached] = img->create_raster(cached ? "drawn_cached" : "drawn", GeoStar::REAL32, nx, ny);
+    ras[cached]->set_write_cache(cached == 1);
+
+    GeoStar::Raster::io_counters().reset();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(long int i=0; i<nshapes; ++i) {
+      long int x = radius + (i*37) % (nx - 3*(long int)radius);
+      long int y = radius + (i*91) % (ny - 3*(long int)radius);
+      if(i % 2) {
+        ras[cached]->drawFilledCircle(x, y, radius, i % 251);
+      } else {
+        std::vector<long int> slice(4);
+        slice[0] = x; slice[1] = y; slice[2] = 2*radius; slice[3] = 2*radius;
+        ras[cached]->drawRectangle(slice, 1, i % 251);
+      }// endif
+    }// endfor: i
+    ras[cached]->flush();
+    times[cached] = seconds_since(start);
+    writes[cached] = GeoStar::Raster::io_counters().write_calls;
+  }// endfor: cached
+
+  // both rasters must hold the same picture:
+  std::vector<long int> slice(4);
+  slice[0] = 0; slice[1] = 0; slice[2] = nx; slice[3] = ny;
+  std::vector<float> a, b;
+  ras[0]->read(slice, a);
+  ras[1]->read(slice, b);
+
+  std::cout << "draw " << nshapes << " shapes: " << writes[0] << " HDF5 writes, " << times[0] << " s direct; "
+            << writes[1] << " HDF5 writes, " << times[1] << " s cached"
+            << (a == b ? "" : " (RESULTS DIFFER)") << std::endl;
+
+  delete ras[0];
+  delete ras[1];
+}// end: writeCacheBenchmark
+
+
+
+// thresh, scale and add on INT8U and INT16U rasters: the operations, which run on the raster's
+// own type, against the same work done on float buffers as the operations used to
+void nativeTypeBenchmark(GeoStar::Image *img, const long int nx, const long int ny) {
+  const double mpix = nx * ny / 1.0e6;
+  const GeoStar::RasterType types[2] = {GeoStar::INT8U, GeoStar::INT16U};
+  const char *typeNames[2] = {"INT8U", "INT16U"};
+  const char *names[3] = {"thresh", "scale", "add"};
+
+  for(int t=0; t<2; ++t) {
+    std::string prefix = std::string("native_") + typeNames[t];
+    GeoStar::Raster *a = make_synthetic(img, prefix + "_a", types[t], nx, ny);
+    GeoStar::Raster *b = make_synthetic(img, prefix + "_b", types[t], nx, ny);
+    GeoStar::Raster *out = img->create_raster(prefix + "_out", types[t], nx, ny);
+
+    for(int op=0; op<3; ++op) {
+      // 1. float buffers, HDF5 converting on the way in and out:
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      switch(op) {
+      case 0:
+        out->for_each_block<float>(NULL, out,
+          [](const std::vector<long int> &slice, std::vector<float> &data) {
+            for(long int pixel=0; pixel<slice[2]*slice[3]; ++pixel) if(data[pixel] < 100) data[pixel] = 0;
+          });
+        break;
+      case 1:
+        a->for_each_block<float>(NULL, out,
+          [](const std::vector<long int> &slice, std::vector<float> &data) {
+            for(long int pixel=0; pixel<slice[2]*slice[3]; ++pixel) {
+              int i = 0.5*(data[pixel]-10.0);
+              data[pixel] = (i < 0) ? 0 : i;
+            }// endfor: pixel
+          });
+        break;
+      default:
+        a->for_each_block<float>(NULL, b, out,
+          [](const std::vector<long int> &slice, std::vector<float> &dataA, std::vector<float> &dataB) {
+            for(long int pixel=0; pixel<slice[2]*slice[3]; ++pixel) dataA[pixel] += dataB[pixel];
+          });
+        break;
+      }// end case
+      double floatTime = seconds_since(start);
+
+      // 2. the operation, on the native type:
+      start = std::chrono::steady_clock::now();
+      switch(op) {
+      case 0:
+        out->thresh(100);
+        break;
+      case 1:
+        a->scale(out, 10.0, 0.5);
+        break;
+      default:
+        a->add(b, out);
+        break;
+      }// end case
+      double nativeTime = seconds_since(start);
+
+      std::cout << typeNames[t] << " " << names[op] << ": " << mpix/floatTime << " MPix/s as float, "
+                << mpix/nativeTime << " MPix/s native, speedup " << floatTime/nativeTime << std::endl;
+    }// endfor: op
+
+    delete out;
+    delete b;
+    delete a;
+  }// endfor: t
+}// end: nativeTypeBenchmark
+
+
+
+// FFT_2D with two REAL32 outputs versus one COMPLEX_REAL64 output, and back.
+// At most 1024x1024 pixels, so the row and column passes stay short.
+void complexFFTBenchmark(GeoStar::Image *img, const long int nx, const long int ny) {
+  const long int fx = std::min(nx, 1024L);
+  const long int fy = std::min(ny, 1024L);
+  GeoStar::RasterIOCounters &counters = GeoStar::Raster::io_counters();
+
+  GeoStar::Raster *ras = make_synthetic(img, "fft_in", GeoStar::REAL32, fx, fy);
+  GeoStar::Raster *rasReal = img->create_raster("fft_real", GeoStar::REAL32, fx, fy);
+  GeoStar::Raster *rasImg = img->create_raster("fft_img", GeoStar::REAL32, fx, fy);
+  GeoStar::Raster *rasComplex = img->create_raster("fft_complex", GeoStar::COMPLEX_REAL64, fx, fy);
+  GeoStar::Raster *rasOut = img->create_raster("fft_out", GeoStar::REAL32, fx, fy);
+
+  counters.reset();
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  ras->FFT_2D(img, rasReal, rasImg);
+  double splitTime = seconds_since(start);
+  std::cout << "FFT_2D to real+imag rasters: " << splitTime << " s, "
+            << counters.read_calls << " reads, " << counters.write_calls << " writes" << std::endl;
+
+  counters.reset();
+  start = std::chrono::steady_clock::now();
+  ras->FFT_2D(img, rasComplex);
+  double complexTime = seconds_since(start);
+  std::cout << "FFT_2D to complex raster: " << complexTime << " s, "
+            << counters.read_calls << " reads, " << counters.write_calls << " writes" << std::endl;
+
+  counters.reset();
+  start = std::chrono::steady_clock::now();
+  rasComplex->FFT_2D_Inv(img, rasOut);
+  std::cout << "FFT_2D_Inv from complex raster: " << seconds_since(start) << " s, "
+            << counters.read_calls << " reads, " << counters.write_calls << " writes" << std::endl;
+
+  delete rasOut;
+  delete rasComplex;
+  delete rasImg;
+  delete rasReal;
+  delete ras;
+}// end: complexFFTBenchmark
+
+
+
+// FFT_2D as it was: a 1D FFT per row into out, then one read, FFT and write per 1-pixel-wide column of out
+void legacyFFT2D(const GeoStar::Raster *in, GeoStar::Raster *out) {
+  const long int nx = in->get_nx();
+  const long int ny = in->get_ny();
+
+  fftw_complex *rowIn = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * nx);
+  fftw_complex *rowOut = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * nx);
+  fftw_plan plan = fftw_plan_dft_1d(nx, rowIn, rowOut, FFTW_FORWARD, FFTW_ESTIMATE);
+  std::vector<double> data(nx);
+  for(long int y=0; y<ny; ++y) {
+    in->read(GeoStar::RasterSlice(0, y, nx, 1), &data[0], nx);
+    for(long int i=0; i<nx; ++i) {
+      rowIn[i][0] = data[i];
+      rowIn[i][1] = 0.0;
+    }
+    fftw_execute(plan);
+    out->write(GeoStar::RasterSlice(0, y, nx, 1), reinterpret_cast<const std::complex<double>*>(rowOut), nx);
+  }// endfor: y
+  fftw_destroy_plan(plan);
+  fftw_free(rowIn); fftw_free(rowOut);
+
+  fftw_complex *colIn = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * ny);
+  fftw_complex *colOut = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * ny);
+  plan = fftw_plan_dft_1d(ny, colIn, colOut, FFTW_FORWARD, FFTW_ESTIMATE);
+  for(long int x=0; x<nx; ++x) {
+    out->read(GeoStar::RasterSlice(x, 0, 1, ny), reinterpret_cast<std::complex<double>*>(colIn), ny);
+    fftw_execute(plan);
+    out->write(GeoStar::RasterSlice(x, 0, 1, ny), reinterpret_cast<const std::complex<double>*>(colOut), ny);
+  }// endfor: x
+  fftw_destroy_plan(plan);
+  fftw_free(colIn); fftw_free(colOut);
+}// end: legacyFFT2D
+
+
+
+// MB/s of writing then reading a contiguous COMPLEX_REAL64 raster in bands of whole rows, in the scratch
+// file's directory: the sequential rate an out-of-core FFT's I/O compares to.  Bytes as io_counters counts them.
+double sequentialRate(const long int nx, const long int ny) {
+  GeoStar::Scratch disk(0);
+  GeoStar::ScratchRaster ras(disk, GeoStar::COMPLEX_REAL64, nx, ny, GeoStar::RasterLayout(GeoStar::CONTIGUOUS));
+  const long int band = std::max(1L, GeoStar::RASTER_BLOCK_PIXELS / nx);
+  std::vector<std::complex<float> > data(band*nx, std::complex<float>(1, 2));
+  GeoStar::RasterIOCounters &counters = GeoStar::Raster::io_counters();
+
+  counters.reset();
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for(long int y=0; y<ny; y+=band)
+    ras->write(GeoStar::RasterSlice(0, y, nx, std::min(band, ny-y)), &data[0], nx*std::min(band, ny-y));
+  for(long int y=0; y<ny; y+=band)
+    ras->read(GeoStar::RasterSlice(0, y, nx, std::min(band, ny-y)), &data[0], nx*std::min(band, ny-y));
+  return (counters.bytes_read + counters.bytes_written) / 1e6 / seconds_since(start);
+}// end: sequentialRate
+
+
+
+// FFT_2D at 1k, 4k and 8k squares (those up to twice the benchmark size): the old row-then-column
+// algorithm, the in-memory r2c transform to a full and to a half spectrum, and the out-of-core
+// path forced by a memory budget of an eighth of what the in-memory one needs, its transpose in
+// the scratch file, with its I/O rate against sequentialRate.  All into COMPLEX_REAL64 rasters, from REAL32 ones:
+// in single precision.
+void fftPathBenchmark(GeoStar::Image *img, const long int nx, const long int ny) {
+  const long int sizes[3] = {1024, 4096, 8192};
+  GeoStar::RasterIOCounters &counters = GeoStar::Raster::io_counters();
+
+  for(int s=0; s<3; ++s) {
+    const long int n = sizes[s];
+    if(n > 2*std::max(nx, ny)) break;
+    const std::string size = std::to_string(n) + "x" + std::to_string(n);
+    const size_t smallBudget = (sizeof(float)*n + sizeof(fftwf_complex)*(n/2 + 1)) * n / 8;
+
+    GeoStar::Raster *ras = make_synthetic(img, "fft_path_in_" + size, GeoStar::REAL32, n, n);
+    GeoStar::Raster *full = img->create_raster("fft_path_full_" + size, GeoStar::COMPLEX_REAL64, n, n);
+    GeoStar::Raster *half = img->create_raster("fft_path_half_" + size, GeoStar::COMPLEX_REAL64, n/2 + 1, n);
+
+    const std::string names[4] = {"rows then 1-pixel columns", "in memory, full spectrum",
+                                  "in memory, half spectrum", "out of core, 1/8 of the memory"};
+    const size_t scratchBudget = GeoStar::Scratch::shared().get_budget();
+    double times[4];
+    for(int path=0; path<4; ++path) {
+      if(path == 3) {
+        GeoStar::Raster::set_fft_memory(smallBudget);
+        GeoStar::Scratch::shared().set_budget(0);
+      }// endif
+      counters.reset();
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      if(path == 0) legacyFFT2D(ras, full);
+      else ras->FFT_2D(img, (path == 2) ? half : full);
+      times[path] = seconds_since(start);
+
+      std::cout << "FFT_2D " << size << " " << names[path] << ": " << times[path] << " s, "
+                << counters.read_calls << " reads, " << counters.write_calls << " writes, speedup "
+                << times[0]/times[path] << std::endl;
+    }// endfor: path
+
+    const double megabytes = (counters.bytes_read + counters.bytes_written) / 1e6;
+    const double sequential = sequentialRate(n/2 + 1, n);
+    std::cout << "FFT_2D " << size << " out of core: " << megabytes << " MB read and written at "
+              << megabytes/times[3] << " MB/s, " << 100*megabytes/times[3]/sequential
+              << "% of sequential " << sequential << " MB/s" << std::endl;
+    GeoStar::Raster::set_fft_memory(GeoStar::RASTER_FFT_MEMORY);
+    GeoStar::Scratch::shared().set_budget(scratchBudget);
+
+    delete half;
+    delete full;
+    delete ras;
+  }// endfor: s
+}// end: fftPathBenchmark
+
+
+
+
+// FFT_2D over a batch of 16 same-sized scenes (up to 1024 square), at FFT_ESTIMATE and FFT_MEASURE: the
+// first transform, planning included; the time per transform over the batch with the plans of FFTPlans; the
+// time per transform planning each afresh, without wisdom, as FFT_2D used to; and the first transform of a
+// next run, its plan from the wisdom file.
+void fftPlanBenchmark(GeoStar::Image *img, const long int nx, const long int ny) {
+  const int batch = 16;
+  const long int n = std::min(std::max(nx, ny), 1024L);
+  const std::string size = std::to_string(n) + "x" + std::to_string(n);
+  GeoStar::FFTPlans &plans = GeoStar::FFTPlans::shared();
+
+  std::vector<GeoStar::Raster *> scenes(batch);
+  for(int i=0; i<batch; ++i)
+    scenes[i] = make_synthetic(img, "fft_plan_in_" + std::to_string(i), GeoStar::REAL32, n, n);
+  GeoStar::Raster *half = img->create_raster("fft_plan_half", GeoStar::COMPLEX_REAL64, n/2 + 1, n);
+
+  const GeoStar::FFTEffort efforts[2] = {GeoStar::FFT_ESTIMATE, GeoStar::FFT_MEASURE};
+  const std::string names[2] = {"estimate", "measure"};
+  for(int e=0; e<2; ++e) {
+    plans.set_effort(efforts[e]);
+    plans.clear();
+    fftw_forget_wisdom();
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    scenes[0]->FFT_2D(img, half);
+    const double first = seconds_since(start);
+    for(int i=1; i<batch; ++i) scenes[i]->FFT_2D(img, half);
+    const double cached = seconds_since(start) / batch;
+
+    start = std::chrono::steady_clock::now();
+    for(int i=0; i<batch; ++i) {
+      plans.clear();
+      fftw_forget_wisdom();
+      scenes[i]->FFT_2D(img, half);
+    }// endfor: i
+    const double uncached = seconds_since(start) / batch;
+
+    // the wisdom the last plans left in the file, as the next run reads it:
+    plans.clear();
+    fftw_forget_wisdom();
+    fftw_import_wisdom_from_filename(plans.get_wisdom_file().c_str());
+    start = std::chrono::steady_clock::now();
+    scenes[0]->FFT_2D(img, half);
+    const double wise = seconds_since(start);
+
+    std::cout << "FFT_2D " << size << " " << names[e] << ": first " << first << " s, " << cached
+              << " s per transform over " << batch << " with cached plans, " << uncached
+              << " s planning each, speedup " << uncached/cached << ", next run first " << wise << " s"
+              << std::endl;
+  }// endfor: e
+  plans.set_effort(GeoStar::FFT_ESTIMATE);
+  boost::filesystem::remove(plans.get_wisdom_file());
+
+  delete half;
+  for(int i=0; i<batch; ++i) delete scenes[i];
+}// end: fftPlanBenchmark
+
+
+
+
+// FFT_2D of the benchmark raster in double precision (REAL64 to COMPLEX_REAL128) and in single precision (REAL32
+// to COMPLEX_REAL64), in memory, on 1, 2, 4, ... threads up to the number of cores: time and speedup over one
+// thread and over double precision on one thread.  Plans are made before timing.
+void fftThreadBenchmark(GeoStar::Image *img, const long int nx, const long int ny) {
+  GeoStar::FFTPlans &plans = GeoStar::FFTPlans::shared();
+  const int cores = std::max((int)std::thread::hardware_concurrency(), 1);
+
+  const GeoStar::RasterType inTypes[2] = {GeoStar::REAL64, GeoStar::REAL32};
+  const GeoStar::RasterType outTypes[2] = {GeoStar::COMPLEX_REAL128, GeoStar::COMPLEX_REAL64};
+  const std::string names[2] = {"double", "single"};
+  double base = 0;
+  for(int p=0; p<2; ++p) {
+    GeoStar::Raster *ras = make_synthetic(img, "fft_threads_in_" + names[p], inTypes[p], nx, ny);
+    GeoStar::Raster *half = img->create_raster("fft_threads_half_" + names[p], outTypes[p], nx/2 + 1, ny);
+
+    double one = 0;
+    for(int threads=1; ; threads = std::min(2*threads, cores)) {
+      plans.set_threads(threads);
+      ras->FFT_2D(img, half);
+
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      ras->FFT_2D(img, half);
+      const double time = seconds_since(start);
+      if(threads == 1) one = time;
+      if(p == 0 && threads == 1) base = time;
+
+      std::cout << "FFT_2D " << nx << "x" << ny << " " << names[p] << " precision, " << threads << " threads: "
+                << time << " s, speedup " << one/time << " over 1 thread, " << base/time
+                << " over double on 1 thread" << std::endl;
+      if(threads == cores) break;
+    }// endfor: threads
+
+    delete half;
+    delete ras;
+  }// endfor: p
+  plans.set_threads(1);
+}// end: fftThreadBenchmark
+
+
+
+
+// a low pass of the benchmark raster (REAL32), in memory and with an eighth of the memory it needs: the way
+// lowPassFilter used to, FFT_2D to real and imaginary REAL64 rasters, zeroing part of them and FFT_2D_Inv back,
+// against frequencyFilter, which filters the spectrum on its way back and writes no raster of it.  Time,
+// HDF5 reads and writes, and speedup.
+void filterBenchmark(GeoStar::Image *img, const long int nx, const long int ny) {
+  GeoStar::RasterIOCounters &counters = GeoStar::Raster::io_counters();
+  const size_t smallBudget = (sizeof(float)*nx + sizeof(fftwf_complex)*(nx/2 + 1)) * ny / 8;
+  const size_t scratchBudget = GeoStar::Scratch::shared().get_budget();
+  const GeoStar::FrequencyFilter filter = GeoStar::FrequencyFilter::lowPass(0.2, GeoStar::FILTER_BUTTERWORTH);
+
+  GeoStar::Raster *ras = make_synthetic(img, "filter_in", GeoStar::REAL32, nx, ny);
+  GeoStar::Raster *re = img->create_raster("filter_re", GeoStar::REAL64, nx, ny);
+  GeoStar::Raster *im = img->create_raster("filter_im", GeoStar::REAL64, nx, ny);
+  GeoStar::Raster *out = img->create_raster("filter_out", GeoStar::REAL32, nx, ny);
+  const long int width = nx / 5;
+  const long int square[4] = {width, width, width, width};
+
+  const std::string where[2] = {"in memory", "out of core, 1/8 of the memory"};
+  for(int pass=0; pass<2; ++pass) {
+    GeoStar::Raster::set_fft_memory(pass == 0 ? GeoStar::RASTER_FFT_MEMORY : smallBudget);
+    GeoStar::Scratch::shared().set_budget(pass == 0 ? scratchBudget : 0);
+
+    counters.reset();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    ras->FFT_2D(img, re, im);
+    re->set(square, 0);
+    im->set(square, 0);
+    re->FFT_2D_Inv(img, out, im);
+    const double legacy = seconds_since(start);
+    std::cout << "low pass " << nx << "x" << ny << " " << where[pass] << ", through spectrum rasters: " << legacy
+              << " s, " << counters.read_calls << " reads, " << counters.write_calls << " writes" << std::endl;
+
+    counters.reset();
+    start = std::chrono::steady_clock::now();
+    ras->frequencyFilter(out, filter);
+    const double time = seconds_since(start);
+    std::cout << "low pass " << nx << "x" << ny << " " << where[pass] << ", frequencyFilter: " << time << " s, "
+              << counters.read_calls << " reads, " << counters.write_calls << " writes, speedup " << legacy/time
+              << std::endl;
+  }// endfor: pass
+  GeoStar::Raster::set_fft_memory(GeoStar::RASTER_FFT_MEMORY);
+  GeoStar::Scratch::shared().set_budget(scratchBudget);
+
+  delete out;
+  delete im;
+  delete re;
+  delete ras;
+}// end: filterBenchmark
+
+
+
+// a per-pixel index over 4 bands: one Raster per band versus one BandStack
+void bandStackBenchmark(GeoStar::Image *img, const long int nx, const long int ny) {
+  const long int nbands = 4;
+  const double mpix = nx * ny / 1.0e6;
+  GeoStar::RasterIOCounters &counters = GeoStar::Raster::io_counters();
+
+  GeoStar::Raster *bands[nbands];
+  GeoStar::BandStack *stack = img->create_bandstack("stack", GeoStar::INT16U, nbands, nx, ny);
+  long int blockShape[2];
+  stack->default_block_shape(blockShape);
+  for(long int b=0; b<nbands; ++b) {
+    bands[b] = make_synthetic(img, "band" + std::to_string(b), GeoStar::INT16U, nx, ny);
+    std::vector<uint16_t> rows(nx*blockShape[1]);
+    for(long int y=0; y<ny; y+=blockShape[1]) {
+      GeoStar::RasterSlice slice(0, y, nx, std::min(blockShape[1], ny-y));
+      bands[b]->read(slice, &rows[0], rows.size());
+      stack->write_band(b, slice, &rows[0], rows.size());
+    }// endfor: y
+  }// endfor: b
+  GeoStar::Raster *out = img->create_raster("stack_out", GeoStar::REAL32, nx, ny);
+
+  // 1. separate rasters: one read per band per block
+  std::vector<float> data[nbands];
+  std::vector<float> result(blockShape[0]*blockShape[1]);
+  counters.reset();
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for(long int y=0; y<ny; y+=blockShape[1]) {
+    for(long int x=0; x<nx; x+=blockShape[0]) {
+      GeoStar::RasterSlice slice(x, y, std::min(blockShape[0], nx-x), std::min(blockShape[1], ny-y));
+      for(long int b=0; b<nbands; ++b) {
+        data[b].resize(slice.size());
+        bands[b]->read(slice, &data[b][0], data[b].size());
+      }// endfor: b
+      for(long int i=0; i<slice.size(); ++i) {
+        const float sum = data[2][i] + data[3][i];
+        result[i] = (sum != 0) ? (data[3][i] - data[2][i]) / sum : 0;
+      }// endfor: i
+      out->write(slice, &result[0], result.size());
+    }// endfor: x
+  }// endfor: y
+  double rasterTime = seconds_since(start);
+  unsigned long rasterReads = counters.read_calls;
+
+  // 2. band stack: one read of every band per block
+  counters.reset();
+  start = std::chrono::steady_clock::now();
+  stack->for_each_block<float>(blockShape, out,
+    [nbands](const std::vector<long int> &slice, const std::vector<float> &pixels, std::vector<float> &outData) {
+      for(long int i=0; i<slice[2]*slice[3]; ++i) {
+        const float red = pixels[i*nbands+2];
+        const float nir = pixels[i*nbands+3];
+        outData[i] = (nir+red != 0) ? (nir-red)/(nir+red) : 0;
+      }// endfor: i
+    });
+  double stackTime = seconds_since(start);
+
+  std::cout << "4-band index, separate rasters: " << mpix/rasterTime << " MPix/s, " << rasterReads << " reads" << std::endl;
+  std::cout << "4-band index, band stack (BIP): " << mpix/stackTime << " MPix/s, " << counters.read_calls << " reads" << std::endl;
+
+  delete out;
+  for(long int b=0; b<nbands; ++b) delete bands[b];
+  delete stack;
+}// end: bandStackBenchmark
+
+
+
+// (a + b) * 0.5 - c / d: one raster per operator, as the operators used to work,
+// versus the fused expression assigned to one output raster
+void expressionBenchmark(GeoStar::Image *img, const long int nx, const long int ny) {
+  const double mpix = nx * ny / 1.0e6;
+  GeoStar::RasterIOCounters &counters = GeoStar::Raster::io_counters();
+
+  GeoStar::Raster *a = make_synthetic(img, "expr_a", GeoStar::REAL32, nx, ny);
+  GeoStar::Raster *b = make_synthetic(img, "expr_b", GeoStar::REAL32, nx, ny);
+  GeoStar::Raster *c = make_synthetic(img, "expr_c", GeoStar::REAL32, nx, ny);
+  GeoStar::Raster *d = make_synthetic(img, "expr_d", GeoStar::REAL32, nx, ny);
+  GeoStar::Raster *out = img->create_raster("expr_out", GeoStar::REAL32, nx, ny);
+
+  // 1. one operator at a time, each into a new raster:
+  counters.reset();
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  GeoStar::Raster *sum = *a + *b;
+  GeoStar::Raster *half = *sum * 0.5f;
+  GeoStar::Raster *ratio = *c / *d;
+  GeoStar::Raster *result = *half - *ratio;
+  double chainedTime = seconds_since(start);
+  unsigned long long chainedBytes = counters.bytes_read + counters.bytes_written;
+
+  // 2. the whole expression in one pass:
+  counters.reset();
+  start = std::chrono::steady_clock::now();
+  *out = (*a + *b) * 0.5f - *c / *d;
+  double fusedTime = seconds_since(start);
+  unsigned long long fusedBytes = counters.bytes_read + counters.bytes_written;
+
+  std::cout << "(a+b)*0.5-c/d, one raster per operator: " << mpix/chainedTime << " MPix/s, "
+            << chainedBytes/1.0e6 << " MB moved, 4 rasters created" << std::endl;
+  std::cout << "(a+b)*0.5-c/d, fused: " << mpix/fusedTime << " MPix/s, "
+            << fusedBytes/1.0e6 << " MB moved, speedup " << chainedTime/fusedTime << std::endl;
+
+  delete result;
+  delete ratio;
+  delete half;
+  delete sum;
+  delete out;
+  delete d;
+  delete c;
+  delete b;
+  delete a;
+}// end: expressionBenchmark
+
+
+
+// NDVI chained through subtract, add and divide, and as one BandMath formula
+void bandMathBenchmark(GeoStar::Image *img, const long int nx, const long int ny) {
+  const double mpix = nx * ny / 1.0e6;
+  GeoStar::RasterIOCounters &counters = GeoStar::Raster::io_counters();
+
+  GeoStar::Raster *red = make_synthetic(img, "bandmath_red", GeoStar::REAL32, nx, ny);
+  GeoStar::Raster *nir = make_synthetic(img, "bandmath_nir", GeoStar::REAL32, nx, ny);
+  GeoStar::Raster *diff = img->create_raster("bandmath_diff", GeoStar::REAL32, nx, ny);
+  GeoStar::Raster *sum = img->create_raster("bandmath_sum", GeoStar::REAL32, nx, ny);
+  GeoStar::Raster *out = img->create_raster("bandmath_out", GeoStar::REAL32, nx, ny);
+
+  // 1. one pass per operation:
+  counters.reset();
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  nir->subtract(red, diff);
+  nir->add(red, sum);
+  diff->divide(sum, out);
+  double chainedTime = seconds_since(start);
+  unsigned long long chainedBytes = counters.bytes_read + counters.bytes_written;
+
+  // 2. the formula, one pass:
+  GeoStar::BandMath ndvi("(nir - red) / (nir + red)");
+  ndvi.set_input("nir", nir);
+  ndvi.set_input("red", red);
+  counters.reset();
+  start = std::chrono::steady_clock::now();
+  ndvi.evaluate(out);
+  double fusedTime = seconds_since(start);
+  unsigned long long fusedBytes = counters.bytes_read + counters.bytes_written;
+
+  std::cout << "NDVI, subtract/add/divide: " << mpix/chainedTime << " MPix/s, "
+            << chainedBytes/1.0e6 << " MB moved" << std::endl;
+  std::cout << "NDVI, BandMath: " << mpix/fusedTime << " MPix/s, "
+            << fusedBytes/1.0e6 << " MB moved, speedup " << chainedTime/fusedTime << std::endl;
+
+  delete out;
+  delete sum;
+  delete diff;
+  delete nir;
+  delete red;
+}// end: bandMathBenchmark
+
+
+
+// a 4-level gaussianPyramid and a thresh->scale->gradientMask chain, on rasters in the file
+// and on InMemoryRasters loaded with one read and stored with one write per result
+void inMemoryBenchmark(GeoStar::File *file, const long int nx, const long int ny) {
+  const int levels = 4;
+  GeoStar::RasterIOCounters &counters = GeoStar::Raster::io_counters();
+
+  // pyramid levels have fixed names, so each way gets its own image:
+  GeoStar::Image *fileImg = file->create_image("in_file");
+  GeoStar::Image *memImg = file->create_image("in_memory");
+  GeoStar::Raster *src = make_synthetic(fileImg, "src", GeoStar::REAL32, nx, ny);
+  GeoStar::Raster *src2 = make_synthetic(memImg, "src", GeoStar::REAL32, nx, ny);
+
+  // 1. gaussianPyramid, levels in the file:
+  counters.reset();
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  std::vector<GeoStar::Raster *> pyramid = src->gaussianPyramid(fileImg, levels);
+  double fileTime = seconds_since(start);
+  unsigned long long fileCalls = counters.read_calls + counters.write_calls;
+  for(int i=1; i<=levels; ++i) delete pyramid[i];
+
+  // 2. gaussianPyramid in memory, then every level stored:
+  counters.reset();
+  start = std::chrono::steady_clock::now();
+  GeoStar::InMemoryRaster *mem = src2->load();
+  pyramid = mem->gaussianPyramid(NULL, levels);
+  for(int i=1; i<=levels; ++i) {
+    delete static_cast<GeoStar::InMemoryRaster *>(pyramid[i])->store(memImg);
+    delete pyramid[i];
+  }// endfor: i
+  double memTime = seconds_since(start);
+  unsigned long long memCalls = counters.read_calls + counters.write_calls;
+  delete mem;
+
+  std::cout << "gaussianPyramid(" << levels << "), in the file: " << fileTime << " s, "
+            << fileCalls << " HDF5 calls" << std::endl;
+  std::cout << "gaussianPyramid(" << levels << "), in memory: " << memTime << " s, "
+            << memCalls << " HDF5 calls, speedup " << fileTime/memTime << std::endl;
+
+  // 3. thresh -> scale -> gradientMask on rasters in the file:
+  GeoStar::Raster *scaled = fileImg->create_raster("scaled", GeoStar::REAL32, nx, ny);
+  GeoStar::Raster *edges = fileImg->create_raster("edges", GeoStar::REAL32, nx, ny);
+  counters.reset();
+  start = std::chrono::steady_clock::now();
+  src->thresh(100);
+  src->scale(scaled, 0, 2);
+  scaled->gradientMask(edges, 1);
+  fileTime = seconds_since(start);
+  fileCalls = counters.read_calls + counters.write_calls;
+
+  // 4. the same chain in memory, only the result stored:
+  GeoStar::InMemoryRaster memScaled("scaled", GeoStar::REAL32, nx, ny);
+  GeoStar::InMemoryRaster memEdges("edges", GeoStar::REAL32, nx, ny);
+  counters.reset();
+  start = std::chrono::steady_clock::now();
+  mem = src2->load();
+  mem->thresh(100);
+  mem->scale(&memScaled, 0, 2);
+  memScaled.gradientMask(&memEdges, 1);
+  delete memEdges.store(memImg);
+  memTime = seconds_since(start);
+  memCalls = counters.read_calls + counters.write_calls;
+
+  std::cout << "thresh->scale->gradientMask, in the file: " << nx*ny/1.0e6/fileTime << " MPix/s, "
+            << fileCalls << " HDF5 calls" << std::endl;
+  std::cout << "thresh->scale->gradientMask, in memory: " << nx*ny/1.0e6/memTime << " MPix/s, "
+            << memCalls << " HDF5 calls, speedup " << fileTime/memTime << std::endl;
+
+  delete mem;
+  delete edges;
+  delete scaled;
+  delete src2;
+  delete src;
+  delete memImg;
+  delete fileImg;
+}// end: inMemoryBenchmark
+
+
+
+// row, column and tile scans of the same data stored with each layout
+void layoutBenchmark(GeoStar::Image *img, const long int nx, const long int ny) {
+  const char *names[3] = {"contiguous", "row-chunked", "tiled"};
+  GeoStar::RasterLayout layouts[3] = {GeoStar::RasterLayout(GeoStar::CONTIGUOUS),
+                                      GeoStar::RasterLayout(GeoStar::ROW_CHUNKED),
+                                      GeoStar::RasterLayout(GeoStar::TILED)};
+  // columns are slow on some layouts, only scan the first few:
+  const long int ncols = std::min(nx, 512L);
+  const long int tile = 256;
+
+  std::vector<long int> slice(4);
+  std::vector<float> data;
+
+  for(int l=0; l<3; ++l) {
+    GeoStar::Raster *ras = make_synthetic(img, std::string("layout_")+names[l], GeoStar::REAL32, nx, ny, layouts[l]);
+    long int chunk[2];
+    ras->get_chunk_shape(chunk);
+
+    // 1. rows, one per read:
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    slice[0]=0;  slice[2]=nx; slice[3]=1;
+    for(long int y=0; y<ny; ++y) {
+      slice[1] = y;
+      ras->read(slice, data);
+    }// endfor: y
+    double rowTime = seconds_since(start);
+
+    // 2. columns, one per read:
+    start = std::chrono::steady_clock::now();
+    slice[1]=0; slice[2]=1; slice[3]=ny;
+    for(long int x=0; x<ncols; ++x) {
+      slice[0] = x;
+      ras->read(slice, data);
+    }// endfor: x
+    double colTime = seconds_since(start);
+
+    // 3. square tiles:
+    start = std::chrono::steady_clock::now();
+    for(long int y=0; y<ny; y+=tile) {
+      for(long int x=0; x<nx; x+=tile) {
+        slice[0]=x; slice[1]=y;
+        slice[2]=std::min(tile, nx-x); slice[3]=std::min(tile, ny-y);
+        ras->read(slice, data);
+      }// endfor: x
+    }// endfor: y
+    double tileTime = seconds_since(start);
+
+    std::cout << names[l] << " (chunk " << chunk[0] << "x" << chunk[1] << "): "
+              << "rows " << nx*ny/1.0e6/rowTime << " MPix/s, "
+              << "columns " << ncols*ny/1.0e6/colTime << " MPix/s, "
+              << "tiles " << nx*ny/1.0e6/tileTime << " MPix/s" << std::endl;
+    delete ras;
+  }// endfor: l
+
+}// end: layoutBenchmark
+
+
+
+// sum of every pixel of a contiguous raster: one whole read, tiles, and a mapped RasterView
+void mappedScanBenchmark(GeoStar::Image *img, const long int nx, const long int ny) {
+  GeoStar::Raster *ras = make_synthetic(img, "mapped", GeoStar::REAL32, nx, ny,
+                                        GeoStar::RasterLayout(GeoStar::CONTIGUOUS));
+  ras->flush();
+  double mpix = nx * ny / 1.0e6;
+
+  // 1. the whole raster in one read:
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  std::vector<float> all(nx*ny);
+  ras->read(GeoStar::RasterSlice(0, 0, nx, ny), &all[0], all.size());
+  double readSum = 0;
+  for(size_t i=0; i<all.size(); ++i) readSum += all[i];
+  double readTime = seconds_since(start);
+  std::vector<float>().swap(all);
+
+  // 2. tile by tile:
+  start = std::chrono::steady_clock::now();
+  long int window[4] = {0, 0, nx, ny};
+  long int shape[2];
+  ras->default_block_shape(shape);
+  GeoStar::RasterReader<float> reader(ras, window, shape);
+  std::vector<long int> slice(4);
+  std::vector<float> data;
+  double blockSum = 0;
+  while(reader.next(slice, data))
+    for(long int i=0; i<slice[2]*slice[3]; ++i) blockSum += data[i];
+  double blockTime = seconds_since(start);
+
+  // 3. mapped; making the view flushes a writable file, timed on its own:
+  start = std::chrono::steady_clock::now();
+  double viewSum = 0;
+  bool mapped;
+  double openTime;
+  double viewTime;
+  {
+    GeoStar::RasterView<float> view(ras);
+    mapped = view.is_mapped();
+    openTime = seconds_since(start);
+    start = std::chrono::steady_clock::now();
+    for(long int y=0; y<ny; ++y) {
+      const float *row = view.row(y);
+      for(long int x=0; x<nx; ++x) viewSum += row[x];
+    }// endfor: y
+    viewTime = seconds_since(start);
+  }
+
+  std::cout << "scan: whole read " << mpix/readTime << " MPix/s, "
+            << "tiles " << mpix/blockTime << " MPix/s, "
+            << (mapped ? "mapped " : "view (not mapped!) ") << mpix/viewTime << " MPix/s"
+            << " (+" << openTime << " s to make the view)";
+  if(readSum != blockSum || readSum != viewSum) std::cout << " -- SUMS DIFFER";
+  std::cout << std::endl;
+
+  delete ras;
+}// end: mappedScanBenchmark
+
+
+
+// ratio and speed of every codec on scene-like REAL32 data: smooth terrain plus sensor noise
+void compressionBenchmark(const long int nx, const long int ny) {
+  std::vector<float> sample((size_t)nx*ny);
+  unsigned int seed = 12345;
+  for(long int y=0; y<ny; ++y) {
+    for(long int x=0; x<nx; ++x) {
+      seed = seed*1103515245 + 12345;
+      float noise = ((seed >> 16) % 64) / 8.0f;
+      sample[y*nx+x] = 1000 + 400*sin(x/97.0)*cos(y/61.0) + noise;
+    }// endfor: x
+  }// endfor: y
+
+  std::vector<GeoStar::CompressionReport> reports =
+    GeoStar::measure_compression(&sample[0], H5::PredType::NATIVE_FLOAT, nx, ny);
+
+  for(size_t i=0; i<reports.size(); ++i) {
+    std::cout << "compression " << GeoStar::compression_name(reports[i].codec) << ": ";
+    if(!reports[i].available) {
+      std::cout << "not available" << std::endl;
+      continue;
+    }// endif
+    std::cout << "ratio " << reports[i].ratio
+              << ", compress " << reports[i].compressMBs << " MB/s"
+              << ", decompress " << reports[i].decompressMBs << " MB/s" << std::endl;
+  }// endfor: i
+
+  std::cout << "compression auto picks: "
+            << GeoStar::compression_name(GeoStar::select_compression(reports)) << std::endl;
+}// end: compressionBenchmark
+
+
+
+// thresh, scale, add and midpointFilter on 1, 2, 4 and 8 threads, speedup against one
+void threadBenchmark(GeoStar::Image *img, const long int nx, const long int ny) {
+  GeoStar::Raster *ras = make_synthetic(img, "threads_in", GeoStar::REAL32, nx, ny);
+  GeoStar::Raster *out = img->create_raster("threads_out", GeoStar::REAL32, nx, ny);
+  double mpix = nx * ny / 1.0e6;
+
+  std::cout << "threads (" << std::thread::hardware_concurrency() << " cores):" << std::endl;
+  const char *names[4] = {"thresh", "scale", "add", "midpointFilter"};
+  double base[4] = {0, 0, 0, 0};
+  for(int threads=1; threads<=8; threads*=2) {
+    ras->set_threads(threads);
+    std::cout << "  " << threads << ":";
+    for(int op=0; op<4; ++op) {
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      switch(op) {
+      case 0: ras->thresh(100); break;
+      case 1: ras->scale(out, 0, 2); break;
+      case 2: ras->add(ras, out); break;
+      default: ras->midpointFilter(out, 5); break;
+      }// end switch
+      double time = seconds_since(start);
+      if(threads == 1) base[op] = time;
+      std::cout << " " << names[op] << " " << mpix/time << " MPix/s (x" << base[op]/time << ")";
+    }// endfor: op
+    std::cout << std::endl;
+  }// endfor: threads
+
+  delete out;
+  delete ras;
+}// end: threadBenchmark
+
+
+
+// scale, thresh, gradientMask, downsample: one operation at a time through REAL32 rasters, then
+// fused by RasterPipeline, with the bytes each reads and writes
+void pipelineBenchmark(GeoStar::Image *img, const long int nx, const long int ny) {
+  GeoStar::Raster *ras = make_synthetic(img, "pipeline_in", GeoStar::REAL32, nx, ny);
+  GeoStar::Raster *scaled = img->create_raster("pipeline_scaled", GeoStar::REAL32, nx, ny);
+  GeoStar::Raster *edges = img->create_raster("pipeline_edges", GeoStar::REAL32, nx, ny);
+  GeoStar::Raster *small = img->create_raster("pipeline_small", GeoStar::REAL32, nx/2, ny/2);
+  GeoStar::Raster *fused = img->create_raster("pipeline_fused", GeoStar::REAL32, nx/2, ny/2);
+  GeoStar::RasterIOCounters &counters = GeoStar::Raster::io_counters();
+  double mpix = nx * ny / 1.0e6;
+
+  counters.reset();
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  ras->scale(scaled, 0, 2);
+  scaled->thresh(100);
+  scaled->gradientMask(edges, 1);
+  edges->downsample(small);
+  double eagerTime = seconds_since(start);
+  const GeoStar::RasterIOCounters eager = counters;
+
+  GeoStar::RasterPipeline chain = GeoStar::RasterPipeline(ras).scale(0, 2).thresh(100).gradientMask(1).downsample();
+  GeoStar::PipelinePlan plan;
+  plan.add_output(chain, fused);
+  const GeoStar::PipelineReport report = plan.report();
+  counters.reset();
+  start = std::chrono::steady_clock::now();
+  plan.run();
+  double fusedTime = seconds_since(start);
+
+  std::cout << "pipeline: scale, thresh, gradientMask, downsample" << std::endl;
+  std::cout << report.plan;
+  std::cout << "  eager: " << mpix/eagerTime << " MPix/s, read " << eager.bytes_read/1.0e6
+            << " MB, wrote " << eager.bytes_written/1.0e6 << " MB (" << report.eager_passes << " passes)" << std::endl;
+  std::cout << "  fused: " << mpix/fusedTime << " MPix/s, read " << counters.bytes_read/1.0e6
+            << " MB, wrote " << counters.bytes_written/1.0e6 << " MB (x" << eagerTime/fusedTime << ")" << std::endl;
+  std::cout << "  reported: eager read " << report.eager_bytes_read/1.0e6 << " MB, wrote "
+            << report.eager_bytes_written/1.0e6 << " MB; fused read " << report.fused_bytes_read/1.0e6
+            << " MB, wrote " << report.fused_bytes_written/1.0e6 << " MB" << std::endl;
+
+  delete fused;
+  delete small;
+  delete edges;
+  delete scaled;
+  delete ras;
+}// end: pipelineBenchmark
+
+
+
+//---------------------------------------------------------
+// the suite: every Raster operation, Image::read_file and Map rendering on synthetic rasters of each size
+// and type, one line (and one JSON record) per operation.  See usage at the top.
+
+// what an operation works on; setup makes the outputs, which are not timed, run is timed, and what
+// run makes is deleted after the timing
+struct SuiteData {
+  GeoStar::Image *img;
+  GeoStar::RasterType type;
+  long int nx;
+  long int ny;
+  GeoStar::Raster *in;    // ramp, never changed
+  GeoStar::Raster *in2;   // another ramp
+  GeoStar::Raster *work;  // ramp, changed by the in-place operations
+  std::vector<GeoStar::Raster *> outs;
+  std::vector<GeoStar::Raster *> made;
+  std::string op;         // name of the operation, prefix of its outputs
+  std::string path;       // file written for read_file and Map
+
+  GeoStar::Raster *output(const std::string &name, const GeoStar::RasterType &t, const long int x, const long int y) {
+    outs.push_back(img->create_raster(op + "_" + name, t, x, y));
+    return outs.back();
+  }
+};
+
+struct SuiteOp {
+  std::string name;
+  double output_scale;  // pixels of the largest output over pixels of the input
+  std::function<void(SuiteData &)> setup;
+  std::function<void(SuiteData &)> run;
+};
+
+// one timed operation
+struct SuiteResult {
+  std::string op;
+  std::string type;
+  long int nx;
+  long int ny;
+  double seconds;
+  GeoStar::RasterIOCounters io;
+  long int peak_rss_kb;
+  std::string status;
+};
+
+// largest output the suite makes, in pixels: 16k x 16k
+const double SUITE_MAX_PIXELS = 16384.0 * 16384.0;
+
+
+// peak resident set size of the process, in kB: VmHWM, which reset_peak_rss sets back to the current size
+long int peak_rss_kb() {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while(std::getline(status, line))
+    if(line.compare(0, 6, "VmHWM:") == 0) return atol(line.c_str() + 6);
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}// end: peak_rss_kb
+
+void reset_peak_rss() {
+  std::ofstream clear("/proc/self/clear_refs");
+  if(clear) clear << "5";
+}// end: reset_peak_rss
+
+
+const char *suite_type_name(const GeoStar::RasterType &type) {
+  switch(type) {
+  case GeoStar::INT8U:  return "INT8U";
+  case GeoStar::INT16U: return "INT16U";
+  default:              return "REAL32";
+  }// endswitch
+}// end: suite_type_name
+
+
+// a GeoTIFF of the ramp of make_synthetic, for read_file
+void write_synthetic_tiff(const std::string &path, const GeoStar::RasterType &type, const long int nx, const long int ny) {
+  GDALAllRegister();
+  GDALDriver *driver = GetGDALDriverManager()->GetDriverByName("GTiff");
+  if(driver == NULL) throw std::runtime_error("no GTiff driver");
+  const GDALDataType gdalType = (type == GeoStar::INT8U) ? GDT_Byte : (type == GeoStar::INT16U) ? GDT_UInt16 : GDT_Float32;
+  GDALDataset *dataset = driver->Create(path.c_str(), nx, ny, 1, gdalType, NULL);
+  if(dataset == NULL) throw std::runtime_error("cannot create " + path);
+
+  const long int rows = 64;
+  std::vector<float> data(nx * rows);
+  for(long int y0=0; y0<ny; y0+=rows) {
+    const long int dy = std::min(rows, ny - y0);
+    for(long int j=0; j<dy; ++j)
+      for(long int i=0; i<nx; ++i)
+        data[j*nx+i] = ((y0+j)*7 + i*13) % 251;
+    dataset->GetRasterBand(1)->RasterIO(GF_Write, 0, y0, nx, dy, data.data(), nx, dy, GDT_Float32, 0, 0);
+  }// endfor: y0
+  GDALClose(dataset);
+}// end: write_synthetic_tiff
+
+
+std::vector<SuiteOp> suite_ops() {
+  std::vector<SuiteOp> ops;
+  const std::function<void(SuiteData &)> none = [](SuiteData &) {};
+  const std::function<void(SuiteData &)> same = [](SuiteData &d) { d.output("out", d.type, d.nx, d.ny); };
+  const std::function<void(SuiteData &)> bytes = [](SuiteData &d) { d.output("out", GeoStar::INT8U, d.nx, d.ny); };
+
+  ops.push_back(SuiteOp{"read", 1, none, [](SuiteData &d) {
+        long int shape[2];
+        d.in->default_block_shape(shape);
+        std::vector<float> data(shape[0]*shape[1]);
+        for(long int y=0; y<d.ny; y+=shape[1])
+          for(long int x=0; x<d.nx; x+=shape[0])
+            d.in->read(GeoStar::RasterSlice(x, y, std::min(shape[0], d.nx-x), std::min(shape[1], d.ny-y)),
+                       data.data(), data.size());
+      }});
+  ops.push_back(SuiteOp{"write", 1, same, [](SuiteData &d) {
+        long int shape[2];
+        d.outs[0]->default_block_shape(shape);
+        std::vector<float> data(shape[0]*shape[1]);
+        for(size_t j=0; j<data.size(); ++j) data[j] = j % 251;
+        for(long int y=0; y<d.ny; y+=shape[1])
+          for(long int x=0; x<d.nx; x+=shape[0])
+            d.outs[0]->write(GeoStar::RasterSlice(x, y, std::min(shape[0], d.nx-x), std::min(shape[1], d.ny-y)),
+                             data.data(), data.size());
+      }});
+  ops.push_back(SuiteOp{"load", 1, none, [](SuiteData &d) { d.made.push_back(d.in->load()); }});
+  ops.push_back(SuiteOp{"copy", 1, same, [](SuiteData &d) {
+        const long int slice[4] = {0, 0, d.nx, d.ny};
+        d.in->copy(slice, d.outs[0]);
+      }});
+  ops.push_back(SuiteOp{"set", 1, none, [](SuiteData &d) {
+        const long int slice[4] = {0, 0, d.nx, d.ny};
+        d.work->set(slice, 7);
+      }});
+  ops.push_back(SuiteOp{"thresh", 1, none, [](SuiteData &d) { d.work->thresh(100); }});
+  ops.push_back(SuiteOp{"scale", 1, same, [](SuiteData &d) { d.in->scale(d.outs[0], 0, 2); }});
+  ops.push_back(SuiteOp{"drawFilledCircle", 1, none, [](SuiteData &d) {
+        d.work->drawFilledCircle(d.nx/2, d.ny/2, std::min(d.nx, d.ny)/4, 200);
+      }});
+  ops.push_back(SuiteOp{"drawLine", 1, none, [](SuiteData &d) {
+        d.work->drawLine(std::vector<long int>{d.nx/8, d.ny/8, 3*d.nx/4, d.ny/2}, 2, 200);
+      }});
+  ops.push_back(SuiteOp{"drawRectangle", 1, none, [](SuiteData &d) {
+        d.work->drawRectangle(std::vector<long int>{d.nx/8, d.ny/8, 3*d.nx/4, 3*d.ny/4}, 2, 200);
+      }});
+  ops.push_back(SuiteOp{"drawFilledRectangle", 1, none, [](SuiteData &d) {
+        d.work->drawFilledRectangle(std::vector<long int>{d.nx/8, d.ny/8, 3*d.nx/4, 3*d.ny/4}, 2, 200, 50);
+      }});
+  ops.push_back(SuiteOp{"bitShift", 1, same, [](SuiteData &d) { d.in->bitShift(d.outs[0], 1, true); }});
+  ops.push_back(SuiteOp{"addSaltPepper", 1, same, [](SuiteData &d) { d.in->addSaltPepper(d.outs[0], 0.05); }});
+  ops.push_back(SuiteOp{"autoLocalThresh", 1, bytes, [](SuiteData &d) { d.in->autoLocalThresh(d.outs[0], 4); }});
+  ops.push_back(SuiteOp{"add", 1, same, [](SuiteData &d) { d.in->add(d.in2, d.outs[0]); }});
+  ops.push_back(SuiteOp{"subtract", 1, same, [](SuiteData &d) { d.in->subtract(d.in2, d.outs[0]); }});
+  ops.push_back(SuiteOp{"multiply", 1, same, [](SuiteData &d) { d.in->multiply(d.in2, d.outs[0]); }});
+  ops.push_back(SuiteOp{"divide", 1, same, [](SuiteData &d) { d.in->divide(d.in2, d.outs[0]); }});
+  ops.push_back(SuiteOp{"expression", 1, same, [](SuiteData &d) { *d.outs[0] = (*d.in + *d.in2) * 0.5; }});
+  ops.push_back(SuiteOp{"harmonicMean", 1, same, [](SuiteData &d) { d.in->harmonicMean(d.outs[0], 5); }});
+  ops.push_back(SuiteOp{"gradientMask", 1, same, [](SuiteData &d) { d.in->gradientMask(d.outs[0], 1); }});
+  ops.push_back(SuiteOp{"midpointFilter", 1, same, [](SuiteData &d) { d.in->midpointFilter(d.outs[0], 5); }});
+  ops.push_back(SuiteOp{"rangeFilter", 1, same, [](SuiteData &d) { d.in->rangeFilter(d.outs[0], 5); }});
+  ops.push_back(SuiteOp{"downsample", 1,
+        [](SuiteData &d) { d.output("out", d.type, d.nx/2, d.ny/2); },
+        [](SuiteData &d) { d.work->downsample(d.outs[0]); }});
+  ops.push_back(SuiteOp{"upsample", 4,
+        [](SuiteData &d) { d.output("out", d.type, d.nx*2, d.ny*2); },
+        [](SuiteData &d) { d.in->upsample(d.outs[0]); }});
+  ops.push_back(SuiteOp{"gaussianPyramid", 1, none, [](SuiteData &d) {
+        std::vector<GeoStar::Raster *> levels = d.in->gaussianPyramid(d.img, 3);
+        d.made.insert(d.made.end(), levels.begin()+1, levels.end());
+      }});
+  ops.push_back(SuiteOp{"laplacianPyramid", 4, none, [](SuiteData &d) {
+        std::vector<GeoStar::Raster *> levels = d.in->laplacianPyramid(d.img, 2);
+        d.made.insert(d.made.end(), levels.begin()+1, levels.end());
+      }});
+  ops.push_back(SuiteOp{"pipeline", 1,
+        [](SuiteData &d) { d.output("out", GeoStar::REAL32, d.nx/2, d.ny/2); },
+        [](SuiteData &d) {
+          GeoStar::RasterPipeline(d.in).scale(0, 2).thresh(100).gradientMask(1).downsample().write(d.outs[0]);
+        }});
+  ops.push_back(SuiteOp{"FFT_2D", 1,
+        [](SuiteData &d) { d.output("out", GeoStar::COMPLEX_REAL64, d.nx, d.ny); },
+        [](SuiteData &d) { d.in->FFT_2D(d.img, d.outs[0]); }});
+  ops.push_back(SuiteOp{"FFT_2D_Inv", 1,
+        [](SuiteData &d) {
+          d.in->FFT_2D(d.img, d.output("spectrum", GeoStar::COMPLEX_REAL64, d.nx, d.ny));
+          d.output("out", GeoStar::REAL32, d.nx, d.ny);
+        },
+        [](SuiteData &d) { d.outs[0]->FFT_2D_Inv(d.img, d.outs[1]); }});
+  ops.push_back(SuiteOp{"lowPassFilter", 1,
+        [](SuiteData &d) { d.output("out", GeoStar::REAL32, d.nx, d.ny); },
+        [](SuiteData &d) { d.in->lowPassFilter(d.img, NULL, NULL, d.outs[0]); }});
+  ops.push_back(SuiteOp{"frequencyFilter", 1,
+        [](SuiteData &d) { d.output("out", GeoStar::REAL32, d.nx, d.ny); },
+        [](SuiteData &d) {
+          d.in->frequencyFilter(d.outs[0], GeoStar::FrequencyFilter::lowPass(0.2, GeoStar::FILTER_BUTTERWORTH));
+        }});
+  ops.push_back(SuiteOp{"read_file", 1,
+        [](SuiteData &d) {
+          d.path = std::string("bench_") + suite_type_name(d.type) + ".tif";
+          write_synthetic_tiff(d.path, d.type, d.nx, d.ny);
+        },
+        [](SuiteData &d) { d.made.push_back(d.img->read_file(d.path, "read_file", 1)); }});
+  ops.push_back(SuiteOp{"Map", 1,
+        [](SuiteData &d) { d.path = "bench_map.png"; },
+        [](SuiteData &d) {
+          GeoStar::Map map(d.nx, d.ny);
+          map.addLatLongGrid(45.0, -123.0, 44.0, -122.0);
+          map.writePNG(d.path);
+        }});
+  return ops;
+}// end: suite_ops
+
+
+// runs op on a new image of data, and times it
+SuiteResult run_suite_op(const SuiteOp &op, SuiteData &d) {
+  SuiteResult r;
+  r.op = op.name;
+  r.type = suite_type_name(d.type);
+  r.nx = d.nx;
+  r.ny = d.ny;
+  r.seconds = 0;
+  r.peak_rss_kb = 0;
+  r.status = "ok";
+
+  if(d.nx * (double)d.ny * op.output_scale > SUITE_MAX_PIXELS) {
+    r.status = "skipped: output too large";
+    return r;
+  }// endif
+
+  d.outs.clear();
+  d.made.clear();
+  d.op = op.name;
+  d.path.clear();
+  try {
+    op.setup(d);
+    GeoStar::Raster::io_counters().reset();
+    reset_peak_rss();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    op.run(d);
+    for(size_t i=0; i<d.outs.size(); ++i) d.outs[i]->flush();
+    r.seconds = seconds_since(start);
+    r.io = GeoStar::Raster::io_counters();
+    r.peak_rss_kb = peak_rss_kb();
+  } catch(const std::exception &e) {
+    r.status = std::string("error: ") + e.what();
+  } catch(...) {
+    r.status = "error";
+  }
+
+  for(size_t i=0; i<d.made.size(); ++i) delete d.made[i];
+  for(size_t i=0; i<d.outs.size(); ++i) delete d.outs[i];
+  if(!d.path.empty()) boost::filesystem::remove(d.path);
+  return r;
+}// end: run_suite_op
+
+
+void print_suite_result(const SuiteResult &r) {
+  std::cout << std::left << std::setw(20) << r.op << std::setw(8) << r.type << std::right
+            << std::setw(6) << r.nx << "x" << std::left << std::setw(6) << r.ny << std::right;
+  if(r.status != "ok") {
+    std::cout << "  " << r.status << std::endl;
+    return;
+  }// endif
+  const double mpix = r.nx * (double)r.ny / 1.0e6;
+  const double mb = (r.io.bytes_read + r.io.bytes_written) / 1.0e6;
+  std::cout << std::fixed << std::setprecision(3) << std::setw(10) << r.seconds << " s"
+            << std::setprecision(1) << std::setw(10) << mpix/r.seconds << " MPix/s"
+            << std::setw(10) << mb/r.seconds << " MB/s"
+            << std::setw(8) << r.io.read_calls << " reads" << std::setw(8) << r.io.write_calls << " writes"
+            << std::setw(9) << r.peak_rss_kb/1024.0 << " MB peak" << std::endl;
+  std::cout.unsetf(std::ios::floatfield);
+}// end: print_suite_result
+
+
+// the records as a JSON document, one record per line
+void write_suite_json(const std::string &path, const std::vector<SuiteResult> &results) {
+  std::ofstream json(path.c_str());
+  json << "{\n  \"cores\": " << std::thread::hardware_concurrency() << ",\n  \"results\": [\n";
+  for(size_t i=0; i<results.size(); ++i) {
+    const SuiteResult &r = results[i];
+    const double mpix = r.nx * (double)r.ny / 1.0e6;
+    const bool ok = (r.status == "ok") && r.seconds > 0;
+    std::string status;
+    for(size_t c=0; c<r.status.size(); ++c) {
+      if(r.status[c] == '"' || r.status[c] == '\\') status += '\\';
+      status += r.status[c];
+    }// endfor: c
+    json << "    {\"op\": \"" << r.op << "\", \"type\": \"" << r.type << "\", \"nx\": " << r.nx << ", \"ny\": " << r.ny
+         << ", \"status\": \"" << status << "\", \"seconds\": " << r.seconds
+         << ", \"mpix_per_s\": " << (ok ? mpix/r.seconds : 0)
+         << ", \"mb_per_s\": " << (ok ? (r.io.bytes_read + r.io.bytes_written)/1.0e6/r.seconds : 0)
+         << ", \"read_calls\": " << r.io.read_calls << ", \"write_calls\": " << r.io.write_calls
+         << ", \"bytes_read\": " << r.io.bytes_read << ", \"bytes_written\": " << r.io.bytes_written
+         << ", \"peak_rss_kb\": " << r.peak_rss_kb << "}" << (i+1 < results.size() ? "," : "") << "\n";
+  }// endfor: i
+  json << "  ]\n}\n";
+}// end: write_suite_json
+
+
+// comma-separated list of values
+std::vector<std::string> split_list(const std::string &list) {
+  std::vector<std::string> items;
+  std::stringstream in(list);
+  std::string item;
+  while(std::getline(in, item, ',')) if(!item.empty()) items.push_back(item);
+  return items;
+}// end: split_list
+
+
+int suite(int argc, char *argv[]) {
+  std::vector<long int> sizes;
+  std::vector<GeoStar::RasterType> types;
+  std::vector<std::string> only;
+  std::string jsonPath;
+
+  for(int i=2; i<argc; ++i) {
+    const std::string arg = argv[i];
+    const std::string value = (i+1 < argc) ? argv[i+1] : "";
+    if(arg == "--json") jsonPath = value;
+    else if(arg == "--ops") only = split_list(value);
+    else if(arg == "--sizes") {
+      std::vector<std::string> items = split_list(value);
+      for(size_t k=0; k<items.size(); ++k) {
+        long int n;
+        if(!parse_size(items[k], n)) {
+          std::cerr << "bad size " << items[k] << std::endl << BENCH_USAGE << std::endl;
+          return 1;
+        }// endif
+        sizes.push_back(n);
+      }// endfor: k
+    } else if(arg == "--types") {
+      std::vector<std::string> items = split_list(value);
+      for(size_t k=0; k<items.size(); ++k) {
+        if(items[k] == "INT8U") types.push_back(GeoStar::INT8U);
+        else if(items[k] == "INT16U") types.push_back(GeoStar::INT16U);
+        else if(items[k] == "REAL32") types.push_back(GeoStar::REAL32);
+        else {
+          std::cerr << "unknown type " << items[k] << std::endl << BENCH_USAGE << std::endl;
+          return 1;
+        }
+      }// endfor: k
+    } else {
+      std::cerr << "unknown option " << arg << std::endl << BENCH_USAGE << std::endl;
+      return 1;
+    }// endif
+    ++i;
+  }// endfor: i
+  if(sizes.empty()) sizes = std::vector<long int>{512, 2048};
+  if(types.empty()) types = std::vector<GeoStar::RasterType>{GeoStar::INT8U, GeoStar::INT16U, GeoStar::REAL32};
+
+  const std::vector<SuiteOp> ops = suite_ops();
+  std::vector<SuiteResult> results;
+  for(size_t s=0; s<sizes.size(); ++s) {
+    for(size_t t=0; t<types.size(); ++t) {
+      // a new file for every size and type, removed after, so the disk holds one of them at a time
+      boost::filesystem::path p("bench_suite.h5");
+      boost::filesystem::remove(p);
+      GeoStar::File *file = new GeoStar::File("bench_suite.h5", "new");
+      SuiteData d;
+      d.type = types[t];
+      d.nx = d.ny = sizes[s];
+      d.img = file->create_image("suite");
+      d.in = make_synthetic(d.img, "in", d.type, d.nx, d.ny);
+      d.in2 = make_synthetic(d.img, "in2", d.type, d.nx, d.ny);
+      d.work = make_synthetic(d.img, "work", d.type, d.nx, d.ny);
+
+      for(size_t k=0; k<ops.size(); ++k) {
+        if(!only.empty() && std::find(only.begin(), only.end(), ops[k].name) == only.end()) continue;
+        results.push_back(run_suite_op(ops[k], d));
+        print_suite_result(results.back());
+      }// endfor: k
+
+      delete d.work;
+      delete d.in2;
+      delete d.in;
+      delete d.img;
+      delete file;
+      boost::filesystem::remove(p);
+    }// endfor: t
+  }// endfor: s
+
+  if(!jsonPath.empty()) write_suite_json(jsonPath, results);
+  return 0;
+}// end: suite
@@ -0,0 +1,211 @@
+// compression.cpp
+//
+// HDF5 compression filters for rasters, and
+// measurement-based selection of the codec.
+//
+//-------------------------------------
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+#include "H5Cpp.h"
+
+#include "compression.hpp"
+#include "Exceptions.hpp"
+
+
+namespace GeoStar {
+
+  // HDF5 filter id of a codec:
+  static H5Z_filter_t compression_filter(const RasterCompression &codec) {
+    switch(codec) {
+    case COMPRESS_DEFLATE:
+      return H5Z_FILTER_DEFLATE;
+    case COMPRESS_LZ4:
+      return H5Z_FILTER_LZ4_PLUGIN;
+    case COMPRESS_ZSTD:
+      return H5Z_FILTER_ZSTD_PLUGIN;
+    default:
+      return H5Z_FILTER_NONE;
+    }// end case
+  }// end: compression_filter
+
+
+
+  std::string compression_name(const RasterCompression &codec) {
+    switch(codec) {
+    case COMPRESS_NONE:
+      return "none";
+    case COMPRESS_DEFLATE:
+      return "deflate";
+    case COMPRESS_LZ4:
+      return "lz4";
+    case COMPRESS_ZSTD:
+      return "zstd";
+    case COMPRESS_AUTO:
+      return "auto";
+    default:
+      return "unknown";
+    }// end case
+  }// end: compression_name
+
+
+
+  bool compression_available(const RasterCompression &codec) {
+    if(codec == COMPRESS_NONE) return true;
+    if(codec == COMPRESS_AUTO) return false;
+
+    // the shuffle filter goes in front of every codec:
+    const H5Z_filter_t filters[2] = {H5Z_FILTER_SHUFFLE, compression_filter(codec)};
+    for(int i=0; i<2; ++i) {
+      // loads the plugin, if there is one:
+      if(H5Zfilter_avail(filters[i]) <= 0) return false;
+
+      unsigned int config = 0;
+      if(H5Zget_filter_info(filters[i], &config) < 0) return false;
+      if(!(config & H5Z_FILTER_CONFIG_ENCODE_ENABLED)) return false;
+      if(!(config & H5Z_FILTER_CONFIG_DECODE_ENABLED)) return false;
+    }// endfor: i
+
+    return true;
+  }// end: compression_available
+
+
+
+  void set_compression(H5::DSetCreatPropList &plist, const RasterCompression &codec,
+                       const int &level) {
+    RasterCreationErrorException RasterCreationError;
+
+    if(codec == COMPRESS_NONE) return;
+    if(!compression_available(codec)) throw RasterCreationError;
+
+    plist.setShuffle();
+
+    switch(codec) {
+    case COMPRESS_DEFLATE:
+      plist.setDeflate(level > 0 ? level : 4);
+      break;
+    case COMPRESS_LZ4:
+      // the plugin picks its own block size
+      plist.setFilter(H5Z_FILTER_LZ4_PLUGIN, H5Z_FLAG_MANDATORY, 0, NULL);
+      break;
+    case COMPRESS_ZSTD: {
+      const unsigned int cd_values[1] = {(unsigned int)(level > 0 ? level : 3)};
+      plist.setFilter(H5Z_FILTER_ZSTD_PLUGIN, H5Z_FLAG_MANDATORY, 1, cd_values);
+      break;
+    }
+    default:
+      throw RasterCreationError;
+    }// end case
+
+  }// end: set_compression
+
+
+
+  // HDF5's error printing off while it lives, and back as it was when it goes, also on an exception
+  struct QuietHDF5Errors {
+    H5E_auto2_t func;
+    void *client_data;
+
+    QuietHDF5Errors() {
+      H5::Exception::getAutoPrint(func, &client_data);
+      H5::Exception::dontPrint();
+    }
+    ~QuietHDF5Errors() { H5::Exception::setAutoPrint(func, client_data); }
+  }; // end: QuietHDF5Errors
+
+
+
+  std::vector<CompressionReport> measure_compression(const void *sample, const H5::DataType &h5Type,
+                                                     const long int &nx, const long int &ny) {
+    const RasterCompression codecs[4] = {COMPRESS_NONE, COMPRESS_DEFLATE, COMPRESS_LZ4, COMPRESS_ZSTD};
+    std::vector<CompressionReport> reports;
+    if(nx < 1 || ny < 1) return reports;
+
+    // an in-memory file, never written to disk, its errors not printed:
+    const QuietHDF5Errors quiet;
+    H5::FileAccPropList fapl;
+    fapl.setCore(1024*1024, false);
+    H5::H5File probe("geostar_compression_probe.h5", H5F_ACC_TRUNC, H5::FileCreatPropList::DEFAULT, fapl);
+
+    hsize_t dims[2];
+    dims[0] = ny;
+    dims[1] = nx;
+    H5::DataSpace space(2, dims);
+
+    hsize_t chunk[2];
+    chunk[0] = std::min(dims[0], (hsize_t)256);
+    chunk[1] = std::min(dims[1], (hsize_t)256);
+
+    const double nbytes = (double)nx * ny * h5Type.getSize();
+    std::vector<char> buffer((size_t)nbytes);
+
+    for(int i=0; i<4; ++i) {
+      CompressionReport report;
+      report.codec = codecs[i];
+      report.available = compression_available(codecs[i]);
+      report.ratio = 0;
+      report.compressMBs = 0;
+      report.decompressMBs = 0;
+
+      if(report.available) {
+        H5::DSetCreatPropList plist;
+        plist.setChunk(2, chunk);
+        set_compression(plist, codecs[i], 0);
+        const std::string name = compression_name(codecs[i]);
+
+        // closing the dataset flushes (and compresses) the cached chunks:
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        {
+          H5::DataSet dataset = probe.createDataSet(name, h5Type, space, plist);
+          dataset.write(sample, h5Type);
+        }
+        const double writeTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        // a fresh dataset has an empty chunk cache, so every chunk is decompressed:
+        hsize_t stored = 0;
+        start = std::chrono::steady_clock::now();
+        {
+          H5::DataSet dataset = probe.openDataSet(name);
+          stored = dataset.getStorageSize();
+          dataset.read(&buffer[0], h5Type);
+        }
+        const double readTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        report.ratio = nbytes / std::max(stored, (hsize_t)1);
+        report.compressMBs = nbytes / 1.0e6 / std::max(writeTime, 1.0e-9);
+        report.decompressMBs = nbytes / 1.0e6 / std::max(readTime, 1.0e-9);
+      }// endif
+
+      reports.push_back(report);
+    }// endfor: i
+
+    return reports;
+  }// end: measure_compression
+
+
+
+  RasterCompression select_compression(const std::vector<CompressionReport> &reports,
+                                       const double &diskBytesPerSec) {
+    RasterCompression best = COMPRESS_NONE;
+    double bestTime = 0;
+
+    for(size_t i=0; i<reports.size(); ++i) {
+      if(!reports[i].available || reports[i].ratio <= 0) continue;
+
+      // seconds per uncompressed byte: written once, read once
+      const double seconds = 2.0 / (reports[i].ratio * diskBytesPerSec)
+                           + 1.0 / (reports[i].compressMBs * 1.0e6)
+                           + 1.0 / (reports[i].decompressMBs * 1.0e6);
+      if(bestTime == 0 || seconds < bestTime) {
+        best = reports[i].codec;
+        bestTime = seconds;
+      }// endif
+    }// endfor: i
+
+    return best;
+  }// end: select_compression
+
+}// end namespace GeoStar
@@ -0,0 +1,71 @@
+// compression.hpp
+//
+// HDF5 compression filters for rasters, and
+// measurement-based selection of the codec.
+//
+//-------------------------------------
+#ifndef COMPRESSION_HPP_
+#define COMPRESSION_HPP_
+
+#include <string>
+#include <vector>
+
+#include "H5Cpp.h"
+#include "RasterLayout.hpp"
+
+namespace GeoStar {
+
+  // registered HDF5 filter ids of the plugin codecs.
+  // They are only usable when the plugin is on HDF5_PLUGIN_PATH.
+  const H5Z_filter_t H5Z_FILTER_LZ4_PLUGIN  = 32004;
+  const H5Z_filter_t H5Z_FILTER_ZSTD_PLUGIN = 32015;
+
+  // sustained disk throughput assumed when picking a codec, bytes/second.
+  const double RASTER_DISK_BYTES_PER_SEC = 150.0e6;
+
+
+  // result of trying one codec on a sample of raster data.
+  struct CompressionReport {
+    RasterCompression codec;
+    bool   available;      // false if the filter is not in this HDF5 build/plugin path
+    double ratio;          // uncompressed bytes / stored bytes
+    double compressMBs;    // MB/s of uncompressed data written through the filter
+    double decompressMBs;  // MB/s of uncompressed data read back through the filter
+  };
+
+
+  // compression_name: printable name of a codec ("deflate", "zstd", ...)
+  std::string compression_name(const RasterCompression &codec);
+
+
+  // compression_available: true if the filters for the codec can be
+  //                        used for both writing and reading.
+  bool compression_available(const RasterCompression &codec);
+
+
+  // set_compression: adds the shuffle filter and the codec's filter to a
+  //                  dataset creation property list.  The property list
+  //                  must already be chunked.  level 0 uses the codec default.
+  //                  Throws RasterCreationErrorException for an unavailable codec
+  //                  or for COMPRESS_AUTO, which has to be resolved first.
+  void set_compression(H5::DSetCreatPropList &plist, const RasterCompression &codec,
+                       const int &level);
+
+
+  // measure_compression: writes the nx*ny sample (of HDF5 type h5Type) to an
+  //                      in-memory HDF5 file with each codec and reads it back,
+  //                      timing both directions and measuring the stored size.
+  //                      The first report is COMPRESS_NONE, the baseline.
+  std::vector<CompressionReport> measure_compression(const void *sample, const H5::DataType &h5Type,
+                                                     const long int &nx, const long int &ny);
+
+
+  // select_compression: picks the codec with the smallest estimated time to
+  //                     write and later read back the data, counting the disk
+  //                     traffic at diskBytesPerSec plus the (de)compression time.
+  RasterCompression select_compression(const std::vector<CompressionReport> &reports,
+                                       const double &diskBytesPerSec = RASTER_DISK_BYTES_PER_SEC);
+
+}// end namespace GeoStar
+
+#endif // COMPRESSION_HPP_
@@ -9,6 +9,14 @@
 #include "File.hpp"
 #include "Image.hpp"
 #include "Raster.hpp"
+#include "InMemoryRaster.hpp"
+#include "RasterView.hpp"
+#include "RasterPipeline.hpp"
+#include "BandStack.hpp"
+#include "BandMath.hpp"
+#include "Scratch.hpp"
+#include "FFTPlans.hpp"
+#include "FrequencyFilter.hpp"
 #include "Map.hpp"
 
 #endif // GEOSTAR_HPP_
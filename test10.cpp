@@ -0,0 +1,241 @@
+// test10.cpp
+//
+// tests FFT_2D and FFT_2D_Inv: in memory and out of core (a tiny memory
+// budget, with the transpose in memory or in the scratch file), full and
+// half spectra, against a plain DFT, and the round trip back to the pixels;
+// an integer spectrum out of core against in memory;
+// the same in single precision between REAL32 rasters; and the plans
+// FFTPlans keeps for them, with their wisdom files and threads.
+//
+// usage: test10
+//
+//---------------------------------------------------------
+#include <string>
+#include <iostream>
+#include <vector>
+#include <complex>
+#include <cmath>
+#include "geostar.hpp"
+#include "testutil.hpp"
+
+#include "boost/filesystem.hpp"
+
+const long int NX = 50;
+const long int NY = 30;
+const long int NH = NX/2 + 1;
+
+// small enough for bands of a few rows and strips of a few columns
+const size_t TINY_BUDGET = 4096;
+
+// true if the first nx columns of every row of a (a_nx wide) match b (b_nx wide)
+template<typename T>
+bool close(const std::vector<T> &a, const long int &a_nx, const std::vector<T> &b, const long int &b_nx,
+           const long int &nx, const double &tolerance) {
+  for(long int y=0; y<NY; ++y)
+    for(long int x=0; x<nx; ++x)
+      if(std::abs(a[y*a_nx + x] - b[y*b_nx + x]) > tolerance) return false;
+  return true;
+}// end: close
+
+
+int main() {
+  int failed = 0;
+
+  boost::filesystem::path p("a10.h5");
+  boost::filesystem::remove(p);
+  GeoStar::File *file = new GeoStar::File("a10.h5", "new");
+  GeoStar::Image *img = file->create_image("landsat");
+
+  GeoStar::Raster *in = img->create_raster("in", GeoStar::REAL64, NX, NY);
+  std::vector<double> input(NX*NY);
+  for(long int i=0; i<NX*NY; ++i) input[i] = double((i*37) % 101) - 50;
+  in->write(GeoStar::RasterSlice(0, 0, NX, NY), &input[0], input.size());
+
+  // the DFT, the slow way
+  std::vector<std::complex<double> > dft(NX*NY);
+  const double pi = std::acos(-1.0);
+  for(long int v=0; v<NY; ++v)
+    for(long int u=0; u<NX; ++u)
+      for(long int y=0; y<NY; ++y)
+        for(long int x=0; x<NX; ++x)
+          dft[v*NX + u] += input[y*NX + x] * std::polar(1.0, -2*pi*(double(u*x)/NX + double(v*y)/NY));
+
+  const double tolerance = 1e-6 * NX * NY;
+
+  // forward, in memory then out of core, full and half:
+  const std::string passes[3] = {" in memory", " out of core", " out of core, on disk"};
+  const size_t scratchBudget = GeoStar::Scratch::shared().get_budget();
+  for(int pass=0; pass<3; ++pass) {
+    const std::string where = passes[pass];
+    GeoStar::Raster::set_fft_memory(pass == 0 ? GeoStar::RASTER_FFT_MEMORY : TINY_BUDGET);
+    GeoStar::Scratch::shared().set_budget(pass == 2 ? 0 : scratchBudget);
+
+    GeoStar::Raster *full = img->create_raster("full" + where, GeoStar::COMPLEX_REAL128, NX, NY);
+    GeoStar::Raster *half = img->create_raster("half" + where, GeoStar::COMPLEX_REAL128, NH, NY);
+    in->FFT_2D(img, full);
+    in->FFT_2D(img, half);
+    failed += check(close(pixels<std::complex<double> >(full), NX, dft, NX, NX, tolerance), "full spectrum" + where);
+    failed += check(close(pixels<std::complex<double> >(half), NH, dft, NX, NH, tolerance), "half spectrum" + where);
+
+    GeoStar::Raster *re = img->create_raster("re" + where, GeoStar::REAL64, NX, NY);
+    GeoStar::Raster *im = img->create_raster("im" + where, GeoStar::REAL64, NX, NY);
+    in->FFT_2D(img, re, im);
+    std::vector<std::complex<double> > parts(NX*NY);
+    const std::vector<double> dataRe = pixels<double>(re), dataIm = pixels<double>(im);
+    for(long int i=0; i<NX*NY; ++i) parts[i] = std::complex<double>(dataRe[i], dataIm[i]);
+    failed += check(close(parts, NX, dft, NX, NX, tolerance), "real and imaginary rasters" + where);
+
+    // back: N times the input, over the scaling factor
+    std::vector<double> expected(NX*NY);
+    for(long int i=0; i<NX*NY; ++i) expected[i] = input[i] * NX * NY / 200000;
+    GeoStar::Raster *back = img->create_raster("back" + where, GeoStar::REAL64, NX, NY);
+    full->FFT_2D_Inv(img, back);
+    failed += check(close(pixels<double>(back), NX, expected, NX, NX, 1e-6), "round trip from the full spectrum" + where);
+    half->FFT_2D_Inv(img, back);
+    failed += check(close(pixels<double>(back), NX, expected, NX, NX, 1e-6), "round trip from the half spectrum" + where);
+    re->FFT_2D_Inv(img, back, im);
+    failed += check(close(pixels<double>(back), NX, expected, NX, NX, 1e-6), "round trip from two rasters" + where);
+
+    // a spectrum that is not of real pixels: the real part of its inverse
+    std::vector<std::complex<double> > odd(NX*NY);
+    for(long int i=0; i<NX*NY; ++i) odd[i] = std::complex<double>(double((i*7) % 13), double((i*11) % 17) - 8);
+    full->write(GeoStar::RasterSlice(0, 0, NX, NY), &odd[0], odd.size());
+    std::vector<double> idft(NX*NY);
+    for(long int y=0; y<NY; ++y)
+      for(long int x=0; x<NX; ++x) {
+        std::complex<double> sum;
+        for(long int v=0; v<NY; ++v)
+          for(long int u=0; u<NX; ++u)
+            sum += odd[v*NX + u] * std::polar(1.0, 2*pi*(double(u*x)/NX + double(v*y)/NY));
+        idft[y*NX + x] = sum.real() / 200000;
+      }
+    full->FFT_2D_Inv(img, back);
+    failed += check(close(pixels<double>(back), NX, idft, NX, NX, 1e-6), "inverse of any complex raster" + where);
+
+    delete back;
+    delete im;
+    delete re;
+    delete half;
+    delete full;
+  }// endfor: pass
+  GeoStar::Raster::set_fft_memory(GeoStar::RASTER_FFT_MEMORY);
+  GeoStar::Scratch::shared().set_budget(scratchBudget);
+
+  // an integer spectrum: the same out of core as in memory, the transpose in floating point
+  GeoStar::Raster *ints[2];
+  std::vector<double> backs[2];
+  for(int pass=0; pass<2; ++pass) {
+    GeoStar::Raster::set_fft_memory(pass == 0 ? GeoStar::RASTER_FFT_MEMORY : TINY_BUDGET);
+    ints[pass] = img->create_raster("int" + passes[pass], GeoStar::COMPLEX_INT64, NX, NY);
+    in->FFT_2D(img, ints[pass]);
+    GeoStar::Raster *back = img->create_raster("int back" + passes[pass], GeoStar::REAL64, NX, NY);
+    ints[0]->FFT_2D_Inv(img, back);
+    backs[pass] = pixels<double>(back);
+    delete back;
+  }// endfor: pass
+  GeoStar::Raster::set_fft_memory(GeoStar::RASTER_FFT_MEMORY);
+  failed += check(close(pixels<std::complex<double> >(ints[1]), NX, pixels<std::complex<double> >(ints[0]), NX, NX, 1),
+                  "COMPLEX_INT64 spectrum out of core");
+  failed += check(close(backs[1], NX, backs[0], NX, NX, 1e-9), "inverse of a COMPLEX_INT64 spectrum out of core");
+  delete ints[1];
+  delete ints[0];
+
+  // single precision, REAL32 to COMPLEX_REAL64 and back, in memory and out of core:
+  GeoStar::Raster *in32 = img->create_raster("in32", GeoStar::REAL32, NX, NY);
+  in32->write(GeoStar::RasterSlice(0, 0, NX, NY), &input[0], input.size());
+  const double tolerance32 = 1e-4 * NX * NY;
+  for(int pass=0; pass<2; ++pass) {
+    const std::string where = passes[pass] + ", single precision";
+    GeoStar::Raster::set_fft_memory(pass == 0 ? GeoStar::RASTER_FFT_MEMORY : TINY_BUDGET);
+
+    GeoStar::Raster *full = img->create_raster("full" + where, GeoStar::COMPLEX_REAL64, NX, NY);
+    GeoStar::Raster *half = img->create_raster("half" + where, GeoStar::COMPLEX_REAL64, NH, NY);
+    in32->FFT_2D(img, full);
+    in32->FFT_2D(img, half);
+    failed += check(close(pixels<std::complex<double> >(full), NX, dft, NX, NX, tolerance32), "full spectrum" + where);
+    failed += check(close(pixels<std::complex<double> >(half), NH, dft, NX, NH, tolerance32), "half spectrum" + where);
+
+    std::vector<double> expected(NX*NY);
+    for(long int i=0; i<NX*NY; ++i) expected[i] = input[i] * NX * NY / 200000;
+    GeoStar::Raster *back = img->create_raster("back" + where, GeoStar::REAL32, NX, NY);
+    half->FFT_2D_Inv(img, back);
+    failed += check(close(pixels<double>(back), NX, expected, NX, NX, 1e-4), "round trip from the half spectrum" + where);
+    full->FFT_2D_Inv(img, back);
+    failed += check(close(pixels<double>(back), NX, expected, NX, NX, 1e-4), "round trip from the full spectrum" + where);
+
+    delete back;
+    delete half;
+    delete full;
+  }// endfor: pass
+
+  // half the memory of double precision is enough to stay in memory: one read of the input
+  const size_t singleBytes = (sizeof(float)*NX + sizeof(std::complex<float>)*NH) * NY;
+  GeoStar::Raster::set_fft_memory(singleBytes);
+  GeoStar::Raster *half32 = img->create_raster("half32", GeoStar::COMPLEX_REAL64, NH, NY);
+  GeoStar::Raster::io_counters().reset();
+  in32->FFT_2D(img, half32);
+  failed += check(GeoStar::Raster::io_counters().read_calls == 1, "single precision in memory on half the budget");
+  GeoStar::Raster::set_fft_memory(GeoStar::RASTER_FFT_MEMORY);
+
+  // the plans: made once per size, the same spectrum when measured, and the wisdom kept next to a10.h5
+  GeoStar::FFTPlans &plans = GeoStar::FFTPlans::shared();
+  boost::filesystem::path wisdom(GeoStar::FFT_WISDOM_FILE);
+  boost::filesystem::remove(wisdom);
+  GeoStar::Raster *again = img->create_raster("again", GeoStar::COMPLEX_REAL128, NX, NY);
+  const unsigned long misses = plans.get_misses();
+  const unsigned long hits = plans.get_hits();
+  in->FFT_2D(img, again);
+  failed += check(plans.get_misses() == misses && plans.get_hits() > hits, "plan reused");
+  failed += check(plans.get_wisdom_file() == boost::filesystem::absolute(wisdom).string(), "wisdom next to the file");
+
+  plans.set_effort(GeoStar::FFT_MEASURE);
+  in->FFT_2D(img, again);
+  failed += check(plans.get_misses() == misses + 1, "planned again when measuring");
+  failed += check(close(pixels<std::complex<double> >(again), NX, dft, NX, NX, tolerance), "full spectrum, measured");
+  failed += check(boost::filesystem::exists(wisdom), "wisdom saved");
+  boost::filesystem::path wisdomSingle(GeoStar::FFT_WISDOM_FILE_SINGLE);
+  boost::filesystem::remove(wisdomSingle);
+  in32->FFT_2D(img, half32);
+  failed += check(boost::filesystem::exists(wisdomSingle), "single-precision wisdom saved");
+  plans.set_effort(GeoStar::FFT_ESTIMATE);
+  boost::filesystem::remove(wisdom);
+  boost::filesystem::remove(wisdomSingle);
+
+  // threads: one per core, the same spectra
+  plans.set_threads(0);
+  failed += check(plans.get_threads() >= 1, "one thread per core");
+  in->FFT_2D(img, again);
+  failed += check(close(pixels<std::complex<double> >(again), NX, dft, NX, NX, tolerance), "full spectrum, threaded");
+  in32->FFT_2D(img, half32);
+  failed += check(close(pixels<std::complex<double> >(half32), NH, dft, NX, NH, tolerance32), "half spectrum, threaded, single precision");
+  plans.set_threads(1);
+
+  // mistakes:
+  GeoStar::Raster *narrow = img->create_raster("narrow", GeoStar::COMPLEX_REAL128, NH-1, NY);
+  bool caught = false;
+  try {
+    in->FFT_2D(img, narrow);
+  } catch(const GeoStar::RasterSizeErrorException &) {
+    caught = true;
+  }
+  failed += check(caught, "output neither full nor half");
+
+  caught = false;
+  try {
+    in->FFT_2D_Inv(img, in);
+  } catch(const GeoStar::DataTypeException &) {
+    caught = true;
+  }
+  failed += check(caught, "inverse of a real raster");
+
+  delete narrow;
+  delete again;
+  delete half32;
+  delete in32;
+  delete in;
+  delete img;
+  delete file;
+
+  boost::filesystem::remove(p);
+  return (failed == 0) ? 0 : 1;
+}// end-main
@@ -0,0 +1,227 @@
+// test11.cpp
+//
+// tests frequencyFilter: the filters of FrequencyFilter (low pass, high
+// pass, band pass, notch, each shape) and a callback, in memory and out of
+// core, in double and single precision, against the spectrum of a plain DFT
+// multiplied by the gains and transformed back; lowPassFilter; and the
+// mistakes.
+//
+// usage: test11
+//
+//---------------------------------------------------------
+#include <string>
+#include <iostream>
+#include <vector>
+#include <complex>
+#include <cmath>
+#include <algorithm>
+#include "geostar.hpp"
+#include "testutil.hpp"
+
+#include "boost/filesystem.hpp"
+
+// odd and even sizes: the half spectrum with and without its Nyquist column
+const long int NX = 24;
+const long int NY = 19;
+
+// small enough for bands of a few rows of the transpose
+const size_t TINY_BUDGET = 4096;
+
+// true if a and b match within tolerance
+bool close(const std::vector<double> &a, const std::vector<double> &b, const double &tolerance) {
+  for(size_t i=0; i<a.size(); ++i)
+    if(std::abs(a[i] - b[i]) > tolerance) return false;
+  return true;
+}// end: close
+
+
+// frequency of index k of an n-point DFT, in cycles per pixel
+double frequency(const long int &k, const long int &n) {
+  return double((k < (n+1)/2) ? k : k-n) / n;
+}// end: frequency
+
+
+// the spectrum of input filtered the slow way: the DFT, times the gains
+std::vector<std::complex<double> > filtered_spectrum(const std::vector<double> &input,
+                                                     const GeoStar::FrequencyFilter &filter) {
+  const double pi = std::acos(-1.0);
+  std::vector<std::complex<double> > dft(NX*NY);
+  for(long int v=0; v<NY; ++v)
+    for(long int u=0; u<NX; ++u) {
+      for(long int y=0; y<NY; ++y)
+        for(long int x=0; x<NX; ++x)
+          dft[v*NX + u] += input[y*NX + x] * std::polar(1.0, -2*pi*(double(u*x)/NX + double(v*y)/NY));
+      dft[v*NX + u] *= filter(frequency(u, NX), frequency(v, NY));
+    }
+  return dft;
+}// end: filtered_spectrum
+
+
+// input filtered the slow way: the real part of the inverse DFT of filtered_spectrum
+std::vector<double> filtered(const std::vector<double> &input, const GeoStar::FrequencyFilter &filter) {
+  const double pi = std::acos(-1.0);
+  const std::vector<std::complex<double> > dft = filtered_spectrum(input, filter);
+
+  std::vector<double> out(NX*NY);
+  for(long int y=0; y<NY; ++y)
+    for(long int x=0; x<NX; ++x) {
+      std::complex<double> sum;
+      for(long int v=0; v<NY; ++v)
+        for(long int u=0; u<NX; ++u)
+          sum += dft[v*NX + u] * std::polar(1.0, 2*pi*(double(u*x)/NX + double(v*y)/NY));
+      out[y*NX + x] = sum.real() / (NX*NY);
+    }
+  return out;
+}// end: filtered
+
+
+int main() {
+  int failed = 0;
+
+  boost::filesystem::path p("a11.h5");
+  boost::filesystem::remove(p);
+  GeoStar::File *file = new GeoStar::File("a11.h5", "new");
+  GeoStar::Image *img = file->create_image("landsat");
+
+  std::vector<double> input(NX*NY);
+  for(long int i=0; i<NX*NY; ++i) input[i] = double((i*37) % 101) - 50;
+  GeoStar::Raster *in = img->create_raster("in", GeoStar::REAL64, NX, NY);
+  in->write(GeoStar::RasterSlice(0, 0, NX, NY), &input[0], input.size());
+  GeoStar::Raster *in32 = img->create_raster("in32", GeoStar::REAL32, NX, NY);
+  in32->write(GeoStar::RasterSlice(0, 0, NX, NY), &input[0], input.size());
+
+  const std::string names[6] = {"all pass", "ideal low pass", "Butterworth low pass", "Gaussian high pass",
+                                "Butterworth band pass", "Gaussian notch"};
+  const GeoStar::FrequencyFilter filters[6] = {
+    GeoStar::FrequencyFilter([](const double &, const double &) { return 1.0; }),
+    GeoStar::FrequencyFilter::lowPass(0.2),
+    GeoStar::FrequencyFilter::lowPass(0.15, GeoStar::FILTER_BUTTERWORTH, 3),
+    GeoStar::FrequencyFilter::highPass(0.1, GeoStar::FILTER_GAUSSIAN),
+    GeoStar::FrequencyFilter::bandPass(0.1, 0.3, GeoStar::FILTER_BUTTERWORTH),
+    GeoStar::FrequencyFilter::notch(0.25, 0.1, 0.05, GeoStar::FILTER_GAUSSIAN)
+  };
+
+  // each filter, in memory then out of core (the transpose in memory, then in the scratch file), in both precisions:
+  const std::string passes[3] = {" in memory", " out of core", " out of core, on disk"};
+  const size_t scratchBudget = GeoStar::Scratch::shared().get_budget();
+  GeoStar::Raster *out = img->create_raster("out", GeoStar::REAL64, NX, NY);
+  GeoStar::Raster *out32 = img->create_raster("out32", GeoStar::REAL32, NX, NY);
+  for(int f=0; f<6; ++f) {
+    const std::vector<double> expected = filtered(input, filters[f]);
+    for(int pass=0; pass<3; ++pass) {
+      GeoStar::Raster::set_fft_memory(pass == 0 ? GeoStar::RASTER_FFT_MEMORY : TINY_BUDGET);
+      GeoStar::Scratch::shared().set_budget(pass == 2 ? 0 : scratchBudget);
+
+      in->frequencyFilter(out, filters[f]);
+      failed += check(close(pixels<double>(out), expected, 1e-8), names[f] + passes[pass]);
+      in32->frequencyFilter(out32, filters[f]);
+      failed += check(close(pixels<double>(out32), expected, 1e-3), names[f] + passes[pass] + ", single precision");
+    }// endfor: pass
+  }// endfor: f
+  GeoStar::Raster::set_fft_memory(GeoStar::RASTER_FFT_MEMORY);
+  GeoStar::Scratch::shared().set_budget(scratchBudget);
+
+  // a callback sees u from 0 to 0.5 only, the highest column of the even width included:
+  double lowest = 0, highest = 0;
+  const GeoStar::FrequencyFilter watch([&lowest, &highest](const double &u, const double &) {
+    lowest = std::min(lowest, u);
+    highest = std::max(highest, u);
+    return 1.0;
+  });
+  for(int pass=0; pass<2; ++pass) {
+    GeoStar::Raster::set_fft_memory(pass == 0 ? GeoStar::RASTER_FFT_MEMORY : TINY_BUDGET);
+    in->frequencyFilter(out, watch);
+  }// endfor: pass
+  GeoStar::Raster::set_fft_memory(GeoStar::RASTER_FFT_MEMORY);
+  failed += check(lowest == 0 && highest == 0.5, "u from 0 to 0.5");
+
+  // all pass is the identity; a constant passes a low pass and is removed by a high pass
+  in->frequencyFilter(out, filters[0]);
+  failed += check(close(pixels<double>(out), input, 1e-8), "all pass returns the input");
+
+  GeoStar::Raster *flat = img->create_raster("flat", GeoStar::REAL64, NX, NY);
+  std::vector<double> constant(NX*NY, 7);
+  flat->write(GeoStar::RasterSlice(0, 0, NX, NY), &constant[0], constant.size());
+  flat->frequencyFilter(out, GeoStar::FrequencyFilter::lowPass(0.01, GeoStar::FILTER_GAUSSIAN));
+  failed += check(close(pixels<double>(out), constant, 1e-8), "a constant through a low pass");
+  flat->frequencyFilter(out, GeoStar::FrequencyFilter::highPass(0.01, GeoStar::FILTER_BUTTERWORTH));
+  failed += check(close(pixels<double>(out), std::vector<double>(NX*NY, 0), 1e-8), "a constant through a high pass");
+
+  // in place, and lowPassFilter, the ideal low pass at 0.2:
+  GeoStar::Raster *same = img->create_raster("same", GeoStar::REAL64, NX, NY);
+  same->write(GeoStar::RasterSlice(0, 0, NX, NY), &input[0], input.size());
+  same->frequencyFilter(same, filters[2]);
+  failed += check(close(pixels<double>(same), filtered(input, filters[2]), 1e-8), "in place");
+  in->lowPassFilter(img, NULL, NULL, out);
+  failed += check(close(pixels<double>(out), filtered(input, filters[1]), 1e-8), "lowPassFilter");
+  GeoStar::Raster *re = img->create_raster("re", GeoStar::REAL64, NX, NY);
+  GeoStar::Raster *im = img->create_raster("im", GeoStar::REAL64, NX, NY);
+  in->lowPassFilter(img, re, im, out);
+  const std::vector<std::complex<double> > lowSpectrum = filtered_spectrum(input, filters[1]);
+  std::vector<double> lowRe(NX*NY), lowIm(NX*NY);
+  for(long int i=0; i<NX*NY; ++i) {
+    lowRe[i] = lowSpectrum[i].real();
+    lowIm[i] = lowSpectrum[i].imag();
+  }
+  failed += check(close(pixels<double>(re), lowRe, 1e-6*NX*NY) && close(pixels<double>(im), lowIm, 1e-6*NX*NY),
+                  "lowPassFilter spectrum rasters");
+
+  // mistakes:
+  GeoStar::Raster *narrow = img->create_raster("narrow", GeoStar::REAL64, NX-1, NY);
+  bool caught = false;
+  try {
+    in->frequencyFilter(narrow, filters[1]);
+  } catch(const GeoStar::RasterSizeErrorException &) {
+    caught = true;
+  }
+  failed += check(caught, "output of another size");
+
+  GeoStar::Raster *spectrum = img->create_raster("spectrum", GeoStar::COMPLEX_REAL128, NX, NY);
+  caught = false;
+  try {
+    spectrum->frequencyFilter(out, filters[1]);
+  } catch(const GeoStar::DataTypeException &) {
+    caught = true;
+  }
+  failed += check(caught, "complex raster");
+
+  caught = false;
+  try {
+    GeoStar::FrequencyFilter::lowPass(0);
+  } catch(const GeoStar::FrequencyParameterException &) {
+    caught = true;
+  }
+  failed += check(caught, "cutoff of 0");
+
+  caught = false;
+  try {
+    GeoStar::FrequencyFilter::highPass(0.1, GeoStar::FILTER_BUTTERWORTH, 0);
+  } catch(const GeoStar::IntegerParameterException &) {
+    caught = true;
+  }
+  failed += check(caught, "order of 0");
+
+  caught = false;
+  try {
+    GeoStar::FrequencyFilter::bandPass(0.3, 0.1);
+  } catch(const GeoStar::FrequencyParameterException &) {
+    caught = true;
+  }
+  failed += check(caught, "band pass from high to low");
+
+  delete spectrum;
+  delete narrow;
+  delete im;
+  delete re;
+  delete same;
+  delete flat;
+  delete out32;
+  delete out;
+  delete in32;
+  delete in;
+  delete img;
+  delete file;
+
+  boost::filesystem::remove(p);
+  return (failed == 0) ? 0 : 1;
+}// end-main
@@ -0,0 +1,65 @@
+// test12.cpp
+//
+// tests the write-back cache: reads see the pixels written to the cache
+// over those in the file, a read of the whole raster after a small write
+// is a single HDF5 read and brings no tiles into the cache, and flush
+// writes only the tiles written to.
+//
+// usage: test12
+//
+//---------------------------------------------------------
+#include <string>
+#include <iostream>
+#include <vector>
+#include "geostar.hpp"
+#include "testutil.hpp"
+
+#include "boost/filesystem.hpp"
+
+const long int NX = 256;
+const long int NY = 192;
+const long int TILE = 64;
+
+int main() {
+  int failed = 0;
+
+  boost::filesystem::path p("a12.h5");
+  boost::filesystem::remove(p);
+  GeoStar::File *file = new GeoStar::File("a12.h5", "new");
+  GeoStar::Image *img = file->create_image("landsat");
+
+  GeoStar::Raster *ras = ramp(img, "ramp", GeoStar::REAL32, NX, NY);
+  GeoStar::Raster *tiled = img->create_raster("tiled", GeoStar::REAL32, NX, NY,
+                                              GeoStar::RasterLayout(GeoStar::TILED, TILE));
+  std::vector<float> expected = pixels(ras);
+  tiled->write(GeoStar::RasterSlice(0, 0, NX, NY), &expected[0], expected.size());
+  delete ras;
+
+  // a small write, inside one tile, then reads of the whole raster:
+  GeoStar::RasterIOCounters &counters = GeoStar::Raster::io_counters();
+  tiled->set_write_cache(true);
+  const long int square[4] = {70, 10, 5, 5};
+  tiled->set(square, 9);
+  for(long int y=square[1]; y<square[1]+square[3]; ++y)
+    for(long int x=square[0]; x<square[0]+square[2]; ++x) expected[y*NX + x] = 9;
+
+  for(int pass=0; pass<2; ++pass) {
+    const std::string which = (pass == 0) ? "first" : "second";
+    counters.reset();
+    failed += check(pixels(tiled) == expected, which + " read sees the cache over the file");
+    failed += check(counters.read_calls == 1, which + " read is one HDF5 read");
+  }// endfor: pass
+
+  counters.reset();
+  tiled->flush();
+  failed += check(counters.write_calls == 1, "flush writes the one tile written to");
+  tiled->set_write_cache(false);
+  failed += check(pixels(tiled) == expected, "file after flush");
+
+  delete tiled;
+  delete img;
+  delete file;
+
+  boost::filesystem::remove(p);
+  return (failed == 0) ? 0 : 1;
+}// end-main
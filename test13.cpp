@@ -0,0 +1,163 @@
+// test13.cpp
+//
+// tests BandMath: NDVI against subtract, add and divide, nested
+// conditionals, a<-b, inputs with nodata, division by zero, and
+// formulas that do not parse.
+//
+// usage: test13
+//
+//---------------------------------------------------------
+#include <string>
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include "geostar.hpp"
+#include "testutil.hpp"
+
+#include "boost/filesystem.hpp"
+
+const long int NX = 70;
+const long int NY = 45;
+
+// formula evaluated on pixels in memory, two variables a and b in that order
+std::vector<float> evaluate(const std::string &formula, const std::vector<float> &a, const std::vector<float> &b) {
+  GeoStar::BandMath math(formula);
+  std::vector<const float *> in;
+  in.push_back(&a[0]);
+  in.push_back(&b[0]);
+  std::vector<float> out(a.size());
+  math.evaluate(in, a.size(), &out[0]);
+  return out;
+}// end: evaluate
+
+
+int main() {
+  int failed = 0;
+
+  boost::filesystem::path p("a13.h5");
+  boost::filesystem::remove(p);
+  GeoStar::File *file = new GeoStar::File("a13.h5", "new");
+  GeoStar::Image *img = file->create_image("landsat");
+
+  GeoStar::Raster *red = ramp(img, "red", GeoStar::REAL32, NX, NY, 7);
+  GeoStar::Raster *nir = ramp(img, "nir", GeoStar::REAL32, NX, NY, 3);
+  const std::vector<float> b4 = pixels(red);
+  const std::vector<float> b5 = pixels(nir);
+
+  // NDVI, against the eager operations where the sum is not 0 (divide gives 255 there, BandMath nodata):
+  GeoStar::Raster *diff = img->create_raster("diff", GeoStar::REAL32, NX, NY);
+  GeoStar::Raster *sum = img->create_raster("sum", GeoStar::REAL32, NX, NY);
+  GeoStar::Raster *eager = img->create_raster("eager", GeoStar::REAL32, NX, NY);
+  nir->subtract(red, diff);
+  nir->add(red, sum);
+  diff->divide(sum, eager);
+  std::vector<float> expected = pixels(eager);
+  for(long int i=0; i<NX*NY; ++i)
+    if(b4[i] + b5[i] == 0) expected[i] = -2;
+
+  GeoStar::Raster *out = img->create_raster("out", GeoStar::REAL32, NX, NY);
+  GeoStar::BandMath ndvi("(b5 - b4) / (b5 + b4)");
+  ndvi.set_input("b4", red);
+  ndvi.set_input("b5", nir);
+  ndvi.set_nodata(-2);
+  ndvi.evaluate(out);
+  failed += check(pixels(out) == expected, "NDVI against subtract, add and divide");
+  const long int blockShape[2] = {16, 5};
+  ndvi.evaluate(out, blockShape);
+  failed += check(pixels(out) == expected, "NDVI in small blocks");
+
+  // nested conditionals, either way round:
+  std::vector<float> classes(NX*NY);
+  for(long int i=0; i<NX*NY; ++i) classes[i] = (b4[i] > 100) ? ((b5[i] > 200) ? 2 : 1) : ((b5[i] < 50) ? -1 : 0);
+  GeoStar::BandMath nested("b4 > 100 ? (b5 > 200 ? 2 : 1) : b5 < 50 ? -1 : 0");
+  nested.set_input("b4", red);
+  nested.set_input("b5", nir);
+  nested.evaluate(out);
+  failed += check(pixels(out) == classes, "nested conditionals");
+
+  // a<-b is a < -b, and binds looser than the arithmetic:
+  const float aa[5] = {-3, -1, 1, 5, 0};
+  const float bb[5] = {2, 2, -2, -6, 0};
+  const std::vector<float> a(aa, aa+5), b(bb, bb+5);
+  std::vector<float> less(5);
+  for(int i=0; i<5; ++i) less[i] = (a[i] < -b[i]) ? 1 : 0;
+  failed += check(evaluate("a<-b", a, b) == less, "a<-b");
+  std::vector<float> shifted(5);
+  for(int i=0; i<5; ++i) shifted[i] = (a[i] + 1 < -b[i] * 2) ? 1 : 0;
+  failed += check(evaluate("a+1<-b*2", a, b) == shifted, "a+1<-b*2");
+
+  // inputs with nodata: any missing input makes the pixel missing
+  std::vector<float> masked(NX*NY);
+  for(long int i=0; i<NX*NY; ++i) masked[i] = (b4[i] == 0 || b5[i] == 75) ? -1 : b5[i] - b4[i];
+  GeoStar::BandMath change("b5 - b4");
+  change.set_input("b4", red, 0);
+  change.set_input("b5", nir, 75);
+  change.set_nodata(-1);
+  change.evaluate(out);
+  failed += check(pixels(out) == masked, "inputs with nodata");
+
+  std::vector<float> withNaN(a);
+  withNaN[1] = std::nan("");
+  GeoStar::BandMath missing("a * 2 + b");
+  missing.set_input("a", red, std::nan(""));
+  std::vector<const float *> in;
+  in.push_back(&withNaN[0]);
+  in.push_back(&b[0]);
+  std::vector<float> result(5);
+  missing.evaluate(in, 5, &result[0]);
+  failed += check(std::isnan(result[1]) && result[0] == a[0]*2 + b[0] && result[3] == a[3]*2 + b[3],
+                  "NaN as the nodata of an input");
+
+  // division by zero gives the output nodata, NaN unless set:
+  const std::vector<float> quotient = evaluate("a / b", a, b);
+  failed += check(std::isnan(quotient[4]) && quotient[0] == a[0] / b[0], "division by zero is NaN");
+  GeoStar::BandMath ratio("b4 / (b5 - b5)");
+  ratio.set_input("b4", red);
+  ratio.set_input("b5", nir);
+  ratio.set_nodata(-9);
+  ratio.evaluate(out);
+  failed += check(pixels(out) == std::vector<float>(NX*NY, -9), "division by zero is the output nodata");
+
+  // mistakes:
+  const std::string malformed[10] = {"", "(b5 - b4", "b5 - b4)", "b5 +", "b5 b4", "sqrt(b5", "pow(b5)",
+                                     "b5 > 0 ? 1", "2 $ 3", "min(b4, b5, 1)"};
+  for(int m=0; m<10; ++m) {
+    bool caught = false;
+    try {
+      GeoStar::BandMath bad(malformed[m]);
+    } catch(const GeoStar::BandMathSyntaxException &) {
+      caught = true;
+    }
+    failed += check(caught, "syntax error in \"" + malformed[m] + "\"");
+  }// endfor: m
+
+  bool caught = false;
+  try {
+    ndvi.set_input("b3", red);
+  } catch(const GeoStar::BandMathInputException &) {
+    caught = true;
+  }
+  failed += check(caught, "input the formula does not use");
+
+  caught = false;
+  try {
+    GeoStar::BandMath unbound("b4 + b5");
+    unbound.set_input("b4", red);
+    unbound.evaluate(out);
+  } catch(const GeoStar::BandMathInputException &) {
+    caught = true;
+  }
+  failed += check(caught, "variable not bound");
+
+  delete out;
+  delete eager;
+  delete sum;
+  delete diff;
+  delete nir;
+  delete red;
+  delete img;
+  delete file;
+
+  boost::filesystem::remove(p);
+  return (failed == 0) ? 0 : 1;
+}// end-main
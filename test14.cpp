@@ -0,0 +1,236 @@
+// test14.cpp
+//
+// tests BandStack: write_bsq and read_bsq, read_bip of a slice away from
+// the origin, read_band and write_band, for_each_block, reopening a stack,
+// Image::read_file_bands on a GeoTIFF, and the mistakes: a stack that
+// exists or does not, slices outside the stack, a read-only file.
+//
+// usage: test14
+//
+//---------------------------------------------------------
+#include <string>
+#include <iostream>
+#include <vector>
+#include "geostar.hpp"
+#include "testutil.hpp"
+#include "gdal_priv.h"
+
+#include "boost/filesystem.hpp"
+
+const long int NB = 3;
+const long int NX = 37;
+const long int NY = 29;
+
+// value of pixel x, y of band b
+float value(const long int &b, const long int &x, const long int &y) {
+  return float(b*1000 + y*NX + x);
+}// end: value
+
+
+// slice of every band, band after band
+std::vector<float> bsq(const GeoStar::RasterSlice &slice) {
+  std::vector<float> out;
+  for(long int b=0; b<NB; ++b)
+    for(long int y=slice.y0; y<slice.y0+slice.dy; ++y)
+      for(long int x=slice.x0; x<slice.x0+slice.dx; ++x) out.push_back(value(b, x, y));
+  return out;
+}// end: bsq
+
+
+// slice of every band, pixel after pixel
+std::vector<double> bip(const GeoStar::RasterSlice &slice) {
+  std::vector<double> out;
+  for(long int y=slice.y0; y<slice.y0+slice.dy; ++y)
+    for(long int x=slice.x0; x<slice.x0+slice.dx; ++x)
+      for(long int b=0; b<NB; ++b) out.push_back(value(b, x, y));
+  return out;
+}// end: bip
+
+
+// writes the bands to a GeoTIFF, as read_file_bands reads them
+bool write_tiff(const std::string &path) {
+  GDALAllRegister();
+  GDALDriver *driver = GetGDALDriverManager()->GetDriverByName("GTiff");
+  if(driver == NULL) return false;
+  GDALDataset *dataset = driver->Create(path.c_str(), NX, NY, NB, GDT_Float32, NULL);
+  if(dataset == NULL) return false;
+  std::vector<float> data = bsq(GeoStar::RasterSlice(0, 0, NX, NY));
+  for(long int b=0; b<NB; ++b)
+    dataset->GetRasterBand(b+1)->RasterIO(GF_Write, 0, 0, NX, NY, &data[b*NX*NY], NX, NY, GDT_Float32, 0, 0);
+  GDALClose(dataset);
+  return true;
+}// end: write_tiff
+
+
+int main() {
+  int failed = 0;
+
+  boost::filesystem::path p("a14.h5");
+  boost::filesystem::path tiff("a14.tif");
+  boost::filesystem::remove(p);
+  boost::filesystem::remove(tiff);
+  GeoStar::File *file = new GeoStar::File("a14.h5", "new");
+  GeoStar::Image *img = file->create_image("landsat");
+
+  // write and read every band, in tiles smaller than the stack:
+  const GeoStar::RasterSlice all(0, 0, NX, NY);
+  const GeoStar::RasterSlice block(5, 7, 11, 9);
+  GeoStar::BandStack *stack = img->create_bandstack("stack", GeoStar::REAL32, NB, NX, NY,
+                                                    GeoStar::RasterLayout(GeoStar::TILED, 16));
+  std::vector<float> data = bsq(all);
+  stack->write_bsq(all, &data[0], data.size());
+  std::vector<float> back(NB*NX*NY);
+  stack->read_bsq(all, &back[0], back.size());
+  failed += check(back == data, "write_bsq then read_bsq");
+  stack->read_bsq(block, &back[0], back.size());
+  back.resize(NB*block.size());
+  failed += check(back == bsq(block), "read_bsq of a slice");
+
+  std::vector<double> pixelOrder;
+  std::vector<char> scratch;
+  stack->read_bip(block, pixelOrder, scratch);
+  failed += check(pixelOrder == bip(block), "read_bip of a slice");
+
+  std::vector<float> band(block.size());
+  stack->read_band(1, block, &band[0], band.size());
+  failed += check(std::vector<float>(back.begin() + block.size(), back.begin() + 2*block.size()) == band,
+                  "read_band");
+
+  // write_band and write_bip over parts of the stack:
+  const GeoStar::RasterSlice corner(NX-4, NY-3, 4, 3);
+  std::vector<float> ones(corner.size(), 1);
+  stack->write_band(2, corner, &ones[0], ones.size());
+  band.resize(corner.size());
+  stack->read_band(2, corner, &band[0], band.size());
+  failed += check(band == ones, "write_band");
+
+  std::vector<double> interleaved = bip(corner);
+  stack->write_bip(corner, interleaved, scratch);
+  pixelOrder.clear();
+  stack->read_bip(corner, pixelOrder, scratch);
+  failed += check(pixelOrder == interleaved, "write_bip then read_bip");
+
+  // for_each_block: the sum of the bands, in small blocks and the default ones
+  std::vector<float> expected(NX*NY);
+  for(long int y=0; y<NY; ++y)
+    for(long int x=0; x<NX; ++x) expected[y*NX + x] = value(0, x, y) + value(1, x, y) + value(2, x, y);
+  GeoStar::Raster *sum = img->create_raster("sum", GeoStar::REAL32, NX, NY);
+  const long int blockShape[2] = {10, 8};
+  const std::vector<float> zeros(NX*NY, 0);
+  for(int pass=0; pass<2; ++pass) {
+    sum->write(all, &zeros[0], zeros.size());
+    stack->for_each_block<float>(pass == 0 ? blockShape : NULL, sum,
+      [](const std::vector<long int> &slice, const std::vector<float> &pixels, std::vector<float> &out) {
+        for(long int i=0; i<slice[2]*slice[3]; ++i) out[i] = pixels[i*NB] + pixels[i*NB+1] + pixels[i*NB+2];
+      });
+    failed += check(pixels(sum) == expected, pass == 0 ? "for_each_block" : "for_each_block, default blocks");
+  }// endfor: pass
+  delete stack;
+
+  // reopened:
+  stack = img->open_bandstack("stack");
+  failed += check(stack->get_nbands() == NB && stack->get_nx() == NX && stack->get_ny() == NY
+                  && stack->get_datatype() == GeoStar::REAL32, "reopened size and type");
+  back.resize(NB*NX*NY);
+  stack->read_bsq(all, &back[0], back.size());
+  failed += check(back == data, "reopened pixels");
+
+  // read_file_bands, all the channels of a GeoTIFF:
+  if(write_tiff(tiff.string())) {
+    GeoStar::BandStack *fromFile = img->read_file_bands(tiff.string(), "fromfile");
+    failed += check(fromFile->get_nbands() == NB && fromFile->get_nx() == NX && fromFile->get_ny() == NY,
+                    "read_file_bands size");
+    fromFile->read_bsq(all, &back[0], back.size());
+    failed += check(back == bsq(all), "read_file_bands pixels");
+    delete fromFile;
+  } else {
+    failed += check(false, "GeoTIFF for read_file_bands");
+  }// endif
+
+  // mistakes:
+  bool caught = false;
+  try {
+    img->read_file_bands("a14-none.tif", "none");
+  } catch(const GeoStar::FileOpenErrorException &) {
+    caught = true;
+  }
+  failed += check(caught, "read_file_bands of a missing file");
+
+  caught = false;
+  try {
+    img->create_bandstack("stack", GeoStar::REAL32, NB, NX, NY);
+  } catch(const GeoStar::RasterExistsException &) {
+    caught = true;
+  }
+  failed += check(caught, "stack that exists");
+
+  caught = false;
+  try {
+    img->open_bandstack("none");
+  } catch(const GeoStar::RasterDoesNotExistException &) {
+    caught = true;
+  }
+  failed += check(caught, "stack that does not exist");
+
+  caught = false;
+  try {
+    stack->read_bsq(GeoStar::RasterSlice(NX-5, 0, 10, 1), &back[0], back.size());
+  } catch(const GeoStar::SliceSizeException &) {
+    caught = true;
+  }
+  failed += check(caught, "slice outside the stack");
+
+  caught = false;
+  try {
+    stack->read_bsq(all, &back[0], back.size()-1);
+  } catch(const GeoStar::SliceSizeException &) {
+    caught = true;
+  }
+  failed += check(caught, "buffer too small");
+
+  caught = false;
+  try {
+    stack->read_band(NB, block, &back[0], back.size());
+  } catch(const GeoStar::SliceSizeException &) {
+    caught = true;
+  }
+  failed += check(caught, "band outside the stack");
+
+  GeoStar::Raster *narrow = img->create_raster("narrow", GeoStar::REAL32, NX-1, NY);
+  caught = false;
+  try {
+    stack->for_each_block<float>(NULL, narrow,
+      [](const std::vector<long int> &, const std::vector<float> &, std::vector<float> &) {});
+  } catch(const GeoStar::RasterSizeErrorException &) {
+    caught = true;
+  }
+  failed += check(caught, "for_each_block into a raster of another size");
+
+  delete narrow;
+  delete stack;
+  delete sum;
+  delete img;
+  delete file;
+
+  // read only: the stack can be read, not created
+  file = new GeoStar::File("a14.h5", "readonly");
+  img = file->open_image("landsat");
+  stack = img->open_bandstack("stack");
+  stack->read_bsq(all, &back[0], back.size());
+  failed += check(back == data, "read from a read-only file");
+  caught = false;
+  try {
+    img->create_bandstack("other", GeoStar::REAL32, NB, NX, NY);
+  } catch(const GeoStar::FileReadOnlyException &) {
+    caught = true;
+  }
+  failed += check(caught, "create in a read-only file");
+
+  delete stack;
+  delete img;
+  delete file;
+
+  boost::filesystem::remove(p);
+  boost::filesystem::remove(tiff);
+  return (failed == 0) ? 0 : 1;
+}// end-main
@@ -0,0 +1,144 @@
+// test15.cpp
+//
+// tests every RasterType: a raster of each type is created, written and
+// read back at the full width of the type, has its type recognised by
+// raster_type_of, and keeps its type and pixels when the file is
+// reopened.  Complex rasters are {re, im} compounds.
+//
+// usage: test15
+//
+//---------------------------------------------------------
+#include <string>
+#include <iostream>
+#include <vector>
+#include <complex>
+#include "geostar.hpp"
+#include "testutil.hpp"
+
+#include "boost/filesystem.hpp"
+
+const long int NX = 13;
+const long int NY = 7;
+const int NTYPES = 16;
+
+const GeoStar::RasterType TYPES[NTYPES] = {
+  GeoStar::INT8U, GeoStar::INT8S, GeoStar::INT16U, GeoStar::INT16S,
+  GeoStar::INT32U, GeoStar::INT32S, GeoStar::INT64U, GeoStar::INT64S,
+  GeoStar::REAL32, GeoStar::REAL64,
+  GeoStar::COMPLEX_INT16, GeoStar::COMPLEX_INT32, GeoStar::COMPLEX_INT64, GeoStar::COMPLEX_INT128,
+  GeoStar::COMPLEX_REAL64, GeoStar::COMPLEX_REAL128
+};
+
+const std::string NAMES[NTYPES] = {
+  "INT8U", "INT8S", "INT16U", "INT16S", "INT32U", "INT32S", "INT64U", "INT64S", "REAL32", "REAL64",
+  "COMPLEX_INT16", "COMPLEX_INT32", "COMPLEX_INT64", "COMPLEX_INT128", "COMPLEX_REAL64", "COMPLEX_REAL128"
+};
+
+
+// pixels for a raster of type: values that only fit in a type that wide, negative ones if it is signed,
+// and fractions that only a double holds for REAL64 and COMPLEX_REAL128
+std::vector<std::complex<double> > values(const GeoStar::RasterType &type) {
+  double offset = 0, step = 1, fraction = 0;
+  bool isSigned = true;
+  switch(type) {
+  case GeoStar::INT8U:           isSigned = false; step = 20;      break;
+  case GeoStar::INT16U:          isSigned = false; offset = 300;   break;
+  case GeoStar::INT16S:          offset = 300;                      break;
+  case GeoStar::INT32U:          isSigned = false; offset = 3.0e9; break;
+  case GeoStar::INT32S:
+  case GeoStar::COMPLEX_INT64:   offset = 70000;                    break;
+  case GeoStar::INT64U:          isSigned = false; offset = 1099511627776.0; break;
+  case GeoStar::INT64S:
+  case GeoStar::COMPLEX_INT128:  offset = 1099511627776.0;          break;
+  case GeoStar::COMPLEX_INT32:   offset = 300;                      break;
+  case GeoStar::REAL32:
+  case GeoStar::COMPLEX_REAL64:  fraction = 0.25;                   break;
+  case GeoStar::REAL64:
+  case GeoStar::COMPLEX_REAL128: fraction = 0.1;                    break;
+  default:                                                          break;
+  }// end case
+
+  std::vector<std::complex<double> > out(NX*NY);
+  for(long int i=0; i<NX*NY; ++i) {
+    const double v = double(i % 11) * step - (isSigned ? 5 : 0);
+    const double re = (v < 0 ? -offset : offset) + v + fraction;
+    out[i] = GeoStar::is_complex(type) ? std::complex<double>(re, -re) : std::complex<double>(re, 0);
+  }// endfor: i
+  return out;
+}// end: values
+
+
+// the pixels of ras, complex or not
+std::vector<std::complex<double> > read_back(const GeoStar::Raster *ras) {
+  if(GeoStar::is_complex(ras->get_datatype())) return pixels<std::complex<double> >(ras);
+  const std::vector<double> real = pixels<double>(ras);
+  return std::vector<std::complex<double> >(real.begin(), real.end());
+}// end: read_back
+
+
+// type, get_datatype and raster_type_of all agree
+bool type_of(const GeoStar::Raster *ras, const GeoStar::RasterType &type) {
+  GeoStar::RasterType found;
+  return ras->get_datatype() == type && GeoStar::raster_type_of(*ras->rasterobj, found) && found == type;
+}// end: type_of
+
+
+int main() {
+  int failed = 0;
+
+  boost::filesystem::path p("a15.h5");
+  boost::filesystem::remove(p);
+  GeoStar::File *file = new GeoStar::File("a15.h5", "new");
+  GeoStar::Image *img = file->create_image("landsat");
+
+  // create, write, read:
+  for(int t=0; t<NTYPES; ++t) {
+    GeoStar::Raster *ras = img->create_raster(NAMES[t], TYPES[t], NX, NY);
+    const std::vector<std::complex<double> > data = values(TYPES[t]);
+    if(GeoStar::is_complex(TYPES[t])) {
+      ras->write(GeoStar::RasterSlice(0, 0, NX, NY), &data[0], data.size());
+    } else {
+      std::vector<double> real(NX*NY);
+      for(long int i=0; i<NX*NY; ++i) real[i] = data[i].real();
+      ras->write(GeoStar::RasterSlice(0, 0, NX, NY), &real[0], real.size());
+    }// endif
+    failed += check(type_of(ras, TYPES[t]), NAMES[t] + " created");
+    failed += check(read_back(ras) == data, NAMES[t] + " round trip");
+    delete ras;
+  }// endfor: t
+
+  // the complex types are compounds of re and im, of half their size each:
+  GeoStar::Raster *ras = img->open_raster("COMPLEX_INT64");
+  const H5::CompType compound = ras->rasterobj->getCompType();
+  failed += check(compound.getNmembers() == 2 && compound.getMemberName(0) == "re"
+                  && compound.getMemberName(1) == "im" && compound.getSize() == 8
+                  && compound.getMemberIntType(0).getSize() == 4, "COMPLEX_INT64 is {int32 re, int32 im}");
+  delete ras;
+
+  delete img;
+  delete file;
+
+  // reopened:
+  file = new GeoStar::File("a15.h5", "existing");
+  img = file->open_image("landsat");
+  for(int t=0; t<NTYPES; ++t) {
+    ras = img->open_raster(NAMES[t]);
+    failed += check(type_of(ras, TYPES[t]) && read_back(ras) == values(TYPES[t]), NAMES[t] + " reopened");
+    delete ras;
+  }// endfor: t
+
+  // a dataset that is no raster type:
+  H5::CompType pair(2*sizeof(float));
+  pair.insertMember("x", 0, H5::PredType::NATIVE_FLOAT);
+  pair.insertMember("y", sizeof(float), H5::PredType::NATIVE_FLOAT);
+  const hsize_t dims[1] = {4};
+  H5::DataSet other = img->imageobj->createDataSet("other", pair, H5::DataSpace(1, dims));
+  GeoStar::RasterType found;
+  failed += check(!GeoStar::raster_type_of(other, found), "compound of other members is no raster type");
+
+  delete img;
+  delete file;
+
+  boost::filesystem::remove(p);
+  return (failed == 0) ? 0 : 1;
+}// end-main
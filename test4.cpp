@@ -87,12 +87,10 @@ main() {
 	in = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * nx);
 	out = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * nx);
 
-	fftw_plan plan;
-	plan = fftw_plan_dft_1d(nx, in, out, FFTW_FORWARD, FFTW_ESTIMATE);
+	//plans come from the cache of the Raster FFTs, which keeps (and destroys) them
+	fftw_plan plan = GeoStar::FFTPlans::shared().dft_1d(nx, FFTW_FORWARD);
 	//execute plan
-	fftw_execute(plan);
-	//delete plan at end
-	fftw_destroy_plan(plan);
+	fftw_execute_dft(plan, in, out);
 	fftw_free(in); fftw_free(out);
 	}//end - basetest
 
@@ -103,8 +101,7 @@ main() {
 	fftw_complex *in2, *out2;
 	in2 = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * nx);
 	out2 = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * nx);
-	fftw_plan plan2;
-	plan2 = fftw_plan_dft_1d(nx, in2, out2, FFTW_FORWARD, FFTW_ESTIMATE);
+	fftw_plan plan2 = GeoStar::FFTPlans::shared().dft_1d(nx, FFTW_FORWARD);
 
 	std::vector<long int>sliceFFTW(4);
     		sliceFFTW[0]=0;
@@ -127,7 +124,7 @@ main() {
 	}
 
 	
-	fftw_execute(plan2);
+	fftw_execute_dft(plan2, in2, out2);
 	
 	for (int i = 0; i < nx; i++) {
 		dataReal[i] = out2[i][0];
@@ -139,14 +136,12 @@ main() {
 	}//endfor - row-by-row
 
 	//now delete objects and reinitialize for the ny size - cols transform
-	fftw_destroy_plan(plan2);
 	fftw_free(in2); fftw_free(out2);
 
 	fftw_complex *inCols, *outCols;
 	inCols = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * ny);
 	outCols = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * ny);
-	fftw_plan planCols;
-	planCols = fftw_plan_dft_1d(ny, inCols, outCols, FFTW_FORWARD, FFTW_ESTIMATE);
+	fftw_plan planCols = GeoStar::FFTPlans::shared().dft_1d(ny, FFTW_FORWARD);
 
 		sliceFFTW[0] = 0;
     		sliceFFTW[1] = 0;
@@ -167,7 +162,7 @@ main() {
 		inCols[i][1] = dataImg[i];
 	}
 	
-	fftw_execute(planCols);
+	fftw_execute_dft(planCols, inCols, outCols);
 	
 	for (int i = 0; i < ny; ++i) {
 		dataReal[i] = outCols[i][0];
@@ -181,7 +176,6 @@ main() {
 	cout << "at 3" << endl;
 	delete rasBufferReal;
 	delete rasBufferImg;
-	fftw_destroy_plan(planCols);
 	fftw_free(inCols); fftw_free(outCols);
 	
 	}//end - FFTW_2D_C2C_Test
@@ -196,8 +190,7 @@ main() {
 	fftw_complex *in2, *out2;
 	in2 = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * nx);
 	out2 = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * nx);
-	fftw_plan plan2;
-	plan2 = fftw_plan_dft_1d(nx, in2, out2, FFTW_FORWARD, FFTW_ESTIMATE);
+	fftw_plan plan2 = GeoStar::FFTPlans::shared().dft_1d(nx, FFTW_FORWARD);
 
 	std::vector<long int>sliceFFTW(4);
     		sliceFFTW[0]=0;
@@ -223,7 +216,7 @@ main() {
 	cout << "imaginary part " << in2[i][1] << endl;
 	}*/
 
-	fftw_execute(plan2);
+	fftw_execute_dft(plan2, in2, out2);
 	
 	for (int i = 0; i < nx; i++) {
 		dataReal[i] = out2[i][0];
@@ -235,14 +228,12 @@ main() {
 	}//endfor - row-by-row
 
 	//now delete objects and reinitialize for the ny size - cols transform
-	fftw_destroy_plan(plan2);
 	fftw_free(in2); fftw_free(out2);
 
 	fftw_complex *inCols, *outCols;
 	inCols = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * ny);
 	outCols = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * ny);
-	fftw_plan planCols;
-	planCols = fftw_plan_dft_1d(ny, inCols, outCols, FFTW_FORWARD, FFTW_ESTIMATE);
+	fftw_plan planCols = GeoStar::FFTPlans::shared().dft_1d(ny, FFTW_FORWARD);
 
 		sliceFFTW[0] = 0;
     		sliceFFTW[1] = 0;
@@ -266,7 +257,7 @@ main() {
 		//cout << " before fft - inCols Imaginary equals " << inCols[i][1] << endl;
 	}
 
-	fftw_execute(planCols);
+	fftw_execute_dft(planCols, inCols, outCols);
 	
 	for (int i = 0; i < ny; ++i) {
 		//cout << " after fft - outCols Real equals " << outCols[i][0] << endl;
@@ -284,7 +275,6 @@ main() {
 	cout << "at 3" << endl;
 	delete rasBufferReal;
 	delete rasBufferImg;
-	fftw_destroy_plan(planCols);
 	fftw_free(inCols); fftw_free(outCols);
 
 	}//end - FFTW_2D_C2C_Cos_Test
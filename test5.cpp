@@ -0,0 +1,149 @@
+// test5.cpp
+//
+// tests "readonly" files: several processes open the same file at once,
+// each checks every pixel it reads and that the file refuses writes.
+// A contiguous copy of the raster is also checked through a mapped RasterView.
+//
+// usage: test5 [nreaders]
+//
+//---------------------------------------------------------
+#include <string>
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "geostar.hpp"
+
+#include "boost/filesystem.hpp"
+
+const long int NX = 1000;
+const long int NY = 800;
+
+// value of pixel (x, y) of the test raster
+float expected_pixel(const long int x, const long int y);
+
+// opens the file readonly and checks it; returns the number of failed checks
+int reader(const int id);
+
+
+int main(int argc, char *argv[]) {
+
+  int nreaders = 8;
+  if(argc > 1) nreaders = atoi(argv[1]);
+
+  // delete output file if already exists
+  boost::filesystem::path p("a5.h5");
+  boost::filesystem::remove(p);
+
+  // write the test raster, and close the file before the readers start:
+  GeoStar::File *file = new GeoStar::File("a5.h5", "new");
+  GeoStar::Image *img = file->create_image("landsat");
+  GeoStar::Raster *ras = img->create_raster("chan1", GeoStar::REAL32, NX, NY);
+  GeoStar::Raster *flat = img->create_raster("chan1_flat", GeoStar::REAL32, NX, NY, GeoStar::RasterLayout(GeoStar::CONTIGUOUS));
+
+  std::vector<float> row(NX);
+  for(long int y=0; y<NY; ++y) {
+    for(long int x=0; x<NX; ++x) row[x] = expected_pixel(x, y);
+    ras->write(GeoStar::RasterSlice(0, y, NX, 1), &row[0], row.size());
+    flat->write(GeoStar::RasterSlice(0, y, NX, 1), &row[0], row.size());
+  }// endfor: y
+
+  delete flat;
+  delete ras;
+  delete img;
+  delete file;
+
+  // readers in child processes, and one more in this process, all at the same time:
+  std::vector<pid_t> children;
+  for(int i=0; i<nreaders; ++i) {
+    pid_t pid = fork();
+    if(pid == 0) _exit(reader(i) == 0 ? 0 : 1);
+    if(pid < 0) {
+      std::cout << "fork failed" << std::endl;
+      break;
+    }// endif
+    children.push_back(pid);
+  }// endfor: i
+
+  int failed = (reader(nreaders) == 0) ? 0 : 1;
+
+  for(size_t i=0; i<children.size(); ++i) {
+    int status;
+    waitpid(children[i], &status, 0);
+    if(!WIFEXITED(status) || WEXITSTATUS(status) != 0) ++failed;
+  }// endfor: i
+
+  std::cout << children.size()+1 << " concurrent readers, " << failed << " failed" << std::endl;
+
+  boost::filesystem::remove(p);
+  return (failed == 0) ? 0 : 1;
+}// end-main
+
+
+
+float expected_pixel(const long int x, const long int y) {
+  return (y*7 + x*13) % 251;
+}// end: expected_pixel
+
+
+
+int reader(const int id) {
+  int errors = 0;
+
+  try {
+    GeoStar::File *file = new GeoStar::File("a5.h5", "readonly");
+    GeoStar::Image *img = file->open_image("landsat");
+    GeoStar::Raster *ras = img->open_raster("chan1");
+
+    // every pixel, in blocks of rows:
+    const long int rows = 64;
+    std::vector<float> data(NX*rows);
+    for(long int y=0; y<NY; y+=rows) {
+      const long int dy = std::min(rows, NY-y);
+      ras->read(GeoStar::RasterSlice(0, y, NX, dy), &data[0], data.size());
+      for(long int j=0; j<dy; ++j)
+        for(long int x=0; x<NX; ++x)
+          if(data[j*NX+x] != expected_pixel(x, y+j)) ++errors;
+    }// endfor: y
+
+    // the contiguous copy is mapped, the tiled raster is read:
+    GeoStar::Raster *flat = img->open_raster("chan1_flat");
+    GeoStar::RasterView<float> view(flat);
+    GeoStar::RasterView<float> tiledView(ras);
+    delete flat;
+    if(!view.is_mapped() || tiledView.is_mapped()) ++errors;
+    for(long int y=0; y<NY; ++y)
+      for(long int x=0; x<NX; ++x)
+        if(view(x, y) != expected_pixel(x, y) || tiledView(x, y) != expected_pixel(x, y)) ++errors;
+
+    // nothing may be written:
+    try {
+      ras->write(GeoStar::RasterSlice(0, 0, NX, 1), &data[0], data.size());
+      ++errors;
+    } catch(GeoStar::FileReadOnlyException &) {
+    }
+    try {
+      GeoStar::Raster *other = img->create_raster("other", GeoStar::REAL32, NX, NY);
+      delete other;
+      ++errors;
+    } catch(GeoStar::FileReadOnlyException &) {
+    }
+    try {
+      GeoStar::Image *other = file->create_image("other");
+      delete other;
+      ++errors;
+    } catch(GeoStar::FileReadOnlyException &) {
+    }
+
+    delete ras;
+    delete img;
+    delete file;
+  } catch(...) {
+    ++errors;
+  }
+
+  if(errors > 0) std::cout << "reader " << id << ": " << errors << " errors" << std::endl;
+  return errors;
+}// end: reader
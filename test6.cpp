@@ -0,0 +1,95 @@
+// test6.cpp
+//
+// tests the Scratch workspace: temporaries get unique names, spill to the
+// scratch file past the memory budget, are removed on release, and an FFT
+// can run twice on the same image without leaving buffers in its file.
+//
+// usage: test6
+//
+//---------------------------------------------------------
+#include <string>
+#include <iostream>
+#include <vector>
+#include "geostar.hpp"
+#include "testutil.hpp"
+
+#include "boost/filesystem.hpp"
+
+const long int NX = 256;
+const long int NY = 128;
+
+int main() {
+  int failed = 0;
+
+  // delete output file if already exists
+  boost::filesystem::path p("a6.h5");
+  boost::filesystem::remove(p);
+
+  // budget for exactly one REAL32 temporary in memory:
+  const size_t bytes = NX * NY * sizeof(float);
+  {
+    GeoStar::Scratch scratch(bytes);
+    GeoStar::ScratchRaster first(scratch, GeoStar::REAL32, NX, NY);
+    failed += check(scratch.get_memory_bytes() == bytes && scratch.get_spill_bytes() == 0, "first temporary in memory");
+    {
+      GeoStar::ScratchRaster second(scratch, GeoStar::REAL32, NX, NY);
+      failed += check(scratch.get_spill_bytes() == bytes, "second temporary spilled");
+      failed += check(first->get_name() != second->get_name(), "unique names");
+
+      std::vector<float> row(NX, 7.0f), back(NX, 0.0f);
+      second->write(GeoStar::RasterSlice(0, 3, NX, 1), &row[0], row.size());
+      second->read(GeoStar::RasterSlice(0, 3, NX, 1), &back[0], back.size());
+      failed += check(back == row, "spilled temporary reads back");
+    }
+    failed += check(scratch.get_spill_bytes() == 0, "spilled temporary released");
+  }
+
+  // temporaries of no bytes: the in-memory file stays open while any is left
+  {
+    GeoStar::Scratch scratch(bytes);
+    GeoStar::Raster *empty = scratch.create_raster(GeoStar::REAL32, 0, NY);
+    GeoStar::Raster *other = scratch.create_raster(GeoStar::REAL32, NX, 0);
+    bool released = true;
+    try {
+      scratch.release(empty);
+      failed += check(other->get_nx() == NX, "other empty temporary still open");
+      scratch.release(other);
+    } catch(...) {
+      released = false;
+    }
+    failed += check(released, "empty temporaries released");
+  }
+
+  // FFT twice on one image, then only the user's rasters are in it:
+  GeoStar::File *file = new GeoStar::File("a6.h5", "new");
+  GeoStar::Image *img = file->create_image("landsat");
+  GeoStar::Raster *ras = img->create_raster("chan1", GeoStar::REAL32, NX, NY);
+  GeoStar::Raster *re = img->create_raster("re", GeoStar::REAL32, NX, NY);
+  GeoStar::Raster *im = img->create_raster("im", GeoStar::REAL32, NX, NY);
+
+  std::vector<float> row(NX);
+  for(long int y=0; y<NY; ++y) {
+    for(long int x=0; x<NX; ++x) row[x] = float((x*y) % 17);
+    ras->write(GeoStar::RasterSlice(0, y, NX, 1), &row[0], row.size());
+  }// endfor: y
+
+  bool ran = true;
+  try {
+    ras->FFT_2D(img, re, im);
+    ras->FFT_2D(img, re, im);
+  } catch(...) {
+    ran = false;
+  }
+  failed += check(ran, "FFT_2D twice on one image");
+  failed += check(!img->datasetExists("BufferComplex") && !img->datasetExists("BufferReal"), "no buffers left in the image");
+  failed += check(GeoStar::Scratch::shared().get_memory_bytes() == 0, "shared workspace empty");
+
+  delete im;
+  delete re;
+  delete ras;
+  delete img;
+  delete file;
+
+  boost::filesystem::remove(p);
+  return (failed == 0) ? 0 : 1;
+}// end-main
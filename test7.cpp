@@ -0,0 +1,97 @@
+// test7.cpp
+//
+// tests InMemoryRaster: load and store round trip the pixels, reads and
+// writes convert types as HDF5 does, and a chain of operations gives the
+// same pixels in memory as on rasters in the file.
+//
+// usage: test7
+//
+//---------------------------------------------------------
+#include <string>
+#include <iostream>
+#include <vector>
+#include <cstdint>
+#include "geostar.hpp"
+#include "testutil.hpp"
+
+#include "boost/filesystem.hpp"
+
+const long int NX = 300;
+const long int NY = 200;
+
+int main() {
+  int failed = 0;
+
+  // delete output file if already exists
+  boost::filesystem::path p("a7.h5");
+  boost::filesystem::remove(p);
+
+  GeoStar::File *file = new GeoStar::File("a7.h5", "new");
+  GeoStar::Image *img = file->create_image("landsat");
+  GeoStar::Raster *ras = img->create_raster("chan1", GeoStar::INT16U, NX, NY);
+
+  std::vector<float> row(NX);
+  for(long int y=0; y<NY; ++y) {
+    for(long int x=0; x<NX; ++x) row[x] = float((x*7 + y*13) % 251);
+    ras->write(GeoStar::RasterSlice(0, y, NX, 1), &row[0], row.size());
+  }// endfor: y
+
+  // load, and a round trip through store:
+  GeoStar::InMemoryRaster *mem = ras->load();
+  failed += check(mem->is_in_memory() && !ras->is_in_memory(), "is_in_memory");
+  failed += check(mem->get_datatype() == GeoStar::INT16U && mem->get_nx() == NX && mem->get_ny() == NY, "load keeps type and size");
+  failed += check(pixels(mem) == pixels(ras), "load copies the pixels");
+
+  GeoStar::Raster *copy = mem->store(img, "chan1_copy");
+  failed += check(pixels(copy) == pixels(ras), "store writes the pixels");
+  delete copy;
+
+  // a column read, and a float write saturated to the raster's type:
+  std::vector<uint8_t> column(NY);
+  mem->read(GeoStar::RasterSlice(5, 0, 1, NY), &column[0], column.size());
+  failed += check(column[10] == (5*7 + 10*13) % 251, "column read converted to uint8");
+  std::vector<double> values(3, 70000.0);
+  mem->write(GeoStar::RasterSlice(1, 1, 3, 1), &values[0], values.size());
+  std::vector<int32_t> back(3);
+  mem->read(GeoStar::RasterSlice(1, 1, 3, 1), &back[0], back.size());
+  failed += check(back[0] == 65535, "write converted as HDF5 converts");
+
+  // thresh -> scale -> gradientMask, in the file and in memory:
+  delete mem;
+  mem = ras->load();
+  GeoStar::Raster *scaled = img->create_raster("scaled", GeoStar::REAL32, NX, NY);
+  GeoStar::Raster *edges = img->create_raster("edges", GeoStar::REAL32, NX, NY);
+  ras->thresh(100);
+  ras->scale(scaled, 0, 2);
+  scaled->gradientMask(edges, 1);
+
+  GeoStar::InMemoryRaster memScaled("scaled", GeoStar::REAL32, NX, NY);
+  GeoStar::InMemoryRaster memEdges("edges", GeoStar::REAL32, NX, NY);
+  GeoStar::Raster::io_counters().reset();
+  mem->thresh(100);
+  mem->scale(&memScaled, 0, 2);
+  memScaled.gradientMask(&memEdges, 1);
+  failed += check(GeoStar::Raster::io_counters().read_calls == 0, "no HDF5 reads in memory");
+  failed += check(pixels(&memEdges) == pixels(edges), "same result in memory and in the file");
+
+  // an expression over in-memory rasters makes an in-memory raster:
+  GeoStar::Raster *sum = memScaled + memEdges;
+  failed += check(sum->is_in_memory() && sum->getParent() == NULL, "expression result in memory");
+  delete sum;
+
+  // a pyramid in memory:
+  std::vector<GeoStar::Raster *> pyramid = mem->gaussianPyramid(NULL, 2);
+  failed += check(pyramid.size() == 3 && pyramid[2]->is_in_memory() && pyramid[2]->get_nx() == NX/4, "pyramid in memory");
+  delete pyramid[2];
+  delete pyramid[1];
+
+  delete mem;
+  delete edges;
+  delete scaled;
+  delete ras;
+  delete img;
+  delete file;
+
+  boost::filesystem::remove(p);
+  return (failed == 0) ? 0 : 1;
+}// end-main
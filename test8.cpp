@@ -0,0 +1,125 @@
+// test8.cpp
+//
+// tests the multithreaded tile walk: the scheduler runs every task once
+// and reports errors, and thresh, scale, the arithmetic (named and as
+// expressions) and the region filters give the same pixels on 4 threads
+// as on one.
+//
+// usage: test8
+//
+//---------------------------------------------------------
+#include <string>
+#include <iostream>
+#include <vector>
+#include <stdexcept>
+#include "geostar.hpp"
+#include "testutil.hpp"
+#include "TileScheduler.hpp"
+
+#include "boost/filesystem.hpp"
+
+const long int NX = 500;
+const long int NY = 301;
+const int THREADS = 4;
+
+// runs op on two copies of the ramp, on one thread and on THREADS; true if the outputs match
+template<typename Op>
+bool same_on_threads(GeoStar::Image *img, const std::string &name, const GeoStar::RasterType &type, Op op) {
+  std::vector<float> result[2];
+  for(int pass=0; pass<2; ++pass) {
+    const std::string suffix = (pass == 0) ? "_1" : "_n";
+    GeoStar::Raster *in = ramp(img, name + suffix, type, NX, NY);
+    GeoStar::Raster *out = img->create_raster(name + suffix + "_out", type, NX, NY);
+    in->set_threads(pass == 0 ? 1 : THREADS);
+    op(in, out);
+    result[pass] = pixels(out);
+    delete out;
+    delete in;
+  }// endfor: pass
+  return result[0] == result[1];
+}// end: same_on_threads
+
+
+int main() {
+  int failed = 0;
+
+  // the scheduler: every task once, on the threads asked for
+  GeoStar::TileScheduler &scheduler = GeoStar::TileScheduler::shared();
+  std::vector<int> runs(1000, 0);
+  std::vector<int> worker_of(1000, -1);
+  scheduler.run(runs.size(), [&](long int t, unsigned worker) { ++runs[t]; worker_of[t] = worker; }, THREADS);
+  bool once = true, inRange = true;
+  for(size_t t=0; t<runs.size(); ++t) {
+    once = once && runs[t] == 1;
+    inRange = inRange && worker_of[t] >= 0 && worker_of[t] < THREADS;
+  }// endfor: t
+  failed += check(once, "every task run once");
+  failed += check(inRange && scheduler.size() >= (unsigned)THREADS, "tasks on the threads asked for");
+
+  // a task's exception reaches the caller, and the scheduler still works after it:
+  bool caught = false;
+  try {
+    scheduler.run(100, [](long int t, unsigned) { if(t == 42) throw std::runtime_error("task 42"); }, THREADS);
+  } catch(const std::runtime_error &) {
+    caught = true;
+  }
+  failed += check(caught, "task exception rethrown");
+
+  // a task can run a batch of its own:
+  std::vector<int> inner(8*16, 0);
+  scheduler.run(8, [&](long int t, unsigned) {
+      scheduler.run(16, [&](long int u, unsigned) { ++inner[t*16 + u]; }, THREADS);
+    }, THREADS);
+  failed += check(std::vector<int>(inner.size(), 1) == inner, "nested batches");
+
+  // the Raster operations, one thread against several:
+  boost::filesystem::path p("a8.h5");
+  boost::filesystem::remove(p);
+  GeoStar::File *file = new GeoStar::File("a8.h5", "new");
+  GeoStar::Image *img = file->create_image("landsat");
+
+  failed += check(same_on_threads(img, "thresh", GeoStar::REAL32,
+                    [](GeoStar::Raster *in, GeoStar::Raster *out) { in->thresh(100); in->scale(out, 0, 1); }),
+                  "thresh");
+  failed += check(same_on_threads(img, "scale", GeoStar::INT16U,
+                    [](GeoStar::Raster *in, GeoStar::Raster *out) { in->scale(out, 10, 3); }),
+                  "scale");
+  failed += check(same_on_threads(img, "add", GeoStar::REAL32,
+                    [](GeoStar::Raster *in, GeoStar::Raster *out) { in->add(in, out); out->set_threads(in->get_threads()); out->multiply(in, out); }),
+                  "add and multiply");
+  failed += check(same_on_threads(img, "expression", GeoStar::REAL32,
+                    [](GeoStar::Raster *in, GeoStar::Raster *out) {
+                      out->set_threads(in->get_threads());
+                      *out = (*in + *in) * 0.5f - *in / *in + 3;
+                    }),
+                  "raster expression");
+  failed += check(same_on_threads(img, "midpoint", GeoStar::INT16U,
+                    [](GeoStar::Raster *in, GeoStar::Raster *out) { in->midpointFilter(out, 5); }),
+                  "midpointFilter on INT16U");
+  failed += check(same_on_threads(img, "range", GeoStar::REAL32,
+                    [](GeoStar::Raster *in, GeoStar::Raster *out) { in->rangeFilter(out, 3); }),
+                  "rangeFilter");
+  failed += check(same_on_threads(img, "gradient", GeoStar::REAL32,
+                    [](GeoStar::Raster *in, GeoStar::Raster *out) { in->gradientMask(out, 2); }),
+                  "gradientMask");
+
+  // an error in the file reaches the caller: the output is too small
+  GeoStar::Raster *in = ramp(img, "small_in", GeoStar::REAL32, NX, NY);
+  GeoStar::Raster *out = img->create_raster("small_out", GeoStar::REAL32, NX/2, NY/2);
+  in->set_threads(THREADS);
+  caught = false;
+  try {
+    in->scale(out, 0, 1);
+  } catch(...) {
+    caught = true;
+  }
+  failed += check(caught, "write error rethrown");
+  delete out;
+  delete in;
+
+  delete img;
+  delete file;
+
+  boost::filesystem::remove(p);
+  return (failed == 0) ? 0 : 1;
+}// end-main
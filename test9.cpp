@@ -0,0 +1,154 @@
+// test9.cpp
+//
+// tests RasterPipeline: fused chains give the same pixels as the Raster
+// operations run one by one, on one thread or several, and the bytes
+// PipelinePlan::report gives are the bytes a run reads and writes.
+//
+// usage: test9
+//
+//---------------------------------------------------------
+#include <string>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include "geostar.hpp"
+#include "testutil.hpp"
+
+#include "boost/filesystem.hpp"
+
+const long int NX = 500;
+const long int NY = 301;
+
+int main() {
+  int failed = 0;
+
+  boost::filesystem::path p("a9.h5");
+  boost::filesystem::remove(p);
+  GeoStar::File *file = new GeoStar::File("a9.h5", "new");
+  GeoStar::Image *img = file->create_image("landsat");
+
+  GeoStar::Raster *in = ramp(img, "in", GeoStar::REAL32, NX, NY, 7);
+  GeoStar::Raster *in2 = ramp(img, "in2", GeoStar::REAL32, NX, NY, 3);
+  const std::vector<float> input = pixels(in);
+
+  // the usual chain, eagerly through REAL32 rasters, then fused:
+  GeoStar::Raster *scaled = img->create_raster("scaled", GeoStar::REAL32, NX, NY);
+  GeoStar::Raster *edges = img->create_raster("edges", GeoStar::REAL32, NX, NY);
+  GeoStar::Raster *small = img->create_raster("small", GeoStar::REAL32, NX/2, NY/2);
+  in->scale(scaled, 0, 2);
+  scaled->thresh(100);
+  scaled->gradientMask(edges, 1);
+  edges->downsample(small);
+
+  GeoStar::RasterPipeline chain = GeoStar::RasterPipeline(in).scale(0, 2).thresh(100).gradientMask(1).downsample();
+  GeoStar::Raster *fused = img->create_raster("fused", GeoStar::REAL32, chain.get_nx(), chain.get_ny());
+  chain.write(fused);
+  failed += check(pixels(fused) == pixels(small), "scale, thresh, gradientMask, downsample fused");
+
+  // the same chain with tiles that do not line up with anything:
+  const long int oddTiles[2] = {37, 11};
+  GeoStar::Raster *fusedOdd = img->create_raster("fused_odd", GeoStar::REAL32, chain.get_nx(), chain.get_ny());
+  GeoStar::PipelinePlan oddPlan;
+  oddPlan.add_output(chain, fusedOdd);
+  oddPlan.run(oddTiles);
+  failed += check(pixels(fusedOdd) == pixels(small), "fused, on odd tiles");
+
+  // the region filters and the arithmetic:
+  GeoStar::Raster *eager = img->create_raster("eager_mid", GeoStar::REAL32, NX, NY);
+  GeoStar::Raster *lazy = img->create_raster("lazy_mid", GeoStar::REAL32, NX, NY);
+  in->midpointFilter(eager, 5);
+  GeoStar::RasterPipeline(in).midpointFilter(5).write(lazy);
+  failed += check(pixels(eager) == pixels(lazy), "midpointFilter");
+
+  // fresh outputs: the filters leave the pixels past the whole regions alone
+  delete lazy;
+  delete eager;
+  eager = img->create_raster("eager_range", GeoStar::REAL32, NX, NY);
+  lazy = img->create_raster("lazy_range", GeoStar::REAL32, NX, NY);
+  in->rangeFilter(eager, 3);
+  GeoStar::RasterPipeline(in).rangeFilter(3).write(lazy);
+  failed += check(pixels(eager) == pixels(lazy), "rangeFilter");
+
+  in->add(in2, eager);
+  GeoStar::RasterPipeline(in).add(GeoStar::RasterPipeline(in2)).write(lazy);
+  failed += check(pixels(eager) == pixels(lazy), "add");
+
+  // convolve with a delta returns its input; a shifted one repeats the edges:
+  std::vector<float> delta(9, 0.0f);
+  delta[4] = 1;
+  GeoStar::RasterPipeline(in).convolve(delta, 3).write(lazy);
+  failed += check(pixels(lazy) == input, "convolve with a delta");
+
+  std::vector<float> shift(9, 0.0f);
+  shift[0] = 1;
+  GeoStar::RasterPipeline(in).convolve(shift, 3).write(lazy);
+  std::vector<float> shifted(NX*NY);
+  for(long int y=0; y<NY; ++y)
+    for(long int x=0; x<NX; ++x)
+      shifted[y*NX + x] = input[std::max(y-1, 0L)*NX + std::max(x-1, 0L)];
+  failed += check(pixels(lazy) == shifted, "convolve with a shifted delta");
+
+  // a shared step and two outputs, on 1 and 4 threads, and the bytes of the run:
+  GeoStar::RasterPipeline smooth = GeoStar::RasterPipeline(in).scale(10, 3).convolve(std::vector<float>(25, 0.04f), 5);
+  GeoStar::RasterPipeline masked = smooth.subtract(GeoStar::RasterPipeline(in2)).thresh(20);
+  GeoStar::RasterPipeline regions = smooth.harmonicMean(3);
+  std::vector<float> results[2][2];
+  for(int pass=0; pass<2; ++pass) {
+    const std::string suffix = (pass == 0) ? "_1" : "_n";
+    GeoStar::Raster *out1 = img->create_raster("masked" + suffix, GeoStar::REAL32, NX, NY);
+    GeoStar::Raster *out2 = img->create_raster("regions" + suffix, GeoStar::REAL32, NX, NY);
+    GeoStar::PipelinePlan plan;
+    plan.add_output(masked, out1);
+    plan.add_output(regions, out2);
+    plan.set_threads(pass == 0 ? 1 : 4);
+    const GeoStar::PipelineReport report = plan.report(oddTiles);
+
+    GeoStar::Raster::io_counters().reset();
+    plan.run(oddTiles);
+    const GeoStar::RasterIOCounters counters = GeoStar::Raster::io_counters();
+    if(pass == 0) {
+      std::cout << report.plan;
+      failed += check(counters.bytes_read == report.fused_bytes_read, "bytes read as reported");
+      failed += check(counters.bytes_written == report.fused_bytes_written, "bytes written as reported");
+      failed += check(report.fused_bytes_written == 2ULL*4*NX*NY, "only the outputs written");
+      failed += check(report.eager_bytes_read > report.fused_bytes_read, "less read than eagerly");
+    }// endif
+    results[pass][0] = pixels(out1);
+    results[pass][1] = pixels(out2);
+    delete out2;
+    delete out1;
+  }// endfor: pass
+  failed += check(results[0][0] == results[1][0] && results[0][1] == results[1][1], "same on 4 threads");
+
+  // mistakes:
+  bool caught = false;
+  try {
+    GeoStar::RasterPipeline(in).add(chain);
+  } catch(const GeoStar::RasterSizeErrorException &) {
+    caught = true;
+  }
+  failed += check(caught, "sizes must match");
+
+  caught = false;
+  try {
+    GeoStar::RasterPipeline(in).convolve(delta, 2);
+  } catch(const GeoStar::IntegerParameterException &) {
+    caught = true;
+  }
+  failed += check(caught, "kernel size must be odd");
+
+  delete lazy;
+  delete eager;
+  delete fusedOdd;
+  delete fused;
+  delete small;
+  delete edges;
+  delete scaled;
+  delete in2;
+  delete in;
+  delete img;
+  delete file;
+
+  boost::filesystem::remove(p);
+  return (failed == 0) ? 0 : 1;
+}// end-main
@@ -0,0 +1,46 @@
+// testutil.hpp
+//
+// helpers shared by the tests: reporting a check, reading back every
+// pixel of a raster, and filling a raster with a ramp.
+//
+//----------------------------------------
+#ifndef TESTUTIL_HPP_
+#define TESTUTIL_HPP_
+
+#include <string>
+#include <iostream>
+#include <vector>
+
+#include "geostar.hpp"
+
+
+// prints ok or FAILED with what was checked; returns 1 if it failed, so a test can add up its failures
+inline int check(const bool ok, const std::string &what) {
+  std::cout << (ok ? "ok:     " : "FAILED: ") << what << std::endl;
+  return ok ? 0 : 1;
+}// end: check
+
+
+// all the pixels of a raster, as T (float, double, or complex for the complex rasters)
+template<typename T = float>
+std::vector<T> pixels(const GeoStar::Raster *ras) {
+  std::vector<T> data(ras->get_nx()*ras->get_ny());
+  ras->read(GeoStar::RasterSlice(0, 0, ras->get_nx(), ras->get_ny()), &data[0], data.size());
+  return data;
+}// end: pixels
+
+
+// a new raster of type, nx by ny, filled with the ramp (x*step + y*13) % 251
+inline GeoStar::Raster *ramp(GeoStar::Image *img, const std::string &name, const GeoStar::RasterType &type,
+                             const long int &nx, const long int &ny, const int &step = 7) {
+  GeoStar::Raster *ras = img->create_raster(name, type, nx, ny);
+  std::vector<float> row(nx);
+  for(long int y=0; y<ny; ++y) {
+    for(long int x=0; x<nx; ++x) row[x] = float((x*step + y*13) % 251);
+    ras->write(GeoStar::RasterSlice(0, y, nx, 1), &row[0], row.size());
+  }// endfor: y
+  return ras;
+}// end: ramp
+
+
+#endif // TESTUTIL_HPP_